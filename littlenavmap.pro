@@ -271,6 +271,8 @@ SOURCES += \
   src/common/dialogrecordhelper.cpp \
   src/common/dirtool.cpp \
   src/common/elevationprovider.cpp \
+  src/common/globeelevationpyramid.cpp \
+  src/common/globemappedreader.cpp \
   src/common/filecheck.cpp \
   src/common/formatter.cpp \
   src/common/fueltool.cpp \
@@ -295,6 +297,9 @@ SOURCES += \
   src/common/vehicleicons.cpp \
   src/connect/connectclient.cpp \
   src/connect/connectdialog.cpp \
+  src/connect/simdatabenchmark.cpp \
+  src/connect/simdatapacket.cpp \
+  src/connect/simdatarecorder.cpp \
   src/db/airspacedialog.cpp \
   src/db/databasedialog.cpp \
   src/db/databaseloader.cpp \
@@ -341,6 +346,7 @@ SOURCES += \
   src/mapgui/maptooltip.cpp \
   src/mapgui/mapvisible.cpp \
   src/mapgui/mapwidget.cpp \
+  src/mapgui/screenindexgrid.cpp \
   src/mappainter/mappainter.cpp \
   src/mappainter/mappainteraircraft.cpp \
   src/mappainter/mappainterairport.cpp \
@@ -360,6 +366,7 @@ SOURCES += \
   src/mappainter/mappainterwind.cpp \
   src/mappainter/mappaintlayer.cpp \
   src/online/onlinedatacontroller.cpp \
+  src/online/onlineparseworker.cpp \
   src/options/optiondata.cpp \
   src/options/optionsdialog.cpp \
   src/perf/aircraftperfcontroller.cpp \
@@ -388,7 +395,9 @@ SOURCES += \
   src/route/route.cpp \
   src/route/routealtitude.cpp \
   src/route/routealtitudeleg.cpp \
+  src/route/routebatch.cpp \
   src/route/routecalcdialog.cpp \
+  src/route/routecalcworker.cpp \
   src/route/routecommand.cpp \
   src/route/routecontroller.cpp \
   src/route/routeextractor.cpp \
@@ -422,8 +431,7 @@ SOURCES += \
   src/search/onlineserversearch.cpp \
   src/search/proceduresearch.cpp \
   src/search/querybuilder.cpp \
-  src/search/randomdepartureairportpickingbycriteria.cpp \
-  src/search/randomdestinationairportpickingbycriteria.cpp \
+  src/search/randomflightpicker.cpp \
   src/search/searchbasetable.cpp \
   src/search/searchcontroller.cpp \
   src/search/sqlcontroller.cpp \
@@ -442,16 +450,20 @@ SOURCES += \
   src/weather/weatherreporter.cpp \
   src/weather/windreporter.cpp \
   src/web/requesthandler.cpp \
+  src/web/webaircraftfeed.cpp \
   src/web/webapp.cpp \
   src/web/webcontroller.cpp \
   src/web/webflags.cpp \
   src/web/webmapcontroller.cpp \
+  src/web/webmapimagecache.cpp \
+  src/web/webmaprequestqueue.cpp \
   src/web/webtools.cpp \
   src/webapi/abstractactionscontroller.cpp \
   src/webapi/abstractlnmactionscontroller.cpp \
   src/webapi/actionscontrollerindex.cpp \
   src/webapi/airportactionscontroller.cpp \
   src/webapi/mapactionscontroller.cpp \
+  src/webapi/routeactionscontroller.cpp \
   src/webapi/simactionscontroller.cpp \
   src/webapi/uiactionscontroller.cpp \
   src/webapi/webapicontroller.cpp
@@ -470,6 +482,8 @@ HEADERS  += \
   src/common/dialogrecordhelper.h \
   src/common/dirtool.h \
   src/common/elevationprovider.h \
+  src/common/globeelevationpyramid.h \
+  src/common/globemappedreader.h \
   src/common/filecheck.h \
   src/common/formatter.h \
   src/common/fueltool.h \
@@ -496,6 +510,9 @@ HEADERS  += \
   src/common/vehicleicons.h \
   src/connect/connectclient.h \
   src/connect/connectdialog.h \
+  src/connect/simdatabenchmark.h \
+  src/connect/simdatapacket.h \
+  src/connect/simdatarecorder.h \
   src/db/airspacedialog.h \
   src/db/databasedialog.h \
   src/db/databaseloader.h \
@@ -541,6 +558,7 @@ HEADERS  += \
   src/mapgui/maptooltip.h \
   src/mapgui/mapvisible.h \
   src/mapgui/mapwidget.h \
+  src/mapgui/screenindexgrid.h \
   src/mappainter/mappainter.h \
   src/mappainter/mappainteraircraft.h \
   src/mappainter/mappainterairport.h \
@@ -560,6 +578,7 @@ HEADERS  += \
   src/mappainter/mappainterwind.h \
   src/mappainter/mappaintlayer.h \
   src/online/onlinedatacontroller.h \
+  src/online/onlineparseworker.h \
   src/options/optiondata.h \
   src/options/optionsdialog.h \
   src/perf/aircraftperfcontroller.h \
@@ -588,7 +607,9 @@ HEADERS  += \
   src/route/route.h \
   src/route/routealtitude.h \
   src/route/routealtitudeleg.h \
+  src/route/routebatch.h \
   src/route/routecalcdialog.h \
+  src/route/routecalcworker.h \
   src/route/routecommand.h \
   src/route/routecommandflags.h \
   src/route/routecontroller.h \
@@ -623,8 +644,7 @@ HEADERS  += \
   src/search/onlineserversearch.h \
   src/search/proceduresearch.h \
   src/search/querybuilder.h \
-  src/search/randomdepartureairportpickingbycriteria.h \
-  src/search/randomdestinationairportpickingbycriteria.h \
+  src/search/randomflightpicker.h \
   src/search/searchbasetable.h \
   src/search/searchcontroller.h \
   src/search/sqlcontroller.h \
@@ -643,16 +663,20 @@ HEADERS  += \
   src/weather/weatherreporter.h \
   src/weather/windreporter.h \
   src/web/requesthandler.h \
+  src/web/webaircraftfeed.h \
   src/web/webapp.h \
   src/web/webcontroller.h \
   src/web/webflags.h \
   src/web/webmapcontroller.h \
+  src/web/webmapimagecache.h \
+  src/web/webmaprequestqueue.h \
   src/web/webtools.h \
   src/webapi/abstractactionscontroller.h \
   src/webapi/abstractlnmactionscontroller.h \
   src/webapi/actionscontrollerindex.h \
   src/webapi/airportactionscontroller.h \
   src/webapi/mapactionscontroller.h \
+  src/webapi/routeactionscontroller.h \
   src/webapi/simactionscontroller.h \
   src/webapi/uiactionscontroller.h \
   src/webapi/webapicontroller.h \
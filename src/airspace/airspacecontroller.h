@@ -83,8 +83,9 @@ public:
                     const map::MapAirspaceFilter& filter, float flightPlanAltitude, bool lazy,
                     map::MapAirspaceSources sourcesParam, bool& overflow);
 
-  /* Get Geometry for any airspace and source database */
-  const atools::geo::LineString *getAirspaceGeometry(map::MapAirspaceId id);
+  /* Get Geometry for any airspace and source database. Returns simplified geometry if maxErrorDeg is not 0.
+   * See AirspaceQuery::getAirspaceGeometryById() */
+  const atools::geo::LineString *getAirspaceGeometry(map::MapAirspaceId id, float maxErrorDeg = 0.f);
 
   /* Read and write widget states, source and airspace selection */
   void restoreState();
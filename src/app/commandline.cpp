@@ -86,6 +86,52 @@ CommandLine::CommandLine()
                                      lnm::STARTUP_LAYOUT);
   parser->addOption(*layoutOpt);
 
+  routeBatchOpt = new QCommandLineOption({"b", lnm::STARTUP_ROUTE_BATCH},
+                                         QObject::tr("Calculate flight plans for all city pairs in the given <%1> CSV file after startup. "
+                                                     "Each line contains departure, destination, cruise altitude in feet and mode. "
+                                                     "Mode is one of \"airway\", \"airwaytrack\", \"jet\", \"victor\", "
+                                                     "\"radionav\" or \"radionavndb\". "
+                                                     "Example \"EDDF,LIRF,35000,airway\". "
+                                                     "Exits when done with status 0 on success, 1 on errors and 2 if canceled.").
+                                         arg(lnm::STARTUP_ROUTE_BATCH),
+                                         lnm::STARTUP_ROUTE_BATCH);
+  parser->addOption(*routeBatchOpt);
+
+  routeBatchOutOpt = new QCommandLineOption({"o", lnm::STARTUP_ROUTE_BATCH_OUT},
+                                            QObject::tr("Write flight plans and \"routes.csv\" summary for option -%1 into "
+                                                        "the directory <%2>. Default is the directory of the CSV file.").
+                                            arg("b").arg(lnm::STARTUP_ROUTE_BATCH_OUT),
+                                            lnm::STARTUP_ROUTE_BATCH_OUT);
+  parser->addOption(*routeBatchOutOpt);
+
+  simRecordOpt = new QCommandLineOption(lnm::STARTUP_SIM_RECORD,
+                                        QObject::tr("Record all data packets received from the simulator or "
+                                                    "Little Navconnect into the file <%1>.").arg(lnm::STARTUP_SIM_RECORD),
+                                        lnm::STARTUP_SIM_RECORD);
+  parser->addOption(*simRecordOpt);
+
+  simReplayOpt = new QCommandLineOption(lnm::STARTUP_SIM_REPLAY,
+                                        QObject::tr("Replay data packets from the file <%1> recorded with option --%2 "
+                                                    "instead of connecting to a simulator.").
+                                        arg(lnm::STARTUP_SIM_REPLAY).arg(lnm::STARTUP_SIM_RECORD),
+                                        lnm::STARTUP_SIM_REPLAY);
+  parser->addOption(*simReplayOpt);
+
+  simReplaySpeedOpt = new QCommandLineOption(lnm::STARTUP_SIM_REPLAY_SPEED,
+                                             QObject::tr("Speed factor <%1> for option --%2. "
+                                                         "Default is 1 for real time. 0 replays as fast as possible.").
+                                             arg(lnm::STARTUP_SIM_REPLAY_SPEED).arg(lnm::STARTUP_SIM_REPLAY),
+                                             lnm::STARTUP_SIM_REPLAY_SPEED);
+  parser->addOption(*simReplaySpeedOpt);
+
+  simReplayBenchmarkOpt = new QCommandLineOption(lnm::STARTUP_SIM_REPLAY_BENCHMARK,
+                                                 QObject::tr("Measure the time needed by each receiver of data packets "
+                                                             "while replaying with option --%1. Prints a report to the log "
+                                                             "and exits once the replay is done. "
+                                                             "Use together with \"-platform offscreen\" to run without display.").
+                                                 arg(lnm::STARTUP_SIM_REPLAY));
+  parser->addOption(*simReplayBenchmarkOpt);
+
   languageOpt = new QCommandLineOption({"g", "language"},
                                        QObject::tr("Use language code <language> like \"de\" or \"en_US\" for the user interface. "
                                                    "The code is not checked for existence or validity and "
@@ -105,6 +151,12 @@ CommandLine::~CommandLine()
   delete performanceOpt;
   delete layoutOpt;
   delete languageOpt;
+  delete routeBatchOpt;
+  delete routeBatchOutOpt;
+  delete simRecordOpt;
+  delete simReplayOpt;
+  delete simReplaySpeedOpt;
+  delete simReplayBenchmarkOpt;
 }
 
 void CommandLine::process()
@@ -142,6 +194,35 @@ void CommandLine::process()
   if(parser->isSet(*layoutOpt) && !parser->value(*layoutOpt).isEmpty())
     NavApp::addStartupOptionStr(lnm::STARTUP_LAYOUT, parser->value(*layoutOpt));
 
+  if(parser->isSet(*routeBatchOpt) && !parser->value(*routeBatchOpt).isEmpty())
+    NavApp::addStartupOptionStr(lnm::STARTUP_ROUTE_BATCH, parser->value(*routeBatchOpt));
+
+  if(parser->isSet(*routeBatchOutOpt) && !parser->value(*routeBatchOutOpt).isEmpty())
+    NavApp::addStartupOptionStr(lnm::STARTUP_ROUTE_BATCH_OUT, parser->value(*routeBatchOutOpt));
+
+  // Simulator data recording and replay
+  if(parser->isSet(*simRecordOpt) && parser->isSet(*simReplayOpt))
+    qWarning() << QObject::tr("Only one of options --%1 and --%2 can be used").arg(lnm::STARTUP_SIM_RECORD).arg(lnm::STARTUP_SIM_REPLAY);
+
+  if(parser->isSet(*simRecordOpt) && !parser->value(*simRecordOpt).isEmpty())
+    NavApp::addStartupOptionStr(lnm::STARTUP_SIM_RECORD, parser->value(*simRecordOpt));
+
+  if(parser->isSet(*simReplayOpt) && !parser->value(*simReplayOpt).isEmpty())
+    NavApp::addStartupOptionStr(lnm::STARTUP_SIM_REPLAY, parser->value(*simReplayOpt));
+
+  if(parser->isSet(*simReplaySpeedOpt) && !parser->value(*simReplaySpeedOpt).isEmpty())
+    NavApp::addStartupOptionStr(lnm::STARTUP_SIM_REPLAY_SPEED, parser->value(*simReplaySpeedOpt));
+
+  if(parser->isSet(*simReplayBenchmarkOpt))
+  {
+    // Benchmark reports and exits at end of replay
+    if(parser->isSet(*simReplayOpt) && !parser->value(*simReplayOpt).isEmpty())
+      NavApp::addStartupOptionStr(lnm::STARTUP_SIM_REPLAY_BENCHMARK, "true");
+    else
+      qWarning() << QObject::tr("Option --%1 requires option --%2. Ignoring.").
+        arg(lnm::STARTUP_SIM_REPLAY_BENCHMARK).arg(lnm::STARTUP_SIM_REPLAY);
+  }
+
   // Other arguments without option
   if(!parser->positionalArguments().isEmpty())
     NavApp::addStartupOptionStrList(lnm::STARTUP_OTHER_ARGUMENTS, parser->positionalArguments());
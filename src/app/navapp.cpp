@@ -1196,6 +1196,11 @@ WebController *NavApp::getWebController()
   return webController;
 }
 
+WebMapController *NavApp::getWebMapController()
+{
+  return webController != nullptr ? webController->getWebMapController() : nullptr;
+}
+
 MapPaintWidget *NavApp::getMapPaintWidgetWeb()
 {
   if(webController != nullptr && webController->getWebMapController() != nullptr)
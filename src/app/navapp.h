@@ -58,6 +58,7 @@ class UserdataSearch;
 class VehicleIcons;
 class WeatherReporter;
 class WebController;
+class WebMapController;
 class WindReporter;
 class MapMarkHandler;
 struct MapAirportHandler;
@@ -422,6 +423,7 @@ public:
 
   static WebController *getWebController();
   static MapPaintWidget *getMapPaintWidgetWeb();
+  static WebMapController *getWebMapController();
 
   static MapMarkHandler *getMapMarkHandler();
   static MapAirportHandler *getMapAirportHandler();
@@ -59,6 +59,12 @@ QByteArray AbstractInfoBuilder::uiinfo(UiInfoData uiInfoData) const
     return "not implemented";
 }
 
+QByteArray AbstractInfoBuilder::routebatch(RouteBatchData routeBatchData) const
+{
+  Q_UNUSED(routeBatchData);
+    return "not implemented";
+}
+
 QByteArray AbstractInfoBuilder::features(MapFeaturesData mapFeaturesData) const
 {
   Q_UNUSED(mapFeaturesData);
@@ -26,6 +26,7 @@ namespace InfoBuilderTypes {
     struct SimConnectInfoData;
     struct UiInfoData;
     struct MapFeaturesData;
+    struct RouteBatchData;
 }
 namespace atools {
     namespace sql {
@@ -41,6 +42,7 @@ using InfoBuilderTypes::AirportInfoData;
 using InfoBuilderTypes::SimConnectInfoData;
 using InfoBuilderTypes::UiInfoData;
 using InfoBuilderTypes::MapFeaturesData;
+using InfoBuilderTypes::RouteBatchData;
 
 /**
  * Generic interface for LNM-specific views.
@@ -98,6 +100,13 @@ public:
    * @param uiInfoData
    */
   virtual QByteArray uiinfo(UiInfoData uiInfoData) const;
+
+  /**
+   * Creates a description for the provided batch flight plan calculation results.
+   *
+   * @param routeBatchData
+   */
+  virtual QByteArray routebatch(RouteBatchData routeBatchData) const;
 protected:
   /**
    * @brief Get heading and opposed heading corrected by magnetic variation
@@ -30,6 +30,7 @@
 #include <QDataStream>
 #include <QDateTime>
 #include <QFile>
+#include <QtEndian>
 
 #include <marble/GeoDataLatLonAltBox.h>
 
@@ -43,6 +44,77 @@ static const float MAX_POINT_DISTANCE_NM = 5.f;
 /* Number of entries to remove at once */
 static const int PRUNE_TRACK_ENTRIES = 200;
 
+/* Maximum number of segments in one chunk of the trail index. Has to fit into quint8 indexes of the levels. */
+static const int CHUNK_SEGMENTS = 64;
+
+/* Number of chunks combined in one group of the second index level */
+static const int CHUNK_GROUP_SIZE = 64;
+
+/* Delay before saving is retried after a write error */
+static const qint64 SAVE_RETRY_DELAY_MS = 60000L;
+
+/* Maximum deviation for the simplified levels 1 and up */
+static const QVector<float> LEVEL_TOLERANCE_METER({25.f, 100.f, 400.f, 1600.f, 6400.f});
+
+namespace {
+
+/* Convert to plane coordinates in meter relative to first point. Accurate enough for the short chunks. */
+QVector<QPointF> localPoints(const atools::geo::LineString& line)
+{
+  QVector<QPointF> points;
+  if(!line.isEmpty())
+  {
+    const Pos& origin = line.at(0);
+    const double meterPerDegree = static_cast<double>(atools::geo::nmToMeter(60.f));
+    const double lonScale = meterPerDegree * std::cos(atools::geo::toRadians(static_cast<double>(origin.getLatY())));
+
+    for(const Pos& pos : line)
+    {
+      double lonDiff = static_cast<double>(pos.getLonX() - origin.getLonX());
+      if(lonDiff > 180.)
+        lonDiff -= 360.;
+      else if(lonDiff < -180.)
+        lonDiff += 360.;
+      points.append(QPointF(lonDiff * lonScale, static_cast<double>(pos.getLatY() - origin.getLatY()) * meterPerDegree));
+    }
+  }
+  return points;
+}
+
+double distanceToSegment(const QPointF& point, const QPointF& from, const QPointF& to)
+{
+  QPointF dir = to - from;
+  double lengthSq = QPointF::dotProduct(dir, dir);
+  double t = lengthSq > 0. ? std::max(0., std::min(1., QPointF::dotProduct(point - from, dir) / lengthSq)) : 0.;
+  QPointF diff = point - (from + dir * t);
+  return std::sqrt(QPointF::dotProduct(diff, diff));
+}
+
+/* Douglas-Peucker simplification. Adds indexes of all points between first and last exclusive which are kept. */
+void simplify(QVector<quint8>& indexes, const QVector<QPointF>& points, int first, int last, double toleranceMeter)
+{
+  double maxDistance = 0.;
+  int maxIndex = -1;
+  for(int i = first + 1; i < last; i++)
+  {
+    double distance = distanceToSegment(points.at(i), points.at(first), points.at(last));
+    if(distance > maxDistance)
+    {
+      maxDistance = distance;
+      maxIndex = i;
+    }
+  }
+
+  if(maxIndex != -1 && maxDistance > toleranceMeter)
+  {
+    simplify(indexes, points, first, maxIndex, toleranceMeter);
+    indexes.append(static_cast<quint8>(maxIndex));
+    simplify(indexes, points, maxIndex, last, toleranceMeter);
+  }
+}
+
+}
+
 static const quint32 FILE_MAGIC_NUMBER = 0x5B6C1A2B;
 
 /* Version 2 to adds timstamp and single floating point precision. Uses 32-bit second timestamps */
@@ -54,6 +126,22 @@ static const quint16 FILE_VERSION_64BIT_TS = 3;
 /* Version 4 adds double floating point precision for coordinates */
 static const quint16 FILE_VERSION_64BIT_COORDS = 4;
 
+/* Columnar append only format. File header is followed by blocks which can be appended independently.
+ * Each block has a header with base values, delta encoded columns for time, latitude, longitude and altitude
+ * and bitsets for ground and valid flags.
+ * The file header contains the number of pruned positions at the beginning of the file which are skipped when reading. */
+static const quint32 TRAIL_FILE_MAGIC_NUMBER = 0x4C4E4D54;
+static const quint16 TRAIL_FILE_VERSION = 1;
+static const quint32 TRAIL_BLOCK_MAGIC_NUMBER = 0x54424C4B;
+static const int TRAIL_FILE_HEADER_SIZE = 16;
+static const int TRAIL_FILE_HEADER_DEAD_OFFSET = 8;
+static const int TRAIL_BLOCK_HEADER_SIZE = 32;
+static const int TRAIL_BLOCK_POSITIONS = 4096;
+
+/* Coordinates are stored as 1/10000000 degree and altitude as 1/100 ft */
+static const double TRAIL_COORD_FACTOR = 10000000.;
+static const double TRAIL_ALT_FACTOR = 100.;
+
 QDataStream& operator>>(QDataStream& dataStream, AircraftTrailPos& trackPos)
 {
   if(AircraftTrail::version == FILE_VERSION_64BIT_COORDS)
@@ -151,6 +239,8 @@ AircraftTrail& AircraftTrail::operator=(const AircraftTrail& other)
   append(other);
   maxTrackEntries = other.maxTrackEntries;
   *lastUserAircraft = *other.lastUserAircraft;
+  fileRewrite = true;
+  clearChunks();
   return *this;
 }
 
@@ -167,34 +257,60 @@ map::AircraftTrailSegment AircraftTrail::findNearest(const QPoint& point, const
                                  viewportBox.east(Marble::GeoDataCoordinates::Degree),
                                  viewportBox.south(Marble::GeoDataCoordinates::Degree));
 
+  // Collect all chunks in viewport together with a lower bound for the distance to position
+  const QVector<AircraftTrailChunk>& trailChunks = getChunks();
+  QVector<std::pair<float, int> > candidates;
+  for(int group = 0; group < chunkGroups.size(); group++)
+  {
+    if(!chunkGroups.at(group).overlaps(viewportRect))
+      continue;
+
+    int end = std::min((group + 1) * CHUNK_GROUP_SIZE, trailChunks.size());
+    for(int i = group * CHUNK_GROUP_SIZE; i < end; i++)
+    {
+      const atools::geo::Rect& chunkBounding = trailChunks.at(i).bounding;
+      if(chunkBounding.overlaps(viewportRect))
+      {
+        float minDistance = 0.f;
+        if(!chunkBounding.crossesAntiMeridian() && !chunkBounding.contains(position))
+        {
+          // Nearest point of rectangle - reduce distance a bit since great circle segments can bulge out of rectangle
+          Pos nearest(atools::minmax(chunkBounding.getWest(), chunkBounding.getEast(), position.getLonX()),
+                      atools::minmax(chunkBounding.getSouth(), chunkBounding.getNorth(), position.getLatY()));
+          minDistance = nearest.distanceMeterTo(position) * 0.9f;
+        }
+        candidates.append(std::make_pair(minDistance, i));
+      }
+    }
+  }
+
+  // Look at nearest chunks first to skip all which are farther away than the current result
+  std::sort(candidates.begin(), candidates.end());
+
   int trackIndex = -1;
-  const QVector<atools::geo::LineString> tracks = getLineStrings(atools::geo::EMPTY_POS); // Do not add user aircraft position at end
-  int indexTracks = 0;
   atools::geo::LineDistance result, resultLine, resultShortest, resultShortestLine;
   resultShortest.distance = map::INVALID_DISTANCE_VALUE;
 
-  for(const atools::geo::LineString& track : tracks)
+  for(const std::pair<float, int>& candidate : qAsConst(candidates))
   {
-    atools::geo::Rect trackBounding = track.boundingRect();
+    if(trackIndex != -1 && candidate.first > std::abs(resultShortest.distance))
+      break;
+
+    const AircraftTrailChunk& chunk = trailChunks.at(candidate.second);
 
 #ifdef DEBUG_INFORMATION_TRACK_NEAREST
-    qDebug() << Q_FUNC_INFO << "###############" << "bounding" << bounding << "viewportRect" << viewportRect;
+    qDebug() << Q_FUNC_INFO << "###############" << "chunk" << chunk.bounding << "viewportRect" << viewportRect;
 #endif
 
-    if(trackBounding.overlaps(viewportRect))
-    {
-      int idx = -1;
-      track.distanceMeterToLineString(position, result, &resultLine, &idx, &viewportRect);
+    int idx = -1;
+    chunk.line.distanceMeterToLineString(position, result, &resultLine, &idx, &viewportRect);
 
-      if(std::abs(result.distance) < std::abs(resultShortest.distance) && result.status == atools::geo::ALONG_TRACK)
-      {
-        resultShortest = result;
-        resultShortestLine = resultLine;
-        trackIndex = idx + indexTracks;
-      }
+    if(std::abs(result.distance) < std::abs(resultShortest.distance) && result.status == atools::geo::ALONG_TRACK)
+    {
+      resultShortest = result;
+      resultShortestLine = resultLine;
+      trackIndex = idx + chunk.start - chunksPruned;
     }
-
-    indexTracks += track.size() + 1;
   }
 
 #ifdef DEBUG_INFORMATION_TRACK_NEAREST
@@ -286,9 +402,170 @@ atools::fs::gpx::GpxData AircraftTrail::toGpxData(const atools::fs::pln::Flightp
   return gpxData;
 }
 
+const QVector<AircraftTrailChunk>& AircraftTrail::getChunks() const
+{
+  if(!chunksValid)
+  {
+    // Rebuild from scratch
+    chunks.clear();
+    chunkGroups.clear();
+    chunksPositions = chunksPruned = 0;
+    lastChunkOpen = false;
+    chunksValid = true;
+  }
+
+  // Add positions appended since last call
+  for(; chunksPositions < size(); chunksPositions++)
+    appendChunkPos(chunksPositions);
+
+  return chunks;
+}
+
+void AircraftTrail::appendChunkPos(int index) const
+{
+  const AircraftTrailPos& trailPos = at(index);
+
+  if(!trailPos.isValid())
+  {
+    // Break in trail - close chunk and drop it if it does not contain a segment
+    if(lastChunkOpen)
+    {
+      lastChunkOpen = false;
+      if(chunks.constLast().line.size() > 1)
+        closeChunk(chunks.last());
+      else
+        chunks.removeLast();
+      updateChunkGroups((chunks.size() - 1) / CHUNK_GROUP_SIZE);
+    }
+    return;
+  }
+
+  Pos pos = trailPos.getPosition();
+  if(!lastChunkOpen)
+  {
+    chunks.append(AircraftTrailChunk());
+    chunks.last().start = index + chunksPruned;
+    lastChunkOpen = true;
+  }
+
+  AircraftTrailChunk& chunk = chunks.last();
+  chunk.line.append(pos);
+  chunk.bounding.extend(pos);
+
+  int group = (chunks.size() - 1) / CHUNK_GROUP_SIZE;
+  if(group < chunkGroups.size())
+    chunkGroups[group].extend(pos);
+  else
+  {
+    chunkGroups.append(atools::geo::Rect());
+    chunkGroups.last().extend(pos);
+  }
+
+  if(chunk.line.size() > CHUNK_SEGMENTS)
+  {
+    // Chunk full - simplify and start next one at the last position to keep the segment between them
+    closeChunk(chunk);
+    updateChunkGroups(group);
+
+    AircraftTrailChunk next;
+    next.start = index + chunksPruned;
+    next.line.append(pos);
+    next.bounding.extend(pos);
+    chunks.append(next);
+
+    group = (chunks.size() - 1) / CHUNK_GROUP_SIZE;
+    if(group >= chunkGroups.size())
+      chunkGroups.append(next.bounding);
+  }
+}
+
+void AircraftTrail::closeChunk(AircraftTrailChunk& chunk) const
+{
+  chunk.bounding = chunk.line.boundingRect();
+
+  // Simplify for each level - first and last position are always kept
+  const QVector<QPointF> points = localPoints(chunk.line);
+  int last = points.size() - 1;
+  chunk.levels.clear();
+  for(float tolerance : LEVEL_TOLERANCE_METER)
+  {
+    QVector<quint8> indexes({0});
+    simplify(indexes, points, 0, last, static_cast<double>(tolerance));
+    indexes.append(static_cast<quint8>(last));
+    chunk.levels.append(indexes);
+  }
+}
+
+void AircraftTrail::updateChunkGroups(int firstGroup) const
+{
+  int numGroups = (chunks.size() + CHUNK_GROUP_SIZE - 1) / CHUNK_GROUP_SIZE;
+  chunkGroups.resize(numGroups);
+
+  for(int group = std::max(firstGroup, 0); group < numGroups; group++)
+  {
+    atools::geo::Rect rect;
+    int end = std::min((group + 1) * CHUNK_GROUP_SIZE, chunks.size());
+    for(int i = group * CHUNK_GROUP_SIZE; i < end; i++)
+      rect.extend(chunks.at(i).bounding);
+    chunkGroups[group] = rect;
+  }
+}
+
+void AircraftTrail::pruneChunks(int numRemoved)
+{
+  if(!chunksValid)
+    return;
+
+  if(numRemoved >= chunksPositions)
+  {
+    clearChunks();
+    return;
+  }
+
+  chunksPositions -= numRemoved;
+  chunksPruned += numRemoved;
+
+  // Remove all chunks which do not have a full segment left
+  int numChunks = 0;
+  while(numChunks < chunks.size() && chunks.at(numChunks).start + chunks.at(numChunks).line.size() - 1 <= chunksPruned)
+    numChunks++;
+  chunks.remove(0, numChunks);
+
+  if(chunks.isEmpty())
+    lastChunkOpen = false;
+  else if(chunks.constFirst().start < chunksPruned)
+  {
+    // Cut off removed positions from first chunk
+    AircraftTrailChunk& chunk = chunks.first();
+    atools::geo::LineString line;
+    for(int i = chunksPruned - chunk.start; i < chunk.line.size(); i++)
+      line.append(chunk.line.at(i));
+    chunk.line = line;
+    chunk.start = chunksPruned;
+
+    if(chunk.levels.isEmpty())
+      // Still open
+      chunk.bounding = chunk.line.boundingRect();
+    else
+      closeChunk(chunk);
+  }
+
+  // Groups are shifted - recalculate all
+  updateChunkGroups(0);
+}
+
+void AircraftTrail::clearChunks()
+{
+  chunks.clear();
+  chunkGroups.clear();
+  chunksPositions = chunksPruned = 0;
+  chunksValid = lastChunkOpen = false;
+}
+
 void AircraftTrail::fillTrailFromGpxData(const atools::fs::gpx::GpxData& gpxData)
 {
   clear();
+  fileRewrite = true;
   appendTrailFromGpxData(gpxData);
 }
 
@@ -311,34 +588,120 @@ void AircraftTrail::appendTrailFromGpxData(const atools::fs::gpx::GpxData& gpxDa
   calculateBoundaries();
 }
 
+int AircraftTrail::getNumUnsavedPositions() const
+{
+  // Back off after errors - a full rewrite and file roll would be retried with each position otherwise
+  if(fileSaveFailedMs > 0L && QDateTime::currentMSecsSinceEpoch() - fileSaveFailedMs < SAVE_RETRY_DELAY_MS)
+    return 0;
+
+  return fileRewrite ? size() : size() - filePositions;
+}
+
 void AircraftTrail::saveState(const QString& suffix, int numBackupFiles)
 {
   QFile trackFile(atools::settings::Settings::getConfigFilename(suffix));
+  bool ok = true;
 
-  if(numBackupFiles > 0)
-    atools::io::FileRoller(numBackupFiles).rollFile(trackFile.fileName());
+  // Compact file if it contains more pruned than current positions
+  if(fileDeadPositions > size() || !trackFile.exists())
+    fileRewrite = true;
 
-  if(trackFile.open(QIODevice::WriteOnly))
+  if(fileRewrite)
+  {
+    // Write whole trail into a new file ===================================
+    if(numBackupFiles > 0)
+      atools::io::FileRoller(numBackupFiles).rollFile(trackFile.fileName());
+
+    if(trackFile.open(QIODevice::WriteOnly))
+    {
+      QByteArray header(TRAIL_FILE_HEADER_SIZE, '\0');
+      uchar *data = reinterpret_cast<uchar *>(header.data());
+      qToLittleEndian<quint32>(TRAIL_FILE_MAGIC_NUMBER, data);
+      qToLittleEndian<quint16>(TRAIL_FILE_VERSION, data + 4);
+
+      if(trackFile.write(header) == header.size() && writeTrailBlocks(trackFile, 0))
+      {
+        fileRewrite = false;
+        filePositions = size();
+        fileDeadPositions = 0;
+      }
+      else
+      {
+        qWarning() << "Cannot write track" << trackFile.fileName() << ":" << trackFile.errorString();
+        ok = false;
+      }
+      trackFile.close();
+    }
+    else
+    {
+      qWarning() << "Cannot write track" << trackFile.fileName() << ":" << trackFile.errorString();
+      ok = false;
+    }
+  }
+  else if(filePositions < size())
   {
-    QDataStream out(&trackFile);
-    saveToStream(out);
-    trackFile.close();
+    // Append only new positions ===================================
+    if(trackFile.open(QIODevice::ReadWrite))
+    {
+      if(trackFile.seek(trackFile.size()) && writeTrailBlocks(trackFile, filePositions) &&
+         writeTrailDeadPositions(trackFile))
+        filePositions = size();
+      else
+      {
+        // Partially written block is detected when reading - rewrite next time
+        qWarning() << "Cannot append track" << trackFile.fileName() << ":" << trackFile.errorString();
+        fileRewrite = true;
+        ok = false;
+      }
+      trackFile.close();
+    }
+    else
+    {
+      qWarning() << "Cannot append track" << trackFile.fileName() << ":" << trackFile.errorString();
+      ok = false;
+    }
   }
-  else
-    qWarning() << "Cannot write track" << trackFile.fileName() << ":" << trackFile.errorString();
+
+  fileSaveFailedMs = ok ? 0L : QDateTime::currentMSecsSinceEpoch();
 }
 
 void AircraftTrail::restoreState(const QString& suffix)
 {
   clear();
+  fileRewrite = true;
+  filePositions = fileDeadPositions = 0;
 
   QFile trackFile(atools::settings::Settings::getConfigFilename(suffix));
   if(trackFile.exists())
   {
     if(trackFile.open(QIODevice::ReadOnly))
     {
-      QDataStream in(&trackFile);
-      readFromStream(in);
+      bool complete = false;
+      int deadPositions = 0;
+      if(readTrailFile(trackFile, complete, deadPositions))
+      {
+        // Skip positions which were pruned before saving
+        deadPositions = std::min(deadPositions, size());
+        erase(begin(), begin() + deadPositions);
+
+        // Remove invalid segments left at the beginning
+        while(!isEmpty() && !constFirst().isValid())
+        {
+          removeFirst();
+          deadPositions++;
+        }
+
+        // Keep appending to file if all blocks could be read
+        fileRewrite = !complete;
+        filePositions = size();
+        fileDeadPositions = deadPositions;
+      }
+      else
+      {
+        // Old format - file is rewritten with next save
+        QDataStream in(&trackFile);
+        readFromStream(in);
+      }
       trackFile.close();
     }
     else
@@ -347,6 +710,198 @@ void AircraftTrail::restoreState(const QString& suffix)
   calculateBoundaries();
 }
 
+bool AircraftTrail::writeTrailDeadPositions(QFile& file) const
+{
+  uchar data[4];
+  qToLittleEndian<quint32>(static_cast<quint32>(fileDeadPositions), data);
+
+  qint64 pos = file.pos();
+  bool ok = file.seek(TRAIL_FILE_HEADER_DEAD_OFFSET) && file.write(reinterpret_cast<const char *>(data), 4) == 4;
+  return file.seek(pos) && ok && file.flush();
+}
+
+bool AircraftTrail::writeTrailBlocks(QFile& file, int from) const
+{
+  int index = from;
+  while(index < size())
+  {
+    // Collect positions for one block - start a new block if the time difference does not fit into 32 bit
+    int to = index + 1;
+    while(to < size() && to - index < TRAIL_BLOCK_POSITIONS &&
+          std::abs(at(to).getTimestampMs() - at(to - 1).getTimestampMs()) < std::numeric_limits<qint32>::max())
+      to++;
+
+    QByteArray block = encodeTrailBlock(index, to);
+    if(file.write(block) != block.size())
+      return false;
+    index = to;
+  }
+  return file.flush();
+}
+
+QByteArray AircraftTrail::encodeTrailBlock(int from, int to) const
+{
+  // Header followed by columns for time, latitude, longitude and altitude deltas and bitsets for ground and valid flags
+  int numPositions = to - from;
+  int columnSize = numPositions * 4, bitsetSize = (numPositions + 7) / 8;
+  int payloadSize = columnSize * 4 + (bitsetSize * 2 + 3) / 4 * 4;
+
+  QByteArray block(TRAIL_BLOCK_HEADER_SIZE + payloadSize, '\0');
+  uchar *data = reinterpret_cast<uchar *>(block.data());
+  uchar *payload = data + TRAIL_BLOCK_HEADER_SIZE;
+  uchar *times = payload, *lats = times + columnSize, *lons = lats + columnSize, *alts = lons + columnSize,
+        *ground = alts + columnSize, *valid = ground + bitsetSize;
+
+  // Base values are the ones of the first position - unsigned arithmetic since differences can overflow across the anti-meridian
+  qint64 lastTime = at(from).getTimestampMs();
+  quint32 lastLat = 0, lastLon = 0, lastAlt = 0;
+  if(at(from).isValid())
+  {
+    const atools::geo::PosD& pos = at(from).getPosD();
+    lastLat = static_cast<quint32>(static_cast<qint32>(std::lround(pos.getLatY() * TRAIL_COORD_FACTOR)));
+    lastLon = static_cast<quint32>(static_cast<qint32>(std::lround(pos.getLonX() * TRAIL_COORD_FACTOR)));
+    lastAlt = static_cast<quint32>(static_cast<qint32>(std::lround(pos.getAltitude() * TRAIL_ALT_FACTOR)));
+  }
+
+  qToLittleEndian<quint32>(TRAIL_BLOCK_MAGIC_NUMBER, data);
+  qToLittleEndian<quint32>(static_cast<quint32>(numPositions), data + 4);
+  qToLittleEndian<qint64>(lastTime, data + 8);
+  qToLittleEndian<quint32>(lastLat, data + 16);
+  qToLittleEndian<quint32>(lastLon, data + 20);
+  qToLittleEndian<quint32>(lastAlt, data + 24);
+
+  for(int i = 0; i < numPositions; i++)
+  {
+    const AircraftTrailPos& trailPos = at(from + i);
+
+    // Invalid positions keep the last coordinates and are marked in the bitset
+    quint32 lat = lastLat, lon = lastLon, alt = lastAlt;
+    if(trailPos.isValid())
+    {
+      const atools::geo::PosD& pos = trailPos.getPosD();
+      lat = static_cast<quint32>(static_cast<qint32>(std::lround(pos.getLatY() * TRAIL_COORD_FACTOR)));
+      lon = static_cast<quint32>(static_cast<qint32>(std::lround(pos.getLonX() * TRAIL_COORD_FACTOR)));
+      alt = static_cast<quint32>(static_cast<qint32>(std::lround(pos.getAltitude() * TRAIL_ALT_FACTOR)));
+      valid[i / 8] |= static_cast<uchar>(1 << (i % 8));
+    }
+
+    if(trailPos.isOnGround())
+      ground[i / 8] |= static_cast<uchar>(1 << (i % 8));
+
+    qToLittleEndian<qint32>(static_cast<qint32>(trailPos.getTimestampMs() - lastTime), times + i * 4);
+    qToLittleEndian<quint32>(lat - lastLat, lats + i * 4);
+    qToLittleEndian<quint32>(lon - lastLon, lons + i * 4);
+    qToLittleEndian<quint32>(alt - lastAlt, alts + i * 4);
+
+    lastTime = trailPos.getTimestampMs();
+    lastLat = lat;
+    lastLon = lon;
+    lastAlt = alt;
+  }
+
+  // Checksum over payload allows to detect partially written blocks
+  qToLittleEndian<quint32>(qChecksum(reinterpret_cast<const char *>(payload), static_cast<uint>(payloadSize)), data + 28);
+  return block;
+}
+
+qint64 AircraftTrail::decodeTrailBlock(const uchar *data, qint64 maxSize)
+{
+  if(maxSize < TRAIL_BLOCK_HEADER_SIZE || qFromLittleEndian<quint32>(data) != TRAIL_BLOCK_MAGIC_NUMBER)
+    return -1;
+
+  quint32 numPositionsUnsigned = qFromLittleEndian<quint32>(data + 4);
+  if(numPositionsUnsigned == 0 || numPositionsUnsigned > static_cast<quint32>(TRAIL_BLOCK_POSITIONS))
+    return -1;
+
+  int numPositions = static_cast<int>(numPositionsUnsigned);
+  int columnSize = numPositions * 4, bitsetSize = (numPositions + 7) / 8;
+  int payloadSize = columnSize * 4 + (bitsetSize * 2 + 3) / 4 * 4;
+  if(maxSize < TRAIL_BLOCK_HEADER_SIZE + payloadSize)
+    return -1;
+
+  const uchar *payload = data + TRAIL_BLOCK_HEADER_SIZE;
+  if(qFromLittleEndian<quint32>(data + 28) != qChecksum(reinterpret_cast<const char *>(payload), static_cast<uint>(payloadSize)))
+    return -1;
+
+  const uchar *times = payload, *lats = times + columnSize, *lons = lats + columnSize, *alts = lons + columnSize,
+              *ground = alts + columnSize, *valid = ground + bitsetSize;
+
+  qint64 time = qFromLittleEndian<qint64>(data + 8);
+  quint32 lat = qFromLittleEndian<quint32>(data + 16), lon = qFromLittleEndian<quint32>(data + 20),
+          alt = qFromLittleEndian<quint32>(data + 24);
+
+  reserve(size() + numPositions);
+  for(int i = 0; i < numPositions; i++)
+  {
+    time += qFromLittleEndian<qint32>(times + i * 4);
+    lat += qFromLittleEndian<quint32>(lats + i * 4);
+    lon += qFromLittleEndian<quint32>(lons + i * 4);
+    alt += qFromLittleEndian<quint32>(alts + i * 4);
+    bool onGround = ground[i / 8] & (1 << (i % 8));
+
+    if(valid[i / 8] & (1 << (i % 8)))
+      append(AircraftTrailPos(atools::geo::PosD(static_cast<qint32>(lon) / TRAIL_COORD_FACTOR,
+                                                static_cast<qint32>(lat) / TRAIL_COORD_FACTOR,
+                                                static_cast<qint32>(alt) / TRAIL_ALT_FACTOR), time, onGround));
+    else
+      append(AircraftTrailPos(time, onGround));
+  }
+
+  return TRAIL_BLOCK_HEADER_SIZE + payloadSize;
+}
+
+bool AircraftTrail::readTrailFile(QFile& file, bool& complete, int& deadPositions)
+{
+  complete = false;
+  deadPositions = 0;
+  qint64 fileSize = file.size();
+  if(fileSize < TRAIL_FILE_HEADER_SIZE)
+    return false;
+
+  uchar *data = file.map(0, fileSize);
+  if(data == nullptr)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot map" << file.fileName() << file.errorString();
+    return false;
+  }
+
+  bool retval = false;
+  if(qFromLittleEndian<quint32>(data) == TRAIL_FILE_MAGIC_NUMBER)
+  {
+    quint16 fileVersion = qFromLittleEndian<quint16>(data + 4);
+    if(fileVersion == TRAIL_FILE_VERSION)
+    {
+      retval = true;
+      complete = true;
+      deadPositions = static_cast<int>(std::min(qFromLittleEndian<quint32>(data + TRAIL_FILE_HEADER_DEAD_OFFSET),
+                                                static_cast<quint32>(std::numeric_limits<int>::max())));
+
+      // Read all blocks - stop at first invalid one which might be left over from a crash while writing
+      qint64 offset = TRAIL_FILE_HEADER_SIZE;
+      while(offset < fileSize)
+      {
+        qint64 blockSize = decodeTrailBlock(data + offset, fileSize - offset);
+        if(blockSize < 0)
+        {
+          qWarning() << Q_FUNC_INFO << "Invalid or truncated block in" << file.fileName() << "at" << offset;
+          complete = false;
+          break;
+        }
+        offset += blockSize;
+      }
+    }
+    else
+    {
+      // Not readable - leave trail empty
+      qWarning() << Q_FUNC_INFO << "Cannot read track. Invalid version number:" << fileVersion;
+      retval = true;
+    }
+  }
+
+  file.unmap(data);
+  return retval;
+}
+
 void AircraftTrail::saveToStream(QDataStream& out)
 {
   out.setVersion(QDataStream::Qt_5_5);
@@ -364,6 +919,7 @@ bool AircraftTrail::readFromStream(QDataStream& in)
 {
   bool retval = false;
   clear();
+  fileRewrite = true;
 
   quint32 magic;
   in.setVersion(QDataStream::Qt_5_5);
@@ -495,13 +1051,24 @@ bool AircraftTrail::appendTrailPos(const atools::fs::sc::SimConnectUserAircraft&
       {
         if(size() > maxTrackEntries)
         {
-          for(int i = 0; i < PRUNE_TRACK_ENTRIES; i++)
+          int numRemoved = 0;
+          for(int i = 0; i < PRUNE_TRACK_ENTRIES; i++, numRemoved++)
             removeFirst();
 
           // Remove invalid segments
-          while(!isEmpty() && !constFirst().isValid())
+          for(; !isEmpty() && !constFirst().isValid(); numRemoved++)
             removeFirst();
 
+          pruneChunks(numRemoved);
+
+          // Removed positions stay in the file until it is compacted
+          if(numRemoved > filePositions)
+            fileRewrite = true;
+          else
+          {
+            filePositions -= numRemoved;
+            fileDeadPositions += numRemoved;
+          }
           pruned = true;
         }
         append(AircraftTrailPos(posD, timestampMs, onGround));
@@ -514,17 +1081,20 @@ bool AircraftTrail::appendTrailPos(const atools::fs::sc::SimConnectUserAircraft&
     // Last one is always valid
     calculateBoundary(constLast());
 
+  // Chunk index is updated incrementally with the next access
   return pruned;
 }
 
 void AircraftTrail::clearTrail()
 {
   clear();
+  fileRewrite = true;
   clearBoundaries();
 }
 
 void AircraftTrail::clearBoundaries()
 {
+  clearChunks();
   bounding = atools::geo::Rect();
   minAltitude = std::numeric_limits<float>::max();
   maxAltitude = std::numeric_limits<float>::min();
@@ -581,6 +1151,60 @@ const QVector<atools::geo::LineString> AircraftTrail::getLineStrings(const atool
   return linestrings;
 }
 
+const QVector<atools::geo::LineString> AircraftTrail::getLineStrings(const atools::geo::Pos& aircraftPos,
+                                                                     const atools::geo::Rect& viewportRect, float toleranceMeter) const
+{
+  QVector<atools::geo::LineString> linestrings;
+  const QVector<AircraftTrailChunk>& trailChunks = getChunks();
+
+  // Use the most simplified level which is still within tolerance
+  int level = 0;
+  while(level < LEVEL_TOLERANCE_METER.size() && LEVEL_TOLERANCE_METER.at(level) <= toleranceMeter)
+    level++;
+
+  int lastChunk = -1;
+  for(int group = 0; group < chunkGroups.size(); group++)
+  {
+    if(!chunkGroups.at(group).overlaps(viewportRect))
+      continue;
+
+    int end = std::min((group + 1) * CHUNK_GROUP_SIZE, trailChunks.size());
+    for(int i = group * CHUNK_GROUP_SIZE; i < end; i++)
+    {
+      const AircraftTrailChunk& chunk = trailChunks.at(i);
+      if(!chunk.bounding.overlaps(viewportRect))
+        continue;
+
+      // Continue linestring if previous chunk was added and shares the border position
+      bool connected = lastChunk != -1 && lastChunk == i - 1 &&
+                       trailChunks.at(lastChunk).start + trailChunks.at(lastChunk).line.size() - 1 == chunk.start;
+      if(!connected)
+        linestrings.append(atools::geo::LineString());
+
+      atools::geo::LineString& line = linestrings.last();
+      if(level == 0 || chunk.levels.isEmpty())
+      {
+        // Full resolution or chunk not closed yet
+        for(int j = connected ? 1 : 0; j < chunk.line.size(); j++)
+          line.append(chunk.line.at(j));
+      }
+      else
+      {
+        const QVector<quint8>& indexes = chunk.levels.at(level - 1);
+        for(int j = connected ? 1 : 0; j < indexes.size(); j++)
+          line.append(chunk.line.at(indexes.at(j)));
+      }
+      lastChunk = i;
+    }
+  }
+
+  // Add aircraft position to avoid gap if end of trail is visible
+  if(aircraftPos.isValid() && lastChunk != -1 && lastChunk == trailChunks.size() - 1 && constLast().isValid())
+    linestrings.last().append(aircraftPos);
+
+  return linestrings;
+}
+
 const QVector<QVector<atools::geo::PosD> > AircraftTrail::getPositionsD() const
 {
   QVector<QVector<atools::geo::PosD> > linestrings;
@@ -18,9 +18,12 @@
 #ifndef LITTLENAVMAP_AIRCRAFTTRACK_H
 #define LITTLENAVMAP_AIRCRAFTTRACK_H
 
+#include "geo/linestring.h"
 #include "geo/pos.h"
 #include "geo/rect.h"
 
+class QFile;
+
 namespace Marble {
 class GeoDataLatLonAltBox;
 }
@@ -43,7 +46,6 @@ class SimConnectUserAircraft;
 }
 namespace geo {
 class Rect;
-class LineString;
 }
 }
 
@@ -117,6 +119,21 @@ QDataStream& operator<<(QDataStream& dataStream, const AircraftTrailPos& obj);
 Q_DECLARE_TYPEINFO(AircraftTrailPos, Q_PRIMITIVE_TYPE);
 Q_DECLARE_METATYPE(AircraftTrailPos);
 
+/* Run of consecutive valid trail positions used as a spatial index and for level of detail in AircraftTrail.
+ * Neighboring chunks share the border position to avoid gaps. */
+struct AircraftTrailChunk
+{
+  /* Sequence number of first position. Index in trail is start minus number of pruned positions. */
+  int start = 0;
+
+  /* Positions start to start + line.size() - 1 */
+  atools::geo::LineString line;
+  atools::geo::Rect bounding;
+
+  /* Indexes into line for simplified levels 1 and up. Empty as long as chunk is still filled. */
+  QVector<QVector<quint8> > levels;
+};
+
 /*
  * Stores the trail points of the flight simulator user aircraft.
  *
@@ -149,10 +166,17 @@ public:
   /* Appends the given gpxData as new track segment without deleting the current one. */
   void appendTrailFromGpxData(const atools::fs::gpx::GpxData& gpxData);
 
-  /* Saves and restores track into a separate file (little_navmap.track). Creates two additional backup files. */
+  /* Saves and restores track into a separate file (little_navmap.track) using a columnar append only format.
+   * Only positions added since the last save are appended if the trail was not changed otherwise.
+   * The file is rewritten and numBackupFiles backups are rolled after all other changes.
+   * Old QDataStream based files are read and converted with the next save. */
   void saveState(const QString& suffix, int numBackupFiles);
   void restoreState(const QString& suffix);
 
+  /* Number of positions not yet written to the file by saveState().
+   * Returns 0 for a while after a failed save to avoid retrying with each new position. */
+  int getNumUnsavedPositions() const;
+
   void clearTrail();
 
   /*
@@ -182,6 +206,11 @@ public:
    * More than one linestring might be returned if the trail is interrupted. */
   const QVector<atools::geo::LineString> getLineStrings(const atools::geo::Pos& aircraftPos) const;
 
+  /* As above but only for parts overlapping viewportRect and simplified so that no position deviates more than
+   * toleranceMeter from the original trail. Use for drawing. */
+  const QVector<atools::geo::LineString> getLineStrings(const atools::geo::Pos& aircraftPos, const atools::geo::Rect& viewportRect,
+                                                        float toleranceMeter) const;
+
   /* Track will be pruned if it contains more track entries than this value. Default is 20000. */
   void setMaxTrackEntries(int value)
   {
@@ -211,6 +240,36 @@ private:
   void calculateBoundaries();
   void calculateBoundary(const AircraftTrailPos& trackPos);
 
+  /* Add all positions not yet covered to the chunk index and return it. Index is built incrementally when appending
+   * positions and rebuilt completely after all other modifications. */
+  const QVector<AircraftTrailChunk>& getChunks() const;
+  void clearChunks();
+
+  /* Update index after removing the given number of positions from the beginning of the list */
+  void pruneChunks(int numRemoved);
+
+  /* Add position at index in list to last chunk or start a new one. Closes last chunk for invalid positions. */
+  void appendChunkPos(int index) const;
+  void closeChunk(AircraftTrailChunk& chunk) const;
+  void updateChunkGroups(int firstGroup) const;
+
+  /* Encode positions from index to index exclusive into one block of the trail file */
+  QByteArray encodeTrailBlock(int from, int to) const;
+
+  /* Decode and append positions from one block. Returns number of bytes read or -1 if the block is truncated or invalid. */
+  qint64 decodeTrailBlock(const uchar *data, qint64 maxSize);
+
+  /* Write all positions from index on as blocks */
+  bool writeTrailBlocks(QFile& file, int from) const;
+
+  /* Update number of pruned positions in file header. Keeps the file position. */
+  bool writeTrailDeadPositions(QFile& file) const;
+
+  /* Read memory mapped trail file. Returns false if the file is not in columnar format.
+   * complete is false if reading stopped at a truncated or invalid block.
+   * deadPositions is the number of pruned positions at the beginning which have to be removed by the caller. */
+  bool readTrailFile(QFile& file, bool& complete, int& deadPositions);
+
   /* Accurate positions for drawing */
   const QVector<QVector<atools::geo::PosD> > getPositionsD() const;
 
@@ -223,12 +282,34 @@ private:
   float maxAltitude, minAltitude;
   atools::geo::Rect bounding;
 
+  /* Lazily built by getChunks() */
+  mutable QVector<AircraftTrailChunk> chunks;
+
+  /* Bounding rectangles for groups of chunks as second level of the hierarchy */
+  mutable QVector<atools::geo::Rect> chunkGroups;
+
+  /* Number of positions in list covered by chunks and number of positions pruned since index was built */
+  mutable int chunksPositions = 0, chunksPruned = 0;
+  mutable bool chunksValid = false, lastChunkOpen = false;
+
   /* Trail density settings which depends on ground speed */
   float minGroundDistMeter, minFlyingDistMeter, maxHeadingDiffDeg, maxSpeedDiffKts, maxAltDiffFtUpper, maxAltDiffFtLower, aglThresholdFt;
   qint64 maxFlyingTimeMs, maxGroundTimeMs;
 
   atools::fs::sc::SimConnectUserAircraft *lastUserAircraft;
 
+  /* Number of positions at the beginning of the list which are already stored at the end of the trail file */
+  int filePositions = 0;
+
+  /* Number of pruned positions which are still stored in the trail file. Saved in the file header. */
+  int fileDeadPositions = 0;
+
+  /* Trail was changed not only by appending - file has to be rewritten */
+  bool fileRewrite = true;
+
+  /* Timestamp of last failed saveState() or 0 if last save was successful */
+  qint64 fileSaveFailedMs = 0L;
+
   /* Needed in RouteExportFormat stream operators to read different formats */
   static quint16 version;
 };
@@ -284,6 +284,7 @@ const QLatin1String AIRSPACE_CONTROLLER_WIDGETS("AirspaceController/Widget");
 const QLatin1String SETTINGS_INFOQUERY("Settings/InfoQuery");
 const QLatin1String SETTINGS_MAPQUERY("Settings/MapQuery1");
 const QLatin1String SETTINGS_DATABASE("Settings/Database");
+const QLatin1String SETTINGS_SEARCH("Settings/Search");
 
 /* Aircraft trail densisity settings */
 const QLatin1String SETTINGS_AIRCRAFT_TRAIL("Settings/AircraftTrail");
@@ -367,8 +368,13 @@ const QLatin1String OPTIONS_DATAREADER_RECONNECT_SOCKET("Options/DataReaderRecon
 const QLatin1String OPTIONS_WEATHER_DEBUG("Options/WeatherDebug");
 const QLatin1String OPTIONS_MAP_JUMP_BACK_DEBUG("Options/MapJumpBackDebug");
 const QLatin1String OPTIONS_PROFILE_JUMP_BACK_DEBUG("Options/ProfileJumpBackDebug");
+const QLatin1String OPTIONS_PROFILE_ELEVATION_BENCHMARK_DEBUG("Options/ProfileElevationBenchmarkDebug");
 const QLatin1String OPTIONS_MAP_LAYER_DEBUG("Options/MapLayerDebug");
 const QLatin1String OPTIONS_MAP_LAYER_DEBUG_DRAW("Options/MapLayerDebugDraw");
+const QLatin1String OPTIONS_MAP_SCREEN_INDEX_BENCHMARK_DEBUG("Options/MapScreenIndexBenchmarkDebug");
+const QLatin1String OPTIONS_SEARCH_BENCHMARK_DEBUG("Options/SearchBenchmarkDebug");
+const QLatin1String OPTIONS_SIM_DATA_STATISTICS_DEBUG("Options/SimDataStatisticsDebug");
+const QLatin1String OPTIONS_MAP_STATIC_LAYER_CACHE("Options/MapStaticLayerCache");
 
 const QLatin1String OPTIONS_ONLINE_NETWORK_DEBUG("Options/OnlineNetworkDebug");
 const QLatin1String OPTIONS_ONLINE_NETWORK_MAX_SHADOW_DIST_NM("Options/MaxShadowDistNm");
@@ -379,6 +385,8 @@ const QLatin1String OPTIONS_ONLINE_NETWORK_MAX_SHADOW_HDG_DIFF_DEG("Options/MaxS
 const QLatin1String OPTIONS_TRACK_DEBUG("Options/TrackDebug");
 const QLatin1String OPTIONS_WIND_DEBUG("Options/WindDebug");
 const QLatin1String OPTIONS_WEBSERVER_DEBUG("Options/WebserverDebug");
+const QLatin1String OPTIONS_WEBSERVER_MAP_POOL_SIZE("Options/WebserverMapPoolSize");
+const QLatin1String OPTIONS_WEBSERVER_IMAGE_CACHE_MB("Options/WebserverImageCacheMb");
 const QLatin1String OPTIONS_STORAGE_DEBUG("Options/StorageDebug");
 const QLatin1String OPTIONS_VERSION("Options/Version");
 const QLatin1String OPTIONS_NO_USER_AGENT("Options/NoUserAgent");
@@ -458,6 +466,12 @@ const QLatin1String STARTUP_FLIGHTPLAN("flight-plan");
 const QLatin1String STARTUP_FLIGHTPLAN_DESCR("flight-plan-descr");
 const QLatin1String STARTUP_AIRCRAFT_PERF("aircraft-perf");
 const QLatin1String STARTUP_LAYOUT("layout");
+const QLatin1String STARTUP_ROUTE_BATCH("route-batch");
+const QLatin1String STARTUP_ROUTE_BATCH_OUT("route-batch-out");
+const QLatin1String STARTUP_SIM_RECORD("sim-record");
+const QLatin1String STARTUP_SIM_REPLAY("sim-replay");
+const QLatin1String STARTUP_SIM_REPLAY_SPEED("sim-replay-speed");
+const QLatin1String STARTUP_SIM_REPLAY_BENCHMARK("sim-replay-benchmark");
 
 /* Not used as long options */
 const QLatin1String STARTUP_OTHER_ARGUMENTS("others"); /* Positional arguments not found after option - string list */
@@ -20,6 +20,8 @@
 #include "common/constants.h"
 #include "geo/calculations.h"
 #include "app/navapp.h"
+#include "common/globeelevationpyramid.h"
+#include "common/globemappedreader.h"
 #include "fs/common/globereader.h"
 #include "gui/helphandler.h"
 #include "options/optiondata.h"
@@ -28,17 +30,28 @@
 #include "geo/pos.h"
 #include "gui/dialog.h"
 #include "atools.h"
+#include "settings/settings.h"
 
 #include <marble/GeoDataCoordinates.h>
 #include <marble/ElevationModel.h>
 
+#include <QElapsedTimer>
+#include <QThread>
 #include <QUrl>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
 
 /* Limt altitude to this value */
 static Q_DECL_CONSTEXPR float ALTITUDE_LIMIT_METER = 8800.f;
 /* Point removal equality tolerance in meter */
 static Q_DECL_CONSTEXPR float SAME_ONLINE_ELEVATION_EPSILON = 1.f;
 
+/* Lines longer than this are split into chunks which are sampled in parallel */
+static Q_DECL_CONSTEXPR float BATCH_CHUNK_LENGTH_METER = 100000.f;
+
+/* Min/max pyramid file in configuration directory */
+static const QLatin1String PYRAMID_FILE_SUFFIX("_globe_pyramid.bin");
+
 using atools::geo::Pos;
 using atools::geo::Line;
 using atools::geo::LineString;
@@ -47,13 +60,28 @@ using atools::fs::common::GlobeReader;
 using namespace Marble;
 
 ElevationProvider::ElevationProvider(QObject *parent)
-  : QObject(parent)
+  : QObject(parent), pyramidCancel(false)
 {
+  connect(&pyramidWatcher, &QFutureWatcher<std::shared_ptr<GlobeElevationPyramid> >::finished,
+          this, &ElevationProvider::pyramidFinished);
 }
 
 ElevationProvider::~ElevationProvider()
 {
-  delete globeReader;
+  cancelPyramid();
+}
+
+void ElevationProvider::cancelPyramid()
+{
+  pyramidCancel.store(true);
+  pyramidFuture.waitForFinished();
+  pyramidCancel.store(false);
+}
+
+std::shared_ptr<GlobeMappedReader> ElevationProvider::getGlobeReader() const
+{
+  std::shared_ptr<GlobeMappedReader> reader = std::atomic_load(&globeReader);
+  return reader != nullptr && reader->isValid() ? reader : std::shared_ptr<GlobeMappedReader>();
 }
 
 void ElevationProvider::marbleUpdateAvailable()
@@ -64,10 +92,11 @@ void ElevationProvider::marbleUpdateAvailable()
 
 float ElevationProvider::getElevationMeter(const atools::geo::Pos& pos, float sampleRadiusMeter)
 {
-  if(isGlobeOfflineProvider())
+  // Keeps the reader alive even if options are changed in the meantime
+  std::shared_ptr<GlobeMappedReader> reader = getGlobeReader();
+  if(reader != nullptr)
   {
-    QMutexLocker locker(&mutex);
-    float elevation = globeReader->getElevation(pos, sampleRadiusMeter);
+    float elevation = reader->getElevation(pos, sampleRadiusMeter);
     if(!(elevation > atools::fs::common::OCEAN && elevation < atools::fs::common::INVALID))
       return 0.f;
     else
@@ -87,11 +116,11 @@ void ElevationProvider::getElevations(atools::geo::LineString& elevations, const
   if(!line.isValid())
     return;
 
-  QMutexLocker locker(&mutex);
-
-  if(isGlobeOfflineProvider())
+  std::shared_ptr<GlobeMappedReader> reader = getGlobeReader();
+  if(reader != nullptr)
   {
-    globeReader->getElevations(elevations, LineString(line.getPos1(), line.getPos2()), sampleRadiusMeter);
+    // Lock free sampling of mapped files
+    reader->getElevations(elevations, LineString(line.getPos1(), line.getPos2()), sampleRadiusMeter);
     for(Pos& pos : elevations)
     {
       float alt = pos.getAltitude();
@@ -102,6 +131,9 @@ void ElevationProvider::getElevations(atools::geo::LineString& elevations, const
   }
   else if(marbleModel != nullptr)
   {
+    // Marble model is not thread safe
+    QMutexLocker locker(&marbleMutex);
+
     // Get altitude points for the line segment
     // The might not be complete and will be more complete on further iterations when we get a signal
     // from the elevation model
@@ -154,9 +186,150 @@ void ElevationProvider::getElevations(atools::geo::LineString& elevations, const
     pos.setAltitude(std::min(pos.getAltitude(), ALTITUDE_LIMIT_METER));
 }
 
+void ElevationProvider::getElevations(QVector<atools::geo::LineString>& elevations, const QVector<atools::geo::Line>& lines,
+                                      float sampleRadiusMeter)
+{
+  elevations.clear();
+  elevations.resize(lines.size());
+
+  if(!isGlobeOfflineProvider())
+  {
+    // Online data cannot be fetched in parallel
+    for(int i = 0; i < lines.size(); i++)
+      getElevations(elevations[i], lines.at(i), sampleRadiusMeter);
+    return;
+  }
+
+  // Split long lines into chunks to distribute the work evenly =====================
+  struct Chunk
+  {
+    int index; /* Index in lines and elevations */
+    atools::geo::Line line;
+    LineString elevations;
+  };
+
+  QVector<Chunk> chunks;
+  for(int i = 0; i < lines.size(); i++)
+  {
+    const atools::geo::Line& line = lines.at(i);
+    if(!line.isValid())
+      continue;
+
+    float lengthMeter = line.lengthMeter();
+    if(lengthMeter > BATCH_CHUNK_LENGTH_METER)
+    {
+      // Split at multiples of the sample distance to keep the same points as for an unsplit line
+      int numChunks = static_cast<int>(std::ceil(lengthMeter / BATCH_CHUNK_LENGTH_METER));
+      float chunkLength = std::ceil(lengthMeter / numChunks / GlobeMappedReader::SAMPLE_DISTANCE_METER) *
+                          GlobeMappedReader::SAMPLE_DISTANCE_METER;
+      numChunks = static_cast<int>(std::ceil(lengthMeter / chunkLength));
+
+      Pos last = line.getPos1();
+      for(int j = 1; j <= numChunks; j++)
+      {
+        Pos next = j < numChunks ? line.interpolate(lengthMeter, chunkLength * j / lengthMeter) : line.getPos2();
+        chunks.append({i, atools::geo::Line(last, next), LineString()});
+        last = next;
+      }
+    }
+    else
+      chunks.append({i, line, LineString()});
+  }
+
+  // Sample all chunks in parallel using the global thread pool =====================
+  QtConcurrent::blockingMap(chunks, [this, sampleRadiusMeter](Chunk& chunk) -> void {
+    getElevations(chunk.elevations, chunk.line, sampleRadiusMeter);
+  });
+
+  // Join chunks in order and remove the duplicate start point of following chunks
+  for(const Chunk& chunk : qAsConst(chunks))
+  {
+    LineString& result = elevations[chunk.index];
+    for(const Pos& pos : chunk.elevations)
+    {
+      if(result.isEmpty() || !result.constLast().almostEqual(pos))
+        result.append(pos);
+    }
+  }
+}
+
+bool ElevationProvider::getMaxElevationMeter(float& maxElevation, const atools::geo::LineString& geometry, float corridorMeter)
+{
+  std::shared_ptr<GlobeElevationPyramid> currentPyramid = std::atomic_load(&pyramid);
+  if(currentPyramid != nullptr && currentPyramid->getMaxElevationMeter(maxElevation, geometry, corridorMeter))
+  {
+    // Limit ground altitude
+    maxElevation = std::min(maxElevation, ALTITUDE_LIMIT_METER);
+    return true;
+  }
+  return false;
+}
+
+bool ElevationProvider::getMinMaxElevationMeter(float& minElevation, float& maxElevation, const atools::geo::Rect& rect)
+{
+  std::shared_ptr<GlobeElevationPyramid> currentPyramid = std::atomic_load(&pyramid);
+  if(currentPyramid != nullptr && currentPyramid->getMinMaxElevationMeter(minElevation, maxElevation, rect))
+  {
+    maxElevation = std::min(maxElevation, ALTITUDE_LIMIT_METER);
+    return true;
+  }
+  return false;
+}
+
+void ElevationProvider::benchmarkMaxElevation(const QVector<atools::geo::LineString>& geometries, float corridorMeter)
+{
+  // Sample all lines =====================
+  QElapsedTimer timer;
+  timer.start();
+  QVector<float> sampledMax;
+  int numPoints = 0;
+  for(const LineString& geometry : geometries)
+  {
+    QVector<atools::geo::Line> lines;
+    for(int i = 0; i < geometry.size() - 1; i++)
+      lines.append(atools::geo::Line(geometry.at(i), geometry.at(i + 1)));
+
+    QVector<LineString> elevations;
+    getElevations(elevations, lines, corridorMeter);
+
+    float maxElevation = 0.f;
+    for(const LineString& elevation : qAsConst(elevations))
+    {
+      numPoints += elevation.size();
+      for(const Pos& pos : elevation)
+        maxElevation = std::max(maxElevation, pos.getAltitude());
+    }
+    sampledMax.append(maxElevation);
+  }
+  qint64 sampledMs = timer.restart();
+
+  // Query pyramid =====================
+  QVector<float> pyramidMax;
+  for(const LineString& geometry : geometries)
+  {
+    float maxElevation = 0.f;
+    if(!getMaxElevationMeter(maxElevation, geometry, corridorMeter))
+    {
+      qInfo() << Q_FUNC_INFO << "Pyramid not available";
+      return;
+    }
+    pyramidMax.append(maxElevation);
+  }
+  qint64 pyramidMs = timer.elapsed();
+
+  float maxDiff = 0.f;
+  for(int i = 0; i < geometries.size(); i++)
+    maxDiff = std::max(maxDiff, std::abs(pyramidMax.at(i) - sampledMax.at(i)));
+
+  qInfo() << Q_FUNC_INFO << "legs" << geometries.size() << "corridor" << corridorMeter << "m"
+          << "sampled" << sampledMs << "ms" << numPoints << "points"
+          << "pyramid" << pyramidMs << "ms"
+          << "max difference" << maxDiff << "m";
+}
+
 bool ElevationProvider::isGlobeOfflineProvider() const
 {
-  return globeReader != nullptr && globeReader->isValid();
+  return getGlobeReader() != nullptr;
 }
 
 bool ElevationProvider::isGlobeDirValid()
@@ -193,45 +366,76 @@ void ElevationProvider::updateReader(bool startupParam)
   bool useOffline = OptionData::instance().getFlags().testFlag(opts::CACHE_USE_OFFLINE_ELEVATION);
   const QString& path = OptionData::instance().getOfflineElevationPath();
 
+  // Readers are not locked - methods still using the old reader keep it alive until they are done
+  std::shared_ptr<GlobeMappedReader> reader;
+  if(useOffline)
   {
-    // Make sure to wait for other methods to finish before changing the reader
-    QMutexLocker locker(&mutex);
-
-    if(useOffline)
+    if(!GlobeReader::isDirValid(path))
+      warnWrongGlobePath = true;
+    else
     {
-      if(!GlobeReader::isDirValid(path))
+      reader = std::make_shared<GlobeMappedReader>(path);
+
+      qDebug() << Q_FUNC_INFO << "Opening GLOBE files";
+
+      if(!reader->openFiles())
       {
-        warnWrongGlobePath = true;
-        delete globeReader;
-        globeReader = nullptr;
+        reader.reset();
+        warnOpenFiles = true;
       }
       else
-      {
-        delete globeReader;
-        globeReader = new GlobeReader(path);
+        qDebug() << Q_FUNC_INFO << "Opening GLOBE done";
+    }
+  }
 
-        qDebug() << Q_FUNC_INFO << "Opening GLOBE files";
+  std::atomic_store(&globeReader, reader);
 
-        if(!globeReader->openFiles())
-        {
-          delete globeReader;
-          globeReader = nullptr;
-          warnOpenFiles = true;
-        }
-        else
-          qDebug() << Q_FUNC_INFO << "Opening GLOBE done";
-      }
-    }
-    else
-    {
-      delete globeReader;
-      globeReader = nullptr;
-    }
+  // Drop pyramid and load or build a new one in background =====================
+  // Stop a running build since it might write the same file - returns quickly after the current row band
+  cancelPyramid();
+  std::atomic_store(&pyramid, std::shared_ptr<GlobeElevationPyramid>());
+  pyramidReader = reader;
+
+  if(reader != nullptr)
+  {
+    pyramidFuture = QtConcurrent::run(&ElevationProvider::loadPyramid, reader,
+                                      atools::settings::Settings::getConfigFilename(PYRAMID_FILE_SUFFIX), &pyramidCancel);
+    pyramidWatcher.setFuture(pyramidFuture);
   }
 
   emit updateAvailable();
 }
 
+std::shared_ptr<GlobeElevationPyramid> ElevationProvider::loadPyramid(std::shared_ptr<GlobeMappedReader> reader, QString filename,
+                                                                      const std::atomic_bool *cancel)
+{
+  QThread::currentThread()->setPriority(QThread::LowestPriority);
+
+  std::shared_ptr<GlobeElevationPyramid> newPyramid = std::make_shared<GlobeElevationPyramid>(reader);
+  if(!newPyramid->loadOrBuild(filename, *cancel))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot load or build elevation pyramid";
+    newPyramid.reset();
+  }
+  return newPyramid;
+}
+
+void ElevationProvider::pyramidFinished()
+{
+  // Ignore result if options were changed while building
+  if(pyramidReader != nullptr && pyramidReader == std::atomic_load(&globeReader))
+  {
+    std::shared_ptr<GlobeElevationPyramid> newPyramid = pyramidFuture.result();
+    if(newPyramid != nullptr)
+    {
+      std::atomic_store(&pyramid, newPyramid);
+
+      // Let the profile update the maximum elevation
+      emit updateAvailable();
+    }
+  }
+}
+
 void ElevationProvider::showErrors()
 {
   const QString& path = OptionData::instance().getOfflineElevationPath();
@@ -18,24 +18,27 @@
 #ifndef LITTLENAVMAP_ELEVATIONPROVIDER_H
 #define LITTLENAVMAP_ELEVATIONPROVIDER_H
 
+#include <QFutureWatcher>
 #include <QMutex>
 #include <QObject>
+#include <QVector>
+
+#include <atomic>
+#include <memory>
 
 namespace Marble {
 class ElevationModel;
 }
 
-namespace atools {
-namespace fs {
-namespace common {
-class GlobeReader;
-}
-}
+class GlobeMappedReader;
+class GlobeElevationPyramid;
 
+namespace atools {
 namespace geo {
 class Pos;
 class LineString;
 class Line;
+class Rect;
 }
 }
 
@@ -43,7 +46,8 @@ class Line;
  * Wraps the slow Marble online elevation provider and the fast offline GLOBE data provider.
  * Use GLOBE data if all paramters are set properly in settings.
  *
- * Class is thread safe.
+ * Class is thread safe. GLOBE data is memory mapped and sampled without locking which allows
+ * to call the methods from several threads in parallel. Only the Marble online provider is serialized.
  */
 class ElevationProvider :
   public QObject
@@ -67,6 +71,23 @@ public:
    * "sampleRadiusMeter" defines a rectangle where five points are sampled for each pos and the maximum is used.*/
   void getElevations(atools::geo::LineString& elevations, const atools::geo::Line& line, float sampleRadiusMeter = 0.f);
 
+  /* As above for many lines at once. "elevations" is resized to the number of lines and contains the result for each line.
+   * Lines are split into chunks which are sampled in parallel on all cores if offline data is used.
+   * Blocks until all lines are done. Online data is fetched sequentially. */
+  void getElevations(QVector<atools::geo::LineString>& elevations, const QVector<atools::geo::Line>& lines,
+                     float sampleRadiusMeter = 0.f);
+
+  /* Maximum ground elevation in meter of all GLOBE cells within "corridorMeter" of the line string.
+   * Uses the min/max pyramid and returns false if offline data is not used or the pyramid is not built yet. */
+  bool getMaxElevationMeter(float& maxElevation, const atools::geo::LineString& geometry, float corridorMeter);
+
+  /* Conservative minimum and maximum ground elevation in meter for the rectangle. Same conditions as above. */
+  bool getMinMaxElevationMeter(float& minElevation, float& maxElevation, const atools::geo::Rect& rect);
+
+  /* Compare time and result of sampling the geometries with getElevations() against the pyramid corridor query.
+   * Results are printed to the log. For debugging only. */
+  void benchmarkMaxElevation(const QVector<atools::geo::LineString>& geometries, float corridorMeter);
+
   /* true if the data is provided from the fast offline source */
   bool isGlobeOfflineProvider() const;
 
@@ -98,13 +119,39 @@ private:
   void marbleUpdateAvailable();
   void updateReader(bool startupParam);
 
+  /* Called by watcher when the pyramid was loaded or built in background */
+  void pyramidFinished();
+
+  /* Background thread. Load or build pyramid for the reader. */
+  static std::shared_ptr<GlobeElevationPyramid> loadPyramid(std::shared_ptr<GlobeMappedReader> reader, QString filename,
+                                                            const std::atomic_bool *cancel);
+
+  /* Stop a running pyramid build and wait for the thread */
+  void cancelPyramid();
+
+  /* Get current reader or null if not valid. Reader stays valid for the caller even if options are changed. */
+  std::shared_ptr<GlobeMappedReader> getGlobeReader() const;
+
   const Marble::ElevationModel *marbleModel = nullptr;
-  atools::fs::common::GlobeReader *globeReader = nullptr;
+
+  /* Replaced atomically on options change. Access only using std::atomic_load and std::atomic_store. */
+  std::shared_ptr<GlobeMappedReader> globeReader;
+
+  /* Min/max pyramid for current reader. Null while building. Same access rules as for reader. */
+  std::shared_ptr<GlobeElevationPyramid> pyramid;
+
+  /* Reader used for the pyramid building in background. Result is dropped if reader changed in the meantime. */
+  std::shared_ptr<GlobeMappedReader> pyramidReader;
+  QFuture<std::shared_ptr<GlobeElevationPyramid> > pyramidFuture;
+  QFutureWatcher<std::shared_ptr<GlobeElevationPyramid> > pyramidWatcher;
+
+  /* Set to stop the pyramid build. Checked by the build for each row band. */
+  std::atomic_bool pyramidCancel;
 
   bool warnWrongGlobePath = false, warnOpenFiles = false, startup = false;
 
-  /* Need to synchronize here since it is called from profile widget thread */
-  mutable QMutex mutex;
+  /* Marble elevation model is not thread safe and is called from the profile widget thread */
+  mutable QMutex marbleMutex;
 
 };
 
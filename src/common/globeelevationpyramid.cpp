@@ -0,0 +1,446 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "common/globeelevationpyramid.h"
+
+#include "atools.h"
+#include "common/globemappedreader.h"
+#include "fs/common/globereader.h"
+#include "geo/linestring.h"
+#include "geo/rect.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringBuilder>
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <limits>
+#include <numeric>
+#include <queue>
+
+using atools::geo::Pos;
+using atools::geo::LineString;
+using atools::geo::Rect;
+
+/* Number of GLOBE cells covered by one level 0 cell in each direction */
+static Q_DECL_CONSTEXPR int LEVEL0_BLOCK_CELLS = 8;
+
+/* Stop adding levels once the grid has this number of columns or less */
+static Q_DECL_CONSTEXPR int TOP_LEVEL_MAX_COLUMNS = 8;
+
+/* Select the level for rectangle queries so that the rectangle covers about this number of cells per direction */
+static Q_DECL_CONSTEXPR int RECT_QUERY_CELLS = 4;
+
+static Q_DECL_CONSTEXPR quint32 FILE_MAGIC_NUMBER = 0x4C4E4D50;
+static Q_DECL_CONSTEXPR quint32 FILE_VERSION = 1;
+
+/* Alignment of cell data in the file */
+static Q_DECL_CONSTEXPR qint64 FILE_DATA_ALIGNMENT = 16;
+
+namespace {
+
+/* Node for best first search. Level -1 is a GLOBE cell. */
+struct Node
+{
+  qint16 maxElevation;
+  int level, row, column;
+
+  bool operator<(const Node& other) const
+  {
+    return maxElevation < other.maxElevation;
+  }
+
+};
+
+/* Elevation from reader with ocean and invalid values replaced by zero */
+qint16 cellValue(const GlobeMappedReader *reader, int row, int column)
+{
+  float elevation = reader->getCellElevation(row, column);
+  if(!(elevation > atools::fs::common::OCEAN && elevation < atools::fs::common::INVALID))
+    return 0;
+  else
+    return static_cast<qint16>(elevation);
+}
+
+/* true if a cell covering "blockCells" GLOBE cells might touch the corridor around the geometry */
+bool cellInCorridor(int blockCells, int row, int column, const LineString& geometry, float corridorMeter)
+{
+  float cellSizeDeg = static_cast<float>(blockCells) / GlobeMappedReader::CELLS_PER_DEGREE;
+  float west = -180.f + column * cellSizeDeg;
+  float north = 90.f - row * cellSizeDeg;
+  float east = std::min(west + cellSizeDeg, 180.f);
+  float south = std::max(north - cellSizeDeg, -90.f);
+
+  // Circle around the cell which contains all corners
+  Pos center((west + east) / 2.f, (north + south) / 2.f);
+  float radiusMeter = std::max(center.distanceMeterTo(Pos(west, north)), center.distanceMeterTo(Pos(west, south)));
+
+  atools::geo::LineDistance result;
+  geometry.distanceMeterToLineString(center, result);
+  float distMeter = result.status != atools::geo::INVALID ? std::abs(result.distance) : center.distanceMeterTo(geometry.constFirst());
+
+  return distMeter <= corridorMeter + radiusMeter;
+}
+
+}
+
+GlobeElevationPyramid::GlobeElevationPyramid(const std::shared_ptr<GlobeMappedReader>& readerParam)
+  : reader(readerParam)
+{
+  initLevels();
+}
+
+GlobeElevationPyramid::~GlobeElevationPyramid()
+{
+  // Closing also unmaps the memory
+  delete file;
+}
+
+void GlobeElevationPyramid::initLevels()
+{
+  levels.clear();
+
+  qint64 offset = 0;
+  int blockCells = LEVEL0_BLOCK_CELLS;
+  while(true)
+  {
+    Level level;
+    level.blockCells = blockCells;
+    level.rows = (GlobeMappedReader::GRID_ROWS + blockCells - 1) / blockCells;
+    level.columns = (GlobeMappedReader::GRID_COLUMNS + blockCells - 1) / blockCells;
+    level.offset = offset;
+    levels.append(level);
+
+    if(level.columns <= TOP_LEVEL_MAX_COLUMNS)
+      break;
+
+    offset += static_cast<qint64>(level.rows) * level.columns;
+    blockCells *= 2;
+  }
+}
+
+qint64 GlobeElevationPyramid::numCells() const
+{
+  const Level& top = levels.constLast();
+  return top.offset + static_cast<qint64>(top.rows) * top.columns;
+}
+
+QString GlobeElevationPyramid::sourceKey() const
+{
+  QStringList key;
+  for(const QString& filename : reader->getFilenames())
+  {
+    QFileInfo fileinfo(filename);
+    key.append(fileinfo.fileName() % ":" % QString::number(fileinfo.size()) % ":" %
+               QString::number(fileinfo.lastModified().toMSecsSinceEpoch()));
+  }
+  return key.join("|");
+}
+
+bool GlobeElevationPyramid::loadOrBuild(const QString& filename, const std::atomic_bool& cancel)
+{
+  if(reader == nullptr || !reader->isValid())
+    return false;
+
+  QString key = sourceKey();
+  if(load(filename, key))
+    return true;
+
+  QElapsedTimer timer;
+  timer.start();
+  if(!build(cancel))
+  {
+    // Drop partial data and the outdated file which does not match the GLOBE files anyway
+    qDebug() << Q_FUNC_INFO << "Building pyramid cancelled after" << timer.elapsed() << "ms";
+    buffer.clear();
+    buffer.squeeze();
+    QFile::remove(filename);
+    return false;
+  }
+  qDebug() << Q_FUNC_INFO << "Building pyramid with" << levels.size() << "levels took" << timer.elapsed() << "ms";
+
+  // Save and map file to avoid keeping the buffer in memory
+  if(save(filename, key) && load(filename, key))
+  {
+    buffer.clear();
+    buffer.squeeze();
+  }
+
+  return isValid();
+}
+
+bool GlobeElevationPyramid::build(const std::atomic_bool& cancel)
+{
+  buffer.resize(static_cast<int>(numCells() * 2));
+  qint16 *data = buffer.data();
+  const GlobeMappedReader *globeReader = reader.get();
+
+  for(int levelIndex = 0; levelIndex < levels.size(); levelIndex++)
+  {
+    const Level& level = levels.at(levelIndex);
+    qint16 *levelData = data + level.offset * 2;
+
+    // Level below or null for level 0 which is built from GLOBE cells
+    const Level *lower = levelIndex > 0 ? &levels.at(levelIndex - 1) : nullptr;
+    const qint16 *lowerData = lower != nullptr ? data + lower->offset * 2 : nullptr;
+
+    QVector<int> rows(level.rows);
+    std::iota(rows.begin(), rows.end(), 0);
+
+    // Calculate all rows in parallel - skip remaining row bands if cancelled
+    QtConcurrent::blockingMap(rows, [&level, levelData, lower, lowerData, globeReader, &cancel](int& row) -> void {
+      if(cancel.load())
+        return;
+
+      for(int column = 0; column < level.columns; column++)
+      {
+        qint16 minElevation = std::numeric_limits<qint16>::max(), maxElevation = std::numeric_limits<qint16>::min();
+
+        if(lower == nullptr)
+        {
+          // Combine GLOBE cells
+          int rowEnd = std::min((row + 1) * level.blockCells, static_cast<int>(GlobeMappedReader::GRID_ROWS));
+          int columnEnd = std::min((column + 1) * level.blockCells, static_cast<int>(GlobeMappedReader::GRID_COLUMNS));
+          for(int r = row * level.blockCells; r < rowEnd; r++)
+          {
+            for(int c = column * level.blockCells; c < columnEnd; c++)
+            {
+              qint16 value = cellValue(globeReader, r, c);
+              minElevation = std::min(minElevation, value);
+              maxElevation = std::max(maxElevation, value);
+            }
+          }
+        }
+        else
+        {
+          // Combine 2 x 2 cells of the level below
+          for(int r = row * 2; r < std::min(row * 2 + 2, lower->rows); r++)
+          {
+            for(int c = column * 2; c < std::min(column * 2 + 2, lower->columns); c++)
+            {
+              const qint16 *lowerCell = lowerData + (static_cast<qint64>(r) * lower->columns + c) * 2;
+              minElevation = std::min(minElevation, lowerCell[0]);
+              maxElevation = std::max(maxElevation, lowerCell[1]);
+            }
+          }
+        }
+
+        qint16 *cell = levelData + (static_cast<qint64>(row) * level.columns + column) * 2;
+        cell[0] = minElevation;
+        cell[1] = maxElevation;
+      }
+    });
+
+    if(cancel.load())
+      return false;
+  }
+
+  cells = buffer.constData();
+  return true;
+}
+
+bool GlobeElevationPyramid::save(const QString& filename, const QString& key) const
+{
+  QFile out(filename);
+  if(!out.open(QIODevice::WriteOnly))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open" << filename << out.errorString();
+    return false;
+  }
+
+  QDataStream stream(&out);
+  stream << FILE_MAGIC_NUMBER << FILE_VERSION << key << numCells();
+
+  // Align data for mapping
+  while(out.pos() % FILE_DATA_ALIGNMENT != 0)
+    stream << static_cast<quint8>(0);
+
+  // Cell data is written in host byte order
+  qint64 size = numCells() * 2 * static_cast<qint64>(sizeof(qint16));
+  if(out.write(reinterpret_cast<const char *>(cells), size) != size)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot write" << filename << out.errorString();
+    out.close();
+    out.remove();
+    return false;
+  }
+
+  out.close();
+  qDebug() << Q_FUNC_INFO << "Saved" << filename;
+  return true;
+}
+
+bool GlobeElevationPyramid::load(const QString& filename, const QString& key)
+{
+  if(!QFile::exists(filename))
+    return false;
+
+  QFile *in = new QFile(filename);
+  if(!in->open(QIODevice::ReadOnly))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open" << filename << in->errorString();
+    delete in;
+    return false;
+  }
+
+  quint32 magic = 0, version = 0;
+  QString fileKey;
+  qint64 fileNumCells = 0;
+  QDataStream stream(in);
+  stream >> magic >> version >> fileKey >> fileNumCells;
+
+  qint64 offset = in->pos();
+  if(offset % FILE_DATA_ALIGNMENT != 0)
+    offset += FILE_DATA_ALIGNMENT - offset % FILE_DATA_ALIGNMENT;
+  qint64 size = numCells() * 2 * static_cast<qint64>(sizeof(qint16));
+
+  if(stream.status() != QDataStream::Ok || magic != FILE_MAGIC_NUMBER || version != FILE_VERSION || fileKey != key ||
+     fileNumCells != numCells() || in->size() != offset + size)
+  {
+    qDebug() << Q_FUNC_INFO << "Outdated or invalid" << filename;
+    delete in;
+    return false;
+  }
+
+  const uchar *mapped = in->map(offset, size);
+  if(mapped == nullptr)
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot map" << filename << in->errorString();
+    delete in;
+    return false;
+  }
+
+  delete file;
+  file = in;
+  cells = reinterpret_cast<const qint16 *>(mapped);
+  qDebug() << Q_FUNC_INFO << "Loaded" << filename;
+  return true;
+}
+
+bool GlobeElevationPyramid::getMaxElevationMeter(float& maxElevation, const LineString& geometry, float corridorMeter) const
+{
+  maxElevation = 0.f;
+  if(!isValid() || geometry.isEmpty())
+    return false;
+
+  // Start with all cells of the top level touching the corridor
+  std::priority_queue<Node> queue;
+  int topLevel = levels.size() - 1;
+  const Level& top = levels.at(topLevel);
+  for(int row = 0; row < top.rows; row++)
+  {
+    for(int column = 0; column < top.columns; column++)
+    {
+      if(cellInCorridor(top.blockCells, row, column, geometry, corridorMeter))
+        queue.push({levelCells(topLevel)[(row * top.columns + column) * 2 + 1], topLevel, row, column});
+    }
+  }
+
+  // Always expand the cell with the highest maximum. The first GLOBE cell taken from the queue is the result.
+  while(!queue.empty())
+  {
+    Node node = queue.top();
+    queue.pop();
+
+    if(node.level < 0)
+    {
+      maxElevation = node.maxElevation;
+      return true;
+    }
+
+    const Level& level = levels.at(node.level);
+    if(node.level == 0)
+    {
+      // Add GLOBE cells of block
+      int rowEnd = std::min((node.row + 1) * level.blockCells, static_cast<int>(GlobeMappedReader::GRID_ROWS));
+      int columnEnd = std::min((node.column + 1) * level.blockCells, static_cast<int>(GlobeMappedReader::GRID_COLUMNS));
+      for(int row = node.row * level.blockCells; row < rowEnd; row++)
+      {
+        for(int column = node.column * level.blockCells; column < columnEnd; column++)
+        {
+          if(cellInCorridor(1, row, column, geometry, corridorMeter))
+            queue.push({cellValue(reader.get(), row, column), -1, row, column});
+        }
+      }
+    }
+    else
+    {
+      // Add 2 x 2 cells of level below
+      int lowerIndex = node.level - 1;
+      const Level& lower = levels.at(lowerIndex);
+      const qint16 *lowerData = levelCells(lowerIndex);
+      for(int row = node.row * 2; row < std::min(node.row * 2 + 2, lower.rows); row++)
+      {
+        for(int column = node.column * 2; column < std::min(node.column * 2 + 2, lower.columns); column++)
+        {
+          if(cellInCorridor(lower.blockCells, row, column, geometry, corridorMeter))
+            queue.push({lowerData[(static_cast<qint64>(row) * lower.columns + column) * 2 + 1], lowerIndex, row, column});
+        }
+      }
+    }
+  }
+
+  // No cell found - can only happen for invalid geometry
+  return true;
+}
+
+bool GlobeElevationPyramid::getMinMaxElevationMeter(float& minElevation, float& maxElevation, const Rect& rect) const
+{
+  minElevation = maxElevation = 0.f;
+  if(!isValid() || !rect.isValid())
+    return false;
+
+  qint16 minValue = std::numeric_limits<qint16>::max(), maxValue = std::numeric_limits<qint16>::min();
+  const QList<Rect> rects = rect.crossesAntiMeridian() ? rect.splitAtAntiMeridian() : QList<Rect>({rect});
+  for(const Rect& r : rects)
+  {
+    // Find finest level where the rectangle covers only a few cells
+    int levelIndex = 0;
+    float sizeDeg = std::max(r.getWidthDegree(), r.getHeightDegree());
+    while(levelIndex < levels.size() - 1 &&
+          static_cast<float>(levels.at(levelIndex).blockCells) / GlobeMappedReader::CELLS_PER_DEGREE * RECT_QUERY_CELLS < sizeDeg)
+      levelIndex++;
+
+    const Level& level = levels.at(levelIndex);
+    const qint16 *data = levelCells(levelIndex);
+    float cellsPerDegree = static_cast<float>(GlobeMappedReader::CELLS_PER_DEGREE) / level.blockCells;
+
+    int columnStart = atools::minmax(0, level.columns - 1, static_cast<int>((r.getWest() + 180.f) * cellsPerDegree));
+    int columnEnd = atools::minmax(0, level.columns - 1, static_cast<int>((r.getEast() + 180.f) * cellsPerDegree));
+    int rowStart = atools::minmax(0, level.rows - 1, static_cast<int>((90.f - r.getNorth()) * cellsPerDegree));
+    int rowEnd = atools::minmax(0, level.rows - 1, static_cast<int>((90.f - r.getSouth()) * cellsPerDegree));
+
+    for(int row = rowStart; row <= rowEnd; row++)
+    {
+      for(int column = columnStart; column <= columnEnd; column++)
+      {
+        const qint16 *cell = data + (static_cast<qint64>(row) * level.columns + column) * 2;
+        minValue = std::min(minValue, cell[0]);
+        maxValue = std::max(maxValue, cell[1]);
+      }
+    }
+  }
+
+  minElevation = minValue;
+  maxElevation = maxValue;
+  return true;
+}
@@ -0,0 +1,113 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LNM_GLOBEELEVATIONPYRAMID_H
+#define LNM_GLOBEELEVATIONPYRAMID_H
+
+#include <QVector>
+
+#include <atomic>
+#include <memory>
+
+class GlobeMappedReader;
+class QFile;
+
+namespace atools {
+namespace geo {
+class LineString;
+class Rect;
+}
+}
+
+/*
+ * Minimum and maximum elevation pyramid over the whole GLOBE grid.
+ *
+ * Level 0 covers blocks of 8 x 8 GLOBE cells and each further level combines 2 x 2 cells of the level below
+ * until the whole world is covered by a few cells. Ocean is stored as zero.
+ *
+ * The pyramid is built once in parallel and saved to a file in the configuration directory which is memory mapped
+ * on later runs. It is rebuilt if the GLOBE files change.
+ *
+ * Corridor queries use a best first search which descends only into cells that can raise the maximum and
+ * touch the corridor. The search ends on the GLOBE cells of the reader which gives the exact result.
+ *
+ * Class is thread safe after loadOrBuild() returned true.
+ */
+class GlobeElevationPyramid
+{
+public:
+  explicit GlobeElevationPyramid(const std::shared_ptr<GlobeMappedReader>& readerParam);
+  ~GlobeElevationPyramid();
+
+  GlobeElevationPyramid(const GlobeElevationPyramid& other) = delete;
+  GlobeElevationPyramid& operator=(const GlobeElevationPyramid& other) = delete;
+
+  /* Load pyramid from file if built for the same GLOBE files. Otherwise build and save it.
+   * Blocking and slow on first run. Call in background thread.
+   * Building stops and returns false without saving a file if "cancel" is set. */
+  bool loadOrBuild(const QString& filename, const std::atomic_bool& cancel);
+
+  bool isValid() const
+  {
+    return cells != nullptr;
+  }
+
+  /* Maximum ground elevation in meter of all GLOBE cells within "corridorMeter" of the line string.
+   * Returns false if not valid. */
+  bool getMaxElevationMeter(float& maxElevation, const atools::geo::LineString& geometry, float corridorMeter) const;
+
+  /* Minimum and maximum ground elevation in meter for all pyramid cells overlapping the rectangle.
+   * Result is conservative since coarse cells can extend beyond the rectangle. Returns false if not valid. */
+  bool getMinMaxElevationMeter(float& minElevation, float& maxElevation, const atools::geo::Rect& rect) const;
+
+private:
+  struct Level
+  {
+    int rows, columns,
+        blockCells; /* Number of GLOBE cells covered by one cell in each direction */
+    qint64 offset; /* Offset in cells array in min/max pairs */
+  };
+
+  /* Create level layout for the whole GLOBE grid */
+  void initLevels();
+  /* Returns false if cancelled. Buffer content is undefined in this case. */
+  bool build(const std::atomic_bool& cancel);
+  bool load(const QString& filename, const QString& key);
+  bool save(const QString& filename, const QString& key) const;
+
+  /* Key identifying the GLOBE files to detect changes */
+  QString sourceKey() const;
+
+  const qint16 *levelCells(int level) const
+  {
+    return cells + levels.at(level).offset * 2;
+  }
+
+  /* Size of all levels in min/max pairs */
+  qint64 numCells() const;
+
+  std::shared_ptr<GlobeMappedReader> reader;
+  QVector<Level> levels;
+
+  /* Min/max pairs for all levels. Points either into the mapped file or buffer. */
+  const qint16 *cells = nullptr;
+  QVector<qint16> buffer;
+  QFile *file = nullptr;
+};
+
+#endif // LNM_GLOBEELEVATIONPYRAMID_H
@@ -0,0 +1,217 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "common/globemappedreader.h"
+
+#include "atools.h"
+#include "fs/common/globereader.h"
+#include "geo/calculations.h"
+#include "geo/line.h"
+#include "geo/linestring.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QtEndian>
+
+#include <cmath>
+
+using atools::geo::Pos;
+using atools::geo::Line;
+using atools::geo::LineString;
+
+/* Number of columns for all tiles */
+static Q_DECL_CONSTEXPR int TILE_COLUMNS = 10800;
+static Q_DECL_CONSTEXPR int TILES_PER_ROW = 4;
+static Q_DECL_CONSTEXPR int NUM_TILES = 16;
+
+/* Tile rows for a-d, e-h, i-l and m-p from north to south and first grid row of each band */
+static const int BAND_ROWS[4] = {4800, 6000, 6000, 4800};
+static const int BAND_START_ROW[4] = {0, 4800, 10800, 16800};
+
+static Q_DECL_CONSTEXPR qint16 GLOBE_OCEAN = -500;
+
+GlobeMappedReader::GlobeMappedReader(const QString& dataDirParam)
+  : dataDir(dataDirParam)
+{
+}
+
+GlobeMappedReader::~GlobeMappedReader()
+{
+  closeFiles();
+}
+
+bool GlobeMappedReader::openFiles()
+{
+  closeFiles();
+
+  QDir dir(dataDir);
+  const QStringList entries = dir.entryList(QDir::Files);
+
+  files.fill(nullptr, NUM_TILES);
+  tiles.fill(nullptr, NUM_TILES);
+
+  for(int i = 0; i < NUM_TILES; i++)
+  {
+    // Look for "a10g" to "p10g" ignoring case and allowing an extension
+    QString name = QString(QChar('a' + i)) + "10g";
+    QString filename;
+    for(const QString& entry : entries)
+    {
+      if(entry.compare(name, Qt::CaseInsensitive) == 0 || entry.startsWith(name + ".", Qt::CaseInsensitive))
+      {
+        filename = dir.filePath(entry);
+        break;
+      }
+    }
+
+    if(filename.isEmpty())
+    {
+      qWarning() << Q_FUNC_INFO << "GLOBE file" << name << "not found in" << dataDir;
+      closeFiles();
+      return false;
+    }
+
+    qint64 expectedSize = static_cast<qint64>(BAND_ROWS[i / TILES_PER_ROW]) * TILE_COLUMNS * 2;
+    QFile *file = new QFile(filename);
+    files[i] = file;
+
+    if(!file->open(QIODevice::ReadOnly))
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot open" << filename << file->errorString();
+      closeFiles();
+      return false;
+    }
+
+    if(file->size() != expectedSize)
+    {
+      qWarning() << Q_FUNC_INFO << "Wrong size for" << filename << file->size() << "expected" << expectedSize;
+      closeFiles();
+      return false;
+    }
+
+    tiles[i] = file->map(0, expectedSize);
+    if(tiles.at(i) == nullptr)
+    {
+      qWarning() << Q_FUNC_INFO << "Cannot map" << filename << file->errorString();
+      closeFiles();
+      return false;
+    }
+    filenames.append(filename);
+  }
+
+  valid = true;
+  return true;
+}
+
+void GlobeMappedReader::closeFiles()
+{
+  valid = false;
+
+  // Closing also unmaps the memory
+  qDeleteAll(files);
+  files.clear();
+  tiles.clear();
+  filenames.clear();
+}
+
+float GlobeMappedReader::cellElevation(const Pos& pos) const
+{
+  if(!valid || !pos.isValid())
+    return atools::fs::common::INVALID;
+
+  int column = atools::minmax(0, GRID_COLUMNS - 1, static_cast<int>((pos.getLonX() + 180.f) * CELLS_PER_DEGREE));
+  int row = atools::minmax(0, GRID_ROWS - 1, static_cast<int>((90.f - pos.getLatY()) * CELLS_PER_DEGREE));
+  return getCellElevation(row, column);
+}
+
+float GlobeMappedReader::getCellElevation(int row, int column) const
+{
+  // Find band from north to south
+  int band = 3;
+  while(band > 0 && row < BAND_START_ROW[band])
+    band--;
+
+  const uchar *tile = tiles.at(band * TILES_PER_ROW + column / TILE_COLUMNS);
+  qint64 offset = (static_cast<qint64>(row - BAND_START_ROW[band]) * TILE_COLUMNS + column % TILE_COLUMNS) * 2;
+
+  qint16 value = qFromLittleEndian<qint16>(tile + offset);
+  return value == GLOBE_OCEAN ? atools::fs::common::OCEAN : static_cast<float>(value);
+}
+
+float GlobeMappedReader::getElevation(const Pos& pos, float sampleRadiusMeter) const
+{
+  float elevation = cellElevation(pos);
+
+  if(sampleRadiusMeter > 0.f)
+  {
+    // Sample the corners of the rectangle and use the maximum
+    for(float angle : {45.f, 135.f, 225.f, 315.f})
+    {
+      float sample = cellElevation(pos.endpoint(sampleRadiusMeter, angle));
+      if(sample < atools::fs::common::INVALID && (elevation >= atools::fs::common::INVALID || sample > elevation))
+        elevation = sample;
+    }
+  }
+  return elevation;
+}
+
+void GlobeMappedReader::getElevations(LineString& elevations, const LineString& linestring, float sampleRadiusMeter) const
+{
+  Pos lastDropped;
+  for(int i = 0; i < linestring.size() - 1; i++)
+  {
+    Line line(linestring.at(i), linestring.at(i + 1));
+    float lengthMeter = line.lengthMeter();
+
+    // Points along great circle excluding the last one
+    LineString positions;
+    int numPoints = std::max(1, static_cast<int>(std::ceil(lengthMeter / SAMPLE_DISTANCE_METER)));
+    line.interpolatePoints(lengthMeter, numPoints, positions);
+
+    // Add end of line string
+    if(i == linestring.size() - 2)
+      positions.append(line.getPos2());
+
+    for(Pos& pos : positions)
+    {
+      pos.setAltitude(getElevation(pos, sampleRadiusMeter));
+
+      if(!elevations.isEmpty())
+      {
+        if(atools::almostEqual(elevations.constLast().getAltitude(), pos.getAltitude()))
+        {
+          // Drop points with same altitude
+          lastDropped = pos;
+          continue;
+        }
+        else if(lastDropped.isValid())
+        {
+          // Add last point of a stretch with same altitude
+          elevations.append(lastDropped);
+          lastDropped = Pos();
+        }
+      }
+      elevations.append(pos);
+    }
+  }
+
+  // Add last point if dropped
+  if(lastDropped.isValid())
+    elevations.append(lastDropped);
+}
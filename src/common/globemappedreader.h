@@ -0,0 +1,104 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LNM_GLOBEMAPPEDREADER_H
+#define LNM_GLOBEMAPPEDREADER_H
+
+#include <QStringList>
+#include <QVector>
+
+class QFile;
+
+namespace atools {
+namespace geo {
+class Pos;
+class LineString;
+}
+}
+
+/*
+ * Reads elevation data from the 16 GLOBE tiles "a10g" to "p10g" which are memory mapped read only.
+ *
+ * Tiles contain signed 16 bit little endian values in meter with a resolution of 30 arc seconds.
+ * -500 is used for ocean.
+ *
+ * Class is thread safe after openFiles() returned true. No locking is done for sampling.
+ * Returns the same indicator values atools::fs::common::OCEAN and atools::fs::common::INVALID as the GlobeReader.
+ */
+class GlobeMappedReader
+{
+public:
+  explicit GlobeMappedReader(const QString& dataDirParam);
+  ~GlobeMappedReader();
+
+  GlobeMappedReader(const GlobeMappedReader& other) = delete;
+  GlobeMappedReader& operator=(const GlobeMappedReader& other) = delete;
+
+  /* Open and map all tiles. Returns false if a tile is missing, has a wrong size or cannot be mapped. */
+  bool openFiles();
+
+  /* true if all tiles are mapped */
+  bool isValid() const
+  {
+    return valid;
+  }
+
+  /* Elevation in meter. "sampleRadiusMeter" defines a rectangle where five points are sampled and the maximum is used. */
+  float getElevation(const atools::geo::Pos& pos, float sampleRadiusMeter = 0.f) const;
+
+  /* Get elevations along all great circle segments of the line string. Creates a point every SAMPLE_DISTANCE_METER
+   * and deletes consecutive ones with same elevation. Elevation in meter. */
+  void getElevations(atools::geo::LineString& elevations, const atools::geo::LineString& linestring,
+                     float sampleRadiusMeter = 0.f) const;
+
+  /* Elevation in meter for a grid cell without any checks. Row 0 is at 90° north and column 0 at 180° west.
+   * Returns atools::fs::common::OCEAN for ocean. */
+  float getCellElevation(int row, int column) const;
+
+  /* Full paths of all tile files ordered from "a10g" to "p10g". Empty if not valid. */
+  const QStringList& getFilenames() const
+  {
+    return filenames;
+  }
+
+  /* Distance between elevation points in getElevations() */
+  static Q_DECL_CONSTEXPR float SAMPLE_DISTANCE_METER = 500.f;
+
+  /* Grid cells per degree - 30 arc seconds */
+  static Q_DECL_CONSTEXPR int CELLS_PER_DEGREE = 120;
+
+  /* Total grid size */
+  static Q_DECL_CONSTEXPR int GRID_COLUMNS = 360 * CELLS_PER_DEGREE;
+  static Q_DECL_CONSTEXPR int GRID_ROWS = 180 * CELLS_PER_DEGREE;
+
+private:
+  void closeFiles();
+
+  /* Raw value for the grid cell containing pos */
+  float cellElevation(const atools::geo::Pos& pos) const;
+
+  QString dataDir;
+  QStringList filenames;
+  bool valid = false;
+
+  /* Index is tile letter a-p. Mapped memory is valid as long as the files are open. */
+  QVector<QFile *> files;
+  QVector<const uchar *> tiles;
+};
+
+#endif // LNM_GLOBEMAPPEDREADER_H
@@ -27,6 +27,10 @@
 class Route;
 
 namespace map { class WeatherContext; }
+namespace routebatch {
+    struct Result;
+    struct Statistics;
+}
 namespace atools {
     namespace sql {
         class SqlRecord;
@@ -99,6 +103,14 @@ namespace InfoBuilderTypes {
         const QList<map::MapWaypoint> waypoints;
     };
 
+    /**
+     * @brief Data container for batch flight plan calculation results
+     */
+    struct RouteBatchData{
+        const QVector<routebatch::Result>* results;
+        const routebatch::Statistics* statistics;
+    };
+
 }
 
 #endif // INFOBUILDERTYPES_H
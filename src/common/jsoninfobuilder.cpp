@@ -17,6 +17,7 @@
 
 #include "common/jsoninfobuilder.h"
 #include "common/infobuildertypes.h"
+#include "route/routebatch.h"
 
 #include "sql/sqlrecord.h"
 #include "weather/weathercontext.h"
@@ -333,6 +334,44 @@ QByteArray JsonInfoBuilder::uiinfo(UiInfoData uiInfoData) const
     return json.dump().data();
 }
 
+QByteArray JsonInfoBuilder::routebatch(RouteBatchData routeBatchData) const
+{
+
+    const routebatch::Statistics& stats = *routeBatchData.statistics;
+
+    JSON json;
+
+       json = {
+           { "statistics", {
+                 { "routes", stats.numRoutes },
+                 { "found", stats.numFound },
+                 { "threads", stats.numWorkers },
+                 { "total_time_ms", stats.totalTimeMs },
+                 { "sum_calculation_time_ms", stats.sumCalcTimeMs },
+                 { "max_calculation_time_ms", stats.maxCalcTimeMs },
+             } },
+           { "routes", JSON::array() },
+       };
+
+       for(const routebatch::Result& result : *routeBatchData.results){
+           json["routes"].push_back({
+               { "departure", qUtf8Printable(result.entry.departureIdent) },
+               { "destination", qUtf8Printable(result.entry.destinationIdent) },
+               { "altitude", result.entry.altitudeFt },
+               { "mode", qUtf8Printable(result.entry.mode) },
+               { "found", result.found },
+               { "error", qUtf8Printable(result.error) },
+               { "distance", result.distanceNm },
+               { "route", qUtf8Printable(result.routeString) },
+               { "lnmpln", qUtf8Printable(result.lnmpln) },
+               { "load_time_ms", result.loadTimeMs },
+               { "calculation_time_ms", result.calcTimeMs },
+           });
+       }
+
+    return json.dump().data();
+}
+
 QByteArray JsonInfoBuilder::features(MapFeaturesData mapFeaturesData) const
 {
 
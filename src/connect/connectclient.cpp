@@ -19,6 +19,7 @@
 
 #include "app/navapp.h"
 #include "common/constants.h"
+#include "connect/simdatarecorder.h"
 #include "fs/sc/simconnectreply.h"
 #include "fs/sc/datareaderthread.h"
 #include "gui/dialog.h"
@@ -50,6 +51,12 @@ const static int FLUSH_QUEUE_MS = 50;
 const static int WEATHER_TIMEOUT_FS_SECS = 15;
 const static int NOT_AVAILABLE_TIMEOUT_FS_SECS = 300;
 
+/* Log packet statistics every ten seconds if enabled */
+const static qint64 PACKET_STATISTICS_INTERVAL_MS = 10000L;
+
+/* Remove cached AI aircraft names not seen within this number of packets */
+const static qint64 AIRCRAFT_NAMES_CLEANUP_PACKETS = 500L;
+
 ConnectClient::ConnectClient(MainWindow *parent)
   : QObject(parent), mainWindow(parent), metarIdentCache(WEATHER_TIMEOUT_FS_SECS), notAvailableStations(NOT_AVAILABLE_TIMEOUT_FS_SECS),
 
@@ -58,6 +65,11 @@ ConnectClient::ConnectClient(MainWindow *parent)
 {
   atools::settings::Settings& settings = atools::settings::Settings::instance();
   verbose = settings.getAndStoreValue(lnm::OPTIONS_CONNECTCLIENT_DEBUG, false).toBool();
+  packetStatistics = settings.getAndStoreValue(lnm::OPTIONS_SIM_DATA_STATISTICS_DEBUG, false).toBool();
+
+  // Needed before receivers are connected
+  if(!NavApp::getStartupOptionStr(lnm::STARTUP_SIM_REPLAY_BENCHMARK).isEmpty())
+    benchmark = new SimDataBenchmark;
 
   errorMessageBox = new QMessageBox(QMessageBox::Critical, QApplication::applicationName(), QString(), QMessageBox::Ok, mainWindow);
 
@@ -117,6 +129,9 @@ ConnectClient::~ConnectClient()
 
   disconnectClicked();
 
+  ATOOLS_DELETE_LOG(replay);
+  ATOOLS_DELETE_LOG(recorder);
+  ATOOLS_DELETE_LOG(benchmark);
   ATOOLS_DELETE_LOG(dataReader);
   ATOOLS_DELETE_LOG(simConnectHandler);
   ATOOLS_DELETE_LOG(xpConnectHandler);
@@ -168,6 +183,10 @@ void ConnectClient::connectToServerDialog()
 
 void ConnectClient::tryConnectOnStartup()
 {
+  if(startRecordOrReplayStartup())
+    // Replay replaces simulator connection
+    return;
+
   if(connectDialog->isAutoConnect())
   {
     reconnectNetworkTimer.stop();
@@ -178,6 +197,102 @@ void ConnectClient::tryConnectOnStartup()
   }
 }
 
+void ConnectClient::translateAircraftNames(atools::fs::sc::SimConnectAircraft& aircraft, connectclient::AircraftNames& names)
+{
+  names.lastPacket = aircraftNamesPacket;
+
+  // Translate again only if the simulator sends other names for this object
+  if(names.type != aircraft.getAirplaneType() || names.airline != aircraft.getAirplaneAirline() ||
+     names.title != aircraft.getAirplaneTitle() || names.model != aircraft.getAirplaneModel())
+  {
+    const atools::fs::scenery::LanguageJson& languageIndex = NavApp::getLanguageIndex();
+    names.type = aircraft.getAirplaneType();
+    names.airline = aircraft.getAirplaneAirline();
+    names.title = aircraft.getAirplaneTitle();
+    names.model = aircraft.getAirplaneModel();
+
+    names.typeTr = languageIndex.getName(names.type);
+    names.airlineTr = languageIndex.getName(names.airline);
+    names.titleTr = languageIndex.getName(names.title);
+    names.modelTr = languageIndex.getName(names.model);
+  }
+
+  aircraft.updateAircraftNames(names.typeTr, names.airlineTr, names.titleTr, names.modelTr);
+}
+
+void ConnectClient::clearAircraftNameCache()
+{
+  aiAircraftNames.clear();
+  userAircraftNames = connectclient::AircraftNames();
+  aircraftNamesPacket = 0L;
+  aircraftCfgKeyCached.clear();
+  icaoTypeDesignatorCached.clear();
+}
+
+void ConnectClient::postDatabaseLoad()
+{
+  clearAircraftNameCache();
+}
+
+bool ConnectClient::startRecordOrReplayStartup()
+{
+  QString replayFile = NavApp::getStartupOptionStr(lnm::STARTUP_SIM_REPLAY);
+  QString recordFile = NavApp::getStartupOptionStr(lnm::STARTUP_SIM_RECORD);
+
+  if(!replayFile.isEmpty())
+  {
+    bool ok = false;
+    float speed = NavApp::getStartupOptionStr(lnm::STARTUP_SIM_REPLAY_SPEED).toFloat(&ok);
+    if(!ok)
+      speed = 1.f;
+
+    replay = new SimDataReplay(this);
+    connect(replay, &SimDataReplay::postSimConnectData, this, &ConnectClient::postSimConnectData);
+    connect(replay, &SimDataReplay::finished, this, &ConnectClient::replayFinished);
+
+    if(replay->start(replayFile, std::max(speed, 0.f)))
+    {
+      // Replay acts like a connection to let all receivers do their normal work
+      replayConnected = true;
+      mainWindow->setConnectionStatusMessageText(tr("Replay"), tr("Replaying simulator data from \"%1\".").arg(replayFile));
+      clearAircraftNameCache();
+      emit connectedToSimulator();
+      return true;
+    }
+
+    mainWindow->setStatusMessage(tr("Cannot replay simulator data from \"%1\".").arg(replayFile));
+    replayFinished();
+  }
+  else if(!recordFile.isEmpty())
+  {
+    recorder = new SimDataRecorder;
+    if(!recorder->open(recordFile))
+      mainWindow->setStatusMessage(tr("Cannot record simulator data to \"%1\".").arg(recordFile));
+  }
+  return false;
+}
+
+void ConnectClient::replayFinished()
+{
+  if(replayConnected)
+  {
+    replayConnected = false;
+    if(!NavApp::isShuttingDown())
+    {
+      mainWindow->setConnectionStatusMessageText(tr("Disconnected"), tr("Replay of simulator data finished."));
+      emit disconnectedFromSimulator();
+    }
+  }
+
+  if(benchmark != nullptr)
+  {
+    benchmark->report();
+
+    // Benchmark mode - exit application
+    QTimer::singleShot(0, mainWindow, &MainWindow::close);
+  }
+}
+
 QString ConnectClient::simName() const
 {
   if(connectDialog->isAnyConnectDirect())
@@ -230,6 +345,7 @@ void ConnectClient::connectedToSimulatorDirect()
                                              tr("Connected to local flight simulator (%1).").arg(simName()));
   connectDialog->setConnected(isConnected());
   mainWindow->setStatusMessage(tr("Connected to simulator."), true /* addLog */);
+  clearAircraftNameCache();
   emit connectedToSimulator();
   emit weatherUpdated();
 }
@@ -265,8 +381,17 @@ void ConnectClient::disconnectedFromSimulatorDirect()
 }
 
 /* Posts data received directly from simconnect or the socket and caches any metar reports */
-void ConnectClient::postSimConnectData(atools::fs::sc::SimConnectData dataPacket)
+void ConnectClient::postSimConnectData(atools::fs::sc::SimConnectData data)
 {
+  // Save packet as received before any modifications
+  if(recorder != nullptr)
+    recorder->write(data);
+
+  // Move into a shared packet which is published to all receivers without copying
+  // Packet must not be modified after sending
+  std::shared_ptr<atools::fs::sc::SimConnectData> packet = std::make_shared<atools::fs::sc::SimConnectData>(std::move(data));
+  atools::fs::sc::SimConnectData& dataPacket = *packet;
+
   if(dataPacket.getStatus() == atools::fs::sc::OK)
   {
     // Check for empty weather replies or metar replys. Aircraft is not valid in this case.
@@ -296,28 +421,43 @@ void ConnectClient::postSimConnectData(atools::fs::sc::SimConnectData dataPacket
       // const QString& getAirplaneTitle() const
       /* Short ICAO code MD80, BE58, etc. Actually type designator. */
       // const QString& getAirplaneModel() const
-      const atools::fs::scenery::LanguageJson& languageIndex = NavApp::getLanguageIndex();
-      if(!languageIndex.isEmpty())
+      // Names are cached by object id since they rarely change between packets
+      if(!NavApp::getLanguageIndex().isEmpty())
       {
+        aircraftNamesPacket++;
+
         // Change user aircraft names
-        userAircraft.updateAircraftNames(languageIndex.getName(userAircraft.getAirplaneType()),
-                                         languageIndex.getName(userAircraft.getAirplaneAirline()),
-                                         languageIndex.getName(userAircraft.getAirplaneTitle()),
-                                         languageIndex.getName(userAircraft.getAirplaneModel()));
+        translateAircraftNames(userAircraft, userAircraftNames);
 
         // Change AI names
         for(atools::fs::sc::SimConnectAircraft& ac : dataPacket.getAiAircraft())
-          ac.updateAircraftNames(languageIndex.getName(ac.getAirplaneType()),
-                                 languageIndex.getName(ac.getAirplaneAirline()),
-                                 languageIndex.getName(ac.getAirplaneTitle()),
-                                 languageIndex.getName(ac.getAirplaneModel()));
+          translateAircraftNames(ac, aiAircraftNames[ac.getObjectId()]);
+
+        // Remove aircraft which were not seen for a while
+        if(aircraftNamesPacket % AIRCRAFT_NAMES_CLEANUP_PACKETS == 0)
+        {
+          for(auto it = aiAircraftNames.begin(); it != aiAircraftNames.end();)
+          {
+            if(it->lastPacket < aircraftNamesPacket - AIRCRAFT_NAMES_CLEANUP_PACKETS)
+              it = aiAircraftNames.erase(it);
+            else
+              ++it;
+          }
+        }
       }
 
       // Update ICAO aircraft designator from aircraft.cfg for MSFS ===================================
       QString aircraftCfgKey = userAircraft.getProperties().value(atools::fs::sc::PROP_AIRCRAFT_CFG).getValueString();
       if(!aircraftCfgKey.isEmpty())
-        // Has property - fetch from index by loaded aircraft.cfg values
-        userAircraft.setAirplaneModel(NavApp::getAircraftIndex().getIcaoTypeDesignator(aircraftCfgKey));
+      {
+        // Has property - fetch from index by loaded aircraft.cfg values only if aircraft changed
+        if(aircraftCfgKey != aircraftCfgKeyCached)
+        {
+          aircraftCfgKeyCached = aircraftCfgKey;
+          icaoTypeDesignatorCached = NavApp::getAircraftIndex().getIcaoTypeDesignator(aircraftCfgKey);
+        }
+        userAircraft.setAirplaneModel(icaoTypeDesignatorCached);
+      }
 
       // Fix incorrect on-ground status which appears from some traffic tools =======================
       for(atools::fs::sc::SimConnectAircraft& ac : dataPacket.getAiAircraft())
@@ -333,7 +473,19 @@ void ConnectClient::postSimConnectData(atools::fs::sc::SimConnectData dataPacket
           ac.setFlag(atools::fs::sc::ON_GROUND);
       }
 
-      emit dataPacketReceived(dataPacket);
+      simdata::PacketPtr constPacket(packet);
+      if(benchmark != nullptr)
+      {
+        QElapsedTimer timer;
+        timer.start();
+        emit dataPacketReceived(constPacket);
+        benchmark->addPacket(timer.nsecsElapsed());
+      }
+      else
+        emit dataPacketReceived(constPacket);
+
+      if(packetStatistics)
+        updatePacketStatistics(constPacket);
     } // if(!dataPacket.isEmptyReply())
 
     if(!dataPacket.getMetars().isEmpty())
@@ -378,7 +530,7 @@ void ConnectClient::postSimConnectData(atools::fs::sc::SimConnectData dataPacket
     // Get flags before disconnecting
     bool xplane = dataReader != nullptr ? dataReader->isXplaneHandler() : false, network = isNetworkConnect();
     atools::fs::sc::SimConnectStatus status = dataPacket.getStatus();
-    QString statusText = simConnectData->getStatusText();
+    QString statusText = dataPacket.getStatusText();
 
     disconnectClicked();
     handleError(status, statusText, xplane, network);
@@ -394,6 +546,33 @@ void ConnectClient::postSimConnectData(atools::fs::sc::SimConnectData dataPacket
   }
 }
 
+void ConnectClient::updatePacketStatistics(const simdata::PacketPtr& packet)
+{
+  if(!packetStatisticsTimer.isValid())
+    packetStatisticsTimer.start();
+
+  // Each pointer kept by a receiver replaces a deep copy - exclude this and the local pointer in postSimConnectData()
+  qint64 size = simdata::approxPacketSize(*packet);
+  long handles = std::max(packet.use_count() - 2L, 0L);
+
+  packetStatisticsNum++;
+  packetStatisticsBytes += size;
+  packetStatisticsSharedBytes += size * handles;
+
+  qint64 elapsed = packetStatisticsTimer.elapsed();
+  if(elapsed > PACKET_STATISTICS_INTERVAL_MS)
+  {
+    double secs = elapsed / 1000.;
+    qInfo() << Q_FUNC_INFO << "Packets per second" << packetStatisticsNum / secs
+            << "received bytes per second" << packetStatisticsBytes / secs
+            << "bytes per second not copied by receivers due to sharing" << packetStatisticsSharedBytes / secs
+            << "receivers keeping last packet" << handles;
+
+    packetStatisticsNum = packetStatisticsBytes = packetStatisticsSharedBytes = 0L;
+    packetStatisticsTimer.restart();
+  }
+}
+
 void ConnectClient::handleError(atools::fs::sc::SimConnectStatus status, const QString& error, bool xplane, bool network)
 {
   QString hint, program;
@@ -747,13 +926,14 @@ void ConnectClient::connectInternal()
 
 bool ConnectClient::isConnectedActive() const
 {
-  return (socket != nullptr && socket->isOpen() && socketConnected) || (dataReader != nullptr && dataReader->isConnected());
+  return (socket != nullptr && socket->isOpen() && socketConnected) || (dataReader != nullptr && dataReader->isConnected()) ||
+         replayConnected;
 }
 
 bool ConnectClient::isConnected() const
 {
-  // socket or SimConnect or Xpconnect
-  return (socket != nullptr && socket->isOpen()) || (dataReader != nullptr && dataReader->isConnected());
+  // socket or SimConnect or Xpconnect or replay from file
+  return (socket != nullptr && socket->isOpen()) || (dataReader != nullptr && dataReader->isConnected()) || replayConnected;
 }
 
 bool ConnectClient::isSimConnect() const
@@ -916,6 +1096,7 @@ void ConnectClient::connectedToServerSocket()
 
   // Let other program parts know about the new connection
   mainWindow->setStatusMessage(tr("Connected to simulator."), true /* addLog */);
+  clearAircraftNameCache();
   emit connectedToSimulator();
   emit weatherUpdated();
 }
@@ -977,7 +1158,7 @@ void ConnectClient::readFromSocket()
         }
 
         // Send around in the application
-        postSimConnectData(*simConnectData);
+        postSimConnectData(std::move(*simConnectData));
         delete simConnectData;
         simConnectData = nullptr;
       }
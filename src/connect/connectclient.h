@@ -18,6 +18,8 @@
 #ifndef LITTLENAVMAP_CONNECTCLIENT_H
 #define LITTLENAVMAP_CONNECTCLIENT_H
 
+#include "connect/simdatabenchmark.h"
+#include "connect/simdatapacket.h"
 #include "fs/sc/simconnectdata.h"
 #include "util/timedcache.h"
 #include "connectdialog.h"
@@ -25,12 +27,33 @@
 
 #include <QAbstractSocket>
 #include <QCache>
+#include <QElapsedTimer>
 #include <QTimer>
 
 class QTcpSocket;
 class ConnectDialog;
 class MainWindow;
 class QMessageBox;
+class SimDataRecorder;
+class SimDataReplay;
+
+namespace connectclient {
+
+/* Translated names and type designator for one aircraft. The original names from the simulator are
+ * kept to detect changes. */
+struct AircraftNames
+{
+  /* Names as sent by the simulator */
+  QString type, airline, title, model;
+
+  /* Translated names */
+  QString typeTr, airlineTr, titleTr, modelTr;
+
+  /* Packet number when this aircraft was seen the last time. Used to remove stale entries. */
+  qint64 lastPacket = 0L;
+};
+
+}
 
 namespace atools {
 namespace fs {
@@ -66,13 +89,30 @@ public:
   /* Opens the connect dialog and depending on result connects to the server/agent */
   void connectToServerDialog();
 
-  /* Connects directly if the connect on startup option is set */
+  /* Connects directly if the connect on startup option is set.
+   * Starts recording or replay of data packets instead if given on the command line. */
   void tryConnectOnStartup();
 
-  /* true if connected to Little Navconnect or the simulator */
+  /* Connect a receiver to dataPacketReceived(). Measures the time needed by the receiver for each packet
+   * if the benchmark command line option is given. */
+  template<typename RECEIVER>
+  void connectDataPacketReceiver(const QString& name, RECEIVER *receiver, void (RECEIVER::*slot)(const simdata::PacketPtr&))
+  {
+    if(benchmark != nullptr)
+      connect(this, &ConnectClient::dataPacketReceived, receiver, [this, name, receiver, slot](const simdata::PacketPtr& packet) {
+        QElapsedTimer timer;
+        timer.start();
+        (receiver->*slot)(packet);
+        benchmark->add(name, timer.nsecsElapsed());
+      });
+    else
+      connect(this, &ConnectClient::dataPacketReceived, receiver, slot);
+  }
+
+  /* true if connected to Little Navconnect or the simulator. Also true while replaying recorded data. */
   bool isConnected() const;
 
-  /* true if connected to Xpconnect, SimConnect or socket is really connected */
+  /* true if connected to Xpconnect, SimConnect or socket is really connected. Also true while replaying. */
   bool isConnectedActive() const;
 
   /* true if connection is using SimConnect for FSX/P3D */
@@ -84,6 +124,9 @@ public:
   /* Connected to Little Navconnect */
   bool isNetworkConnect() const;
 
+  /* Clears the aircraft name caches since ICAO designators depend on the loaded database */
+  void postDatabaseLoad();
+
   /* Just saves and restores the state of the dialog */
   void saveState();
   void restoreState();
@@ -104,8 +147,9 @@ public:
 
 signals:
   /* Emitted when new data was received from the server (Little Navconnect), SimConnect or X-Plane.
-   * can be aircraft position or weather update */
-  void dataPacketReceived(const atools::fs::sc::SimConnectData& simConnectData);
+   * can be aircraft position or weather update.
+   * The packet is shared between all receivers and must not be changed. Keep the pointer instead of copying the data. */
+  void dataPacketReceived(const simdata::PacketPtr& simConnectData);
 
   /* Emitted when a new SimConnect data was received that contains weather data */
   void weatherUpdated();
@@ -149,6 +193,21 @@ private:
   void showTerminalError();
   void showXpconnectVersionWarning(const QString& xpconnectVersion);
 
+  /* Collect and log statistics for shared packets if enabled */
+  void updatePacketStatistics(const simdata::PacketPtr& packet);
+
+  /* Start recording or replay of data packets if given on the command line. Returns true if replaying. */
+  bool startRecordOrReplayStartup();
+
+  /* Replay from file is done. Prints benchmark and closes main window if requested. */
+  void replayFinished();
+
+  /* Replace aircraft names with translated ones from language index. Uses and updates the cache entry names. */
+  void translateAircraftNames(atools::fs::sc::SimConnectAircraft& aircraft, connectclient::AircraftNames& names);
+
+  /* Clear translated name and ICAO designator caches. Called on each new connection and after loading a database. */
+  void clearAircraftNameCache();
+
   bool silent = false, manualDisconnect = false;
   ConnectDialog *connectDialog = nullptr;
 
@@ -194,6 +253,28 @@ private:
   int directReconnectXpSec = 5;
 
   atools::util::Version minimumXpconnectVersion;
+
+  /* Recording and replay of packets from command line options */
+  SimDataRecorder *recorder = nullptr;
+  SimDataReplay *replay = nullptr;
+
+  /* Replay is running and connectedToSimulator() was sent */
+  bool replayConnected = false;
+  SimDataBenchmark *benchmark = nullptr;
+
+  /* Translated names for AI aircraft keyed by object id and user aircraft names */
+  QHash<unsigned int, connectclient::AircraftNames> aiAircraftNames;
+  connectclient::AircraftNames userAircraftNames;
+  qint64 aircraftNamesPacket = 0L;
+
+  /* Last aircraft.cfg key and resulting ICAO type designator for user aircraft */
+  QString aircraftCfgKeyCached, icaoTypeDesignatorCached;
+
+  /* Packet statistics for debugging. Number of packets, bytes received and bytes which would have been copied
+   * by receivers keeping a copy of the packet. */
+  bool packetStatistics = false;
+  QElapsedTimer packetStatisticsTimer;
+  qint64 packetStatisticsNum = 0L, packetStatisticsBytes = 0L, packetStatisticsSharedBytes = 0L;
 };
 
 #endif // LITTLENAVMAP_CONNECTCLIENT_H
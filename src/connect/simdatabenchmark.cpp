@@ -0,0 +1,61 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "connect/simdatabenchmark.h"
+
+#include <QDebug>
+
+void SimDataBenchmark::add(const QString& name, qint64 nanoseconds)
+{
+  Timing& timing = timings[name];
+  timing.num++;
+  timing.sumNs += nanoseconds;
+  timing.maxNs = std::max(timing.maxNs, nanoseconds);
+}
+
+void SimDataBenchmark::addPacket(qint64 nanoseconds)
+{
+  packetTiming.num++;
+  packetTiming.sumNs += nanoseconds;
+  packetTiming.maxNs = std::max(packetTiming.maxNs, nanoseconds);
+}
+
+void SimDataBenchmark::report() const
+{
+  qInfo().noquote().nospace() << "Simulator data benchmark: " << packetTiming.num << " packets";
+
+  for(auto it = timings.constBegin(); it != timings.constEnd(); ++it)
+  {
+    const Timing& timing = it.value();
+    qInfo().noquote().nospace() << "Receiver " << it.key() << ": packets " << timing.num
+                                << ", average " << (timing.num > 0 ? timing.sumNs / timing.num / 1000 : 0L) << " us"
+                                << ", maximum " << timing.maxNs / 1000 << " us"
+                                << ", total " << timing.sumNs / 1000000 << " ms";
+  }
+
+  qInfo().noquote().nospace() << "All receivers: average "
+                              << (packetTiming.num > 0 ? packetTiming.sumNs / packetTiming.num / 1000 : 0L) << " us"
+                              << ", maximum " << packetTiming.maxNs / 1000 << " us"
+                              << ", total " << packetTiming.sumNs / 1000000 << " ms";
+}
+
+void SimDataBenchmark::clear()
+{
+  timings.clear();
+  packetTiming = Timing();
+}
@@ -0,0 +1,54 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LNM_SIMDATABENCHMARK_H
+#define LNM_SIMDATABENCHMARK_H
+
+#include <QMap>
+
+/*
+ * Collects the time needed by each receiver of simulator data packets.
+ * Used to compare performance of the simulator update path with replayed recordings.
+ */
+class SimDataBenchmark
+{
+public:
+  /* Add time for one packet to the receiver with the given name */
+  void add(const QString& name, qint64 nanoseconds);
+
+  /* Add time for all receivers together for one packet */
+  void addPacket(qint64 nanoseconds);
+
+  /* Log average and maximum time per packet for all receivers */
+  void report() const;
+
+  void clear();
+
+private:
+  struct Timing
+  {
+    int num = 0;
+    qint64 sumNs = 0L, maxNs = 0L;
+  };
+
+  /* Sorted by receiver name */
+  QMap<QString, Timing> timings;
+  Timing packetTiming;
+};
+
+#endif // LNM_SIMDATABENCHMARK_H
@@ -0,0 +1,59 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "connect/simdatapacket.h"
+
+#include "fs/sc/simconnectdata.h"
+
+using atools::fs::sc::SimConnectData;
+using atools::fs::sc::SimConnectAircraft;
+
+namespace simdata {
+
+const PacketPtr& emptyPacket()
+{
+  static const PacketPtr EMPTY_PACKET = std::make_shared<const SimConnectData>();
+  return EMPTY_PACKET;
+}
+
+PacketPtr makePacket(SimConnectData&& data)
+{
+  return std::make_shared<const SimConnectData>(std::move(data));
+}
+
+namespace {
+
+qint64 stringSize(const SimConnectAircraft& aircraft)
+{
+  return (aircraft.getAirplaneTitle().size() + aircraft.getAirplaneModel().size() + aircraft.getAirplaneType().size() +
+          aircraft.getAirplaneAirline().size() + aircraft.getAirplaneRegistration().size() +
+          aircraft.getAirplaneFlightnumber().size()) * static_cast<qint64>(sizeof(QChar));
+}
+
+}
+
+qint64 approxPacketSize(const SimConnectData& data)
+{
+  qint64 size = sizeof(SimConnectData) + stringSize(data.getUserAircraftConst());
+
+  for(const SimConnectAircraft& aircraft : data.getAiAircraftConst())
+    size += sizeof(SimConnectAircraft) + stringSize(aircraft);
+  return size;
+}
+
+}
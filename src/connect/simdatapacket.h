@@ -0,0 +1,51 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LNM_SIMDATAPACKET_H
+#define LNM_SIMDATAPACKET_H
+
+#include <QtGlobal>
+
+#include <memory>
+
+namespace atools {
+namespace fs {
+namespace sc {
+class SimConnectData;
+}
+}
+}
+
+namespace simdata {
+
+/* Immutable and reference counted simulator data packet as published by ConnectClient::dataPacketReceived().
+ * Receivers keep the pointer instead of copying the packet which contains all AI aircraft. Never null. */
+typedef std::shared_ptr<const atools::fs::sc::SimConnectData> PacketPtr;
+
+/* Shared empty packet which can be used to reset handles */
+const PacketPtr& emptyPacket();
+
+/* Create a shared packet by moving data into it */
+PacketPtr makePacket(atools::fs::sc::SimConnectData&& data);
+
+/* Approximate number of bytes needed for a deep copy of the packet including aircraft names */
+qint64 approxPacketSize(const atools::fs::sc::SimConnectData& data);
+
+}
+
+#endif // LNM_SIMDATAPACKET_H
@@ -0,0 +1,181 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "connect/simdatarecorder.h"
+
+#include "fs/sc/simconnectdata.h"
+
+#include <QDataStream>
+#include <QDebug>
+
+namespace {
+/* "LNSR" */
+const quint32 RECORDING_MAGIC_NUMBER = 0x4C4E5352;
+const quint16 RECORDING_VERSION = 1;
+}
+
+// ==================================================================================
+SimDataRecorder::SimDataRecorder()
+{
+}
+
+SimDataRecorder::~SimDataRecorder()
+{
+  close();
+}
+
+bool SimDataRecorder::open(const QString& filename)
+{
+  close();
+
+  file.setFileName(filename);
+  if(file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+  {
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_5);
+    out << RECORDING_MAGIC_NUMBER << RECORDING_VERSION;
+
+    numPackets = 0;
+    timer.start();
+    qInfo() << Q_FUNC_INFO << "Recording to" << filename;
+    return true;
+  }
+  else
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open" << filename << file.errorString();
+    return false;
+  }
+}
+
+void SimDataRecorder::close()
+{
+  if(file.isOpen())
+  {
+    qInfo() << Q_FUNC_INFO << "Recorded" << numPackets << "packets to" << file.fileName();
+    file.close();
+  }
+}
+
+void SimDataRecorder::write(atools::fs::sc::SimConnectData& data)
+{
+  if(!file.isOpen())
+    return;
+
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_5_5);
+  out << static_cast<qint64>(timer.elapsed());
+
+  if(!data.write(&file) || out.status() != QDataStream::Ok)
+  {
+    qWarning() << Q_FUNC_INFO << "Error writing" << file.fileName() << file.errorString();
+    close();
+  }
+  else
+    numPackets++;
+}
+
+// ==================================================================================
+SimDataReplay::SimDataReplay(QObject *parent)
+  : QObject(parent)
+{
+  timer.setSingleShot(true);
+  connect(&timer, &QTimer::timeout, this, &SimDataReplay::sendNext);
+}
+
+SimDataReplay::~SimDataReplay()
+{
+  timer.stop();
+  file.close();
+}
+
+bool SimDataReplay::start(const QString& filename, float speedFactor)
+{
+  stop();
+
+  file.setFileName(filename);
+  if(!file.open(QIODevice::ReadOnly))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open" << filename << file.errorString();
+    return false;
+  }
+
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_5);
+  quint32 magic = 0;
+  quint16 version = 0;
+  in >> magic >> version >> firstPacketMs;
+
+  if(in.status() != QDataStream::Ok || magic != RECORDING_MAGIC_NUMBER || version != RECORDING_VERSION)
+  {
+    qWarning() << Q_FUNC_INFO << "Invalid file" << filename << "magic" << magic << "version" << version;
+    file.close();
+    return false;
+  }
+
+  qInfo() << Q_FUNC_INFO << "Replaying" << filename << "speed" << speedFactor;
+
+  speed = speedFactor;
+  numPackets = 0;
+  nextPacketMs = firstPacketMs;
+  replayTimer.start();
+  timer.start(0);
+  return true;
+}
+
+void SimDataReplay::stop()
+{
+  timer.stop();
+  file.close();
+}
+
+void SimDataReplay::sendNext()
+{
+  atools::fs::sc::SimConnectData data;
+  if(!data.read(&file) || data.getStatus() != atools::fs::sc::OK)
+  {
+    qWarning() << Q_FUNC_INFO << "Error reading packet" << numPackets << "from" << file.fileName();
+    stop();
+    emit finished();
+    return;
+  }
+
+  numPackets++;
+  emit postSimConnectData(data);
+
+  if(!file.isOpen())
+    // Stopped by receiver
+    return;
+
+  if(file.atEnd())
+  {
+    qInfo() << Q_FUNC_INFO << "Replayed" << numPackets << "packets from" << file.fileName();
+    stop();
+    emit finished();
+    return;
+  }
+
+  // Read time for next packet and schedule it relative to replay start
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_5);
+  in >> nextPacketMs;
+
+  int delay = 0;
+  if(speed > 0.f)
+    delay = static_cast<int>(std::max((nextPacketMs - firstPacketMs) / speed - replayTimer.elapsed(), 0.f));
+  timer.start(delay);
+}
@@ -0,0 +1,124 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LNM_SIMDATARECORDER_H
+#define LNM_SIMDATARECORDER_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTimer>
+
+namespace atools {
+namespace fs {
+namespace sc {
+class SimConnectData;
+}
+}
+}
+
+/*
+ * Writes simulator data packets into a file for later replay by SimDataReplay.
+ *
+ * File starts with a magic number and version. Each packet is prefixed with the milliseconds since start of
+ * recording and written in the same binary format as used for the Little Navconnect network protocol.
+ */
+class SimDataRecorder
+{
+public:
+  SimDataRecorder();
+  ~SimDataRecorder();
+
+  SimDataRecorder(const SimDataRecorder& other) = delete;
+  SimDataRecorder& operator=(const SimDataRecorder& other) = delete;
+
+  /* Create or truncate file and write header. Returns false on error. */
+  bool open(const QString& filename);
+  void close();
+
+  bool isOpen() const
+  {
+    return file.isOpen();
+  }
+
+  /* Append packet with current timestamp. Closes file on error. */
+  void write(atools::fs::sc::SimConnectData& data);
+
+  int getNumPackets() const
+  {
+    return numPackets;
+  }
+
+private:
+  QFile file;
+  QElapsedTimer timer;
+  int numPackets = 0;
+};
+
+/*
+ * Reads a file created by SimDataRecorder and sends the packets using the original timing or as fast as possible.
+ * Packets are sent in the event loop and are delivered in the GUI thread.
+ */
+class SimDataReplay :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit SimDataReplay(QObject *parent);
+  virtual ~SimDataReplay() override;
+
+  SimDataReplay(const SimDataReplay& other) = delete;
+  SimDataReplay& operator=(const SimDataReplay& other) = delete;
+
+  /* Open file and start sending packets. speed is a factor for the recorded timing. 0 sends as fast as possible.
+   * Returns false if the file cannot be opened or is not valid. */
+  bool start(const QString& filename, float speedFactor);
+  void stop();
+
+  bool isRunning() const
+  {
+    return file.isOpen();
+  }
+
+  int getNumPackets() const
+  {
+    return numPackets;
+  }
+
+signals:
+  /* Sent for each packet read from file */
+  void postSimConnectData(atools::fs::sc::SimConnectData dataPacket);
+
+  /* End of file reached or read error */
+  void finished();
+
+private:
+  /* Read and send next packet and schedule the one after */
+  void sendNext();
+
+  QFile file;
+  QTimer timer;
+  float speed = 1.f;
+  int numPackets = 0;
+
+  /* Recording time for the first and next packet and replay start time */
+  qint64 firstPacketMs = -1L, nextPacketMs = -1L;
+  QElapsedTimer replayTimer;
+};
+
+#endif // LNM_SIMDATARECORDER_H
@@ -51,6 +51,10 @@ const QString DATABASE_NAME_NAV_AIRSPACE = "LNMDBNAVAS";
 /* Network online player data */
 const QString DATABASE_NAME_ONLINE = "LNMDBONLINE";
 
+/* Connections used by the online data parsing thread to write online data and read user airspace geometry */
+const QString DATABASE_NAME_ONLINE_PARSE = "LNMONLINEPARSE";
+const QString DATABASE_NAME_ONLINE_PARSE_AIRSPACE = "LNMONLINEPARSEAS";
+
 /* Temporary database used for database checking, copying and preparation */
 const QString DATABASE_NAME_TEMP = "LNMTEMPDB";
 
@@ -60,6 +64,15 @@ const QString DATABASE_NAME_LOADER = "LNMLOADER";
 /* Used to temporary load metadata */
 const QString DATABASE_NAME_DLG_INFO_TEMP = "LNMTEMPDB2";
 
+/* Read only connections used by flight plan calculation threads to load the route network.
+ * A suffix is appended to get unique names per thread. */
+const QString DATABASE_NAME_ROUTE_CALC_NAV = "LNMROUTECALCNAV";
+const QString DATABASE_NAME_ROUTE_CALC_TRACK = "LNMROUTECALCTRACK";
+
+/* Read only connections used by search tabs to count result rows in background.
+ * A suffix is appended to get unique names per search model. */
+const QString DATABASE_NAME_SEARCH_COUNT = "LNMSEARCHCOUNT";
+
 /* Common type for all databases */
 const QString DATABASE_TYPE = "QSQLITE";
 
@@ -65,6 +65,7 @@
 #include "profile/profilewidget.h"
 #include "query/airportquery.h"
 #include "query/procedurequery.h"
+#include "route/routebatch.h"
 #include "route/routecontroller.h"
 #include "routeexport/routeexport.h"
 #include "routeexport/simbriefhandler.h"
@@ -88,6 +89,8 @@
 #include "weather/weatherreporter.h"
 #include "weather/windreporter.h"
 #include "web/webcontroller.h"
+#include "web/webmapcontroller.h"
+#include "web/webaircraftfeed.h"
 #include "common/updatehandler.h"
 
 #include <marble/MarbleAboutDialog.h>
@@ -105,6 +108,9 @@
 #include <QProgressDialog>
 #include <QThread>
 #include <QStringBuilder>
+#include <QFileInfo>
+#include <QDir>
+#include <QtConcurrent/QtConcurrentRun>
 
 #include "ui_mainwindow.h"
 
@@ -496,8 +502,10 @@ MainWindow::~MainWindow()
 
   weatherUpdateTimer.stop();
 
-  // Close all queries
+  // Close all queries - also cancels route batch
   preDatabaseLoad();
+  routeBatchWatcher.waitForFinished();
+  ATOOLS_DELETE_LOG(routeBatch);
 
   // Set all pointers to null to catch errors for late access
   NavApp::removeDialogFromDockHandler(routeStringDialog);
@@ -1476,7 +1484,8 @@ void MainWindow::connectAllSlots()
 
   // Airway/tracks =======================================================
   TrackController *trackController = NavApp::getTrackController();
-  connect(trackController, &TrackController::postTrackLoad, routeController, &RouteController::clearAirwayNetworkCache);
+  connect(trackController, &TrackController::preTrackLoad, routeController, &RouteController::cancelRouteCalculation);
+  connect(trackController, &TrackController::postTrackLoad, routeController, &RouteController::preloadRouteNetworks);
   connect(trackController, &TrackController::postTrackLoad, infoController, &InfoController::tracksChanged);
   connect(trackController, &TrackController::postTrackLoad, this, &MainWindow::updateMapObjectsShown);
   connect(trackController, &TrackController::postTrackLoad, routeController, &RouteController::tracksChanged);
@@ -1582,11 +1591,13 @@ void MainWindow::connectAllSlots()
   connect(ui->actionConnectSimulatorToggle, &QAction::toggled, connectClient, &ConnectClient::connectToggle);
 
   // Deliver first to route controller to update active leg and distances
-  connect(connectClient, &ConnectClient::dataPacketReceived, routeController, &RouteController::simDataChanged);
-  connect(connectClient, &ConnectClient::dataPacketReceived, mapWidget, &MapWidget::simDataChanged);
-  connect(connectClient, &ConnectClient::dataPacketReceived, profileWidget, &ProfileWidget::simDataChanged);
-  connect(connectClient, &ConnectClient::dataPacketReceived, infoController, &InfoController::simDataChanged);
-  connect(connectClient, &ConnectClient::dataPacketReceived, NavApp::getAircraftPerfController(), &AircraftPerfController::simDataChanged);
+  // Receivers are timed separately if running a replay benchmark
+  connectClient->connectDataPacketReceiver("route", routeController, &RouteController::simDataChanged);
+  connectClient->connectDataPacketReceiver("map", mapWidget, &MapWidget::simDataChanged);
+  connectClient->connectDataPacketReceiver("profile", profileWidget, &ProfileWidget::simDataChanged);
+  connectClient->connectDataPacketReceiver("info", infoController, &InfoController::simDataChanged);
+  connectClient->connectDataPacketReceiver("perf", NavApp::getAircraftPerfController(), &AircraftPerfController::simDataChanged);
+  connectClient->connectDataPacketReceiver("online", NavApp::getOnlinedataController(), &OnlinedataController::simDataChanged);
 
   connect(connectClient, &ConnectClient::connectedToSimulator,
           NavApp::getAircraftPerfController(), &AircraftPerfController::connectedToSimulator);
@@ -1647,6 +1658,47 @@ void MainWindow::connectAllSlots()
   connect(ui->actionOpenWebserver, &QAction::triggered, this, &MainWindow::openWebserver);
   connect(NavApp::getWebController(), &WebController::webserverStatusChanged, this, &MainWindow::webserverStatusChanged);
 
+  // Invalidate cached static map layers if anything drawn changes
+  connect(routeController, &RouteController::routeChanged, mapWidget, &MapPaintWidget::mapContentChanged);
+  connect(routeController, &RouteController::routeAltitudeChanged, mapWidget, &MapPaintWidget::mapContentChanged);
+  connect(weatherReporter, &WeatherReporter::weatherUpdated, mapWidget, &MapPaintWidget::mapContentChanged);
+  connect(windReporter, &WindReporter::windDisplayUpdated, mapWidget, &MapPaintWidget::mapContentChanged);
+  connect(mapWidget, &MapPaintWidget::searchMarkChanged, mapWidget, &MapPaintWidget::mapContentChanged);
+  connect(NavApp::getOnlinedataController(), &OnlinedataController::onlineClientAndAtcUpdated,
+          mapWidget, &MapPaintWidget::mapContentChanged);
+  connect(NavApp::getOnlinedataController(), &OnlinedataController::onlineNetworkChanged,
+          mapWidget, &MapPaintWidget::mapContentChanged);
+  connect(NavApp::getUserdataController(), &UserdataController::userdataChanged, mapWidget, &MapPaintWidget::mapContentChanged);
+  connect(NavApp::getLogdataController(), &LogdataController::logDataChanged, mapWidget, &MapPaintWidget::mapContentChanged);
+  connect(NavApp::getAirspaceController(), &AirspaceController::userAirspacesUpdated,
+          mapWidget, &MapPaintWidget::mapContentChanged);
+  connect(NavApp::getTrackController(), &TrackController::postTrackLoad, mapWidget, &MapPaintWidget::mapContentChanged);
+
+  // Invalidate cached web server map images if anything drawn changes
+  WebMapController *webMapController = NavApp::getWebMapController();
+  connect(routeController, &RouteController::routeChanged, webMapController, &WebMapController::mapStateChanged);
+  connect(weatherReporter, &WeatherReporter::weatherUpdated, webMapController, &WebMapController::mapStateChanged);
+  connect(windReporter, &WindReporter::windDisplayUpdated, webMapController, &WebMapController::mapStateChanged);
+  connect(optionsDialog, &OptionsDialog::optionsChanged, webMapController, &WebMapController::mapStateChanged);
+  connect(mapWidget, &MapPaintWidget::shownMapFeaturesChanged, webMapController, &WebMapController::mapStateChanged);
+  connect(mapWidget, &MapPaintWidget::searchMarkChanged, webMapController, &WebMapController::mapStateChanged);
+  connect(NavApp::getOnlinedataController(), &OnlinedataController::onlineClientAndAtcUpdated,
+          webMapController, &WebMapController::mapStateChanged);
+  connect(NavApp::getOnlinedataController(), &OnlinedataController::onlineNetworkChanged,
+          webMapController, &WebMapController::mapStateChanged);
+  connect(NavApp::getUserdataController(), &UserdataController::userdataChanged,
+          webMapController, &WebMapController::mapStateChanged);
+  connect(NavApp::getLogdataController(), &LogdataController::logDataChanged,
+          webMapController, &WebMapController::mapStateChanged);
+  connect(NavApp::getAirspaceController(), &AirspaceController::userAirspacesUpdated,
+          webMapController, &WebMapController::mapStateChanged);
+  connect(NavApp::getTrackController(), &TrackController::postTrackLoad, webMapController, &WebMapController::mapStateChanged);
+  connectClient->connectDataPacketReceiver("webmap", webMapController, &WebMapController::simDataChanged);
+
+  // Serialize packets once for all streaming web clients
+  connectClient->connectDataPacketReceiver("webfeed", NavApp::getWebController()->getAircraftFeed(),
+                                           &WebAircraftFeed::simDataChanged);
+
   // Shortcut menu
   connect(ui->actionShortcutMap, &QAction::triggered, this, &MainWindow::actionShortcutMapTriggered);
   connect(ui->actionShortcutProfile, &QAction::triggered, this, &MainWindow::actionShortcutProfileTriggered);
@@ -3294,6 +3346,13 @@ void MainWindow::mainWindowShown()
   if(ui->actionRouteDownloadTracks->isChecked())
     QTimer::singleShot(1000, NavApp::getTrackController(), &TrackController::startDownloadStartup);
 
+  // Fill flight plan calculation network cache in background
+  QTimer::singleShot(2000, routeController, &RouteController::preloadRouteNetworks);
+
+  // Calculate flight plans given on command line
+  if(!NavApp::getStartupOptionStr(lnm::STARTUP_ROUTE_BATCH).isEmpty())
+    QTimer::singleShot(500, this, &MainWindow::routeBatchStartup);
+
   // Log screen information ==============
   const QList<QScreen *> screens = QGuiApplication::screens();
   for(QScreen *screen : screens)
@@ -3309,6 +3368,70 @@ void MainWindow::mainWindowShown()
   qDebug() << Q_FUNC_INFO << "leave";
 }
 
+void MainWindow::routeBatchStartup()
+{
+  QString filename = NavApp::getStartupOptionStr(lnm::STARTUP_ROUTE_BATCH);
+  routeBatchOutDir = NavApp::getStartupOptionStr(lnm::STARTUP_ROUTE_BATCH_OUT);
+  if(routeBatchOutDir.isEmpty())
+    routeBatchOutDir = QFileInfo(filename).absolutePath();
+
+  qDebug() << Q_FUNC_INFO << filename << routeBatchOutDir;
+
+  QVector<routebatch::Entry> entries = routebatch::readEntries(filename);
+  if(entries.isEmpty())
+  {
+    qWarning() << Q_FUNC_INFO << "No flight plans to calculate in" << filename;
+    QCoreApplication::exit(1);
+    return;
+  }
+
+  // Batch mode - window is not needed
+  showMinimized();
+  setStatusMessage(tr("Calculating %1 flight plans ...").arg(entries.size()));
+
+  // Resolve airports in this thread and calculate in background
+  routeBatch = new RouteBatch;
+  routeBatch->prepare(entries);
+  connect(&routeBatchWatcher, &QFutureWatcher<void>::finished, this, &MainWindow::routeBatchFinished);
+  routeBatchWatcher.setFuture(QtConcurrent::run(routeBatch, &RouteBatch::calculateRoutes));
+}
+
+void MainWindow::routeBatchFinished()
+{
+  if(routeBatch == nullptr || NavApp::isShuttingDown())
+    return;
+
+  int exitCode = 0;
+  if(routeBatch->isCanceled())
+  {
+    // Database was switched while calculating
+    qWarning() << Q_FUNC_INFO << "Route batch canceled";
+    exitCode = 2;
+  }
+  else
+  {
+    QVector<routebatch::Result> results = routeBatch->finish();
+    bool written = routeBatch->writeResults(routeBatchOutDir, results);
+
+    const routebatch::Statistics& stats = routeBatch->getStatistics();
+    qInfo() << Q_FUNC_INFO << "routes" << stats.numRoutes << "found" << stats.numFound << "workers" << stats.numWorkers
+            << "total" << stats.totalTimeMs << "ms sum calculation" << stats.sumCalcTimeMs
+            << "ms max calculation" << stats.maxCalcTimeMs << "ms";
+
+    if(!written)
+    {
+      qWarning() << Q_FUNC_INFO << "Error saving calculated flight plans to" << routeBatchOutDir;
+      exitCode = 1;
+    }
+  }
+
+  ATOOLS_DELETE_LOG(routeBatch);
+
+  // Batch mode - leave event loop without asking and return status code from main()
+  qInfo() << Q_FUNC_INFO << "Exiting with status" << exitCode;
+  QCoreApplication::exit(exitCode);
+}
+
 void MainWindow::loadLayoutDelayed(const QString& filename)
 {
   try
@@ -4020,8 +4143,8 @@ void MainWindow::updateMapKeys()
       mapWidget->setKeys(mapThemeHandler->getMapThemeKeysHash());
 
     // Might be null if not started
-    if(NavApp::getMapPaintWidgetWeb() != nullptr)
-      NavApp::getMapPaintWidgetWeb()->setKeys(mapThemeHandler->getMapThemeKeysHash());
+    if(NavApp::getWebMapController() != nullptr)
+      NavApp::getWebMapController()->setKeys(mapThemeHandler->getMapThemeKeysHash());
   }
 }
 
@@ -4514,6 +4637,9 @@ void MainWindow::preDatabaseLoad()
 {
   qDebug() << Q_FUNC_INFO;
 
+  // Stop flight plan batch calculations from command line or web API which use own database connections
+  RouteBatch::cancelAll();
+
   if(!hasDatabaseLoadStatus)
   {
     hasDatabaseLoadStatus = true;
@@ -4554,6 +4680,7 @@ void MainWindow::postDatabaseLoad(atools::fs::FsPaths::SimulatorType type)
     weatherReporter->postDatabaseLoad(type);
     windReporter->postDatabaseLoad(type);
     routeExport->postDatabaseLoad();
+    NavApp::getConnectClient()->postDatabaseLoad();
 
     // U actions for flight simulator database switch in main menu
     NavApp::getDatabaseManager()->insertSimSwitchActions();
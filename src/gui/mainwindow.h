@@ -21,6 +21,7 @@
 #include "fs/fspaths.h"
 #include "common/mapflags.h"
 
+#include <QFutureWatcher>
 #include <QMainWindow>
 #include <QFileInfoList>
 #include <QTimer>
@@ -41,6 +42,7 @@ class QPushButton;
 class QToolButton;
 class Route;
 class RouteController;
+class RouteBatch;
 class RouteExport;
 class RouteStringDialog;
 class SearchBaseTable;
@@ -291,6 +293,13 @@ private:
   void mainWindowShown();
   void mainWindowShownDelayed();
 
+  /* Calculate flight plans for city pairs given by command line option "route-batch" in background.
+   * Application exits with status code 0 if all results could be written. */
+  void routeBatchStartup();
+
+  /* Called by watcher when the command line batch is calculated. Writes results and exits the application. */
+  void routeBatchFinished();
+
   /* Dock window functions */
   void raiseFloatingWindows();
   void hideTitleBar();
@@ -549,6 +558,11 @@ private:
   /* Reload weather all 15 seconds */
   QTimer weatherUpdateTimer;
 
+  /* Flight plan calculation for command line option "route-batch" */
+  RouteBatch *routeBatch = nullptr;
+  QFutureWatcher<void> routeBatchWatcher;
+  QString routeBatchOutDir;
+
   bool firstStart = true; /* emit window shown only once after startup */
 
   WeatherContextHandler *weatherContextHandler;
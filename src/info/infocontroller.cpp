@@ -585,7 +585,7 @@ void InfoController::updateProgress()
     // ok - scrollbars not pressed
     html.clear();
     html.setIdBits(aircraftProgressConfig->getEnabledBits());
-    infoBuilder->aircraftProgressText(lastSimData.getUserAircraftConst(), html, NavApp::getRouteConst());
+    infoBuilder->aircraftProgressText(lastSimData->getUserAircraftConst(), html, NavApp::getRouteConst());
     atools::gui::util::updateTextEdit(ui->textBrowserAircraftProgressInfo, html.getHtml(),
                                       false /* scroll to top*/, true /* keep selection */);
   }
@@ -1203,8 +1203,8 @@ void InfoController::updateUserAircraftText()
       {
         // ok - scrollbars not pressed
         HtmlBuilder html(true /* has background color */);
-        infoBuilder->aircraftText(lastSimData.getUserAircraftConst(), html);
-        infoBuilder->aircraftTextWeightAndFuel(lastSimData.getUserAircraftConst(), html);
+        infoBuilder->aircraftText(lastSimData->getUserAircraftConst(), html);
+        infoBuilder->aircraftTextWeightAndFuel(lastSimData->getUserAircraftConst(), html);
         atools::gui::util::updateTextEdit(ui->textBrowserAircraftInfo, html.getHtml(),
                                           false /* scroll to top*/, true /* keep selection */);
       }
@@ -1240,7 +1240,7 @@ void InfoController::updateAircraftProgressText()
         // ok - scrollbars not pressed
         HtmlBuilder html(true /* has background color */);
         html.setIdBits(aircraftProgressConfig->getEnabledBits());
-        infoBuilder->aircraftProgressText(lastSimData.getUserAircraftConst(), html, NavApp::getRouteConst());
+        infoBuilder->aircraftProgressText(lastSimData->getUserAircraftConst(), html, NavApp::getRouteConst());
         atools::gui::util::updateTextEdit(ui->textBrowserAircraftProgressInfo, html.getHtml(),
                                           false /* scroll to top*/, true /* keep selection */);
       }
@@ -1281,7 +1281,7 @@ void InfoController::updateAiAircraftText()
           int num = 1;
           for(const map::MapAiAircraft& aircraft : qAsConst(currentSearchResult.aiAircraft))
           {
-            infoBuilder->aircraftText(aircraft.getAircraft(), html, num, lastSimData.getAiAircraftConst().size());
+            infoBuilder->aircraftText(aircraft.getAircraft(), html, num, lastSimData->getAiAircraftConst().size());
 
             infoBuilder->aircraftProgressText(aircraft.getAircraft(), html, Route());
             num++;
@@ -1292,7 +1292,7 @@ void InfoController::updateAiAircraftText()
         }
         else
         {
-          int numAi = lastSimData.getAiAircraftConst().size();
+          int numAi = lastSimData->getAiAircraftConst().size();
           QString text;
 
           if(!(NavApp::getShownMapTypes() & map::AIRCRAFT_AI))
@@ -1321,8 +1321,10 @@ void InfoController::updateAiAircraftText()
   }
 }
 
-void InfoController::simDataChanged(const atools::fs::sc::SimConnectData& data)
+void InfoController::simDataChanged(const simdata::PacketPtr& packet)
 {
+  const atools::fs::sc::SimConnectData& data = *packet;
+
   if(databaseLoadStatus)
     return;
 
@@ -1334,7 +1336,7 @@ void InfoController::simDataChanged(const atools::fs::sc::SimConnectData& data)
     // Last update was more than 500 ms ago
     updateAiAirports(data);
 
-    lastSimData = data;
+    lastSimData = packet;
     if(data.getUserAircraftConst().isFullyValid() && ui->dockWidgetAircraft->isVisible())
     {
       if(tabHandlerAircraft->getCurrentTabId() == ic::AIRCRAFT_USER)
@@ -1402,7 +1404,7 @@ void InfoController::connectedToSimulator()
 void InfoController::disconnectedFromSimulator()
 {
   qDebug() << Q_FUNC_INFO;
-  lastSimData = atools::fs::sc::SimConnectData();
+  lastSimData = simdata::emptyPacket();
   lastSimUpdate = 0;
   updateAircraftInfo();
 }
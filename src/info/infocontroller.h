@@ -18,6 +18,7 @@
 #ifndef LITTLENAVMAP_INFOCONTROLLER_H
 #define LITTLENAVMAP_INFOCONTROLLER_H
 
+#include "connect/simdatapacket.h"
 #include "fs/sc/simconnectdata.h"
 #include "common/mapresult.h"
 #include "common/tabindexes.h"
@@ -97,7 +98,7 @@ public:
   void tracksChanged();
 
   /* Update aircraft and aircraft progress tab */
-  void simDataChanged(const atools::fs::sc::SimConnectData& data);
+  void simDataChanged(const simdata::PacketPtr& packet);
   void connectedToSimulator();
   void disconnectedFromSimulator();
 
@@ -175,7 +176,7 @@ private:
   QString waitingForUpdateText, notConnectedText;
 
   bool databaseLoadStatus = false;
-  atools::fs::sc::SimConnectData lastSimData;
+  simdata::PacketPtr lastSimData = simdata::emptyPacket();
   qint64 lastSimUpdate = 0;
   qint64 lastSimBearingUpdate = 0;
 
@@ -71,6 +71,9 @@ LogdataController::LogdataController(atools::fs::userdata::LogdataManager *logda
 {
   dialog = new atools::gui::Dialog(mainWindow);
 
+  // Keep about two million trail positions
+  trailCache.setMaxCost(2000);
+
   // Do not use a parent to allow the window moving to back
   statsDialog = new LogStatisticsDialog(nullptr, this);
 
@@ -115,7 +118,7 @@ void LogdataController::undoTriggered()
     {
       qDebug() << Q_FUNC_INFO << "Committing";
       transaction.commit();
-      manager->clearGeometryCache();
+      clearGeometryCache();
 
       emit refreshLogSearch(false /* loadAll */, false /* keepSelection */, true /* force */);
       emit logDataChanged();
@@ -146,7 +149,7 @@ void LogdataController::redoTriggered()
     {
       qDebug() << Q_FUNC_INFO << "Committing";
       transaction.commit();
-      manager->clearGeometryCache();
+      clearGeometryCache();
 
       emit refreshLogSearch(false /* loadAll */, false /* keepSelection */, true /* force */);
       emit logDataChanged();
@@ -422,7 +425,7 @@ void LogdataController::createTakeoffLanding(const atools::fs::sc::SimConnectUse
 void LogdataController::logChanged(bool loadAll, bool keepSelection)
 {
   // Clear cache and update map screen index
-  manager->clearGeometryCache();
+  clearGeometryCache();
   manager->updateUndoRedoActions();
 
   emit logDataChanged();
@@ -487,12 +490,12 @@ void LogdataController::preDatabaseLoad()
 
 void LogdataController::postDatabaseLoad()
 {
-  manager->clearGeometryCache();
+  clearGeometryCache();
 }
 
 void LogdataController::displayOptionsChanged()
 {
-  manager->clearGeometryCache();
+  clearGeometryCache();
 }
 
 const atools::fs::gpx::GpxData *LogdataController::getGpxData(int id)
@@ -500,6 +503,34 @@ const atools::fs::gpx::GpxData *LogdataController::getGpxData(int id)
   return manager->getGpxData(id);
 }
 
+const AircraftTrail *LogdataController::getAircraftTrail(int id)
+{
+  AircraftTrail *trail = trailCache.object(id);
+  if(trail == nullptr)
+  {
+    const atools::fs::gpx::GpxData *gpxData = manager->getGpxData(id);
+    if(gpxData != nullptr)
+    {
+      trail = new AircraftTrail;
+      trail->fillTrailFromGpxData(*gpxData);
+
+      // Object is deleted if cost exceeds cache size
+      if(!trailCache.insert(id, trail, trail->size() / 1000 + 1))
+      {
+        qWarning() << Q_FUNC_INFO << "Trail too large for cache" << id;
+        trail = nullptr;
+      }
+    }
+  }
+  return trail;
+}
+
+void LogdataController::clearGeometryCache()
+{
+  manager->clearGeometryCache();
+  trailCache.clear();
+}
+
 void LogdataController::editLogEntryFromMap(int id)
 {
   qDebug() << Q_FUNC_INFO;
@@ -20,6 +20,7 @@
 
 #include "common/maptypes.h"
 
+#include <QCache>
 #include <QObject>
 #include <QVector>
 
@@ -63,6 +64,7 @@ struct MapLogbookEntry;
 
 }
 
+class AircraftTrail;
 class MainWindow;
 class LogStatisticsDialog;
 class LogdataDialog;
@@ -152,6 +154,10 @@ public:
 
   const atools::fs::gpx::GpxData *getGpxData(int id);
 
+  /* Trail of the attached GPX track converted for nearest queries. Kept in a cache until the logbook is changed.
+   * Returns null if entry has no track. */
+  const AircraftTrail *getAircraftTrail(int id);
+
   /* Clear caches */
   void preDatabaseLoad();
   void postDatabaseLoad();
@@ -218,12 +224,18 @@ private:
   void undoTriggered();
   void redoTriggered();
 
+  /* Clear GPX geometry in manager and trail cache */
+  void clearGeometryCache();
+
   /* Remember last aircraft for fuel calculations */
   const atools::fs::sc::SimConnectUserAircraft *aircraftAtTakeoff = nullptr;
   int logEntryId = -1;
 
   LogStatisticsDialog *statsDialog = nullptr;
 
+  /* Trails by logbook id. Cost is number of trail positions in thousands. */
+  QCache<int, AircraftTrail> trailCache;
+
   atools::fs::userdata::LogdataManager *manager;
   atools::gui::Dialog *dialog;
   MainWindow *mainWindow;
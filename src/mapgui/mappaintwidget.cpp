@@ -133,6 +133,12 @@ MapPaintWidget::~MapPaintWidget()
   ATOOLS_DELETE_LOG(mapQuery);
 }
 
+quint64 MapPaintWidget::getContentGeneration() const
+{
+  // Sum of two increasing counters changes whenever one of them changes
+  return contentGeneration + screenIndex->getContentGeneration();
+}
+
 void MapPaintWidget::copySettings(const MapPaintWidget& other)
 {
   paintLayer->copySettings(*other.paintLayer);
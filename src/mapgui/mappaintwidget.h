@@ -344,6 +344,33 @@ public:
     noNavPaint = value;
   }
 
+  /* Request a repaint which is caused by simulator aircraft updates only.
+   * Allows the paint layer to reuse the cached static map layers. */
+  void updateSimOnly()
+  {
+    simOnlyUpdate = true;
+    update();
+  }
+
+  /* Increase content generation for changes drawn in the static layers which are not covered by the static layer key.
+   * Needed since a normal update() and updateSimOnly() can fall into the same paint event.
+   * Connected to route, weather, online, userdata, logbook, airspace and track changes. */
+  void mapContentChanged()
+  {
+    contentGeneration++;
+  }
+
+  /* Content generation including all changes of marks and highlights */
+  quint64 getContentGeneration() const;
+
+  /* true if the current paint was requested by updateSimOnly() only. Resets the flag. */
+  bool takeSimOnlyUpdate()
+  {
+    bool retval = simOnlyUpdate;
+    simOnlyUpdate = false;
+    return retval;
+  }
+
   bool isPaintCopyright() const
   {
     return paintCopyright;
@@ -564,6 +591,12 @@ protected:
   /* Skip the first unneeded render event after mouse events */
   bool skipRender = false;
 
+  /* Set by updateSimOnly() and reset on each render */
+  bool simOnlyUpdate = false;
+
+  /* Increased by mapContentChanged() */
+  quint64 contentGeneration = 0L;
+
 private:
   /* Set map theme and adjust properties accordingly. themePath is the full path to the DGML */
   void setThemeInternal(const QString& themePath);
@@ -42,6 +42,9 @@
 
 #include <marble/GeoDataLineString.h>
 
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+
 using atools::geo::Pos;
 using atools::geo::Line;
 using atools::geo::LineString;
@@ -72,16 +75,19 @@ void assignIdAndInsert(const QString& settingsName, QHash<int, TYPE>& hash)
 MapScreenIndex::MapScreenIndex(MapPaintWidget *mapPaintWidgetParam, MapPaintLayer *mapPaintLayer)
   : mapWidget(mapPaintWidgetParam), paintLayer(mapPaintLayer)
 {
+  contentGeneration.store(0L);
   airportQuery = NavApp::getAirportQuerySim();
 
-  simData = new SimConnectData;
-  lastSimData = new SimConnectData;
+  simData = lastSimData = simdata::emptyPacket();
   lastUserAircraftForAverage = new SimConnectUserAircraft;
   searchHighlights = new map::MapResult;
   procedureHighlight = new proc::MapProcedureLegs;
   procedureLegHighlight = new proc::MapProcedureLeg;
   movingAverageSimAircraft = new atools::util::MovingAverageTime(TURN_PATH_AVERAGE_TIME_MS);
   profileHighlight = new atools::geo::Pos;
+
+  benchmarkGrids = atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_MAP_SCREEN_INDEX_BENCHMARK_DEBUG,
+                                                                           false).toBool();
 }
 
 MapScreenIndex::~MapScreenIndex()
@@ -90,8 +96,6 @@ MapScreenIndex::~MapScreenIndex()
   delete procedureLegHighlight;
   delete procedureHighlight;
   delete movingAverageSimAircraft;
-  delete simData;
-  delete lastSimData;
   delete lastUserAircraftForAverage;
   delete profileHighlight;
 }
@@ -99,8 +103,8 @@ MapScreenIndex::~MapScreenIndex()
 void MapScreenIndex::copy(const MapScreenIndex& other)
 {
   // Copy content of pointer objects
-  *simData = *other.simData;
-  *lastSimData = *other.lastSimData;
+  simData = other.simData;
+  lastSimData = other.lastSimData;
   *searchHighlights = *other.searchHighlights;
   *procedureLegHighlight = *other.procedureLegHighlight;
   *procedureHighlight = *other.procedureHighlight;
@@ -126,6 +130,14 @@ void MapScreenIndex::copy(const MapScreenIndex& other)
   ilsLines = other.ilsLines;
   routePointsEditable = other.routePointsEditable;
   routePointsAll = other.routePointsAll;
+  routeLinesGrid = other.routeLinesGrid;
+  routePointsEditableGrid = other.routePointsEditableGrid;
+  routePointsAllGrid = other.routePointsAllGrid;
+  airwayLinesGrid = other.airwayLinesGrid;
+  logEntryLinesGrid = other.logEntryLinesGrid;
+  airspacePolygonsGrid = other.airspacePolygonsGrid;
+  ilsPolygonsGrid = other.ilsPolygonsGrid;
+  ilsLinesGrid = other.ilsLinesGrid;
   lastUserAircraftForAverageTs = other.lastUserAircraftForAverageTs;
   routeDrawnNavaids = other.routeDrawnNavaids;
 }
@@ -165,6 +177,10 @@ void MapScreenIndex::updateAirspaceScreenGeometryInternal(QSet<map::MapAirspaceI
         airspaces.append(&airspace);
     }
 
+    // Same simplified geometry as used by the airspace painter
+    const MapScale *scale = paintLayer->getMapScale();
+    float maxErrorDeg = scale != nullptr && scale->isValid() ? scale->getNmPerPixel() / 60.f : 0.f;
+
     CoordinateConverter conv(mapWidget->viewport());
     for(const map::MapAirspace *airspace : qAsConst(airspaces))
     {
@@ -176,7 +192,7 @@ void MapScreenIndex::updateAirspaceScreenGeometryInternal(QSet<map::MapAirspaceI
       // Check if airspace overlaps with current screen and is not already in list
       if(airspacebox.intersects(curBox) && !ids.contains(airspace->combinedId()))
       {
-        const atools::geo::LineString *lines = controller->getAirspaceGeometry(airspace->combinedId());
+        const atools::geo::LineString *lines = controller->getAirspaceGeometry(airspace->combinedId(), maxErrorDeg);
         if(lines != nullptr)
         {
           const QVector<QPolygonF *> polys = conv.createPolygons(*lines, mapWidget->rect());
@@ -203,11 +219,14 @@ void MapScreenIndex::resetIlsScreenGeometry()
 {
   ilsPolygons.clear();
   ilsLines.clear();
+  ilsPolygonsGrid.clear();
+  ilsLinesGrid.clear();
 }
 
 void MapScreenIndex::updateAirspaceScreenGeometry(const Marble::GeoDataLatLonBox& curBox)
 {
   airspacePolygons.clear();
+  airspacePolygonsGrid.clear();
   if(paintLayer == nullptr || paintLayer->getMapLayer() == nullptr)
     return;
 
@@ -327,6 +346,7 @@ void MapScreenIndex::updateIlsScreenGeometry(const Marble::GeoDataLatLonBox& cur
 void MapScreenIndex::updateLogEntryScreenGeometry(const Marble::GeoDataLatLonBox& curBox)
 {
   logEntryLines.clear();
+  logEntryLinesGrid.clear();
 
   const MapScale *scale = paintLayer->getMapScale();
 
@@ -368,6 +388,7 @@ void MapScreenIndex::updateAirwayScreenGeometry(const Marble::GeoDataLatLonBox&
     return;
 
   airwayLines.clear();
+  airwayLinesGrid.clear();
 
   // Use ID set to check for duplicates between calls
   QSet<int> ids;
@@ -501,6 +522,7 @@ void MapScreenIndex::saveState() const
 
 void MapScreenIndex::restoreState()
 {
+  contentGeneration++;
   assignIdAndInsert<map::DistanceMarker>(lnm::MAP_DISTANCEMARKERS, distanceMarks);
   assignIdAndInsert<map::RangeMarker>(lnm::MAP_RANGEMARKERS, rangeMarks);
   assignIdAndInsert<map::PatternMarker>(lnm::MAP_TRAFFICPATTERNS, patternMarks);
@@ -510,26 +532,31 @@ void MapScreenIndex::restoreState()
 
 void MapScreenIndex::changeSearchHighlights(const map::MapResult& newHighlights)
 {
+  contentGeneration++;
   *searchHighlights = newHighlights;
 }
 
 void MapScreenIndex::setProcedureHighlights(const QVector<proc::MapProcedureLegs>& value)
 {
+  contentGeneration++;
   procedureHighlights = value;
 }
 
 void MapScreenIndex::setProcedureHighlight(const proc::MapProcedureLegs& newHighlight)
 {
+  contentGeneration++;
   *procedureHighlight = newHighlight;
 }
 
 void MapScreenIndex::setProcedureLegHighlight(const proc::MapProcedureLeg& newLegHighlight)
 {
+  contentGeneration++;
   *procedureLegHighlight = newLegHighlight;
 }
 
 void MapScreenIndex::addRangeMark(const map::RangeMarker& obj)
 {
+  contentGeneration++;
 #ifdef DEBUG_INFORMATION
   qDebug() << Q_FUNC_INFO << obj.id;
 #endif
@@ -538,6 +565,7 @@ void MapScreenIndex::addRangeMark(const map::RangeMarker& obj)
 
 void MapScreenIndex::addPatternMark(const map::PatternMarker& obj)
 {
+  contentGeneration++;
 #ifdef DEBUG_INFORMATION
   qDebug() << Q_FUNC_INFO << obj.id;
 #endif
@@ -546,6 +574,7 @@ void MapScreenIndex::addPatternMark(const map::PatternMarker& obj)
 
 void MapScreenIndex::addDistanceMark(const map::DistanceMarker& obj)
 {
+  contentGeneration++;
 #ifdef DEBUG_INFORMATION
   qDebug() << Q_FUNC_INFO << obj.id;
 #endif
@@ -554,6 +583,7 @@ void MapScreenIndex::addDistanceMark(const map::DistanceMarker& obj)
 
 void MapScreenIndex::addHoldingMark(const map::HoldingMarker& obj)
 {
+  contentGeneration++;
 #ifdef DEBUG_INFORMATION
   qDebug() << Q_FUNC_INFO << obj.id;
 #endif
@@ -562,6 +592,7 @@ void MapScreenIndex::addHoldingMark(const map::HoldingMarker& obj)
 
 void MapScreenIndex::addMsaMark(const map::MsaMarker& obj)
 {
+  contentGeneration++;
 #ifdef DEBUG_INFORMATION
   qDebug() << Q_FUNC_INFO << obj.id;
 #endif
@@ -570,6 +601,7 @@ void MapScreenIndex::addMsaMark(const map::MsaMarker& obj)
 
 void MapScreenIndex::removeRangeMark(int id)
 {
+  contentGeneration++;
 #ifdef DEBUG_INFORMATION
   qDebug() << Q_FUNC_INFO << id;
 #endif
@@ -578,6 +610,7 @@ void MapScreenIndex::removeRangeMark(int id)
 
 void MapScreenIndex::removePatternMark(int id)
 {
+  contentGeneration++;
 #ifdef DEBUG_INFORMATION
   qDebug() << Q_FUNC_INFO << id;
 #endif
@@ -586,6 +619,7 @@ void MapScreenIndex::removePatternMark(int id)
 
 void MapScreenIndex::removeDistanceMark(int id)
 {
+  contentGeneration++;
 #ifdef DEBUG_INFORMATION
   qDebug() << Q_FUNC_INFO << id;
 #endif
@@ -594,6 +628,7 @@ void MapScreenIndex::removeDistanceMark(int id)
 
 void MapScreenIndex::removeHoldingMark(int id)
 {
+  contentGeneration++;
 #ifdef DEBUG_INFORMATION
   qDebug() << Q_FUNC_INFO << id;
 #endif
@@ -602,6 +637,7 @@ void MapScreenIndex::removeHoldingMark(int id)
 
 void MapScreenIndex::removeMsaMark(int id)
 {
+  contentGeneration++;
 #ifdef DEBUG_INFORMATION
   qDebug() << Q_FUNC_INFO << id;
 #endif
@@ -610,6 +646,7 @@ void MapScreenIndex::removeMsaMark(int id)
 
 void MapScreenIndex::clearAllMarkers(map::MapTypes types)
 {
+  contentGeneration++;
   if(types.testFlag(map::MARK_RANGE))
     rangeMarks.clear();
 
@@ -628,16 +665,19 @@ void MapScreenIndex::clearAllMarkers(map::MapTypes types)
 
 void MapScreenIndex::updateDistanceMarkerFromPos(int id, const atools::geo::Pos& pos)
 {
+  contentGeneration++;
   distanceMarks[id].from = pos;
 }
 
 void MapScreenIndex::updateDistanceMarkerToPos(int id, const atools::geo::Pos& pos)
 {
+  contentGeneration++;
   distanceMarks[id].to = distanceMarks[id].position = pos;
 }
 
 void MapScreenIndex::updateDistanceMarker(int id, const map::DistanceMarker& marker)
 {
+  contentGeneration++;
   distanceMarks[id] = marker;
   distanceMarks[id].id = id;
 }
@@ -659,12 +699,12 @@ const QVector<atools::fs::sc::SimConnectAircraft>& MapScreenIndex::getAiAircraft
 
 void MapScreenIndex::clearSimData()
 {
-  updateSimData(SimConnectData());
+  updateSimData(simdata::emptyPacket());
 }
 
-void MapScreenIndex::updateSimData(const atools::fs::sc::SimConnectData& data)
+void MapScreenIndex::updateSimData(const simdata::PacketPtr& packet)
 {
-  *simData = data;
+  simData = packet;
   updateAverageTurn();
 }
 
@@ -734,13 +774,14 @@ void MapScreenIndex::getAverageGroundAndTurnSpeed(float& groundSpeedKts, float&
 #endif
 }
 
-void MapScreenIndex::updateLastSimData(const atools::fs::sc::SimConnectData& data)
+void MapScreenIndex::updateLastSimData(const simdata::PacketPtr& packet)
 {
-  *lastSimData = data;
+  lastSimData = packet;
 }
 
 void MapScreenIndex::setProfileHighlight(const atools::geo::Pos& value)
 {
+  contentGeneration++;
   *profileHighlight = value;
 }
 
@@ -759,6 +800,9 @@ void MapScreenIndex::updateRouteScreenGeometry(const Marble::GeoDataLatLonBox& c
   routeLines.clear();
   routePointsEditable.clear();
   routePointsAll.clear();
+  routeLinesGrid.clear();
+  routePointsEditableGrid.clear();
+  routePointsAllGrid.clear();
 
   QList<std::pair<int, QPoint> > airportPoints;
   QList<std::pair<int, QPoint> > otherPointsEditable;
@@ -1019,16 +1063,11 @@ void MapScreenIndex::getAllNearest(const QPoint& point, int maxDistance, map::Ma
     // Trail is only shown for single selection
     if(types.testFlag(map::QUERY_AIRCRAFT_TRAIL_LOG) && searchHighlights->logbookEntries.size() == 1)
     {
-      const atools::fs::gpx::GpxData *gpxData =
-        NavApp::getLogdataController()->getGpxData(searchHighlights->logbookEntries.constFirst().id);
-      if(gpxData != nullptr)
-      {
-        AircraftTrail trail;
-        trail.fillTrailFromGpxData(*gpxData);
-
+      // Trail is converted from GPX once and cached until logbook changes
+      const AircraftTrail *trail = NavApp::getLogdataController()->getAircraftTrail(searchHighlights->logbookEntries.constFirst().id);
+      if(trail != nullptr)
         // Get nearest (one) trail segment from logbook preview and provide screen coordinate conversion function
-        result.trailSegmentLog = trail.findNearest(point, pos, maxDistance, mapWidget->viewport()->viewLatLonAltBox(), coordinateFunc);
-      }
+        result.trailSegmentLog = trail->findNearest(point, pos, maxDistance, mapWidget->viewport()->viewLatLonAltBox(), coordinateFunc);
     }
   }
 }
@@ -1232,8 +1271,13 @@ int MapScreenIndex::getNearestRoutePointIndex(int xs, int ys, int maxDistance, b
   int minIndex = -1;
   float minDist = map::INVALID_DISTANCE_VALUE;
 
-  for(const std::pair<int, QPoint>& rsp : (editableOnly ? routePointsEditable : routePointsAll))
+  const QList<std::pair<int, QPoint> >& points = editableOnly ? routePointsEditable : routePointsAll;
+  QVector<int> indexes;
+  indexGrid(editableOnly ? routePointsEditableGrid : routePointsAllGrid, points).query(indexes, xs, ys, maxDistance);
+
+  for(int index : qAsConst(indexes))
   {
+    const std::pair<int, QPoint>& rsp = points.at(index);
     const QPoint& point = rsp.second;
     float dist = atools::geo::manhattanDistance(point.x(), point.y(), xs, ys);
     if(dist < minDist && dist < maxDistance)
@@ -1253,24 +1297,121 @@ void MapScreenIndex::updateAllGeometry(const Marble::GeoDataLatLonBox& curBox)
   updateLogEntryScreenGeometry(curBox);
   updateAirspaceScreenGeometry(curBox);
   updateIlsScreenGeometry(curBox);
+
+  // Build spatial index now instead of on first mouse movement
+  updateIndexGrids();
+
+  if(benchmarkGrids)
+    benchmarkIndexGrids();
+}
+
+template<typename LIST>
+const ScreenIndexGrid& MapScreenIndex::indexGrid(ScreenIndexGrid& grid, const LIST& list) const
+{
+  if(!grid.isValid())
+    grid.build(list, mapWidget->rect());
+  return grid;
+}
+
+void MapScreenIndex::updateIndexGrids() const
+{
+  indexGrid(routeLinesGrid, routeLines);
+  indexGrid(routePointsEditableGrid, routePointsEditable);
+  indexGrid(routePointsAllGrid, routePointsAll);
+  indexGrid(airwayLinesGrid, airwayLines);
+  indexGrid(logEntryLinesGrid, logEntryLines);
+  indexGrid(airspacePolygonsGrid, airspacePolygons);
+  indexGrid(ilsPolygonsGrid, ilsPolygons);
+  indexGrid(ilsLinesGrid, ilsLines);
+}
+
+void MapScreenIndex::benchmarkIndexGrids() const
+{
+  const int NUM_QUERIES = 1000, MAX_DISTANCE = 10;
+  QRect rect = mapWidget->rect();
+  if(rect.isEmpty())
+    return;
+
+  // Same random positions for both runs
+  QVector<QPoint> points;
+  QRandomGenerator random(1);
+  for(int i = 0; i < NUM_QUERIES; i++)
+    points.append(QPoint(random.bounded(rect.width()), random.bounded(rect.height())));
+
+  // Linear scan =========================
+  QElapsedTimer timer;
+  timer.start();
+  int numLinear = 0;
+  for(const QPoint& point : qAsConst(points))
+  {
+    for(const std::pair<int, QLine>& linePair : airwayLines)
+    {
+      const QLine& line = linePair.second;
+      if(atools::geo::distanceToLine(point.x(), point.y(), line.x1(), line.y1(), line.x2(), line.y2(), true) < MAX_DISTANCE)
+        numLinear++;
+    }
+
+    for(const std::pair<map::MapAirspaceId, QPolygon>& polyPair : airspacePolygons)
+    {
+      if(polyPair.second.containsPoint(point, Qt::OddEvenFill))
+        numLinear++;
+    }
+  }
+  qint64 linearNs = timer.nsecsElapsed();
+
+  // Grid =========================
+  timer.restart();
+  int numGrid = 0;
+  QVector<int> indexes;
+  for(const QPoint& point : qAsConst(points))
+  {
+    airwayLinesGrid.query(indexes, point.x(), point.y(), MAX_DISTANCE);
+    for(int index : qAsConst(indexes))
+    {
+      const QLine& line = airwayLines.at(index).second;
+      if(atools::geo::distanceToLine(point.x(), point.y(), line.x1(), line.y1(), line.x2(), line.y2(), true) < MAX_DISTANCE)
+        numGrid++;
+    }
+
+    airspacePolygonsGrid.query(indexes, QRect(point, QSize(1, 1)));
+    for(int index : qAsConst(indexes))
+    {
+      if(airspacePolygons.at(index).second.containsPoint(point, Qt::OddEvenFill))
+        numGrid++;
+    }
+  }
+  qint64 gridNs = timer.nsecsElapsed();
+
+  qInfo() << Q_FUNC_INFO << "queries" << NUM_QUERIES << "airway lines" << airwayLines.size()
+          << "airspace polygons" << airspacePolygons.size()
+          << "linear" << linearNs / NUM_QUERIES << "ns/query"
+          << "grid" << gridNs / NUM_QUERIES << "ns/query"
+          << "hits" << numLinear << numGrid;
 }
 
 void MapScreenIndex::getNearestAirspaces(int xs, int ys, map::MapResult& result) const
 {
-  for(const std::pair<map::MapAirspaceId, QPolygon>& polyPair : airspacePolygons)
+  QVector<int> indexes;
+  indexGrid(airspacePolygonsGrid, airspacePolygons).query(indexes, QRect(xs, ys, 1, 1));
+
+  for(int index : qAsConst(indexes))
   {
+    const std::pair<map::MapAirspaceId, QPolygon>& polyPair = airspacePolygons.at(index);
     if(polyPair.second.containsPoint(QPoint(xs, ys), Qt::OddEvenFill))
       result.airspaces.append(NavApp::getAirspaceController()->getAirspaceById(polyPair.first));
   }
 }
 
-QSet<int> MapScreenIndex::nearestLineIds(const QList<std::pair<int, QLine> >& lineList, int xs, int ys,
+QSet<int> MapScreenIndex::nearestLineIds(const QList<std::pair<int, QLine> >& lineList, ScreenIndexGrid& grid, int xs, int ys,
                                          int maxDistance, bool lineDistanceOnly) const
 {
+  QVector<int> indexes;
+  indexGrid(grid, lineList).query(indexes, xs, ys, maxDistance);
+
   QSet<int> ids;
-  for(int i = 0; i < lineList.size(); i++)
+  for(int index : qAsConst(indexes))
   {
-    const std::pair<int, QLine>& linePair = lineList.at(i);
+    const std::pair<int, QLine>& linePair = lineList.at(index);
     const QLine& line = linePair.second;
 
     if(atools::geo::distanceToLine(xs, ys, line.x1(), line.y1(), line.x2(), line.y2(), lineDistanceOnly) < maxDistance)
@@ -1299,7 +1440,7 @@ void MapScreenIndex::getNearestLogEntries(int xs, int ys, int maxDistance, map::
   if(paintLayer->getShownMapDisplayTypes().testFlag(map::LOGBOOK_DIRECT) ||
      paintLayer->getShownMapDisplayTypes().testFlag(map::LOGBOOK_ROUTE))
   {
-    const QSet<int> nearestIds = nearestLineIds(logEntryLines, xs, ys, maxDistance, false /* also distance to points */);
+    const QSet<int> nearestIds = nearestLineIds(logEntryLines, logEntryLinesGrid, xs, ys, maxDistance, false /* also distance to points */);
     for(int id : nearestIds)
       maptools::insertSortedByDistance(conv, result.logbookEntries, &ids, xs, ys,
                                        NavApp::getLogdataController()->getLogEntryById(id));
@@ -1314,12 +1455,14 @@ void MapScreenIndex::getNearestIls(int xs, int ys, int maxDistance, map::MapResu
     return;
 
   // Get nearest center lines (also considering buffer)
-  QSet<int> ilsIds = nearestLineIds(ilsLines, xs, ys, maxDistance, false /* lineDistanceOnly */);
+  QSet<int> ilsIds = nearestLineIds(ilsLines, ilsLinesGrid, xs, ys, maxDistance, false /* lineDistanceOnly */);
 
   // Get nearest ILS by geometry - duplicates are removed in set
-  for(int i = 0; i < ilsPolygons.size(); i++)
+  QVector<int> indexes;
+  indexGrid(ilsPolygonsGrid, ilsPolygons).query(indexes, QRect(xs, ys, 1, 1));
+  for(int index : qAsConst(indexes))
   {
-    const std::pair<int, QPolygon>& polyPair = ilsPolygons.at(i);
+    const std::pair<int, QPolygon>& polyPair = ilsPolygons.at(index);
     if(polyPair.second.containsPoint(QPoint(xs, ys), Qt::OddEvenFill))
       ilsIds.insert(polyPair.first);
   }
@@ -1334,7 +1477,7 @@ void MapScreenIndex::getNearestIls(int xs, int ys, int maxDistance, map::MapResu
 void MapScreenIndex::getNearestAirways(int xs, int ys, int maxDistance, map::MapResult& result) const
 {
   AirwayTrackQuery *airwayTrackQuery = mapWidget->getAirwayTrackQuery();
-  const QSet<int> nearestIds = nearestLineIds(airwayLines, xs, ys, maxDistance, true /* lineDistanceOnly */);
+  const QSet<int> nearestIds = nearestLineIds(airwayLines, airwayLinesGrid, xs, ys, maxDistance, true /* lineDistanceOnly */);
   for(int id : nearestIds)
     result.airways.append(airwayTrackQuery->getAirwayById(id));
 }
@@ -1347,9 +1490,12 @@ int MapScreenIndex::getNearestRouteLegIndex(int xs, int ys, int maxDistance) con
   int minIndex = -1;
   float minDist = std::numeric_limits<float>::max();
 
-  for(int i = 0; i < routeLines.size(); i++)
+  QVector<int> indexes;
+  indexGrid(routeLinesGrid, routeLines).query(indexes, xs, ys, maxDistance);
+
+  for(int index : qAsConst(indexes))
   {
-    const std::pair<int, QLine>& line = routeLines.at(i);
+    const std::pair<int, QLine>& line = routeLines.at(index);
 
     QLine l = line.second;
 
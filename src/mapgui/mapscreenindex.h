@@ -19,10 +19,14 @@
 #define LITTLENAVMAP_MAPSCREENINDEX_H
 
 #include "common/mapflags.h"
+#include "connect/simdatapacket.h"
+#include "mapgui/screenindexgrid.h"
 
 #include <QDateTime>
 #include <QHash>
 
+#include <atomic>
+
 namespace atools {
 namespace fs {
 namespace sc {
@@ -138,6 +142,12 @@ public:
   void saveState() const;
   void restoreState();
 
+  /* Increased whenever marks or highlights are changed. Thread safe. Used to detect changes drawn on the map. */
+  quint64 getContentGeneration() const
+  {
+    return contentGeneration.load();
+  }
+
   /* Get objects that are highlighted because of selected flight plan legs in the table */
   const QList<int>& getRouteHighlights() const
   {
@@ -146,6 +156,7 @@ public:
 
   void setRouteHighlights(const QList<int>& value)
   {
+    contentGeneration++;
     routeHighlights = value;
   }
 
@@ -254,9 +265,9 @@ public:
 
   void clearSimData();
 
-  void updateSimData(const atools::fs::sc::SimConnectData& data);
+  void updateSimData(const simdata::PacketPtr& packet);
 
-  void updateLastSimData(const atools::fs::sc::SimConnectData& data);
+  void updateLastSimData(const simdata::PacketPtr& packet);
 
   void setProfileHighlight(const atools::geo::Pos& value);
 
@@ -274,11 +285,13 @@ public:
 
   void changeAirspaceHighlights(const QList<map::MapAirspace>& value)
   {
+    contentGeneration++;
     airspaceHighlights = value;
   }
 
   void changeAirwayHighlights(const QList<QList<map::MapAirway> >& value)
   {
+    contentGeneration++;
     airwayHighlights = value;
   }
 
@@ -321,12 +334,24 @@ private:
   /* Fill average values for ground speed and turn speed for turn path display. */
   void updateAverageTurn();
 
-  QSet<int> nearestLineIds(const QList<std::pair<int, QLine> >& lineList, int xs, int ys, int maxDistance, bool lineDistanceOnly) const;
+  QSet<int> nearestLineIds(const QList<std::pair<int, QLine> >& lineList, ScreenIndexGrid& grid, int xs, int ys, int maxDistance,
+                           bool lineDistanceOnly) const;
+
+  /* Get grid for list and build it if the list was changed */
+  template<typename LIST>
+  const ScreenIndexGrid& indexGrid(ScreenIndexGrid& grid, const LIST& list) const;
+
+  /* Build all grids which are not valid */
+  void updateIndexGrids() const;
+
+  /* Compare linear scan and grid query for random positions and print result to log */
+  void benchmarkIndexGrids() const;
 
   template<typename TYPE>
   int getNearestId(int xs, int ys, int maxDistance, const QHash<int, TYPE>& typeList) const;
 
-  atools::fs::sc::SimConnectData *simData, *lastSimData;
+  /* Shared packets from ConnectClient. Never null. */
+  simdata::PacketPtr simData, lastSimData;
 
   /* Average values for ground speed and turn speed for turn path display. */
   atools::fs::sc::SimConnectUserAircraft *lastUserAircraftForAverage;
@@ -339,6 +364,9 @@ private:
   AirportQuery *airportQuery;
   MapPaintLayer *paintLayer;
 
+  /* Increased by all methods changing marks or highlights */
+  std::atomic<quint64> contentGeneration;
+
   /* All highlights from search windows - also online airspaces */
   map::MapResult *searchHighlights;
 
@@ -387,6 +415,13 @@ private:
   QList<std::pair<int, QPolygon> > ilsPolygons;
   QList<std::pair<int, QLine> > ilsLines; /* Index ILS center lines separately to allow
                                            * tooltips when getting the cursor near a line */
+
+  /* Spatial index for the lists above. Cleared together with the list and built on first query or in updateAllGeometry(). */
+  mutable ScreenIndexGrid routeLinesGrid, routePointsEditableGrid, routePointsAllGrid, airwayLinesGrid, logEntryLinesGrid,
+                          airspacePolygonsGrid, ilsPolygonsGrid, ilsLinesGrid;
+
+  /* Log timing of hit testing after each update */
+  bool benchmarkGrids = false;
 };
 
 #endif // LITTLENAVMAP_MAPSCREENINDEX_H
@@ -25,6 +25,7 @@
 #include "util/xmlstream.h"
 #include "mapgui/mapwidget.h"
 #include "app/navapp.h"
+#include "web/webmapcontroller.h"
 #include "ui_mainwindow.h"
 #include "gui/dialog.h"
 #include "gui/widgetstate.h"
@@ -748,8 +749,8 @@ void MapThemeHandler::changeMapTheme()
   qDebug() << Q_FUNC_INFO << themeId << theme;
 
   mapWidget->setTheme(theme.getDgmlFilepath(), themeId);
-  if(NavApp::getMapPaintWidgetWeb() != nullptr)
-    NavApp::getMapPaintWidgetWeb()->setTheme(theme.getDgmlFilepath(), themeId);
+  if(NavApp::getWebMapController() != nullptr)
+    NavApp::getWebMapController()->setTheme(theme.getDgmlFilepath(), themeId);
 
   NavApp::setStatusMessage(tr("Map theme changed to %1.").arg(actionGroupMapTheme->checkedAction()->text()));
 }
@@ -805,8 +806,8 @@ void MapThemeHandler::optionsChanged()
     currentThemeId = defaultTheme.getThemeId();
     NavApp::getMapWidgetGui()->setTheme(defaultTheme.getDgmlFilepath(), currentThemeId);
 
-    if(NavApp::getMapPaintWidgetWeb() != nullptr)
-      NavApp::getMapPaintWidgetWeb()->setTheme(defaultTheme.getDgmlFilepath(), currentThemeId);
+    if(NavApp::getWebMapController() != nullptr)
+      NavApp::getWebMapController()->setTheme(defaultTheme.getDgmlFilepath(), currentThemeId);
   }
 
   // Check the theme action
@@ -127,6 +127,9 @@ const static QHash<opts::SimUpdateRate, SimUpdateDelta> SIM_UPDATE_DELTA_MAP_CLO
 // Do not zoom closer automatically
 static float MIN_AUTO_ZOOM_NM = 0.2f;
 
+// Append new trail positions to the files once this number is collected
+static const int TRAIL_FLUSH_POSITIONS = 50;
+
 // Maps minimum zoom in NM by altitude above ground in ft
 // Use odd numbers to avoid jumping at typical flown altitude levels
 static const QVector<std::pair<float, float> > ALT_TO_MIN_ZOOM_FT_NM =
@@ -2397,8 +2400,10 @@ void MapWidget::showGridConfiguration()
   }
 }
 
-void MapWidget::simDataChanged(const atools::fs::sc::SimConnectData& simulatorData)
+void MapWidget::simDataChanged(const simdata::PacketPtr& packet)
 {
+  const atools::fs::sc::SimConnectData& simulatorData = *packet;
+
   using atools::almostNotEqual;
   using atools::geo::angleAbsDiff;
 
@@ -2407,11 +2412,11 @@ void MapWidget::simDataChanged(const atools::fs::sc::SimConnectData& simulatorDa
   // Emit signal later once all values are updated - check for aircraft state changes
   bool userAircraftValidToggled = getScreenIndexConst()->getUserAircraft().isFullyValid() != aircraft.isFullyValid();
 
-  getScreenIndex()->updateSimData(simulatorData);
+  getScreenIndex()->updateSimData(packet);
 
   if(databaseLoadStatus || !aircraft.isValid())
   {
-    getScreenIndex()->updateLastSimData(atools::fs::sc::SimConnectData());
+    getScreenIndex()->updateLastSimData(simdata::emptyPacket());
 
     // Update action states if needed
     if(userAircraftValidToggled)
@@ -2469,6 +2474,12 @@ void MapWidget::simDataChanged(const atools::fs::sc::SimConnectData& simulatorDa
   if(pruned)
     emit aircraftTrackPruned();
 
+  // Files are append only and write only new positions - keeps saving on exit short and avoids loss on crashes
+  if(aircraftTrail->getNumUnsavedPositions() >= TRAIL_FLUSH_POSITIONS)
+    aircraftTrail->saveState(lnm::AIRCRAFT_TRACK_SUFFIX, 2 /* numBackups */);
+  if(aircraftTrailLogbook->getNumUnsavedPositions() >= TRAIL_FLUSH_POSITIONS)
+    aircraftTrailLogbook->saveState(lnm::LOGBOOK_TRACK_SUFFIX, 0 /* numBackups */);
+
   if(wasEmpty != aircraftTrail->isEmpty())
     // We have a track - update toolbar and menu
     emit updateActionStates();
@@ -2564,7 +2575,7 @@ void MapWidget::simDataChanged(const atools::fs::sc::SimConnectData& simulatorDa
 
     if(dataHasChanged)
       // Also changes local "last"
-      getScreenIndex()->updateLastSimData(simulatorData);
+      getScreenIndex()->updateLastSimData(packet);
 
     // Option to udpate always
     bool updateAlways = od.getFlags() & opts::SIM_UPDATE_MAP_CONSTANTLY;
@@ -2799,8 +2810,8 @@ void MapWidget::simDataChanged(const atools::fs::sc::SimConnectData& simulatorDa
     // touchdownDetected = false;
 
     if((dataHasChanged || aiVisible) && !contextMenuActive)
-      // Not scrolled or zoomed but needs a redraw
-      update();
+      // Not scrolled or zoomed but needs a redraw - static layers can be taken from cache if nothing else changed
+      updateSimOnly();
 
     if(!updatesEnabled())
       setUpdatesEnabled(true);
@@ -3978,7 +3989,7 @@ void MapWidget::debugMovingPlane(QMouseEvent *event)
                                                                   perf.isJetFuel(), helicopter);
       data.setPacketId(packetId++);
 
-      emit NavApp::getConnectClient()->dataPacketReceived(data);
+      emit NavApp::getConnectClient()->dataPacketReceived(simdata::makePacket(std::move(data)));
       lastPos = pos;
       lastPoint = event->pos();
     }
@@ -139,7 +139,7 @@ public:
   void startUserpointDrag(const map::MapUserpoint& userpoint, const QPoint& point);
 
   /* New data from simconnect has arrived. Update aircraft position and track. */
-  void simDataChanged(const atools::fs::sc::SimConnectData& simulatorData);
+  void simDataChanged(const simdata::PacketPtr& packet);
 
   /* Update sun shading from UI elements */
   void updateSunShadingOption();
@@ -0,0 +1,110 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "mapgui/screenindexgrid.h"
+
+#include "atools.h"
+
+#include <algorithm>
+
+void ScreenIndexGrid::clear()
+{
+  screen = QRect();
+  columns = rows = 0;
+  valid = false;
+  cellStart.clear();
+  items.clear();
+}
+
+void ScreenIndexGrid::cellRange(const QRect& rect, int& column1, int& row1, int& column2, int& row2) const
+{
+  column1 = atools::minmax(0, columns - 1, (rect.left() - screen.left()) / CELL_SIZE_PIXEL);
+  column2 = atools::minmax(0, columns - 1, (rect.right() - screen.left()) / CELL_SIZE_PIXEL);
+  row1 = atools::minmax(0, rows - 1, (rect.top() - screen.top()) / CELL_SIZE_PIXEL);
+  row2 = atools::minmax(0, rows - 1, (rect.bottom() - screen.top()) / CELL_SIZE_PIXEL);
+}
+
+void ScreenIndexGrid::build(const QVector<QRect>& boundings, const QRect& screenRect)
+{
+  clear();
+  valid = true;
+
+  if(boundings.isEmpty() || !screenRect.isValid())
+    return;
+
+  screen = screenRect;
+  columns = (screen.width() + CELL_SIZE_PIXEL - 1) / CELL_SIZE_PIXEL;
+  rows = (screen.height() + CELL_SIZE_PIXEL - 1) / CELL_SIZE_PIXEL;
+
+  // Count items for each cell =========================
+  cellStart.fill(0, columns * rows + 1);
+  int column1, row1, column2, row2;
+  for(const QRect& rect : boundings)
+  {
+    cellRange(rect, column1, row1, column2, row2);
+    for(int row = row1; row <= row2; row++)
+    {
+      for(int column = column1; column <= column2; column++)
+        cellStart[row * columns + column + 1]++;
+    }
+  }
+
+  // Convert counts to start offsets =========================
+  for(int i = 1; i < cellStart.size(); i++)
+    cellStart[i] += cellStart.at(i - 1);
+
+  // Fill items =========================
+  items.resize(cellStart.constLast());
+  QVector<int> fill(cellStart);
+  for(int i = 0; i < boundings.size(); i++)
+  {
+    cellRange(boundings.at(i), column1, row1, column2, row2);
+    for(int row = row1; row <= row2; row++)
+    {
+      for(int column = column1; column <= column2; column++)
+        items[fill[row * columns + column]++] = i;
+    }
+  }
+}
+
+void ScreenIndexGrid::query(QVector<int>& indexes, const QRect& rect) const
+{
+  indexes.clear();
+
+  if(items.isEmpty())
+    return;
+
+  int column1, row1, column2, row2;
+  cellRange(rect, column1, row1, column2, row2);
+  for(int row = row1; row <= row2; row++)
+  {
+    for(int column = column1; column <= column2; column++)
+    {
+      int cell = row * columns + column;
+      for(int i = cellStart.at(cell); i < cellStart.at(cell + 1); i++)
+        indexes.append(items.at(i));
+    }
+  }
+
+  // Objects can span more than one cell - sort to keep list order and remove duplicates
+  if(row1 != row2 || column1 != column2)
+  {
+    std::sort(indexes.begin(), indexes.end());
+    indexes.erase(std::unique(indexes.begin(), indexes.end()), indexes.end());
+  }
+}
@@ -0,0 +1,106 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LNM_SCREENINDEXGRID_H
+#define LNM_SCREENINDEXGRID_H
+
+#include <QRect>
+#include <QVector>
+
+/*
+ * Uniform grid in screen coordinates for fast hit testing of lines, polygons and points.
+ *
+ * Stores the indexes of objects into a list for each grid cell covered by the object bounding rectangle.
+ * Objects outside the screen rectangle are put into the nearest border cells.
+ *
+ * Built once after the screen geometry changed and queried on mouse movement.
+ * Cells are stored in a flat array with start offsets to avoid many small allocations.
+ */
+class ScreenIndexGrid
+{
+public:
+  /* Build grid for bounding rectangles. Index in "boundings" is the object index. */
+  void build(const QVector<QRect>& boundings, const QRect& screenRect);
+
+  /* Build grid for a list of pairs of id and a geometry. QLine, QPolygon and QPoint are supported. */
+  template<typename LIST>
+  void build(const LIST& list, const QRect& screenRect);
+
+  void clear();
+
+  /* Get sorted and unique indexes of all objects which bounding rectangle might overlap "rect" */
+  void query(QVector<int>& indexes, const QRect& rect) const;
+
+  /* Get indexes for all objects which might be within "maxDistance" of the screen position */
+  void query(QVector<int>& indexes, int xs, int ys, int maxDistance) const
+  {
+    query(indexes, QRect(xs - maxDistance, ys - maxDistance, maxDistance * 2 + 1, maxDistance * 2 + 1));
+  }
+
+  bool isEmpty() const
+  {
+    return items.isEmpty();
+  }
+
+  /* false if cleared and not built yet */
+  bool isValid() const
+  {
+    return valid;
+  }
+
+  /* Size of a grid cell in pixels */
+  static Q_DECL_CONSTEXPR int CELL_SIZE_PIXEL = 48;
+
+private:
+  static QRect boundingRect(const QLine& line)
+  {
+    return QRect(line.p1(), line.p2()).normalized();
+  }
+
+  static QRect boundingRect(const QPolygon& polygon)
+  {
+    return polygon.boundingRect();
+  }
+
+  static QRect boundingRect(const QPoint& point)
+  {
+    return QRect(point, QSize(1, 1));
+  }
+
+  /* Get range of covered cells clamped to grid */
+  void cellRange(const QRect& rect, int& column1, int& row1, int& column2, int& row2) const;
+
+  QRect screen;
+  int columns = 0, rows = 0;
+  bool valid = false;
+
+  /* Items of cell i are in items from cellStart[i] to cellStart[i + 1] */
+  QVector<int> cellStart, items;
+};
+
+template<typename LIST>
+void ScreenIndexGrid::build(const LIST& list, const QRect& screenRect)
+{
+  QVector<QRect> boundings;
+  boundings.reserve(list.size());
+  for(const auto& pair : list)
+    boundings.append(boundingRect(pair.second));
+  build(boundings, screenRect);
+}
+
+#endif // LNM_SCREENINDEXGRID_H
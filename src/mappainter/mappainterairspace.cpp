@@ -85,6 +85,9 @@ void MapPainterAirspace::render()
     const QVector<QPolygonF *> polygons;
   };
 
+  // Allow an error of one pixel when simplifying airspace geometry - one degree latitude is 60 NM
+  float maxErrorDeg = scale->isValid() ? scale->getNmPerPixel() / 60.f : 0.f;
+
   QVector<DrawAirspace> visibleAirspaces;
   if(!airspaces.isEmpty())
   {
@@ -111,7 +114,7 @@ void MapPainterAirspace::render()
           return;
 
         // Get cached geometry =====================
-        const LineString *lineString = controller->getAirspaceGeometry(airspace->combinedId());
+        const LineString *lineString = controller->getAirspaceGeometry(airspace->combinedId(), maxErrorDeg);
         if(lineString != nullptr)
         {
           if(airspace->isOnline())
@@ -37,6 +37,8 @@
 #include "util/paintercontextsaver.h"
 #include "common/textplacement.h"
 #include "fs/userdata/logdatamanager.h"
+#include "common/aircrafttrail.h"
+#include "logbook/logdatacontroller.h"
 
 #include <marble/GeoDataLineString.h>
 #include <marble/GeoDataLinearRing.h>
@@ -454,18 +456,10 @@ void MapPainterMark::paintLogEntries(const QList<map::MapLogbookEntry>& entries)
           maxAltitude = std::max(maxAltitude, gpxData->maxTrailAltitude);
           minAltitude = std::min(minAltitude, gpxData->minTrailAltitude);
 
-          for(const atools::fs::gpx::TrailPoints& points : gpxData->trails)
-          {
-            if(!points.isEmpty())
-            {
-              ageo::LineString lineString;
-              for(const atools::fs::gpx::TrailPoint& point : points)
-                lineString.append(point.pos.asPos());
-
-              if(resolves(lineString.boundingRect()))
-                visibleTrailGeometries.append(lineString);
-            }
-          }
+          // Use cached and simplified trail - get only visible parts
+          const AircraftTrail *trail = NavApp::getLogdataController()->getAircraftTrail(logEntry.id);
+          if(trail != nullptr)
+            visibleTrailGeometries.append(trail->getLineStrings(ageo::EMPTY_POS, context->viewportRect, scale->getMeterPerPixel()));
         }
       }
       break;
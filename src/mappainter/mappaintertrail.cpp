@@ -21,6 +21,7 @@
 #include "common/aircrafttrail.h"
 #include "fs/sc/simconnectuseraircraft.h"
 #include "mapgui/mappaintwidget.h"
+#include "mapgui/mapscale.h"
 #include "route/route.h"
 #include "util/paintercontextsaver.h"
 #include "geo/linestring.h"
@@ -67,7 +68,9 @@ void MapPainterTrail::render()
         maxAltitude = std::max(context->route->getCruiseAltitudeFt(), maxAltitude);
 
       atools::util::PainterContextSaver saver(context->painter);
-      const QVector<atools::geo::LineString> lineStrings = aircraftTrail.getLineStrings(mapPaintWidget->getUserAircraft().getPosition());
+      // Get only visible parts and simplify to about one pixel deviation
+      const QVector<atools::geo::LineString> lineStrings = aircraftTrail.getLineStrings(mapPaintWidget->getUserAircraft().getPosition(),
+                                                                                        context->viewportRect, scale->getMeterPerPixel());
       paintAircraftTrail(lineStrings, aircraftTrail.getMinAltitude(), maxAltitude);
     }
   }
@@ -51,11 +51,15 @@
 using namespace Marble;
 using namespace atools::geo;
 
+/* Redraw static layers at least every two seconds to catch changes which are not covered by the cache key */
+const static qint64 STATIC_LAYER_CACHE_MAX_AGE_MS = 2000L;
+
 MapPaintLayer::MapPaintLayer(MapPaintWidget *widget)
   : mapPaintWidget(widget)
 {
   verbose = atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_MAP_LAYER_DEBUG, false).toBool();
   verboseDraw = atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_MAP_LAYER_DEBUG_DRAW, false).toBool();
+  staticLayerCache = atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_MAP_STATIC_LAYER_CACHE, false).toBool();
 
   // Create the layer configuration
   initMapLayerSettings();
@@ -127,6 +131,7 @@ void MapPaintLayer::preDatabaseLoad()
 void MapPaintLayer::postDatabaseLoad()
 {
   databaseLoadStatus = false;
+  staticLayerImage = QImage();
 }
 
 void MapPaintLayer::setShowMapObjects(map::MapTypes type, map::MapTypes mask)
@@ -259,6 +264,11 @@ void MapPaintLayer::initMapLayerSettings()
   layers->loadFromFile();
 }
 
+const MapLayer *MapPaintLayer::getMapLayerForDistance(float distanceKm, int level) const
+{
+  return layers != nullptr ? layers->getLayer(distanceKm, level) : nullptr;
+}
+
 /* Update the stored layer pointers after zoom distance has changed */
 void MapPaintLayer::updateLayers()
 {
@@ -298,6 +308,9 @@ bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport, const
   Q_UNUSED(renderPos)
   Q_UNUSED(layer)
 
+  // Always reset flag
+  bool simOnlyUpdate = mapPaintWidget->takeSimOnlyUpdate();
+
   if(!databaseLoadStatus && !mapPaintWidget->isNoNavPaint())
   {
     // Update map scale for screen distance approximation
@@ -314,8 +327,23 @@ bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport, const
       qDebug() << Q_FUNC_INFO << "layer" << *mapLayer;
 #endif
 
-      // Clear the airport id cache
-      shownDetailAirportIds.clear();
+      // Check if static layers can be drawn from or into the cache image ==============================
+      bool useStaticLayerCache = staticLayerCache && !mapPaintWidget->isPrinting() &&
+                                 mapPaintWidget->viewContext() == Marble::Still;
+      bool reuseStaticLayers = false;
+      if(useStaticLayerCache)
+      {
+        StaticLayerKey key = staticLayerKeyFor(viewport, painter->device()->devicePixelRatioF());
+
+        // Reuse only if painting was caused by simulator updates and nothing else changed
+        reuseStaticLayers = simOnlyUpdate && !staticLayerImage.isNull() && key == staticLayerKey &&
+                            staticLayerTimer.elapsed() < STATIC_LAYER_CACHE_MAX_AGE_MS;
+        staticLayerKey = key;
+      }
+
+      // Clear the airport id cache - keep values if static layers are not drawn
+      if(!reuseStaticLayers)
+        shownDetailAirportIds.clear();
 
       // Prepare context =====================================================
       context = PaintContext();
@@ -408,7 +436,8 @@ bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport, const
 
       // Prepare index for all navaids drawn by route - needed for context menu and tooltips
       context.routeDrawnNavaids = mapPaintWidget->getRouteDrawnNavaids();
-      context.routeDrawnNavaids->clear();
+      if(!reuseStaticLayers)
+        context.routeDrawnNavaids->clear();
 
       context.startTimer("All");
       setNoAntiAliasFont(&context);
@@ -537,75 +566,168 @@ bool MapPaintLayer::render(GeoPainter *painter, ViewportParams *viewport, const
 
       // =========================================================================
       // Draw ====================================
+      if(useStaticLayerCache)
+      {
+        // Ships are drawn above static layers since they move
+        renderStaticLayersCached(painter, viewport, reuseStaticLayers);
+        renderDynamicLayers(true /* ships */);
+      }
+      else
+      {
+        renderStaticLayers(true /* ships */);
+        renderDynamicLayers(false /* ships */);
+      }
 
-      // Altitude below all others
-      mapPainterAltitude->render();
-
-      // Ship below other navaids and airports
-      mapPainterShip->render();
+      resetNoAntiAliasFont(&context);
+      context.endTimer("All");
 
-      if(!mapPaintWidget->isDistanceCutOff())
-      {
-        if(!context.isObjectOverflow())
-          mapPainterAirspace->render();
+      mapPainterTop->render();
+    } // if(!noRender())
 
-        if(!context.isObjectOverflow())
-          mapPainterIls->render();
+    if(!mapPaintWidget->isPrinting() && mapPaintWidget->isVisibleWidget())
+      // Dim the map by drawing a semi-transparent black rectangle - but not for printing or web services
+      mapcolors::darkenPainterRect(*painter);
+  }
+  return true;
+}
 
-        if(context.mapLayer->isAirportDiagram())
-        {
-          if(!context.isObjectOverflow())
-            mapPainterAirport->render();
+void MapPaintLayer::renderStaticLayers(bool ships)
+{
+  // Altitude below all others
+  mapPainterAltitude->render();
 
-          if(!context.isObjectOverflow())
-            mapPainterNav->render();
-        }
-        else
-        {
-          if(!context.isObjectOverflow())
-            mapPainterMsa->render();
+  // Ship below other navaids and airports
+  if(ships)
+    mapPainterShip->render();
 
-          if(!context.isObjectOverflow())
-            mapPainterNav->render();
+  if(!mapPaintWidget->isDistanceCutOff())
+  {
+    if(!context.isObjectOverflow())
+      mapPainterAirspace->render();
 
-          if(!context.isObjectOverflow())
-            mapPainterAirport->render();
-        }
-      }
+    if(!context.isObjectOverflow())
+      mapPainterIls->render();
 
+    if(context.mapLayer->isAirportDiagram())
+    {
       if(!context.isObjectOverflow())
-        mapPainterUser->render();
+        mapPainterAirport->render();
 
       if(!context.isObjectOverflow())
-        mapPainterWind->render();
+        mapPainterNav->render();
+    }
+    else
+    {
+      if(!context.isObjectOverflow())
+        mapPainterMsa->render();
 
-      // if(!context.isOverflow()) always paint route even if number of objects is too large
-      mapPainterRoute->render();
+      if(!context.isObjectOverflow())
+        mapPainterNav->render();
 
       if(!context.isObjectOverflow())
-        mapPainterWeather->render();
+        mapPainterAirport->render();
+    }
+  }
 
-      if(context.mapLayer->isAirportDiagram() && !context.isObjectOverflow())
-        mapPainterMsa->render();
+  if(!context.isObjectOverflow())
+    mapPainterUser->render();
 
-      if(!context.isObjectOverflow())
-        mapPainterTrack->render();
+  if(!context.isObjectOverflow())
+    mapPainterWind->render();
 
-      mapPainterAircraft->render();
+  // if(!context.isOverflow()) always paint route even if number of objects is too large
+  mapPainterRoute->render();
 
-      mapPainterMark->render();
+  if(!context.isObjectOverflow())
+    mapPainterWeather->render();
 
-      resetNoAntiAliasFont(&context);
-      context.endTimer("All");
+  if(context.mapLayer->isAirportDiagram() && !context.isObjectOverflow())
+    mapPainterMsa->render();
+}
 
-      mapPainterTop->render();
-    } // if(!noRender())
+void MapPaintLayer::renderDynamicLayers(bool ships)
+{
+  if(ships)
+    mapPainterShip->render();
 
-    if(!mapPaintWidget->isPrinting() && mapPaintWidget->isVisibleWidget())
-      // Dim the map by drawing a semi-transparent black rectangle - but not for printing or web services
-      mapcolors::darkenPainterRect(*painter);
+  if(!context.isObjectOverflow())
+    mapPainterTrack->render();
+
+  mapPainterAircraft->render();
+
+  mapPainterMark->render();
+}
+
+void MapPaintLayer::renderStaticLayersCached(GeoPainter *painter, ViewportParams *viewport, bool reuse)
+{
+  if(reuse)
+  {
+    // Restore counters from last drawing into the image
+    context.objectCount = staticLayerObjectCount;
+    context.setQueryOverflow(staticLayerQueryOverflow);
   }
-  return true;
+  else
+  {
+    // Draw into a transparent image having the same resolution as the map
+    qreal ratio = staticLayerKey.devicePixelRatio;
+    staticLayerImage = QImage(staticLayerKey.size * ratio, QImage::Format_ARGB32_Premultiplied);
+    staticLayerImage.setDevicePixelRatio(ratio);
+    staticLayerImage.fill(Qt::transparent);
+
+    GeoPainter imagePainter(&staticLayerImage, viewport, painter->mapQuality());
+    imagePainter.setFont(painter->font());
+    imagePainter.setRenderHints(painter->renderHints());
+
+    context.painter = &imagePainter;
+    renderStaticLayers(false /* ships */);
+    context.painter = painter;
+    imagePainter.end();
+
+    staticLayerObjectCount = context.getObjectCount();
+    staticLayerQueryOverflow = context.isQueryOverflow();
+    staticLayerTimer.start();
+  }
+
+  painter->drawImage(QPointF(0., 0.), staticLayerImage);
+}
+
+MapPaintLayer::StaticLayerKey MapPaintLayer::staticLayerKeyFor(const ViewportParams *viewport, qreal devicePixelRatio) const
+{
+  const OptionData& od = OptionData::instance();
+  const Route& route = NavApp::getRouteConst();
+
+  StaticLayerKey key;
+  key.centerLon = viewport->centerLongitude();
+  key.centerLat = viewport->centerLatitude();
+  key.devicePixelRatio = devicePixelRatio;
+  key.radius = viewport->radius();
+  key.projection = viewport->projection();
+  key.detailLevel = detailLevel;
+  key.minimumRunwayLenghtFt = minimumRunwayLenghtFt;
+  key.routeSize = route.size();
+  key.activeLeg = route.getActiveLegIndex();
+  key.contentGeneration = mapPaintWidget->getContentGeneration();
+  key.size = viewport->size();
+  key.objectTypes = objectTypes;
+  key.objectDisplayTypes = objectDisplayTypes;
+  key.airspaceTypes = airspaceTypes;
+  key.weatherSource = weatherSource;
+  key.dispOptsRoute = od.getDisplayOptionsRoute();
+  key.flags = od.getFlags();
+  key.flags2 = od.getFlags2();
+  key.darkMap = NavApp::isDarkMapTheme();
+  return key;
+}
+
+bool MapPaintLayer::StaticLayerKey::operator==(const StaticLayerKey& other) const
+{
+  return centerLon == other.centerLon && centerLat == other.centerLat && devicePixelRatio == other.devicePixelRatio &&
+         radius == other.radius && projection == other.projection && detailLevel == other.detailLevel &&
+         minimumRunwayLenghtFt == other.minimumRunwayLenghtFt && routeSize == other.routeSize &&
+         activeLeg == other.activeLeg && contentGeneration == other.contentGeneration && size == other.size && objectTypes == other.objectTypes &&
+         objectDisplayTypes == other.objectDisplayTypes && airspaceTypes == other.airspaceTypes &&
+         weatherSource == other.weatherSource && dispOptsRoute == other.dispOptsRoute && flags == other.flags &&
+         flags2 == other.flags2 && darkMap == other.darkMap;
 }
 
 void MapPaintLayer::setNoAntiAliasFont(PaintContext *context)
@@ -20,6 +20,8 @@
 
 #include "mappainter/mappainter.h"
 
+#include <QElapsedTimer>
+#include <QImage>
 #include <QPen>
 
 #include <marble/LayerInterface.h>
@@ -55,6 +57,10 @@ class MapPaintWidget;
 /*
  * Implements the Marble layer interface that paints upon the Marble map. Contains all painter instances
  * and calls them in order for each paint event.
+ *
+ * Optionally keeps all static layers like airspaces, navaids, airports and flight plan in an offscreen image.
+ * The image is reused for repaints which are caused by simulator updates only as long as viewport, zoom and
+ * display options do not change. Only ships, trail, aircraft, marks and top layer are drawn in this case.
  */
 class MapPaintLayer :
   public Marble::LayerInterface
@@ -78,6 +84,10 @@ public:
     return mapLayer;
   }
 
+  /* Get a map layer for the given zoom distance and detail level without changing the current state.
+   * Used to query map objects without painting. */
+  const MapLayer *getMapLayerForDistance(float distanceKm, int level) const;
+
   /* Get the current map layer for the zoom distance. This layer is independent of any detail level changes */
   const MapLayer *getMapLayerEffective() const
   {
@@ -206,6 +216,41 @@ private:
   /* Restore normal font anti-aliasing for default and painter font */
   void resetNoAntiAliasFont(PaintContext *context);
 
+  /* Draw all layers below the aircraft which do not depend on simulator data. Ships are drawn too if requested. */
+  void renderStaticLayers(bool ships);
+
+  /* Draw ships if requested, trail, aircraft and marks */
+  void renderDynamicLayers(bool ships);
+
+  /* Draw static layers into the cache image if reuse is false and copy the image to the map */
+  void renderStaticLayersCached(Marble::GeoPainter *painter, Marble::ViewportParams *viewport, bool reuse);
+
+  /* Identifies the state of the static layer cache image */
+  struct StaticLayerKey
+  {
+    qreal centerLon = 0., centerLat = 0., devicePixelRatio = 1.;
+    int radius = 0, projection = 0, detailLevel = 0, minimumRunwayLenghtFt = 0, routeSize = 0, activeLeg = 0;
+    quint64 contentGeneration = 0L; /* Route, highlights, marks, online and other changes */
+    QSize size;
+    map::MapTypes objectTypes = map::NONE;
+    map::MapDisplayTypes objectDisplayTypes = map::DISPLAY_TYPE_NONE;
+    map::MapAirspaceFilter airspaceTypes;
+    map::MapWeatherSource weatherSource = map::WEATHER_SOURCE_SIMULATOR;
+    optsd::DisplayOptionsRoute dispOptsRoute;
+    opts::Flags flags;
+    opts2::Flags2 flags2;
+    bool darkMap = false;
+
+    bool operator==(const StaticLayerKey& other) const;
+
+    bool operator!=(const StaticLayerKey& other) const
+    {
+      return !operator==(other);
+    }
+  };
+
+  StaticLayerKey staticLayerKeyFor(const Marble::ViewportParams *viewport, qreal devicePixelRatio) const;
+
   /* Map objects currently shown */
   map::MapTypes objectTypes = map::NONE;
   map::MapDisplayTypes objectDisplayTypes = map::DISPLAY_TYPE_NONE;
@@ -250,6 +295,16 @@ private:
   bool verbose = false, verboseDraw = false;
   QFont::StyleStrategy savedFontStrategy, savedDefaultFontStrategy;
 
+  /* Static layer cache. Enabled by settings. */
+  bool staticLayerCache = false;
+  QImage staticLayerImage;
+  StaticLayerKey staticLayerKey;
+  QElapsedTimer staticLayerTimer;
+
+  /* Object count and overflow from static layers needed when reusing the image */
+  int staticLayerObjectCount = 0;
+  bool staticLayerQueryOverflow = false;
+
 };
 
 #endif // LITTLENAVMAP_MAPPAINTLAYER_H
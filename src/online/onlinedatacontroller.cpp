@@ -33,6 +33,7 @@
 #include "app/navapp.h"
 #include "settings/settings.h"
 #include "fs/sc/simconnectdata.h"
+#include "sql/sqldatabase.h"
 
 #include <QDebug>
 #include <QMessageBox>
@@ -45,6 +46,11 @@ static const int MIN_TRANSCEIVER_DOWNLOAD_INTERVAL_MIN = 5;
 // Minimum reload time for whazzup files (JSON or txt)
 static const int MIN_RELOAD_TIME_SECONDS = 15;
 
+// Simulator aircraft snapshots for shadow detection. Keeps one snapshot per second for five minutes
+// which covers the usual whazzup reload times and delays.
+static const int SHADOW_SNAPSHOT_CAPACITY = 300;
+static const qint64 SHADOW_SNAPSHOT_INTERVAL_MS = 1000L;
+
 using atools::fs::online::OnlinedataManager;
 using atools::util::HttpDownloader;
 using atools::geo::LineString;
@@ -93,6 +99,11 @@ OnlinedataController::OnlinedataController(atools::fs::online::OnlinedataManager
   // Request gzipped content if possible
   downloader->setAcceptEncoding("gzip");
 
+  shadowSnapshots.resize(SHADOW_SNAPSHOT_CAPACITY);
+
+  parseWorker = new OnlineParseWorker(this);
+  connect(parseWorker, &OnlineParseWorker::finished, this, &OnlinedataController::parseFinished);
+
   updateAtcSizes();
 
   connect(downloader, &HttpDownloader::downloadFinished, this, &OnlinedataController::downloadFinished);
@@ -112,6 +123,9 @@ OnlinedataController::OnlinedataController(atools::fs::online::OnlinedataManager
 
 OnlinedataController::~OnlinedataController()
 {
+  // Wait for parser thread which writes into the database
+  parseWorker->cancelAndWait();
+
   manager->setGeometryCallback(atools::fs::online::GeoCallbackType(nullptr));
 
   deInitQueries();
@@ -166,6 +180,7 @@ void OnlinedataController::updateAtcSizes()
     sizeMap.insert(type, diameter != -1 ? std::max(1, diameter / 2) : -1);
   }
   manager->setAtcSize(sizeMap);
+  atcSizes = sizeMap;
 }
 
 void OnlinedataController::startProcessing()
@@ -318,13 +333,12 @@ void OnlinedataController::downloadFinished(const QByteArray& data, QString url)
     if(verbose)
       qDebug() << Q_FUNC_INFO << "DOWNLOADING_TRANSCEIVERS";
 
-    QString tranceiversTxt = uncompress(data, Q_FUNC_INFO, true /* utf8 */);
-
 #ifdef DEBUG_INFORMATION_ONLINE
-    atools::strToFile(QDir::tempPath() + "/lnm_tranceivers.json", tranceiversTxt);
+    atools::strToFile(QDir::tempPath() + "/lnm_tranceivers.json", uncompress(data, Q_FUNC_INFO, true /* utf8 */));
 #endif
     // transceivers.json downloaded ============================================
-    manager->readFromTransceivers(tranceiversTxt);
+    // Keep raw data which is uncompressed and parsed in the thread before each whazzup file
+    transceiversData = data;
 
     // Next in chain after transceivers is JSON
     currentState = DOWNLOADING_WHAZZUP;
@@ -338,55 +352,33 @@ void OnlinedataController::downloadFinished(const QByteArray& data, QString url)
       qDebug() << Q_FUNC_INFO << "DOWNLOADING_WHAZZUP";
 
     // whazzup.txt or JSON downloaded ============================================
-    atools::fs::online::Format format = convertFormat(OptionData::instance().getOnlineFormat());
-
-    // Contains servers and does not need an extra download
-    bool vatsimJson = format == atools::fs::online::VATSIM_JSON3;
-    bool ivaoJson = format == atools::fs::online::IVAO_JSON2;
-
-    QString whazzupTxt = uncompress(data, Q_FUNC_INFO, ivaoJson || vatsimJson /* utf8 */);
+    // Uncompress, parse and write to database in background - continued in parseFinished()
+    const OptionData& od = OptionData::instance();
+    onlineparse::Request request;
+    request.whazzup = data;
+    request.format = convertFormat(od.getOnlineFormat());
+    if(request.format == atools::fs::online::VATSIM_JSON3)
+      request.transceivers = transceiversData;
+    request.codec = codec;
+    request.lastUpdateTime = whazzupUpdateTime;
+    request.atcSizes = atcSizes;
+    request.onlineDbFile = getDatabase()->databaseName();
+    if(NavApp::getDatabaseUserAirspace() != nullptr)
+      request.userAirspaceDbFile = NavApp::getDatabaseUserAirspace()->databaseName();
+    request.airspaceByName = od.getFlags2().testFlag(opts2::ONLINE_AIRSPACE_BY_NAME);
+    request.airspaceByFile = od.getFlags2().testFlag(opts2::ONLINE_AIRSPACE_BY_FILE);
+    request.verbose = atools::settings::Settings::instance().valueBool(lnm::OPTIONS_WHAZZUP_PARSER_DEBUG);
 
 #ifdef DEBUG_INFORMATION_ONLINE
-    atools::strToFile(QDir::tempPath() + "/lnm_whazzup." + (ivaoJson || vatsimJson ? "json" : "txt"), whazzupTxt);
+    bool json = request.format == atools::fs::online::IVAO_JSON2 || request.format == atools::fs::online::VATSIM_JSON3;
+    atools::strToFile(QDir::tempPath() + "/lnm_whazzup." + (json ? "json" : "txt"), uncompress(data, Q_FUNC_INFO, json));
 #endif
 
-    if(manager->readFromWhazzup(whazzupTxt, format, manager->getLastUpdateTimeFromWhazzup()))
-    {
-      QString whazzupVoiceUrlFromStatus = manager->getWhazzupVoiceUrlFromStatus();
-      if(!vatsimJson && !ivaoJson && !whazzupVoiceUrlFromStatus.isEmpty() &&
-         lastServerDownload < now.addSecs(-MIN_SERVER_DOWNLOAD_INTERVAL_MIN * 60))
-      {
-        // Next in chain is server file
-        currentState = DOWNLOADING_WHAZZUP_SERVERS;
-        downloader->setUrl(whazzupVoiceUrlFromStatus);
-        startDownloader();
-      }
-      else
-      {
-        // Done after downloading whazzup.txt - start timer for next session
-        startDownloadTimer();
-        currentState = NONE;
-        lastUpdateTime = now;
-
-        // Clear map display cache and update spatial index to match simulator shadow aircraft
-        aircraftCache.clear();
-        updateShadowIndex();
-
-        // Message for search tabs, map widget and info
-        emit onlineServersUpdated(true /* load all */, true /* keep selection */, true /* force */);
-        emit onlineClientAndAtcUpdated(true /* load all */, true /* keep selection */, true /* force */);
-        statusBarMessage();
-      }
-    }
-    else
+    if(!parseWorker->start(request))
     {
-      if(verbose)
-        qInfo() << Q_FUNC_INFO << "whazzup.txt is not recent";
-
-      // Done after old update - try again later
+      // Should never happen - try again later
       startDownloadTimer();
       currentState = NONE;
-      lastUpdateTime = now;
     }
   }
   else if(currentState == DOWNLOADING_WHAZZUP_SERVERS)
@@ -415,7 +407,7 @@ void OnlinedataController::downloadFinished(const QByteArray& data, QString url)
     atools::strToFile(QDir::tempPath() + "/lnm_servers." + suffix, serversTxt);
 #endif
 
-    manager->readServersFromWhazzup(serversTxt, format, manager->getLastUpdateTimeFromWhazzup());
+    manager->readServersFromWhazzup(serversTxt, format, whazzupUpdateTime);
     lastServerDownload = now;
 
     // Done after downloading server.txt - start timer for next session
@@ -430,6 +422,71 @@ void OnlinedataController::downloadFinished(const QByteArray& data, QString url)
   }
 }
 
+void OnlinedataController::parseFinished()
+{
+  const onlineparse::Result& result = parseWorker->getResult();
+  const QDateTime now = QDateTime::currentDateTime();
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "updated" << result.updated << "canceled" << result.canceled;
+
+  if(result.canceled)
+    return;
+
+  if(result.updated)
+  {
+    parseTiming = result.timing;
+    qInfo() << Q_FUNC_INFO << "Whazzup clients" << result.clients.size()
+            << "uncompress" << parseTiming.uncompressMs << "ms transceivers" << parseTiming.transceiversMs
+            << "ms whazzup" << parseTiming.whazzupMs << "ms total" << parseTiming.totalMs << "ms";
+
+    // New data is visible for the GUI connection now
+    dataGeneration++;
+    whazzupUpdateTime = result.lastUpdateTime;
+    whazzupReloadMinutes = result.reloadMinutes;
+    onlineClients = parseWorker->takeClients();
+
+    atools::fs::online::Format format = convertFormat(OptionData::instance().getOnlineFormat());
+    bool json = format == atools::fs::online::VATSIM_JSON3 || format == atools::fs::online::IVAO_JSON2;
+
+    QString whazzupVoiceUrlFromStatus = manager->getWhazzupVoiceUrlFromStatus();
+    if(!json && !whazzupVoiceUrlFromStatus.isEmpty() &&
+       lastServerDownload < now.addSecs(-MIN_SERVER_DOWNLOAD_INTERVAL_MIN * 60))
+    {
+      // Next in chain is server file
+      currentState = DOWNLOADING_WHAZZUP_SERVERS;
+      downloader->setUrl(whazzupVoiceUrlFromStatus);
+      startDownloader();
+    }
+    else
+    {
+      // Done after downloading whazzup.txt - start timer for next session
+      startDownloadTimer();
+      currentState = NONE;
+      lastUpdateTime = now;
+
+      // Clear map display cache and update spatial index to match simulator shadow aircraft
+      aircraftCache.clear();
+      updateShadowIndex();
+
+      // Message for search tabs, map widget and info
+      emit onlineServersUpdated(true /* load all */, true /* keep selection */, true /* force */);
+      emit onlineClientAndAtcUpdated(true /* load all */, true /* keep selection */, true /* force */);
+      statusBarMessage();
+    }
+  }
+  else
+  {
+    if(verbose)
+      qInfo() << Q_FUNC_INFO << "whazzup.txt is not recent";
+
+    // Done after old update - try again later
+    startDownloadTimer();
+    currentState = NONE;
+    lastUpdateTime = now;
+  }
+}
+
 void OnlinedataController::startDownloader()
 {
   if(verbose)
@@ -485,6 +542,7 @@ void OnlinedataController::statusBarMessage()
 void OnlinedataController::stopAllProcesses()
 {
   downloader->cancelDownload();
+  parseWorker->cancelAndWait();
   downloadTimer.stop();
   currentState = NONE;
   // clientCallsignAndPosMap.clear(); // Do not clear these until the download is finished
@@ -530,7 +588,12 @@ void OnlinedataController::optionsChanged()
   onlineAircraftSpatialIndex.clear();
   aircraftIdSimToOnline.clear();
   aircraftIdOnlineToSim.clear();
-  currentDataPacketMap.clear();
+  clearShadowSnapshots();
+  onlineClients.clear();
+  transceiversData.clear();
+  whazzupUpdateTime = QDateTime();
+  whazzupReloadMinutes = 0;
+  dataGeneration++;
 
   updateAtcSizes();
 
@@ -655,18 +718,17 @@ const atools::fs::sc::SimConnectAircraft& OnlinedataController::getShadowSimAirc
   const static atools::fs::sc::SimConnectAircraft EMPTY_SIM_AIRCRAFT;
 
   int simId = aircraftIdOnlineToSim.value(onlineId, -1);
-  if(simId != -1 && !currentDataPacketMap.isEmpty())
+  if(simId != -1 && shadowSnapshotCount > 0)
   {
     // Get latest data packet
-    const atools::fs::sc::SimConnectData& last = currentDataPacketMap.last();
-    const atools::fs::sc::SimConnectUserAircraft& userAircraft = last.getUserAircraftConst();
+    const atools::fs::sc::SimConnectUserAircraft& userAircraft = lastDataPacket->getUserAircraftConst();
     if(userAircraft.isValid() && userAircraft.getId() == simId)
       // Is user aircraft
       return userAircraft;
     else
     {
       // Look for AI aircraft
-      const atools::fs::sc::SimConnectAircraft *simAircraft = last.getAiAircraftConstById(simId);
+      const atools::fs::sc::SimConnectAircraft *simAircraft = lastDataPacket->getAiAircraftConstById(simId);
       if(simAircraft != nullptr)
         return *simAircraft;
     }
@@ -704,8 +766,7 @@ bool OnlinedataController::isShadowAircraft(const atools::fs::sc::SimConnectAirc
 // Called by ConnectClient after each simulator data package
 void OnlinedataController::updateAircraftShadowState(atools::fs::sc::SimConnectData& dataPacket)
 {
-  // Check if connected online to avoid overflow of currentDataPacketMap which
-  // is cleared in updateShadowIndex() after each online download
+  // Check if connected online to avoid collecting snapshots needlessly
   if(isNetworkActive())
   {
     // Modify AI aircraft and set shadow flag if a online network aircraft is registered as shadowed in the index
@@ -717,29 +778,118 @@ void OnlinedataController::updateAircraftShadowState(atools::fs::sc::SimConnectD
       for(SimConnectAircraft& aiAircraft : dataPacket.getAiAircraft())
         aiAircraft.setFlag(atools::fs::sc::SIM_ONLINE_SHADOW, isShadowAircraft(aiAircraft));
 
-      currentDataPacketMap.insert(QDateTime::currentDateTimeUtc(), dataPacket);
+      addShadowSnapshot(dataPacket);
     }
   }
   else
-    currentDataPacketMap.clear();
+    clearShadowSnapshots();
+}
+
+void OnlinedataController::simDataChanged(const simdata::PacketPtr& packet)
+{
+  if(isNetworkActive() && !packet->isEmptyReply() && packet->isUserAircraftValid())
+    lastDataPacket = packet;
+}
+
+void OnlinedataController::addShadowSnapshot(const atools::fs::sc::SimConnectData& dataPacket)
+{
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+  // Ignore packets arriving faster than the interval - also drop all if clock was set back
+  if(shadowSnapshotCount > 0)
+  {
+    qint64 lastTimestamp = shadowSnapshotAt(shadowSnapshotCount - 1).timestampMs;
+    if(now < lastTimestamp)
+      clearShadowSnapshots();
+    else if(now - lastTimestamp < SHADOW_SNAPSHOT_INTERVAL_MS)
+      return;
+  }
+
+  // Reuse vector of oldest entry to avoid reallocation
+  ShadowSnapshot& snapshot = shadowSnapshots[shadowSnapshotHead];
+  snapshot.timestampMs = now;
+  snapshot.aircraft.clear();
+
+  const atools::fs::sc::SimConnectUserAircraft& userAircraft = dataPacket.getUserAircraftConst();
+  if(!userAircraft.isAnyBoat())
+    snapshot.aircraft.append({userAircraft.getId(), userAircraft.getPosition(), userAircraft.getActualAltitudeFt(),
+                              userAircraft.getGroundSpeedKts(), userAircraft.getHeadingDegTrue(), true /* user */});
+
+  for(const SimConnectAircraft& aiAircraft : dataPacket.getAiAircraftConst())
+  {
+    if(!aiAircraft.isAnyBoat())
+      snapshot.aircraft.append({aiAircraft.getId(), aiAircraft.getPosition(), aiAircraft.getActualAltitudeFt(),
+                                aiAircraft.getGroundSpeedKts(), aiAircraft.getHeadingDegTrue(), false /* user */});
+  }
+
+  shadowSnapshotHead = (shadowSnapshotHead + 1) % shadowSnapshots.size();
+  shadowSnapshotCount = std::min(shadowSnapshotCount + 1, shadowSnapshots.size());
+}
+
+const OnlinedataController::ShadowSnapshot& OnlinedataController::shadowSnapshotAt(int index) const
+{
+  int size = shadowSnapshots.size();
+  return shadowSnapshots.at((shadowSnapshotHead - shadowSnapshotCount + index + size) % size);
+}
+
+const OnlinedataController::ShadowSnapshot *OnlinedataController::nearestShadowSnapshot(qint64 timestampMs) const
+{
+  if(shadowSnapshotCount == 0)
+    return nullptr;
+
+  // Binary search for first snapshot not older than timestamp
+  int lower = 0, upper = shadowSnapshotCount;
+  while(lower < upper)
+  {
+    int middle = (lower + upper) / 2;
+    if(shadowSnapshotAt(middle).timestampMs < timestampMs)
+      lower = middle + 1;
+    else
+      upper = middle;
+  }
+
+  if(lower == shadowSnapshotCount)
+    // All older - use latest
+    return &shadowSnapshotAt(shadowSnapshotCount - 1);
+  else if(lower == 0)
+    // All newer - use oldest
+    return &shadowSnapshotAt(0);
+  else
+  {
+    // Use closer one of the two neighbors
+    const ShadowSnapshot& before = shadowSnapshotAt(lower - 1);
+    const ShadowSnapshot& after = shadowSnapshotAt(lower);
+    return timestampMs - before.timestampMs < after.timestampMs - timestampMs ? &before : &after;
+  }
+}
+
+void OnlinedataController::clearShadowSnapshots()
+{
+  for(ShadowSnapshot& snapshot : shadowSnapshots)
+  {
+    snapshot.timestampMs = 0L;
+    snapshot.aircraft.clear();
+  }
+  shadowSnapshotHead = shadowSnapshotCount = 0;
+  lastDataPacket = simdata::emptyPacket();
 }
 
 /* Return online aircraft for simulator aircraft based on distance and other parameter similarity */
-OnlineAircraft OnlinedataController::shadowAircraftInternal(const atools::fs::sc::SimConnectAircraft& simAircraft)
+OnlineAircraft OnlinedataController::shadowAircraftInternal(const ShadowAircraft& simAircraft)
 {
   const static OnlineAircraft EMPTY_ONLINE_AIRCRAFT;
 
 #ifdef DEBUG_INFORMATION_USER_ONLINE_DISABLED
-  if(simAircraft.isUser())
+  if(simAircraft.user)
   {
-    qDebug() << Q_FUNC_INFO << simAircraft.getAirplaneRegistrationKey() << simAircraft.getPosition();
+    qDebug() << Q_FUNC_INFO << simAircraft.getAirplaneRegistrationKey() << simAircraft.pos;
 
     if(onlineAircraftRegKeyIndex.contains(simAircraft.getAirplaneRegistrationKey()))
     {
       const atools::geo::Pos pos = onlineAircraftRegKeyIndex.value(simAircraft.getAirplaneRegistrationKey()).getPosition();
-      qDebug() << Q_FUNC_INFO << "online" << pos << "sim" << simAircraft.getPosition();
+      qDebug() << Q_FUNC_INFO << "online" << pos << "sim" << simAircraft.pos;
 
-      qDebug() << Q_FUNC_INFO << atools::geo::meterToNm(pos.distanceMeterTo3d(simAircraft.getPosition()));
+      qDebug() << Q_FUNC_INFO << atools::geo::meterToNm(pos.distanceMeterTo3d(simAircraft.pos));
     }
   }
 #endif
@@ -748,9 +898,9 @@ OnlineAircraft OnlinedataController::shadowAircraftInternal(const atools::fs::sc
   {
     // First get all nearest aircraft from spatial index ======================================
     QVector<OnlineAircraft> nearest;
-    onlineAircraftSpatialIndex.getRadius(nearest, simAircraft.getPosition(), atools::geo::nmToMeter(maxShadowDistanceNm));
+    onlineAircraftSpatialIndex.getRadius(nearest, simAircraft.pos, atools::geo::nmToMeter(maxShadowDistanceNm));
 
-    if(verbose && simAircraft.isUser())
+    if(verbose && simAircraft.user)
       qDebug() << Q_FUNC_INFO << "nearest.size()" << nearest.size();
 
     // Filter out all which do not match more non-spatial criteria =================================
@@ -758,30 +908,30 @@ OnlineAircraft OnlinedataController::shadowAircraftInternal(const atools::fs::sc
                                  [&simAircraft, this](const OnlineAircraft& aircraft) -> bool {
       bool altOk = true, gsOk = true, hdgOk = true;
 
-      if(atools::inRange(-1000.f, map::INVALID_ALTITUDE_VALUE / 4.f, simAircraft.getActualAltitudeFt()) &&
+      if(atools::inRange(-1000.f, map::INVALID_ALTITUDE_VALUE / 4.f, simAircraft.actualAltitudeFt) &&
          atools::inRange(-1000.f, map::INVALID_ALTITUDE_VALUE / 4.f, aircraft.pos.getAltitude()))
-        altOk = atools::almostEqual(simAircraft.getActualAltitudeFt(), aircraft.pos.getAltitude(), maxShadowAltDiffFt);
+        altOk = atools::almostEqual(simAircraft.actualAltitudeFt, aircraft.pos.getAltitude(), maxShadowAltDiffFt);
 
-      if(atools::inRange(0.f, map::INVALID_SPEED_VALUE / 4.f, simAircraft.getGroundSpeedKts()) &&
+      if(atools::inRange(0.f, map::INVALID_SPEED_VALUE / 4.f, simAircraft.groundSpeedKts) &&
          atools::inRange(0.f, map::INVALID_SPEED_VALUE / 4.f, aircraft.groundSpeedKts))
-        gsOk = atools::almostEqual(simAircraft.getGroundSpeedKts(), aircraft.groundSpeedKts, maxShadowGsDiffKts);
+        gsOk = atools::almostEqual(simAircraft.groundSpeedKts, aircraft.groundSpeedKts, maxShadowGsDiffKts);
 
-      if(atools::inRange(0.f, map::INVALID_HEADING_VALUE / 4.f, simAircraft.getHeadingDegTrue()) &&
+      if(atools::inRange(0.f, map::INVALID_HEADING_VALUE / 4.f, simAircraft.headingTrue) &&
          atools::inRange(0.f, map::INVALID_HEADING_VALUE / 4.f, aircraft.headingTrue))
-        hdgOk = atools::geo::angleAbsDiff(simAircraft.getHeadingDegTrue(), aircraft.headingTrue) < maxShadowHdgDiffDeg;
+        hdgOk = atools::geo::angleAbsDiff(simAircraft.headingTrue, aircraft.headingTrue) < maxShadowHdgDiffDeg;
 
       return !(altOk && gsOk && hdgOk);
     }), nearest.end());
 
-    if(verbose && simAircraft.isUser())
+    if(verbose && simAircraft.user)
       qDebug() << Q_FUNC_INFO << "nearest.size() after filter" << nearest.size();
 
     if(!nearest.isEmpty())
     {
       // Sort to get closest by coordinates and altitude to start of list
-      maptools::sortByDistanceAndAltitude(nearest, simAircraft.getPosition());
+      maptools::sortByDistanceAndAltitude(nearest, simAircraft.pos);
 
-      if(verbose && simAircraft.isUser())
+      if(verbose && simAircraft.user)
         qDebug() << Q_FUNC_INFO << "Found" << nearest.first().registrationKey;
 
       return nearest.constFirst();
@@ -806,92 +956,38 @@ void OnlinedataController::updateShadowIndex()
   // Clear the id maps and the spatial index
   clearShadowIndexes();
 
-  if(OptionData::instance().getFlags().testFlag(opts::ONLINE_REMOVE_SHADOW) && !currentDataPacketMap.isEmpty())
+  if(OptionData::instance().getFlags().testFlag(opts::ONLINE_REMOVE_SHADOW) && shadowSnapshotCount > 0)
   {
-    const QDateTime lastUpdateTimeWhazzup = manager->getLastUpdateTimeFromWhazzup();
-    const auto upper = currentDataPacketMap.upperBound(lastUpdateTimeWhazzup);
-    const auto lower = currentDataPacketMap.lowerBound(lastUpdateTimeWhazzup);
-    QMap<QDateTime, atools::fs::sc::SimConnectData>::iterator entry = currentDataPacketMap.end();
-
-    if(upper != currentDataPacketMap.end() && lower != currentDataPacketMap.end())
-    {
-      qint64 lastUpdateWhazzupSecs = lastUpdateTimeWhazzup.toSecsSinceEpoch();
-      if(std::abs(upper.key().toSecsSinceEpoch() - lastUpdateWhazzupSecs) <
-         std::abs(lower.key().toSecsSinceEpoch() - lastUpdateWhazzupSecs))
-        entry = upper;
-      else
-        entry = lower;
-    }
-    else if(upper != currentDataPacketMap.end())
-      entry = upper;
-    else if(lower != currentDataPacketMap.end())
-      entry = lower;
+    // Get the simulator aircraft positions closest to the whazzup update time
+    const ShadowSnapshot *snapshot = nearestShadowSnapshot(whazzupUpdateTime.toMSecsSinceEpoch());
 
     if(verbose)
     {
-      qDebug() << Q_FUNC_INFO << currentDataPacketMap.firstKey() << currentDataPacketMap.lastKey();
-      qDebug() << Q_FUNC_INFO << "lastUpdateTimeWhazzup" << lastUpdateTimeWhazzup
-               << "lower" << lower.key() << "upper" << upper.key();
-
-      if(entry != currentDataPacketMap.end())
-        qDebug() << Q_FUNC_INFO << "entry.key()" << entry.key();
+      qDebug() << Q_FUNC_INFO << QDateTime::fromMSecsSinceEpoch(shadowSnapshotAt(0).timestampMs)
+               << QDateTime::fromMSecsSinceEpoch(shadowSnapshotAt(shadowSnapshotCount - 1).timestampMs);
+      qDebug() << Q_FUNC_INFO << "lastUpdateTimeWhazzup" << whazzupUpdateTime
+               << "snapshot" << QDateTime::fromMSecsSinceEpoch(snapshot->timestampMs);
     }
 
-    if(entry != currentDataPacketMap.end())
+    if(snapshot != nullptr && !snapshot->aircraft.isEmpty())
     {
-      int removed = 0;
-      while(currentDataPacketMap.begin() != entry && !currentDataPacketMap.isEmpty())
-      {
-        currentDataPacketMap.erase(currentDataPacketMap.begin());
-        removed++;
-      }
-
-      if(verbose)
-        qDebug() << Q_FUNC_INFO << "removed" << removed << "currentDataPackets.size()" << currentDataPacketMap.size();
+      // Fill and update spatial index =================================
+      onlineAircraftSpatialIndex.append(onlineClients);
+      onlineAircraftSpatialIndex.updateIndex();
 
-      atools::fs::sc::SimConnectData currentDataPacket = entry.value();
-      if(currentDataPacket.isUserAircraftValid())
+      // update an index for user and AI aircraft in snapshot
+      for(const ShadowAircraft& simAircraft : snapshot->aircraft)
       {
-        // Fill and update spatial index =================================
-        onlineAircraftSpatialIndex.append(manager->getClientCallsignAndPosMap());
-        onlineAircraftSpatialIndex.updateIndex();
+        OnlineAircraft onlineAircraft = shadowAircraftInternal(simAircraft);
 
-        const atools::fs::sc::SimConnectUserAircraft& simUserAircraft = currentDataPacket.getUserAircraftConst();
-        if(!simUserAircraft.isAnyBoat())
+        if(onlineAircraft.isValid())
         {
-          const OnlineAircraft onlineUserAircraft = shadowAircraftInternal(simUserAircraft);
-          if(onlineUserAircraft.isValid())
-          {
-            int simId = simUserAircraft.getId();
-            int onlineId = onlineUserAircraft.id;
-            aircraftIdSimToOnline.insert(simId, onlineId);
-            aircraftIdOnlineToSim.insert(onlineId, simId);
-
-            if(verbose)
-              qDebug() << Q_FUNC_INFO << "User sim" << simId << simUserAircraft.getAirplaneRegistration() << simUserAircraft.getPosition()
-                       << "online" << onlineId << onlineUserAircraft.registration << onlineUserAircraft.pos;
-          }
-        }
+          aircraftIdSimToOnline.insert(simAircraft.id, onlineAircraft.id);
+          aircraftIdOnlineToSim.insert(onlineAircraft.id, simAircraft.id);
 
-        // update an index for currentDataPacket
-        for(const SimConnectAircraft& simAircraft : currentDataPacket.getAiAircraftConst())
-        {
-          if(!simAircraft.isAnyBoat())
-          {
-            OnlineAircraft onlineAircraft = shadowAircraftInternal(simAircraft);
-
-            if(onlineAircraft.isValid())
-            {
-              int simId = simAircraft.getId();
-              int onlineId = onlineAircraft.id;
-              aircraftIdSimToOnline.insert(simId, onlineId);
-              aircraftIdOnlineToSim.insert(onlineId, simId);
-
-              if(verbose)
-                qDebug() << Q_FUNC_INFO << "Sim" << simId << simAircraft.getAirplaneRegistration() << simAircraft.getPosition()
-                         << "online" << onlineId << onlineAircraft.registration << onlineAircraft.pos;
-            }
-          }
+          if(verbose)
+            qDebug() << Q_FUNC_INFO << (simAircraft.user ? "User sim" : "Sim") << simAircraft.id << simAircraft.pos
+                     << "online" << onlineAircraft.id << onlineAircraft.registration << onlineAircraft.pos;
         }
       }
     }
@@ -976,7 +1072,7 @@ void OnlinedataController::startDownloadTimer()
     if(intervalSeconds == -1)
     {
       // Use time from whazzup.txt - mode auto
-      intervalSeconds = std::max(manager->getReloadMinutesFromWhazzup() * 60, 60);
+      intervalSeconds = std::max((whazzupReloadMinutes > 0 ? whazzupReloadMinutes : manager->getReloadMinutesFromWhazzup()) * 60, 60);
       source = "whazzup";
     }
     else
@@ -1023,8 +1119,9 @@ void OnlinedataController::debugDumpContainerSizes() const
 {
   if(downloader != nullptr)
     downloader->debugDumpContainerSizes();
-  qDebug() << Q_FUNC_INFO << "currentDataPacketMap.size()" << currentDataPacketMap.size();
+  qDebug() << Q_FUNC_INFO << "shadowSnapshotCount" << shadowSnapshotCount;
   qDebug() << Q_FUNC_INFO << "onlineAircraftSpatialIndex.size()" << onlineAircraftSpatialIndex.size();
+  qDebug() << Q_FUNC_INFO << "onlineClients.size()" << onlineClients.size();
   qDebug() << Q_FUNC_INFO << "aircraftIdSimToOnline.size()" << aircraftIdSimToOnline.size();
   qDebug() << Q_FUNC_INFO << "aircraftIdOnlineToSim.size()" << aircraftIdOnlineToSim.size();
   qDebug() << Q_FUNC_INFO << "aircraftCache.list.size()" << aircraftCache.list.size();
@@ -18,8 +18,11 @@
 #ifndef LNM_ONLINECONTROLLER_H
 #define LNM_ONLINECONTROLLER_H
 
+#include "connect/simdatapacket.h"
 #include "fs/online/onlinetypes.h"
+#include "fs/sc/simconnectdata.h"
 #include "geo/spatialindex.h"
+#include "online/onlineparseworker.h"
 #include "query/querytypes.h"
 
 #include <QDateTime>
@@ -132,6 +135,19 @@ public:
   /* Get number of online clients/aircraft */
   int getNumClients() const;
 
+  /* Incremented each time new whazzup data was committed to the database by the parser thread.
+   * Can be used by views to detect outdated cached query results. */
+  quint32 getDataGeneration() const
+  {
+    return dataGeneration;
+  }
+
+  /* Uncompress and parse times of the last whazzup update */
+  const onlineparse::Timing& getParseTiming() const
+  {
+    return parseTiming;
+  }
+
   /* Get an online network aircraft for given simulator shadow aircraft with updated position */
   atools::fs::sc::SimConnectAircraft getShadowedOnlineAircraft(const atools::fs::sc::SimConnectAircraft& simAircraft);
 
@@ -143,6 +159,9 @@ public:
    * Called by ConnectClient after receiving simulator data package. */
   void updateAircraftShadowState(atools::fs::sc::SimConnectData& dataPacket);
 
+  /* Keeps the final shared packet to get full simulator aircraft for shadows */
+  void simDataChanged(const simdata::PacketPtr& packet);
+
   /* Print the size of all container classes to detect overflow or memory leak conditions */
   void debugDumpContainerSizes() const;
 
@@ -162,6 +181,9 @@ private:
   void downloadFinished(const QByteArray& data, QString url);
   void downloadFailed(const QString& error, int errorCode, QString url);
   void downloadSslErrors(const QStringList& errors, const QString& downloadUrl);
+
+  /* Parser thread finished writing whazzup data to the database. Continues download chain. */
+  void parseFinished();
   void statusBarMessage();
 
   void startDownloadInternal();
@@ -181,8 +203,34 @@ private:
   void updateShadowIndex();
   void clearShadowIndexes();
 
+  /* Position and movement of a simulator aircraft as needed for shadow detection */
+  struct ShadowAircraft
+  {
+    int id;
+    atools::geo::Pos pos;
+    float actualAltitudeFt, groundSpeedKts, headingTrue;
+    bool user;
+  };
+
+  /* All user and AI aircraft from a simulator data packet at a certain time */
+  struct ShadowSnapshot
+  {
+    qint64 timestampMs = 0L;
+    QVector<ShadowAircraft> aircraft;
+  };
+
+  /* Add snapshot of all aircraft in packet to ring buffer. Overwrites the oldest one if full. */
+  void addShadowSnapshot(const atools::fs::sc::SimConnectData& dataPacket);
+
+  /* Get snapshot closest to given time or null if none */
+  const ShadowSnapshot *nearestShadowSnapshot(qint64 timestampMs) const;
+
+  /* Snapshot by index from oldest (0) to latest (shadowSnapshotCount - 1) */
+  const ShadowSnapshot& shadowSnapshotAt(int index) const;
+  void clearShadowSnapshots();
+
   /* Return online aircraft for simulator aircraft based on distance and other parameter similarity */
-  atools::fs::online::OnlineAircraft shadowAircraftInternal(const atools::fs::sc::SimConnectAircraft& simAircraft);
+  atools::fs::online::OnlineAircraft shadowAircraftInternal(const ShadowAircraft& simAircraft);
 
   /* Database manager */
   atools::fs::online::OnlinedataManager *manager;
@@ -190,6 +238,9 @@ private:
   /* Downloader for all files */
   atools::util::HttpDownloader *downloader;
 
+  /* Uncompresses and parses whazzup files in background */
+  OnlineParseWorker *parseWorker;
+
   MainWindow *mainWindow;
 
   /* State is set before triggering the download and clear on the last download in the chain.
@@ -223,10 +274,26 @@ private:
 
   QString whazzupUrlFromStatus;
 
+  /* Values from last whazzup file processed by the parser thread */
+  QDateTime whazzupUpdateTime;
+  int whazzupReloadMinutes = 0;
+
+  /* Raw download of last transceivers file. Parsed in thread together with each whazzup file. */
+  QByteArray transceiversData;
+
+  /* Diameters for ATC center circles by type. Passed to the parser thread. */
+  QHash<atools::fs::online::fac::FacilityType, int> atcSizes;
+
+  quint32 dataGeneration = 0;
+  onlineparse::Timing parseTiming;
+
   QTextCodec *codec = nullptr;
 
   bool verbose = false;
 
+  // All online aircraft with callsign and position from last parsed whazzup file
+  QVector<atools::fs::online::OnlineAircraft> onlineClients;
+
   // All online aircraft from download for spatial search (nearest)
   atools::geo::SpatialIndex<atools::fs::online::OnlineAircraft> onlineAircraftSpatialIndex;
 
@@ -237,9 +304,13 @@ private:
   QHash<int, int> aircraftIdSimToOnline, // All shadow aircraft mapped from sim key to online value
                   aircraftIdOnlineToSim; // Shadow aircraft mapped from online key to sim value
 
-  // Time series of all data received from simulator. Needed to get a set of aircraft which
-  // fit to the last update time of the downloaded whazzup file
-  QMap<QDateTime, atools::fs::sc::SimConnectData> currentDataPacketMap;
+  // Ring buffer with time series of aircraft positions received from simulator. Needed to get a set of aircraft which
+  // fit to the last update time of the downloaded whazzup file. Snapshots are ordered by time.
+  QVector<ShadowSnapshot> shadowSnapshots;
+  int shadowSnapshotHead = 0 /* Next index to write */, shadowSnapshotCount = 0;
+
+  // Latest packet from simulator used to get full aircraft for shadows
+  simdata::PacketPtr lastDataPacket = simdata::emptyPacket();
 
   // Cache used for map display
   query::SimpleRectCache<atools::fs::sc::SimConnectAircraft> aircraftCache;
@@ -0,0 +1,228 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "online/onlineparseworker.h"
+
+#include "common/mapflags.h"
+#include "db/dbtools.h"
+#include "exception.h"
+#include "fs/online/onlinedatamanager.h"
+#include "query/airspacequery.h"
+#include "sql/sqldatabase.h"
+#include "zip/gzip.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QTextCodec>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentRun>
+
+using atools::sql::SqlDatabase;
+using atools::fs::online::OnlinedataManager;
+using atools::fs::online::OnlineAircraft;
+
+OnlineParseWorker::OnlineParseWorker(QObject *parent)
+  : QObject(parent)
+{
+  cancelFlag.store(false);
+
+  // Notification from thread that it has finished and we can get the result from the future
+  connect(&watcher, &QFutureWatcher<onlineparse::Result>::finished, this, &OnlineParseWorker::threadFinished);
+}
+
+OnlineParseWorker::~OnlineParseWorker()
+{
+  cancelAndWait();
+}
+
+bool OnlineParseWorker::start(const onlineparse::Request& request)
+{
+  if(isRunning())
+  {
+    qWarning() << Q_FUNC_INFO << "Parsing already running";
+    return false;
+  }
+
+  cancelFlag.store(false);
+  suppressFinished = false;
+  result = onlineparse::Result();
+
+  future = QtConcurrent::run(this, &OnlineParseWorker::parseThread, request);
+
+  // Watcher will call OnlineParseWorker::threadFinished() when finished
+  watcher.setFuture(future);
+  return true;
+}
+
+void OnlineParseWorker::cancel()
+{
+  cancelFlag.store(true);
+}
+
+void OnlineParseWorker::cancelAndWait()
+{
+  if(isRunning())
+  {
+    qDebug() << Q_FUNC_INFO;
+    suppressFinished = true;
+    cancelFlag.store(true);
+    future.waitForFinished();
+  }
+}
+
+bool OnlineParseWorker::isRunning() const
+{
+  // isStarted() is true for a default constructed future and stays true when done - do not use it here
+  return future.isRunning();
+}
+
+onlineparse::Result OnlineParseWorker::parseThread(onlineparse::Request request)
+{
+  QThread::currentThread()->setPriority(QThread::LowPriority);
+
+  onlineparse::Result res;
+  QElapsedTimer timer, totalTimer;
+  totalTimer.start();
+  timer.start();
+
+  // Uncompress and convert ============================================
+  // JSON formats are UTF-8 while text formats use windows encoding
+  bool utf8 = request.format == atools::fs::online::VATSIM_JSON3 || request.format == atools::fs::online::IVAO_JSON2;
+  QByteArray whazzupData = atools::zip::gzipDecompressIf(request.whazzup, Q_FUNC_INFO);
+  QString whazzupTxt = utf8 || request.codec == nullptr ? QString(whazzupData) : request.codec->toUnicode(whazzupData);
+  QString transceiversTxt;
+  if(!request.transceivers.isEmpty())
+    transceiversTxt = QString(atools::zip::gzipDecompressIf(request.transceivers, Q_FUNC_INFO));
+
+  // Free memory early
+  whazzupData.clear();
+  request.whazzup.clear();
+  request.transceivers.clear();
+  res.timing.uncompressMs = timer.restart();
+
+  if(cancelFlag.load())
+  {
+    res.canceled = true;
+    return res;
+  }
+
+  // Connections can only be used in the thread which created them - use separate ones here
+  QString onlineName = dbtools::DATABASE_NAME_ONLINE_PARSE;
+  QString airspaceName = dbtools::DATABASE_NAME_ONLINE_PARSE_AIRSPACE;
+  SqlDatabase::addDatabase(dbtools::DATABASE_TYPE, onlineName);
+  SqlDatabase::addDatabase(dbtools::DATABASE_TYPE, airspaceName);
+
+  {
+    SqlDatabase dbOnline(onlineName), dbAirspace(airspaceName);
+    AirspaceQuery *airspaceQuery = nullptr;
+    OnlinedataManager *manager = nullptr;
+
+    try
+    {
+      // Writeable and not exclusive to allow GUI connection to read while parsing
+      dbtools::openDatabaseFileExt(&dbOnline, request.onlineDbFile, false /* readonly */, false /* createSchema */,
+                                   false /* exclusive */, false /* auto transactions */);
+
+      if(!request.userAirspaceDbFile.isEmpty() && (request.airspaceByName || request.airspaceByFile))
+      {
+        dbtools::openDatabaseFileExt(&dbAirspace, request.userAirspaceDbFile, true /* readonly */, false /* createSchema */,
+                                     false /* exclusive */, false /* auto transactions */);
+        airspaceQuery = new AirspaceQuery(&dbAirspace, map::AIRSPACE_SRC_USER);
+        airspaceQuery->initQueries();
+      }
+
+      manager = new OnlinedataManager(&dbOnline, request.verbose);
+      manager->initQueries();
+      manager->setAtcSize(request.atcSizes);
+
+      if(airspaceQuery != nullptr)
+      {
+        // Same lookup order as OnlinedataController::airspaceGeometryCallback() but using own query
+        manager->setGeometryCallback([airspaceQuery, &request](const QString& callsign,
+                                                                atools::fs::online::fac::FacilityType type) -> const atools::geo::LineString *
+        {
+          const atools::geo::LineString *lineString = nullptr;
+          if(request.airspaceByName)
+            lineString = airspaceQuery->getAirspaceGeometryByName(callsign, atools::fs::online::facilityTypeToDb(type));
+
+          if(lineString == nullptr && request.airspaceByFile)
+            lineString = airspaceQuery->getAirspaceGeometryByFile(callsign);
+          return lineString;
+        });
+      }
+
+      // Parse transceivers needed for frequencies in VATSIM JSON ============================================
+      if(!transceiversTxt.isEmpty())
+        manager->readFromTransceivers(transceiversTxt);
+      res.timing.transceiversMs = timer.restart();
+
+      // Parse and insert into database - GUI connection sees the data once the transaction is committed ============
+      if(!cancelFlag.load())
+      {
+        res.updated = manager->readFromWhazzup(whazzupTxt, request.format, request.lastUpdateTime);
+
+        if(res.updated)
+        {
+          res.lastUpdateTime = manager->getLastUpdateTimeFromWhazzup();
+          res.reloadMinutes = manager->getReloadMinutesFromWhazzup();
+
+          for(const OnlineAircraft& aircraft : manager->getClientCallsignAndPosMap())
+            res.clients.append(aircraft);
+        }
+      }
+      res.timing.whazzupMs = timer.restart();
+    }
+    catch(atools::Exception& e)
+    {
+      qWarning() << Q_FUNC_INFO << "Caught exception" << e.what();
+      res.updated = false;
+    }
+    catch(...)
+    {
+      qWarning() << Q_FUNC_INFO << "Caught unknown exception";
+      res.updated = false;
+    }
+
+    if(manager != nullptr)
+    {
+      manager->setGeometryCallback(atools::fs::online::GeoCallbackType(nullptr));
+      manager->deInitQueries();
+      delete manager;
+    }
+    delete airspaceQuery;
+
+    dbtools::closeDatabaseFile(&dbOnline);
+    dbtools::closeDatabaseFile(&dbAirspace);
+  }
+
+  SqlDatabase::removeDatabase(onlineName);
+  SqlDatabase::removeDatabase(airspaceName);
+
+  res.canceled = cancelFlag.load();
+  res.timing.totalMs = totalTimer.elapsed();
+  return res;
+}
+
+void OnlineParseWorker::threadFinished()
+{
+  if(suppressFinished)
+    return;
+
+  result = future.result();
+  emit finished();
+}
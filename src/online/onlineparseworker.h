@@ -0,0 +1,148 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LNM_ONLINEPARSEWORKER_H
+#define LNM_ONLINEPARSEWORKER_H
+
+#include "fs/online/onlinetypes.h"
+
+#include <QDateTime>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QObject>
+
+#include <atomic>
+
+class QTextCodec;
+
+namespace onlineparse {
+
+/* Parameters for parsing a downloaded whazzup file. Filled on the GUI thread and passed by value to the worker. */
+struct Request
+{
+  /* Raw and possibly gzip compressed download data. transceivers can be empty. */
+  QByteArray whazzup, transceivers;
+  atools::fs::online::Format format = atools::fs::online::UNKNOWN;
+
+  /* Used to convert whazzup data which is not UTF-8 */
+  QTextCodec *codec = nullptr;
+
+  /* Last update time from previous whazzup file. File is ignored if not newer. */
+  QDateTime lastUpdateTime;
+
+  /* Circle diameter overrides for ATC centers */
+  QHash<atools::fs::online::fac::FacilityType, int> atcSizes;
+
+  /* Database files for online data and user airspaces. Airspace file can be empty. */
+  QString onlineDbFile, userAirspaceDbFile;
+
+  /* Look up ATC center geometry by callsign name and/or file name in user airspaces */
+  bool airspaceByName = false, airspaceByFile = false, verbose = false;
+};
+
+/* Time needed for each stage of the last parse run in milliseconds */
+struct Timing
+{
+  qint64 uncompressMs = 0L, transceiversMs = 0L, whazzupMs = 0L, totalMs = 0L;
+};
+
+/* Result of parsing. Only valid once the worker signalled finished(). */
+struct Result
+{
+  /* true if file was newer and data was written into the database */
+  bool updated = false, canceled = false;
+
+  /* Values from the parsed whazzup file */
+  QDateTime lastUpdateTime;
+  int reloadMinutes = 0;
+
+  /* All clients with callsign and position for the shadow aircraft spatial index */
+  QVector<atools::fs::online::OnlineAircraft> clients;
+
+  Timing timing;
+};
+
+}
+
+/*
+ * Uncompresses and parses whazzup and transceiver files of online networks and writes them to the online
+ * database in a background thread using QtConcurrent.
+ *
+ * Uses a separate online data manager on an own database connection to the online database file.
+ * The GUI thread connection sees all new data at once when the worker commits the transaction.
+ * ATC center geometries are fetched from the user airspace database using an own read-only connection.
+ *
+ * Only one parse job can be active at any time. Completion is signalled by finished() in the GUI thread.
+ */
+class OnlineParseWorker :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit OnlineParseWorker(QObject *parent);
+  virtual ~OnlineParseWorker() override;
+
+  OnlineParseWorker(const OnlineParseWorker& other) = delete;
+  OnlineParseWorker& operator=(const OnlineParseWorker& other) = delete;
+
+  /* Start parsing in background and return immediately. Does nothing and returns false if already running. */
+  bool start(const onlineparse::Request& request);
+
+  /* Signal cancel which is checked between stages. Returns immediately. finished() is sent later. */
+  void cancel();
+
+  /* Signal cancel and block until the thread has finished. finished() is not sent. */
+  void cancelAndWait();
+
+  bool isRunning() const;
+
+  /* Result of last run. Valid after finished() was sent. */
+  const onlineparse::Result& getResult() const
+  {
+    return result;
+  }
+
+  /* Move clients out of result to avoid copying */
+  QVector<atools::fs::online::OnlineAircraft> takeClients()
+  {
+    return std::move(result.clients);
+  }
+
+signals:
+  /* Parsing finished or was canceled. Get result with getResult(). */
+  void finished();
+
+private:
+  onlineparse::Result parseThread(onlineparse::Request request);
+  void threadFinished();
+
+  /* Used to fetch result from thread */
+  QFuture<onlineparse::Result> future;
+
+  /* Sends signal once thread is finished */
+  QFutureWatcher<onlineparse::Result> watcher;
+
+  onlineparse::Result result;
+  std::atomic_bool cancelFlag;
+
+  /* Suppresses finished() signal if canceled by cancelAndWait() */
+  bool suppressFinished = false;
+};
+
+#endif // LNM_ONLINEPARSEWORKER_H
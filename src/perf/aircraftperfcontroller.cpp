@@ -67,7 +67,7 @@ AircraftPerfController::AircraftPerfController(MainWindow *parent)
   // Calculate fuel flow average over ten seconds
   fuelFlowGroundspeedAverage = new atools::util::MovingAverageTime(10000);
 
-  lastSimData = new atools::fs::sc::SimConnectData();
+  lastSimData = simdata::emptyPacket();
 
   QStringList paths({QApplication::applicationDirPath()});
   ui->textBrowserAircraftPerformanceReport->setSearchPaths(paths);
@@ -99,7 +99,6 @@ AircraftPerfController::~AircraftPerfController()
   delete fileHistory;
   delete perfHandler;
   delete perf;
-  delete lastSimData;
   delete fuelFlowGroundspeedAverage;
 }
 
@@ -1114,7 +1113,7 @@ void AircraftPerfController::fuelReport(atools::util::HtmlBuilder& html, bool pr
     {
       if(NavApp::getMainUi()->actionAircraftPerformanceWarnMismatch->isChecked())
       {
-        QString model = lastSimData->getUserAircraft().getAirplaneModel();
+        QString model = lastSimData->getUserAircraftConst().getAirplaneModel();
         if(!perf->isDefault() && !model.isEmpty() && perf->getAircraftType() != model)
         {
           QString msg(tr("User aircraft type \"%1\" in simulator is not equal to type \"%2\" used in performance file.\n"
@@ -1441,18 +1440,19 @@ void AircraftPerfController::optionsChanged()
 void AircraftPerfController::connectedToSimulator()
 {
   currentReportLastSampleTimeMs = reportLastSampleTimeMs = 0L; // Force update on next simDataChanged
-  *lastSimData = atools::fs::sc::SimConnectData();
+  lastSimData = simdata::emptyPacket();
 }
 
 void AircraftPerfController::disconnectedFromSimulator()
 {
-  *lastSimData = atools::fs::sc::SimConnectData();
+  lastSimData = simdata::emptyPacket();
   updateReports();
 }
 
-void AircraftPerfController::simDataChanged(const atools::fs::sc::SimConnectData& simulatorData)
+void AircraftPerfController::simDataChanged(const simdata::PacketPtr& packet)
 {
-  *lastSimData = simulatorData;
+  const atools::fs::sc::SimConnectData& simulatorData = *packet;
+  lastSimData = packet;
 
 #ifdef DEBUG_INFORMATION_PERF_SIMDATA
   qDebug() << Q_FUNC_INFO << simulatorData.getUserAircraftConst().getZuluTime().toString(Qt::ISODateWithMs)
@@ -18,6 +18,7 @@
 #ifndef LNM_AIRCRAFTPERFCONTROLLER_H
 #define LNM_AIRCRAFTPERFCONTROLLER_H
 
+#include "connect/simdatapacket.h"
 #include "fs/perf/aircraftperfconstants.h"
 
 #include <QTimer>
@@ -115,7 +116,7 @@ public:
   }
 
   /* Updates for automatic performance calculation */
-  void simDataChanged(const atools::fs::sc::SimConnectData& simulatorData);
+  void simDataChanged(const simdata::PacketPtr& packet);
 
   /* Cruise speed knots TAS */
   float getRouteCruiseSpeedKts();
@@ -267,7 +268,7 @@ private:
 
   /* Timer to delay wind updates */
   QTimer windChangeTimer;
-  atools::fs::sc::SimConnectData *lastSimData;
+  simdata::PacketPtr lastSimData;
 
   /* For a smooth endurance calculation - first value is fuel flow in PPH and second is groundspeed in KTS */
   atools::util::MovingAverageTime *fuelFlowGroundspeedAverage;
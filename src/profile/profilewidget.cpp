@@ -155,6 +155,19 @@ struct ElevationLeg
   float maxElevation = 0.f; /* Max ground altitude for this leg */
 };
 
+/* Elevation points for a single leg independent of its position in the flight plan.
+ * Reused if a leg with the same geometry is found in the next calculation. */
+struct ElevationLegCacheEntry
+{
+  atools::geo::LineString geometry, /* Key to detect hash collisions */
+                          elevation; /* Ground elevation in feet (Pos.altitude) and position */
+  QVector<double> distances; /* Distances for each elevation point measured from leg start. Nautical miles. */
+  float maxElevation = 0.f; /* Max ground altitude for this leg */
+};
+
+/* Key is hash of leg geometry */
+typedef QHash<uint, ElevationLegCacheEntry> ElevationLegCache;
+
 struct ElevationLegList
 {
   Route route; /* Copy from route controller.
@@ -163,8 +176,117 @@ struct ElevationLegList
   float maxElevationFt = 0.f /* Maximum ground elevation for the route */,
         totalDistance = 0.f /* Total route distance in nautical miles */;
   int totalNumPoints = 0; /* Number of elevation points in whole flight plan */
+
+  /* Elevation points for all legs of the last calculation. Passed into the thread and returned with all legs
+   * of the new calculation to drop removed legs. */
+  ElevationLegCache legCache;
+  quint32 legCacheGeneration = 0; /* Cache is discarded if the generation changed while the thread was running */
 };
 
+namespace {
+
+uint legGeometryHash(const atools::geo::LineString& geometry)
+{
+  uint hash = static_cast<uint>(geometry.size());
+  for(const Pos& pos : geometry)
+  {
+    hash = qHash(pos.getLonX(), hash);
+    hash = qHash(pos.getLatY(), hash);
+  }
+  return hash;
+}
+
+bool legGeometryEqual(const atools::geo::LineString& geometry1, const atools::geo::LineString& geometry2)
+{
+  if(geometry1.size() != geometry2.size())
+    return false;
+
+  for(int i = 0; i < geometry1.size(); i++)
+  {
+    if(geometry1.at(i).getLonX() != geometry2.at(i).getLonX() || geometry1.at(i).getLatY() != geometry2.at(i).getLatY())
+      return false;
+  }
+  return true;
+}
+
+/* false if leg is too long for the online provider and elevation is not fetched */
+bool isElevationLegFetched(const RouteAltitudeLeg& altLeg)
+{
+  return altLeg.getDistanceTo() < ELEVATION_MAX_LEG_NM || NavApp::isGlobeOfflineProvider();
+}
+
+/* Leg geometry without invalid points and with at least two points */
+LineString elevationLegGeometry(const RouteAltitudeLeg& altLeg)
+{
+  LineString geometry = altLeg.getGeoLineString();
+
+  geometry.removeInvalid();
+  if(geometry.size() == 1)
+    geometry.append(geometry.constFirst());
+  return geometry;
+}
+
+/* Add missing start and end points or dummy points if the provider did not return any values */
+void completeLegElevations(LineString& elevations, const LineString& geometry)
+{
+  if(!elevations.isEmpty())
+  {
+    // Add start or end point if heightProfile omitted these - check only lat lon not alt
+    if(!elevations.constFirst().almostEqual(geometry.constFirst()))
+      elevations.prepend(geometry.constFirst().alt(elevations.constFirst().getAltitude()));
+
+    if(!elevations.constLast().almostEqual(geometry.constLast()))
+      elevations.append(geometry.constLast().alt(elevations.constLast().getAltitude()));
+  }
+
+  // Add two null elevation dummy points if provider does not return any values
+  if(elevations.isEmpty())
+  {
+    elevations.append(geometry.constFirst().alt(0.f));
+    elevations.append(geometry.constLast().alt(0.f));
+  }
+}
+
+/* Convert elevation points in meter to feet and calculate distances from leg start and maximum */
+ElevationLegCacheEntry createLegCacheEntry(LineString elevations, const LineString& geometry)
+{
+  ElevationLegCacheEntry entry;
+  entry.geometry = geometry;
+
+  double distNm = 0.;
+  // Loop over all elevation points for the current leg
+  Pos lastPos;
+  for(int j = 0; j < elevations.size(); j++)
+  {
+    Pos& coord = elevations[j];
+    float altFeet = atools::geo::meterToFeet(coord.getAltitude());
+    coord.setAltitude(altFeet);
+
+    // Adjust maximum
+    if(altFeet > entry.maxElevation)
+      entry.maxElevation = altFeet;
+
+    if(j > 0)
+      // Update leg distance
+      distNm += atools::geo::meterToNm(lastPos.distanceMeterToDouble(coord));
+
+    // Distance to elevation point from leg start
+    entry.distances.append(distNm);
+    lastPos = coord;
+  }
+  entry.elevation = elevations;
+
+  // Use maximum of all terrain cells in the corridor around the leg if the GLOBE pyramid is available
+  // This catches peaks between the sample points
+  float corridorMaxMeter;
+  if(NavApp::getElevationProvider()->getMaxElevationMeter(corridorMaxMeter, geometry, atools::geo::nmToMeter(ELEVATION_SAMPLE_RADIUS_NM)))
+    entry.maxElevation = std::max(entry.maxElevation, atools::geo::meterToFeet(corridorMaxMeter));
+
+  return entry;
+}
+
+}
+
 // =======================================================================================
 
 ProfileWidget::ProfileWidget(QWidget *parent)
@@ -185,6 +307,8 @@ ProfileWidget::ProfileWidget(QWidget *parent)
 
   jumpBack = new JumpBack(this, atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_PROFILE_JUMP_BACK_DEBUG,
                                                                                         false).toBool());
+  elevationBenchmark = atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_PROFILE_ELEVATION_BENCHMARK_DEBUG,
+                                                                               false).toBool();
   connect(jumpBack, &JumpBack::jumpBack, this, &ProfileWidget::jumpBackToAircraftTimeout);
 
   connect(scrollArea, &ProfileScrollArea::showPosAlongFlightplan, this, &ProfileWidget::showPosAlongFlightplan);
@@ -241,8 +365,10 @@ float ProfileWidget::aircraftAlt(const atools::fs::sc::SimConnectUserAircraft& a
          aircraft.getIndicatedAltitudeFt() : aircraft.getActualAltitudeFt();
 }
 
-void ProfileWidget::simDataChanged(const atools::fs::sc::SimConnectData& simulatorData)
+void ProfileWidget::simDataChanged(const simdata::PacketPtr& packet)
 {
+  const atools::fs::sc::SimConnectData& simulatorData = *packet;
+
   if(databaseLoadStatus || !simulatorData.getUserAircraftConst().isValid())
     return;
 
@@ -254,13 +380,13 @@ void ProfileWidget::simDataChanged(const atools::fs::sc::SimConnectData& simulat
   // Do not update for single airport plans
   if(route.getSizeWithoutAlternates() > 1)
   {
-    simData = simulatorData;
+    simData = packet;
 
-    bool lastPosValid = lastSimData.getUserAircraftConst().isValid();
-    bool simPosValid = simData.getUserAircraftConst().isValid();
+    bool lastPosValid = lastSimData->getUserAircraftConst().isValid();
+    bool simPosValid = simData->getUserAircraftConst().isValid();
 
-    float lastAlt = aircraftAlt(lastSimData.getUserAircraftConst());
-    float simAlt = aircraftAlt(simData.getUserAircraftConst());
+    float lastAlt = aircraftAlt(lastSimData->getUserAircraftConst());
+    float simAlt = aircraftAlt(simData->getUserAircraftConst());
 
     aircraftDistanceFromStart = route.getProjectionDistance();
 
@@ -271,7 +397,7 @@ void ProfileWidget::simDataChanged(const atools::fs::sc::SimConnectData& simulat
     if(aircraftDistanceFromStart < map::INVALID_DISTANCE_VALUE)
     {
 #ifdef DEBUG_INFORMATION_PROFILE_SIMDATA
-      if(simData.getUserAircraft().isDebug())
+      if(simData->getUserAircraftConst().isDebug())
         qDebug() << Q_FUNC_INFO << aircraftDistanceFromStart;
 #endif
 
@@ -347,7 +473,7 @@ void ProfileWidget::centerAircraft()
   // Probably center aircraft on scroll area
   if(ui->actionProfileCenterAircraft->isChecked())
   {
-    QPoint currentScreenPoint = toScreen(QPointF(aircraftDistanceFromStart, aircraftAlt(simData.getUserAircraftConst())));
+    QPoint currentScreenPoint = toScreen(QPointF(aircraftDistanceFromStart, aircraftAlt(simData->getUserAircraftConst())));
     bool destUsed;
     QPoint zoomScreenPoint = destinationAirportScreenPos(destUsed, ZOOM_DESTINATION_MAX_AHEAD);
     if(ui->actionProfileZoomAircraft->isChecked() && destUsed)
@@ -365,7 +491,7 @@ void ProfileWidget::centerAircraft()
     }
     else
       // Destination not in range - zoom normally, keep aircraft visible and keep zoom value
-      scrollArea->centerAircraft(currentScreenPoint, simData.getUserAircraftConst().getVerticalSpeedFeetPerMin(), false /* force */);
+      scrollArea->centerAircraft(currentScreenPoint, simData->getUserAircraftConst().getVerticalSpeedFeetPerMin(), false /* force */);
   }
 }
 
@@ -373,7 +499,7 @@ void ProfileWidget::connectedToSimulator()
 {
   qDebug() << Q_FUNC_INFO;
   jumpBack->cancel();
-  simData = atools::fs::sc::SimConnectData();
+  simData = simdata::emptyPacket();
   updateScreenCoords();
   update();
   updateHeaderLabel();
@@ -383,7 +509,7 @@ void ProfileWidget::disconnectedFromSimulator()
 {
   qDebug() << Q_FUNC_INFO;
   jumpBack->cancel();
-  simData = atools::fs::sc::SimConnectData();
+  simData = simdata::emptyPacket();
   updateScreenCoords();
   update();
   updateHeaderLabel();
@@ -440,8 +566,8 @@ void ProfileWidget::updateScreenCoords()
   else
     maxWindowAlt = legList->route.getCruiseAltitudeFt();
 
-  if(simData.getUserAircraftConst().isValid() && (showAircraft || showAircraftTrail) && !NavApp::getRouteConst().isFlightplanEmpty())
-    maxWindowAlt = std::max(maxWindowAlt, aircraftAlt(simData.getUserAircraftConst()));
+  if(simData->getUserAircraftConst().isValid() && (showAircraft || showAircraftTrail) && !NavApp::getRouteConst().isFlightplanEmpty())
+    maxWindowAlt = std::max(maxWindowAlt, aircraftAlt(simData->getUserAircraftConst()));
 
   // if(showAircraftTrack)
   // maxWindowAlt = std::max(maxWindowAlt, maxTrackAltitudeFt);
@@ -619,7 +745,7 @@ void ProfileWidget::paintVerticalPath(QPainter& painter, const Route& route)
 {
   static const float LINE_LENGTH_NM = 20.f;
 
-  float aircraftAltitude = aircraftAlt(simData.getUserAircraftConst());
+  float aircraftAltitude = aircraftAlt(simData->getUserAircraftConst());
   int acx = distanceX(aircraftDistanceFromStart);
   int acy = altitudeY(aircraftAltitude);
 
@@ -632,8 +758,8 @@ void ProfileWidget::paintVerticalPath(QPainter& painter, const Route& route)
     painter.setBackgroundMode(Qt::OpaqueMode);
     painter.setBackground(Qt::transparent);
 
-    float verticalSpeedFeetPerMin = simData.getUserAircraftConst().getVerticalSpeedFeetPerMin();
-    float groundSpeedFeetPerMin = atools::geo::nmToFeet(simData.getUserAircraftConst().getGroundSpeedKts()) / 60.f;
+    float verticalSpeedFeetPerMin = simData->getUserAircraftConst().getVerticalSpeedFeetPerMin();
+    float groundSpeedFeetPerMin = atools::geo::nmToFeet(simData->getUserAircraftConst().getGroundSpeedKts()) / 60.f;
 
     float lineLenNm = std::min(std::min(route.getTotalDistance() - aircraftDistanceFromStart, LINE_LENGTH_NM),
                                scrollArea->getViewport()->width() / 3.f / horizontalScale);
@@ -1658,7 +1784,7 @@ void ProfileWidget::paintEvent(QPaintEvent *)
   }
 
   // Draw user aircraft =========================================================
-  const atools::fs::sc::SimConnectUserAircraft& userAircraft = simData.getUserAircraftConst();
+  const atools::fs::sc::SimConnectUserAircraft& userAircraft = simData->getUserAircraftConst();
   if(userAircraft.isValid() && showAircraft && aircraftDistanceFromStart < map::INVALID_DISTANCE_VALUE && !curRoute.isActiveMissed() &&
      !curRoute.isActiveAlternate())
   {
@@ -1842,6 +1968,10 @@ void ProfileWidget::elevationUpdateAvailable()
   if(databaseLoadStatus)
     return;
 
+  // Elevation data changed - cached legs are outdated
+  legList->legCache.clear();
+  elevationCacheGeneration++;
+
   // Do not terminate thread here since this can lead to starving updates
 
   // Start thread after long delay to calculate new data
@@ -1915,6 +2045,10 @@ void ProfileWidget::updateTimeout()
   legs.route = NavApp::getRouteConst();
   legs.route.updateApproachIls();
 
+  // Pass elevation points of last calculation to avoid fetching unchanged legs again
+  legs.legCache = legList->legCache;
+  legs.legCacheGeneration = elevationCacheGeneration;
+
   // Start thread
   future = QtConcurrent::run(this, &ProfileWidget::fetchRouteElevationsThread, legs);
 
@@ -1932,6 +2066,11 @@ void ProfileWidget::updateThreadFinished()
   {
     // Was not terminated in the middle of calculations - get result from the future
     *legList = future.result();
+
+    // Elevation data was updated while the thread was running
+    if(legList->legCacheGeneration != elevationCacheGeneration)
+      legList->legCache.clear();
+
     updateScreenCoords();
     updateErrorLabel();
     updateHeaderLabel();
@@ -1946,6 +2085,41 @@ void ProfileWidget::updateThreadFinished()
   }
 }
 
+/* Get lines between all points of the geometry. Lines are split at the antimeridian if crossed
+ * @return true if not aborted */
+bool ProfileWidget::fetchElevationLines(QVector<atools::geo::Line>& lines, const atools::geo::LineString& geometry) const
+{
+  for(int i = 0; i < geometry.size() - 1; i++)
+  {
+    // Create a line string from the two points and split it at the date line if crossing
+    GeoDataLineString coords;
+    coords.setTessellate(true);
+    coords << GeoDataCoordinates(geometry.at(i).getLonX(), geometry.at(i).getLatY(), 0., GeoDataCoordinates::Degree)
+           << GeoDataCoordinates(geometry.at(i + 1).getLonX(), geometry.at(i + 1).getLatY(), 0., GeoDataCoordinates::Degree);
+
+    const QVector<Marble::GeoDataLineString *> coordsCorrected = coords.toDateLineCorrected();
+    for(const Marble::GeoDataLineString *ls : coordsCorrected)
+    {
+      for(int j = 1; j < ls->size(); j++)
+      {
+        const Marble::GeoDataCoordinates& c1 = ls->at(j - 1);
+        const Marble::GeoDataCoordinates& c2 = ls->at(j);
+        Pos p1(c1.longitude(), c1.latitude());
+        Pos p2(c2.longitude(), c2.latitude());
+
+        p1.toDeg();
+        p2.toDeg();
+        lines.append(atools::geo::Line(p1, p2));
+      }
+    }
+    qDeleteAll(coordsCorrected);
+
+    if(terminateThreadSignal)
+      return false;
+  }
+  return true;
+}
+
 /* Get elevation points between the two points. This returns also correct results if the antimeridian is crossed
  * @return true if not aborted */
 bool ProfileWidget::fetchRouteElevations(atools::geo::LineString& elevations, const atools::geo::LineString& geometry) const
@@ -1954,71 +2128,73 @@ bool ProfileWidget::fetchRouteElevations(atools::geo::LineString& elevations, co
 
   if(elevationProvider->isValid())
   {
-    for(int i = 0; i < geometry.size() - 1; i++)
-    {
-      // Create a line string from the two points and split it at the date line if crossing
-      GeoDataLineString coords;
-      coords.setTessellate(true);
-      coords << GeoDataCoordinates(geometry.at(i).getLonX(), geometry.at(i).getLatY(), 0., GeoDataCoordinates::Degree)
-             << GeoDataCoordinates(geometry.at(i + 1).getLonX(), geometry.at(i + 1).getLatY(), 0., GeoDataCoordinates::Degree);
-
-      const QVector<Marble::GeoDataLineString *> coordsCorrected = coords.toDateLineCorrected();
-      for(const Marble::GeoDataLineString *ls : coordsCorrected)
-      {
-        for(int j = 1; j < ls->size(); j++)
-        {
-          if(terminateThreadSignal)
-            return false;
+    QVector<atools::geo::Line> lines;
+    if(!fetchElevationLines(lines, geometry))
+      return false;
 
-          const Marble::GeoDataCoordinates& c1 = ls->at(j - 1);
-          const Marble::GeoDataCoordinates& c2 = ls->at(j);
-          Pos p1(c1.longitude(), c1.latitude());
-          Pos p2(c2.longitude(), c2.latitude());
+    // Sampled in parallel for offline data
+    QVector<LineString> lineElevations;
+    elevationProvider->getElevations(lineElevations, lines, atools::geo::nmToMeter(ELEVATION_SAMPLE_RADIUS_NM));
 
-          p1.toDeg();
-          p2.toDeg();
-          elevationProvider->getElevations(elevations, atools::geo::Line(p1, p2), atools::geo::nmToMeter(ELEVATION_SAMPLE_RADIUS_NM));
-        }
-      }
-      qDeleteAll(coordsCorrected);
-    }
+    for(const LineString& lineElevation : qAsConst(lineElevations))
+      elevations.append(lineElevation);
+  }
 
-    if(!elevations.isEmpty())
-    {
-      // Add start or end point if heightProfile omitted these - check only lat lon not alt
-      if(!elevations.constFirst().almostEqual(geometry.constFirst()))
-        elevations.prepend(geometry.constFirst().alt(elevations.constFirst().getAltitude()));
+  completeLegElevations(elevations, geometry);
+  return true;
+}
 
-      if(!elevations.constLast().almostEqual(geometry.constLast()))
-        elevations.append(geometry.constLast().alt(elevations.constLast().getAltitude()));
-    }
+/* Fetch elevation points for all given leg geometries at once which allows to sample all legs in parallel.
+ * @return true if not aborted */
+bool ProfileWidget::fetchRouteElevationsBatch(ElevationLegCache& legCache, const QVector<LineString>& geometries) const
+{
+  // Collect lines for all legs and remember index range for each leg
+  QVector<atools::geo::Line> lines;
+  QVector<int> firstLineIndex;
+  for(const LineString& geometry : geometries)
+  {
+    firstLineIndex.append(lines.size());
+    if(!fetchElevationLines(lines, geometry))
+      return false;
   }
+  firstLineIndex.append(lines.size());
 
-  // Add two null elevation dummy points if provider does not return any values
-  if(elevations.isEmpty())
+  QVector<LineString> lineElevations;
+  NavApp::getElevationProvider()->getElevations(lineElevations, lines, atools::geo::nmToMeter(ELEVATION_SAMPLE_RADIUS_NM));
+
+  if(terminateThreadSignal)
+    return false;
+
+  for(int i = 0; i < geometries.size(); i++)
   {
-    elevations.append(geometry.constFirst().alt(0.f));
-    elevations.append(geometry.constLast().alt(0.f));
-  }
+    // Join lines of leg
+    LineString elevations;
+    for(int j = firstLineIndex.at(i); j < firstLineIndex.at(i + 1); j++)
+      elevations.append(lineElevations.at(j));
 
+    completeLegElevations(elevations, geometries.at(i));
+    legCache.insert(legGeometryHash(geometries.at(i)), createLegCacheEntry(elevations, geometries.at(i)));
+  }
   return true;
 }
 
-/* Background thread. Fetches elevation points from Marble elevation model and updates totals. */
+/* Background thread. Fetches elevation points from Marble elevation model and updates totals.
+ * Uses elevation points from the leg cache for unchanged legs. */
 ElevationLegList ProfileWidget::fetchRouteElevationsThread(ElevationLegList legs) const
 {
   QThread::currentThread()->setPriority(QThread::LowestPriority);
   // qDebug() << "priority" << QThread::currentThread()->priority();
 
-  using atools::geo::meterToNm;
-  using atools::geo::nmToMeter;
-  using atools::geo::meterToFeet;
-
   legs.totalNumPoints = 0;
   legs.totalDistance = 0.f;
   legs.maxElevationFt = 0.f;
   legs.elevationLegs.clear();
 
+  // Cache from last calculation and new cache containing only legs of this calculation
+  const ElevationLegCache lastCache = legs.legCache;
+  legs.legCache.clear();
+  int numCached = 0, numFetched = 0;
+
   if(legs.route.getSizeWithoutAlternates() <= 1)
     // Return empty result
     return ElevationLegList();
@@ -2027,6 +2203,27 @@ ElevationLegList ProfileWidget::fetchRouteElevationsThread(ElevationLegList legs
     // Return empty result
     return ElevationLegList();
 
+  // Fetch all changed legs at once in parallel if offline data is used =====================
+  ElevationLegCache fetchedCache;
+  if(NavApp::isGlobeOfflineProvider())
+  {
+    QVector<LineString> geometries;
+    for(int i = 1; i <= legs.route.getDestinationLegIndex(); i++)
+    {
+      const RouteAltitudeLeg& altLeg = legs.route.getAltitudeLegAt(i);
+      if(altLeg.isMissed() || altLeg.isAlternate())
+        break;
+
+      LineString geometry = elevationLegGeometry(altLeg);
+      ElevationLegCache::const_iterator it = lastCache.constFind(legGeometryHash(geometry));
+      if(it == lastCache.constEnd() || !legGeometryEqual(it->geometry, geometry))
+        geometries.append(geometry);
+    }
+
+    if(!geometries.isEmpty() && !fetchRouteElevationsBatch(fetchedCache, geometries))
+      return ElevationLegList();
+  }
+
   // Total calculated distance across all legs
   double totalDistanceNm = 0.;
 
@@ -2048,60 +2245,56 @@ ElevationLegList ProfileWidget::fetchRouteElevationsThread(ElevationLegList legs
     double scale = 1.;
 
     // Skip for too long segments when using the marble online provider
-    if(altLeg.getDistanceTo() < ELEVATION_MAX_LEG_NM || NavApp::isGlobeOfflineProvider())
+    if(isElevationLegFetched(altLeg))
     {
-      LineString geometry = altLeg.getGeoLineString();
-
-      geometry.removeInvalid();
-      if(geometry.size() == 1)
-        geometry.append(geometry.constFirst());
-
-      // Includes first and last point
-      LineString elevations;
-      if(!fetchRouteElevations(elevations, geometry))
-        return ElevationLegList();
-
-      if(elevations.isEmpty())
-        return ElevationLegList();
+      LineString geometry = elevationLegGeometry(altLeg);
 
-      // elevations.removeDuplicates();
-#ifdef DEBUG_INFORMATION_PROFILE
-      qDebug() << Q_FUNC_INFO << "elevations" << elevations << atools::geo::meterToNm(elevations.lengthMeter());
-      qDebug() << Q_FUNC_INFO << "geometry" << geometry << atools::geo::meterToNm(geometry.lengthMeter());
-#endif
-      leg.geometry = geometry;
-
-      double distNm = totalDistanceNm;
-      // Loop over all elevation points for the current leg
-      Pos lastPos;
-      for(int j = 0; j < elevations.size(); j++)
+      uint key = legGeometryHash(geometry);
+      ElevationLegCacheEntry entry;
+      ElevationLegCache::const_iterator it = lastCache.constFind(key);
+      ElevationLegCache::const_iterator itFetched = fetchedCache.constFind(key);
+      if(it != lastCache.constEnd() && legGeometryEqual(it->geometry, geometry))
+      {
+        // Leg not changed - reuse elevation points
+        entry = it.value();
+        numCached++;
+      }
+      else if(itFetched != fetchedCache.constEnd() && legGeometryEqual(itFetched->geometry, geometry))
+      {
+        // Fetched in batch above
+        entry = itFetched.value();
+        numFetched++;
+      }
+      else
       {
-        if(terminateThreadSignal)
+        // Includes first and last point
+        LineString elevations;
+        if(!fetchRouteElevations(elevations, geometry))
           return ElevationLegList();
 
-        Pos& coord = elevations[j];
-        float altFeet = meterToFeet(coord.getAltitude());
-        coord.setAltitude(altFeet);
-
-        // Adjust maximum
-        if(altFeet > leg.maxElevation)
-          leg.maxElevation = altFeet;
-        if(altFeet > legs.maxElevationFt)
-          legs.maxElevationFt = altFeet;
-
-        if(j > 0)
-          // Update total distance
-          distNm += meterToNm(lastPos.distanceMeterToDouble(coord));
+        if(elevations.isEmpty())
+          return ElevationLegList();
 
-        // Coordinate with elevation
-        leg.elevation.append(coord);
+        // elevations.removeDuplicates();
+#ifdef DEBUG_INFORMATION_PROFILE
+        qDebug() << Q_FUNC_INFO << "elevations" << elevations << atools::geo::meterToNm(elevations.lengthMeter());
+        qDebug() << Q_FUNC_INFO << "geometry" << geometry << atools::geo::meterToNm(geometry.lengthMeter());
+#endif
+        entry = createLegCacheEntry(elevations, geometry);
+        numFetched++;
+      }
+      legs.legCache.insert(key, entry);
 
-        // Distance to elevation point from departure
-        leg.distances.append(distNm);
+      leg.geometry = geometry;
+      leg.elevation = entry.elevation;
+      leg.maxElevation = entry.maxElevation;
+      legs.maxElevationFt = std::max(legs.maxElevationFt, entry.maxElevation);
+      legs.totalNumPoints += entry.elevation.size();
 
-        legs.totalNumPoints++;
-        lastPos = coord;
-      }
+      // Convert leg distances to distances from departure
+      leg.distances.reserve(entry.distances.size());
+      for(double dist : qAsConst(entry.distances))
+        leg.distances.append(totalDistanceNm + dist);
 
       // float distanceTo = atools::geo::meterToNm(geometry.lengthMeter());
       float distanceTo = altLeg.getDistanceTo();
@@ -2141,6 +2334,23 @@ ElevationLegList ProfileWidget::fetchRouteElevationsThread(ElevationLegList legs
   }
 
   legs.totalDistance = static_cast<float>(totalDistanceNm);
+
+  if(elevationBenchmark)
+  {
+    // Compare sampling with pyramid query for all legs
+    QVector<LineString> geometries;
+    for(const ElevationLeg& leg : qAsConst(legs.elevationLegs))
+      geometries.append(leg.geometry);
+    NavApp::getElevationProvider()->benchmarkMaxElevation(geometries, atools::geo::nmToMeter(ELEVATION_SAMPLE_RADIUS_NM));
+  }
+
+#ifdef DEBUG_INFORMATION_PROFILE
+  qDebug() << Q_FUNC_INFO << "cached legs" << numCached << "fetched legs" << numFetched;
+#else
+  Q_UNUSED(numCached)
+  Q_UNUSED(numFetched)
+#endif
+
   return legs;
 }
 
@@ -2565,7 +2775,7 @@ void ProfileWidget::updateHeaderLabel()
   {
     float distFromStartNm = 0.f, distToDestNm = 0.f, nearestLegDistance = 0.f;
     const Route& route = NavApp::getRouteConst();
-    if(simData.getUserAircraftConst().isValid())
+    if(simData->getUserAircraftConst().isValid())
     {
       bool timeToDestOpt = options.testFlag(optsp::PROFILE_HEADER_DIST_TIME_TO_DEST);
 
@@ -18,13 +18,16 @@
 #ifndef LITTLENAVMAP_PROFILEWIDGET_H
 #define LITTLENAVMAP_PROFILEWIDGET_H
 
+#include "connect/simdatapacket.h"
 #include "fs/sc/simconnectdata.h"
 
 #include <QFutureWatcher>
+#include <QHash>
 #include <QWidget>
 
 namespace atools {
 namespace geo {
+class Line;
 class LineString;
 }
 namespace fs {
@@ -48,6 +51,7 @@ class Route;
 class RouteLeg;
 class ProfileOptions;
 struct ElevationLegList;
+struct ElevationLegCacheEntry;
 
 /*
  * Loads and displays the flight plan elevation profile. The elevation data is
@@ -74,7 +78,7 @@ public:
   void routeAltitudeChanged(int altitudeFeet);
 
   /* Update user aircraft on profile display */
-  void simDataChanged(const atools::fs::sc::SimConnectData& simulatorData);
+  void simDataChanged(const simdata::PacketPtr& packet);
 
   /* Track was shortened and needs a full update */
   void aircraftTrailPruned();
@@ -209,6 +213,9 @@ private:
   virtual void contextMenuEvent(QContextMenuEvent *event) override;
 
   bool fetchRouteElevations(atools::geo::LineString& elevations, const atools::geo::LineString& geometry) const;
+  bool fetchRouteElevationsBatch(QHash<uint, ElevationLegCacheEntry>& legCache,
+                                 const QVector<atools::geo::LineString>& geometries) const;
+  bool fetchElevationLines(QVector<atools::geo::Line>& lines, const atools::geo::LineString& geometry) const;
   ElevationLegList fetchRouteElevationsThread(ElevationLegList legs) const;
   void elevationUpdateAvailable();
   void updateTimeout();
@@ -284,7 +291,7 @@ private:
   void centerAircraft();
 
   /* User aircraft data */
-  atools::fs::sc::SimConnectData simData, lastSimData;
+  simdata::PacketPtr simData = simdata::emptyPacket(), lastSimData = simdata::emptyPacket();
 
   /* Track x = distance from start in NM and y = altitude in feet */
   QPolygonF aircraftTrailPoints;
@@ -307,6 +314,12 @@ private:
   QFutureWatcher<ElevationLegList> watcher;
   bool terminateThreadSignal = false;
 
+  /* Incremented when elevation data changes to invalidate the leg cache of a running thread */
+  quint32 elevationCacheGeneration = 0;
+
+  /* Log timing of sampled versus pyramid maximum elevation for each calculation */
+  bool elevationBenchmark = false;
+
   bool databaseLoadStatus = false;
   bool active = false;
   bool insideResizeEvent = false; // Avoid recursion when resize is called by ProfileScrollArea::scaleView
@@ -33,6 +33,78 @@ using namespace Marble;
 using namespace atools::sql;
 using namespace atools::geo;
 
+/* Maximum deviation in degree for each level of detail. Index 0 is the original geometry. */
+static const QVector<float> AIRSPACE_LOD_TOLERANCE_DEG({0.f, 0.001f, 0.004f, 0.016f, 0.064f, 0.256f});
+
+/* Do not simplify below this number of points since polygons are closed */
+static const int AIRSPACE_LOD_MIN_POINTS = 5;
+
+namespace {
+
+/* Distance of point from the line through start and end in degree. Uses plain coordinates
+ * which errs on the safe side for longitude. */
+float distanceToLineDeg(const Pos& pos, const Pos& start, const Pos& end)
+{
+  float dx = end.getLonX() - start.getLonX(), dy = end.getLatY() - start.getLatY();
+  float px = pos.getLonX() - start.getLonX(), py = pos.getLatY() - start.getLatY();
+  float length = std::sqrt(dx * dx + dy * dy);
+
+  if(length < 1.e-9f)
+    // Start and end are equal for closed rings
+    return std::sqrt(px * px + py * py);
+  else
+    return std::abs(dx * py - dy * px) / length;
+}
+
+/* Simplify line using the Douglas-Peucker algorithm. Start and end point are always kept. */
+void simplifyLine(LineString& simplified, const LineString& line, float toleranceDeg)
+{
+  int size = line.size();
+  if(size < 3)
+  {
+    simplified = line;
+    return;
+  }
+
+  QVector<bool> keep(size, false);
+  keep[0] = keep[size - 1] = true;
+
+  // Stack of index ranges avoids recursion for large geometries
+  QVector<std::pair<int, int> > ranges({std::make_pair(0, size - 1)});
+  while(!ranges.isEmpty())
+  {
+    std::pair<int, int> range = ranges.takeLast();
+
+    float maxDist = 0.f;
+    int maxIndex = -1;
+    for(int i = range.first + 1; i < range.second; i++)
+    {
+      float dist = distanceToLineDeg(line.at(i), line.at(range.first), line.at(range.second));
+      if(dist > maxDist)
+      {
+        maxDist = dist;
+        maxIndex = i;
+      }
+    }
+
+    if(maxIndex != -1 && maxDist > toleranceDeg)
+    {
+      keep[maxIndex] = true;
+      ranges.append(std::make_pair(range.first, maxIndex));
+      ranges.append(std::make_pair(maxIndex, range.second));
+    }
+  }
+
+  simplified.clear();
+  for(int i = 0; i < size; i++)
+  {
+    if(keep.at(i))
+      simplified.append(line.at(i));
+  }
+}
+
+}
+
 static double queryRectInflationFactor = 0.2;
 static double queryRectInflationIncrement = 0.1;
 int AirspaceQuery::queryMaxRows = map::MAX_MAP_OBJECTS;
@@ -238,26 +310,41 @@ void AirspaceQuery::airspaceGeometry(LineString *lines, const QByteArray& bytes)
   geometry.swapGeometry(*lines);
 }
 
-const LineString *AirspaceQuery::getAirspaceGeometryById(int airspaceId)
+const LineString *AirspaceQuery::getAirspaceGeometryById(int airspaceId, float maxErrorDeg)
 {
   if(!query::valid(Q_FUNC_INFO, airspaceLinesByIdQuery))
     return nullptr;
 
-  if(airspaceLineCache.contains(airspaceId))
-    return airspaceLineCache.object(airspaceId);
-  else
+  QVector<LineString> *levels = airspaceLineCache.object(airspaceId);
+  if(levels == nullptr)
   {
-    LineString *linestring = new LineString;
+    levels = new QVector<LineString>({LineString()});
 
     airspaceLinesByIdQuery->bindValue(":id", airspaceId);
     airspaceLinesByIdQuery->exec();
     if(airspaceLinesByIdQuery->next())
-      airspaceGeometry(linestring, airspaceLinesByIdQuery->value("geometry").toByteArray());
+      airspaceGeometry(&levels->first(), airspaceLinesByIdQuery->value("geometry").toByteArray());
     airspaceLinesByIdQuery->finish();
-    airspaceLineCache.insert(airspaceId, linestring);
 
-    return linestring;
+    // Create simplified geometries until the point limit is reached
+    for(int i = 1; i < AIRSPACE_LOD_TOLERANCE_DEG.size() && levels->constLast().size() > AIRSPACE_LOD_MIN_POINTS; i++)
+    {
+      LineString simplified;
+      simplifyLine(simplified, levels->constLast(), AIRSPACE_LOD_TOLERANCE_DEG.at(i));
+      if(simplified.size() < AIRSPACE_LOD_MIN_POINTS)
+        break;
+      levels->append(simplified);
+    }
+
+    airspaceLineCache.insert(airspaceId, levels);
   }
+
+  // Get coarsest level within error
+  int index = 0;
+  while(index + 1 < levels->size() && AIRSPACE_LOD_TOLERANCE_DEG.at(index + 1) <= maxErrorDeg)
+    index++;
+
+  return &levels->at(index);
 }
 
 const LineString *AirspaceQuery::getAirspaceGeometryByFile(QString callsign)
@@ -67,7 +67,11 @@ public:
   /* Get airspaces for map display */
   const QList<map::MapAirspace> *getAirspaces(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
                                               const map::MapAirspaceFilter& filter, float flightPlanAltitude, bool lazy, bool& overflow);
-  const atools::geo::LineString *getAirspaceGeometryById(int airspaceId);
+
+  /* Get geometry in full resolution if maxErrorDeg is 0. Otherwise the coarsest simplified geometry where
+   * no point deviates more than maxErrorDeg degrees from the original. Simplified geometries are created on first use
+   * and cached together with the original. */
+  const atools::geo::LineString *getAirspaceGeometryById(int airspaceId, float maxErrorDeg = 0.f);
 
   /* Query raw geometry blob by online callsign (name) and facility type */
   const atools::geo::LineString *getAirspaceGeometryByName(QString callsign, const QString& facilityType);
@@ -103,8 +107,9 @@ private:
   map::MapAirspaceFilter lastAirspaceFilter;
   float lastFlightplanAltitude = 0.f;
 
-  /* ID/object caches */
-  QCache<int, atools::geo::LineString> airspaceLineCache;
+  /* ID/object caches. Airspace lines contain the full geometry at index 0 followed by simplified geometries
+   * for each tolerance in AIRSPACE_LOD_TOLERANCE_DEG. */
+  QCache<int, QVector<atools::geo::LineString> > airspaceLineCache;
   QCache<QString, atools::geo::LineString> onlineCenterGeoCache, onlineCenterGeoFileCache;
 
   static int queryMaxRows;
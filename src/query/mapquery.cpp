@@ -83,6 +83,16 @@ MapQuery::MapQuery(atools::sql::SqlDatabase *sqlDbSim, SqlDatabase *sqlDbNav, Sq
   queryRectInflationFactor = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "QueryRectInflationFactor", 0.5).toDouble();
   queryRectInflationIncrement = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "QueryRectInflationIncrement", 0.5).toDouble();
   queryMaxRows = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "MapQueryRowLimit", map::MAX_MAP_OBJECTS).toInt();
+
+  // Maximum number of objects kept in all tiles for each type
+  int tileCacheObjects = settings.getAndStoreValue(lnm::SETTINGS_MAPQUERY + "TileCacheObjects", 50000).toInt();
+  airportCache.setMaxObjects(tileCacheObjects);
+  airportMsaCache.setMaxObjects(tileCacheObjects);
+  vorCache.setMaxObjects(tileCacheObjects);
+  ndbCache.setMaxObjects(tileCacheObjects);
+  markerCache.setMaxObjects(tileCacheObjects);
+  holdingCache.setMaxObjects(tileCacheObjects);
+  ilsCache.setMaxObjects(tileCacheObjects);
 }
 
 MapQuery::~MapQuery()
@@ -863,19 +873,8 @@ const QList<map::MapAirport> *MapQuery::getAirports(const Marble::GeoDataLatLonB
   bool addon = types.testFlag(map::AIRPORT_ADDON);
   bool normal = types & map::AIRPORT_ALL;
 
-  airportCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
-                           [this, addon, normal](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
-  {
-    return curLayer->hasSameQueryParametersAirport(newLayer) &&
-    // Invalidate cache if settings differ
-    airportCacheAddonFlag == addon && airportCacheNormalFlag == normal;
-  });
-
-  airportCacheAddonFlag = addon;
-  airportCacheNormalFlag = normal;
-
   airportByRectQuery->bindValue(":minlength", mapLayer->getMinRunwayLength());
-  return fetchAirports(rect, airportByRectQuery, lazy, false /* overview */, addon, normal, overflow);
+  return fetchAirports(rect, mapLayer, airportByRectQuery, lazy, false /* overview */, addon, normal, overflow);
 }
 
 const QList<map::MapAirport> *MapQuery::getAirportsByRect(const atools::geo::Rect& rect, const MapLayer *mapLayer, bool lazy,
@@ -890,11 +889,8 @@ const QList<map::MapAirport> *MapQuery::getAirportsByRect(const atools::geo::Rec
   bool addon = types.testFlag(map::AIRPORT_ADDON);
   bool normal = types & map::AIRPORT_ALL;
 
-  airportCacheAddonFlag = addon;
-  airportCacheNormalFlag = normal;
-
   airportByRectQuery->bindValue(":minlength", mapLayer->getMinRunwayLength());
-  return fetchAirports(latLonBox, airportByRectQuery, lazy, false /* overview */, addon, normal, overflow);
+  return fetchAirports(latLonBox, mapLayer, airportByRectQuery, lazy, false /* overview */, addon, normal, overflow);
 }
 
 const QList<map::MapVor> *MapQuery::getVors(const GeoDataLatLonBox& rect, const MapLayer *mapLayer,
@@ -907,22 +903,19 @@ const QList<map::MapVor> *MapQuery::getVors(const GeoDataLatLonBox& rect, const
                        [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersVor(newLayer);
-  });
-
-  if(vorCache.list.isEmpty() && !lazy)
+  },
+                       [this](const GeoDataLatLonBox& tileRect, QList<MapVor>& vors) -> void
   {
-    for(const GeoDataLatLonBox& r : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+    query::bindRect(tileRect, vorsByRectQuery);
+    vorsByRectQuery->exec();
+    while(vorsByRectQuery->next())
     {
-      query::bindRect(r, vorsByRectQuery);
-      vorsByRectQuery->exec();
-      while(vorsByRectQuery->next())
-      {
-        MapVor vor;
-        mapTypesFactory->fillVor(vorsByRectQuery->record(), vor);
-        vorCache.list.append(vor);
-      }
+      MapVor vor;
+      mapTypesFactory->fillVor(vorsByRectQuery->record(), vor);
+      vors.append(vor);
     }
-  }
+  }, queryMaxRows);
+
   overflow = vorCache.validate(queryMaxRows);
   return &vorCache.list;
 }
@@ -943,22 +936,19 @@ const QList<map::MapNdb> *MapQuery::getNdbs(const GeoDataLatLonBox& rect, const
                        [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersNdb(newLayer);
-  });
-
-  if(ndbCache.list.isEmpty() && !lazy)
+  },
+                       [this](const GeoDataLatLonBox& tileRect, QList<MapNdb>& ndbs) -> void
   {
-    for(const GeoDataLatLonBox& r : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+    query::bindRect(tileRect, ndbsByRectQuery);
+    ndbsByRectQuery->exec();
+    while(ndbsByRectQuery->next())
     {
-      query::bindRect(r, ndbsByRectQuery);
-      ndbsByRectQuery->exec();
-      while(ndbsByRectQuery->next())
-      {
-        MapNdb ndb;
-        mapTypesFactory->fillNdb(ndbsByRectQuery->record(), ndb);
-        ndbCache.list.append(ndb);
-      }
+      MapNdb ndb;
+      mapTypesFactory->fillNdb(ndbsByRectQuery->record(), ndb);
+      ndbs.append(ndb);
     }
-  }
+  }, queryMaxRows);
+
   overflow = ndbCache.validate(queryMaxRows);
   return &ndbCache.list;
 }
@@ -1081,23 +1071,19 @@ const QList<map::MapMarker> *MapQuery::getMarkers(const GeoDataLatLonBox& rect,
                           [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersMarker(newLayer);
-  });
-
-  if(markerCache.list.isEmpty() && !lazy)
+  },
+                          [this](const GeoDataLatLonBox& tileRect, QList<map::MapMarker>& markers) -> void
   {
-    for(const GeoDataLatLonBox& r :
-        query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+    query::bindRect(tileRect, markersByRectQuery);
+    markersByRectQuery->exec();
+    while(markersByRectQuery->next())
     {
-      query::bindRect(r, markersByRectQuery);
-      markersByRectQuery->exec();
-      while(markersByRectQuery->next())
-      {
-        map::MapMarker marker;
-        mapTypesFactory->fillMarker(markersByRectQuery->record(), marker);
-        markerCache.list.append(marker);
-      }
+      map::MapMarker marker;
+      mapTypesFactory->fillMarker(markersByRectQuery->record(), marker);
+      markers.append(marker);
     }
-  }
+  }, queryMaxRows);
+
   overflow = markerCache.validate(queryMaxRows);
   return &markerCache.list;
 }
@@ -1119,23 +1105,19 @@ const QList<map::MapHolding> *MapQuery::getHoldings(const Marble::GeoDataLatLonB
                              [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
     {
       return curLayer->hasSameQueryParametersHolding(newLayer);
-    });
-
-    if(holdingCache.list.isEmpty() && !lazy)
+    },
+                             [this](const GeoDataLatLonBox& tileRect, QList<MapHolding>& holdings) -> void
     {
-      for(const GeoDataLatLonBox& r :
-          query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+      query::bindRect(tileRect, holdingByRectQuery);
+      holdingByRectQuery->exec();
+      while(holdingByRectQuery->next())
       {
-        query::bindRect(r, holdingByRectQuery);
-        holdingByRectQuery->exec();
-        while(holdingByRectQuery->next())
-        {
-          MapHolding holding;
-          mapTypesFactory->fillHolding(holdingByRectQuery->record(), holding);
-          holdingCache.list.append(holding);
-        }
+        MapHolding holding;
+        mapTypesFactory->fillHolding(holdingByRectQuery->record(), holding);
+        holdings.append(holding);
       }
-    }
+    }, queryMaxRows);
+
     overflow = holdingCache.validate(queryMaxRows);
     return &holdingCache.list;
   }
@@ -1151,24 +1133,19 @@ const QList<map::MapAirportMsa> *MapQuery::getAirportMsa(const Marble::GeoDataLa
                                 [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
     {
       return curLayer->hasSameQueryParametersAirportMsa(newLayer);
-    });
-
-    if(airportMsaCache.list.isEmpty() && !lazy)
+    },
+                                [this](const GeoDataLatLonBox& tileRect, QList<MapAirportMsa>& msas) -> void
     {
-      for(const GeoDataLatLonBox& r :
-          query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+      query::bindRect(tileRect, airportMsaByRectQuery);
+      airportMsaByRectQuery->exec();
+      while(airportMsaByRectQuery->next())
       {
-        query::bindRect(r, airportMsaByRectQuery);
-
-        airportMsaByRectQuery->exec();
-        while(airportMsaByRectQuery->next())
-        {
-          MapAirportMsa msa;
-          mapTypesFactory->fillAirportMsa(airportMsaByRectQuery->record(), msa);
-          airportMsaCache.list.append(msa);
-        }
+        MapAirportMsa msa;
+        mapTypesFactory->fillAirportMsa(airportMsaByRectQuery->record(), msa);
+        msas.append(msa);
       }
-    }
+    }, queryMaxRows);
+
     overflow = airportMsaCache.validate(queryMaxRows);
     return &airportMsaCache.list;
   }
@@ -1180,39 +1157,36 @@ const QList<map::MapIls> *MapQuery::getIls(GeoDataLatLonBox rect, const MapLayer
   if(!query::valid(Q_FUNC_INFO, ilsByRectQuery))
     return nullptr;
 
+  // ILS length is 9 NM * 1' per degree
+  double increase = atools::geo::toRadians(9. / 60.);
+
+  // Increase bounding rect since ILS has no bounding to query
+  rect.setBoundaries(rect.north() + increase, rect.south() - increase, rect.east() + increase, rect.west() - increase);
+
   ilsCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
                        [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersIls(newLayer);
-  });
-
-  if(ilsCache.list.isEmpty() && !lazy)
+  },
+                       [this, mapLayer](const GeoDataLatLonBox& tileRect, QList<MapIls>& ilsList) -> void
   {
-    // ILS length is 9 NM * 1' per degree
-    double increase = atools::geo::toRadians(9. / 60.);
-
-    // Increase bounding rect since ILS has no bounding to query
-    rect.setBoundaries(rect.north() + increase, rect.south() - increase, rect.east() + increase, rect.west() - increase);
+    query::bindRect(tileRect, ilsByRectQuery);
 
-    for(const GeoDataLatLonBox& r : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+    ilsByRectQuery->exec();
+    while(ilsByRectQuery->next())
     {
-      query::bindRect(r, ilsByRectQuery);
+      // ILS is always loaded from nav except if all is off
+      map::MapRunwayEnd end;
+      if(mapLayer->isIlsDetail() && !NavApp::isNavdataOff())
+        // Get the runway end to fix graphical alignment issues in map
+        end = NavApp::getAirportQueryNav()->getRunwayEndById(ilsByRectQuery->valueInt("loc_runway_end_id"));
 
-      ilsByRectQuery->exec();
-      while(ilsByRectQuery->next())
-      {
-        // ILS is always loaded from nav except if all is off
-        map::MapRunwayEnd end;
-        if(mapLayer->isIlsDetail() && !NavApp::isNavdataOff())
-          // Get the runway end to fix graphical alignment issues in map
-          end = NavApp::getAirportQueryNav()->getRunwayEndById(ilsByRectQuery->valueInt("loc_runway_end_id"));
-
-        MapIls ils;
-        mapTypesFactory->fillIls(ilsByRectQuery->record(), ils, end.isFullyValid() ? end.heading : map::INVALID_HEADING_VALUE);
-        ilsCache.list.append(ils);
-      }
+      MapIls ils;
+      mapTypesFactory->fillIls(ilsByRectQuery->record(), ils, end.isFullyValid() ? end.heading : map::INVALID_HEADING_VALUE);
+      ilsList.append(ils);
     }
-  }
+  }, queryMaxRows);
+
   overflow = ilsCache.validate(queryMaxRows);
   return &ilsCache.list;
 }
@@ -1224,70 +1198,79 @@ const QList<map::MapIls> *MapQuery::getIls(GeoDataLatLonBox rect, const MapLayer
  * @param overview fetch only incomplete data for overview airports
  * @return pointer to the airport cache
  */
-const QList<map::MapAirport> *MapQuery::fetchAirports(const Marble::GeoDataLatLonBox& rect, atools::sql::SqlQuery *query,
-                                                      bool lazy, bool overview, bool addon, bool normal, bool& overflow)
+const QList<map::MapAirport> *MapQuery::fetchAirports(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
+                                                      atools::sql::SqlQuery *query, bool lazy, bool overview, bool addon,
+                                                      bool normal, bool& overflow)
 {
   if(!query::valid(Q_FUNC_INFO, query))
     return nullptr;
 
   AirportQuery *airportQueryNav = NavApp::getAirportQueryNav();
+  bool navdata = NavApp::isNavdataAll();
 
-  if(airportCache.list.isEmpty() && !lazy)
+  airportCache.updateCache(rect, mapLayer, queryRectInflationFactor, queryRectInflationIncrement, lazy,
+                           [this, addon, normal](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
+  {
+    return curLayer->hasSameQueryParametersAirport(newLayer) &&
+    // Invalidate cache if settings differ
+    airportCacheAddonFlag == addon && airportCacheNormalFlag == normal;
+  },
+                           [this, query, airportQueryNav, overview, addon, normal, navdata]
+                             (const GeoDataLatLonBox& tileRect, QList<MapAirport>& airports) -> void
   {
-    bool navdata = NavApp::isNavdataAll();
+    // Avoid duplicates between both queries
+    QSet<int> ids;
 
-    for(const GeoDataLatLonBox& r : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+    // Get normal airports ==========
+    if(normal)
     {
-      // Avoid duplicates between both queries
-      QSet<int> ids;
-
-      // Get normal airports ==========
-      if(normal)
+      query::bindRect(tileRect, query);
+      query->exec();
+      while(query->next())
       {
-        query::bindRect(r, query);
-        query->exec();
-        while(query->next())
-        {
-          MapAirport airport;
-          if(overview)
-            // Fill only a part of the object
-            mapTypesFactory->fillAirportForOverview(query->record(), airport, navdata, NavApp::isAirportDatabaseXPlane(navdata));
-          else
-            mapTypesFactory->fillAirport(query->record(), airport, true /* complete */, navdata, NavApp::isAirportDatabaseXPlane(navdata));
-
-          // Need to update airport procedure flag for mixed mode databases to enable procedure filter on map
-          airportQueryNav->correctAirportProcedureFlag(airport);
-
-          ids.insert(airport.id);
-          airportCache.list.append(airport);
-        }
+        MapAirport airport;
+        if(overview)
+          // Fill only a part of the object
+          mapTypesFactory->fillAirportForOverview(query->record(), airport, navdata, NavApp::isAirportDatabaseXPlane(navdata));
+        else
+          mapTypesFactory->fillAirport(query->record(), airport, true /* complete */, navdata, NavApp::isAirportDatabaseXPlane(navdata));
+
+        // Need to update airport procedure flag for mixed mode databases to enable procedure filter on map
+        airportQueryNav->correctAirportProcedureFlag(airport);
+
+        ids.insert(airport.id);
+        airports.append(airport);
       }
+    }
 
-      // Get add-on airports ==========
-      if(addon && airportAddonByRectQuery != nullptr)
+    // Get add-on airports ==========
+    if(addon && airportAddonByRectQuery != nullptr)
+    {
+      query::bindRect(tileRect, airportAddonByRectQuery);
+      airportAddonByRectQuery->exec();
+      while(airportAddonByRectQuery->next())
       {
-        query::bindRect(r, airportAddonByRectQuery);
-        airportAddonByRectQuery->exec();
-        while(airportAddonByRectQuery->next())
-        {
-          MapAirport airport;
-          if(overview)
-            // Fill only a part of the object
-            mapTypesFactory->fillAirportForOverview(airportAddonByRectQuery->record(), airport, navdata,
-                                                    NavApp::isAirportDatabaseXPlane(navdata));
-          else
-            mapTypesFactory->fillAirport(airportAddonByRectQuery->record(), airport, true /* complete */, navdata,
-                                         NavApp::isAirportDatabaseXPlane(navdata));
-
-          // Need to update airport procedure flag for mixed mode databases to enable procedure filter on map
-          airportQueryNav->correctAirportProcedureFlag(airport);
-
-          if(!ids.contains(airport.id))
-            airportCache.list.append(airport);
-        }
+        MapAirport airport;
+        if(overview)
+          // Fill only a part of the object
+          mapTypesFactory->fillAirportForOverview(airportAddonByRectQuery->record(), airport, navdata,
+                                                  NavApp::isAirportDatabaseXPlane(navdata));
+        else
+          mapTypesFactory->fillAirport(airportAddonByRectQuery->record(), airport, true /* complete */, navdata,
+                                       NavApp::isAirportDatabaseXPlane(navdata));
+
+        // Need to update airport procedure flag for mixed mode databases to enable procedure filter on map
+        airportQueryNav->correctAirportProcedureFlag(airport);
+
+        if(!ids.contains(airport.id))
+          airports.append(airport);
       }
     }
-  }
+  }, queryMaxRows);
+
+  airportCacheAddonFlag = addon;
+  airportCacheNormalFlag = normal;
+
   overflow = airportCache.validate(queryMaxRows);
   return &airportCache.list;
 }
@@ -1528,6 +1511,14 @@ void MapQuery::initQueries()
 
 void MapQuery::deInitQueries()
 {
+  airportCache.logStatistics("airports");
+  airportMsaCache.logStatistics("airport MSA");
+  vorCache.logStatistics("VOR");
+  ndbCache.logStatistics("NDB");
+  markerCache.logStatistics("markers");
+  holdingCache.logStatistics("holdings");
+  ilsCache.logStatistics("ILS");
+
   airportCache.clear();
   airportMsaCache.clear();
   vorCache.clear();
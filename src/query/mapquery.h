@@ -260,8 +260,9 @@ private:
                                 const atools::geo::Pos& sortByDistancePos,
                                 float maxDistanceMeter, bool airportFromNavDatabase, map::AirportQueryFlags flags) const;
 
-  const QList<map::MapAirport> *fetchAirports(const Marble::GeoDataLatLonBox& rect, atools::sql::SqlQuery *query,
-                                              bool lazy, bool overview, bool addon, bool normal, bool& overflow);
+  const QList<map::MapAirport> *fetchAirports(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer,
+                                              atools::sql::SqlQuery *query, bool lazy, bool overview, bool addon, bool normal,
+                                              bool& overflow);
 
   QVector<map::MapIls> ilsByAirportAndRunway(const QString& airportIdent, const QString& runway) const;
 
@@ -273,17 +274,19 @@ private:
   MapTypesFactory *mapTypesFactory;
   atools::sql::SqlDatabase *dbSim, *dbNav, *dbUser;
 
-  /* Simple bounding rectangle caches */
+  /* Tile based spatial caches */
   bool airportCacheAddonFlag = false; // Keep addon status flag for comparing
   bool airportCacheNormalFlag = false; // Keep normal (non add-on) status flag for comparing
-  query::SimpleRectCache<map::MapAirport> airportCache;
+  query::TileRectCache<map::MapAirport> airportCache;
+  query::TileRectCache<map::MapVor> vorCache;
+  query::TileRectCache<map::MapNdb> ndbCache;
+  query::TileRectCache<map::MapMarker> markerCache;
+  query::TileRectCache<map::MapHolding> holdingCache;
+  query::TileRectCache<map::MapIls> ilsCache;
+  query::TileRectCache<map::MapAirportMsa> airportMsaCache;
+
+  /* Not cached since user points can change. Used as list only. */
   query::SimpleRectCache<map::MapUserpoint> userpointCache;
-  query::SimpleRectCache<map::MapVor> vorCache;
-  query::SimpleRectCache<map::MapNdb> ndbCache;
-  query::SimpleRectCache<map::MapMarker> markerCache;
-  query::SimpleRectCache<map::MapHolding> holdingCache;
-  query::SimpleRectCache<map::MapIls> ilsCache;
-  query::SimpleRectCache<map::MapAirportMsa> airportMsaCache;
 
   bool gls = false;
 
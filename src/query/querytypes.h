@@ -22,8 +22,13 @@
 #include "sql/sqlquery.h"
 #include "common/maptypes.h"
 
+#include <QCache>
+#include <QDebug>
 #include <QList>
+#include <QSet>
+#include <QVector>
 
+#include <cmath>
 #include <functional>
 
 #include <marble/GeoDataCoordinates.h>
@@ -91,6 +96,84 @@ struct SimpleRectCache
 
 };
 
+/* Tile sizes are powers of two in degree from 1/16 to 64 degree */
+const int TILE_CACHE_LEVEL_MIN = -4;
+const int TILE_CACHE_LEVEL_MAX = 6;
+
+/* Tile size is selected to have about this number of tiles in the larger dimension of the requested rectangle */
+const double TILE_CACHE_TILES_PER_RECT = 2.;
+
+/*
+ * Spatial cache that keeps objects in fixed latitude/longitude tiles with least recently used eviction.
+ * Tile size is selected by the size of the requested rectangle. Only tiles which are not in the cache are
+ * loaded by the fetch function which allows to keep data when panning or returning to a previous area.
+ *
+ * Objects are queried by position. Duplicates at tile boundaries are removed by the field TYPE::id.
+ */
+template<typename TYPE>
+struct TileRectCache
+{
+  typedef std::function<bool (const MapLayer *curLayer, const MapLayer *mapLayer)> LayerCompareFunc;
+
+  /* Called to load all objects inside the tile rectangle into the list. Rectangle does not cross the anti-meridian. */
+  typedef std::function<void (const Marble::GeoDataLatLonBox& tileRect, QList<TYPE>& objects)> FetchFunc;
+
+  /* Cache limit is the total number of objects in all tiles */
+  explicit TileRectCache(int maxObjects = 50000)
+  {
+    tiles.setMaxCost(maxObjects);
+  }
+
+  /*
+   * Fills list with all objects from the tiles covering rect. Missing tiles are loaded with funcFetch.
+   * @param factor and increment inflate rect before selecting tiles to include objects outside which
+   * are drawn into the rectangle like labels, symbols or MSA circles
+   * @param lazy if true do not fetch new data but return the old potentially incomplete dataset
+   * @param queryMaxRows row limit of the query and the merged list. Tiles reaching the limit are incomplete and
+   * not cached. Loading stops once the merged list is full.
+   * @return true if any tiles were loaded
+   */
+  bool updateCache(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, double factor, double increment,
+                   bool lazy, LayerCompareFunc funcSameLayer, FetchFunc funcFetch, int queryMaxRows);
+  void clear();
+
+  /* Returns true in case of overflow */
+  bool validate(int queryMaxRows) const
+  {
+    return incomplete || list.size() >= queryMaxRows;
+  }
+
+  void setMaxObjects(int maxObjects)
+  {
+    tiles.setMaxCost(maxObjects);
+  }
+
+  /* Print hit and miss counters */
+  void logStatistics(const QString& name) const
+  {
+    qDebug() << Q_FUNC_INFO << name << "tiles" << tiles.size() << "objects" << tiles.totalCost()
+             << "hits" << hits << "misses" << misses;
+  }
+
+  /* Objects from all tiles covering the last requested rectangle */
+  QList<TYPE> list;
+
+  /* Number of tiles taken from cache and loaded from database */
+  qint64 hits = 0L, misses = 0L;
+
+private:
+  /* Get all keys for tiles overlapping the rectangle */
+  static QVector<quint64> tileKeys(const Marble::GeoDataLatLonBox& rect);
+  static Marble::GeoDataLatLonBox tileRect(quint64 key);
+
+  QCache<quint64, QList<TYPE> > tiles;
+  const MapLayer *curMapLayer = nullptr;
+  QVector<quint64> curTileKeys;
+
+  /* Last list contains tiles which hit the row limit */
+  bool incomplete = false;
+};
+
 // ---------------------------------------------------------------------------------
 
 template<typename TYPE>
@@ -146,6 +229,160 @@ void SimpleRectCache<TYPE>::clear()
   curMapLayer = nullptr;
 }
 
+template<typename TYPE>
+bool TileRectCache<TYPE>::updateCache(const Marble::GeoDataLatLonBox& rect, const MapLayer *mapLayer, double factor,
+                                      double increment, bool lazy, LayerCompareFunc funcSameLayer, FetchFunc funcFetch,
+                                      int queryMaxRows)
+{
+  if(lazy)
+    // Nothing changed
+    return false;
+
+#ifndef DEBUG_DISABLE_RECT_CACHE
+  if(curMapLayer != nullptr && !funcSameLayer(curMapLayer, mapLayer))
+#else
+  Q_UNUSED(funcSameLayer)
+#endif
+    // New layer needs other query parameters - all tiles are invalid
+    clear();
+  curMapLayer = mapLayer;
+
+  // Add margin for objects outside of the rectangle which are still visible
+  Marble::GeoDataLatLonBox inflatedRect(rect);
+  query::inflateQueryRect(inflatedRect, factor, increment);
+
+  const QVector<quint64> keys = tileKeys(inflatedRect);
+  if(keys == curTileKeys)
+    // Same tiles as last call - list is still valid. Keep it also if incomplete since a new query
+    // would run into the same row limit again
+    return false;
+
+  list.clear();
+  incomplete = false;
+  bool fetched = false;
+
+  // Objects on tile boundaries can appear twice
+  QSet<int> ids;
+  for(quint64 key : keys)
+  {
+    if(list.size() >= queryMaxRows)
+    {
+      // Stop loading further tiles once the merged list reaches the limit
+      incomplete = true;
+      break;
+    }
+
+    QList<TYPE> *objects = tiles.object(key);
+    bool loaded = objects == nullptr;
+    if(loaded)
+    {
+      misses++;
+      fetched = true;
+      objects = new QList<TYPE>;
+      funcFetch(tileRect(key), *objects);
+    }
+    else
+      hits++;
+
+    for(const TYPE& obj : qAsConst(*objects))
+    {
+      if(list.size() >= queryMaxRows)
+        break;
+
+      if(!ids.contains(obj.id))
+      {
+        ids.insert(obj.id);
+        list.append(obj);
+      }
+    }
+
+    if(loaded)
+    {
+      if(objects->size() < queryMaxRows)
+        // Takes ownership and might delete the list immediately if too large
+        tiles.insert(key, objects, std::max(objects->size(), 1));
+      else
+      {
+        // Row limit reached - do not keep incomplete tile
+        incomplete = true;
+        delete objects;
+      }
+    }
+  }
+
+  curTileKeys = keys;
+  return fetched;
+}
+
+template<typename TYPE>
+void TileRectCache<TYPE>::clear()
+{
+  list.clear();
+  tiles.clear();
+  curTileKeys.clear();
+  curMapLayer = nullptr;
+  incomplete = false;
+}
+
+template<typename TYPE>
+QVector<quint64> TileRectCache<TYPE>::tileKeys(const Marble::GeoDataLatLonBox& rect)
+{
+  double west = rect.west(Marble::GeoDataCoordinates::Degree), east = rect.east(Marble::GeoDataCoordinates::Degree),
+         north = rect.north(Marble::GeoDataCoordinates::Degree), south = rect.south(Marble::GeoDataCoordinates::Degree);
+  double maxSize = std::max(rect.width(Marble::GeoDataCoordinates::Degree), north - south);
+
+  int level = static_cast<int>(std::ceil(std::log2(std::max(maxSize, 1.e-6) / TILE_CACHE_TILES_PER_RECT)));
+  level = std::min(std::max(level, TILE_CACHE_LEVEL_MIN), TILE_CACHE_LEVEL_MAX);
+  double size = std::ldexp(1., level);
+
+  int numX = static_cast<int>(std::ceil(360. / size)), numY = static_cast<int>(std::ceil(180. / size));
+  auto clampX = [numX](double value) -> int {
+                  return std::min(std::max(static_cast<int>(std::floor(value)), 0), numX - 1);
+                };
+  auto clampY = [numY](double value) -> int {
+                  return std::min(std::max(static_cast<int>(std::floor(value)), 0), numY - 1);
+                };
+
+  int x1 = clampX((west + 180.) / size), x2 = clampX((east + 180.) / size);
+  int y1 = clampY((south + 90.) / size), y2 = clampY((north + 90.) / size);
+
+  // Column indexes - wrap around at the anti-meridian
+  QVector<int> columns;
+  if(rect.crossesDateLine())
+  {
+    for(int x = x1; x < numX; x++)
+      columns.append(x);
+    for(int x = 0; x <= x2; x++)
+      columns.append(x);
+  }
+  else
+  {
+    for(int x = x1; x <= x2; x++)
+      columns.append(x);
+  }
+
+  QVector<quint64> keys;
+  quint64 levelKey = static_cast<quint64>(level - TILE_CACHE_LEVEL_MIN) << 48;
+  for(int x : qAsConst(columns))
+  {
+    for(int y = y1; y <= y2; y++)
+      keys.append(levelKey | (static_cast<quint64>(x) << 24) | static_cast<quint64>(y));
+  }
+  return keys;
+}
+
+template<typename TYPE>
+Marble::GeoDataLatLonBox TileRectCache<TYPE>::tileRect(quint64 key)
+{
+  int level = static_cast<int>(key >> 48) + TILE_CACHE_LEVEL_MIN;
+  int x = static_cast<int>((key >> 24) & 0xffffff), y = static_cast<int>(key & 0xffffff);
+  double size = std::ldexp(1., level);
+
+  double west = -180. + x * size, south = -90. + y * size;
+  return Marble::GeoDataLatLonBox(std::min(south + size, 90.), south, std::min(west + size, 180.), west,
+                                  Marble::GeoDataCoordinates::Degree);
+}
+
 /* Get a record from the cache or get it from a database query */
 template<typename ID>
 const atools::sql::SqlRecord *cachedRecord(QCache<ID, atools::sql::SqlRecord>& cache, atools::sql::SqlQuery *query,
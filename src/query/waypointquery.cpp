@@ -157,25 +157,22 @@ const QList<map::MapWaypoint> *WaypointQuery::getWaypoints(const GeoDataLatLonBo
                             [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersWaypoint(newLayer);
-  });
-
-  if(waypointCache.list.isEmpty() && !lazy)
+  },
+                            [this](const GeoDataLatLonBox& tileRect, QList<map::MapWaypoint>& waypoints) -> void
   {
-    for(const GeoDataLatLonBox& r : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+    query::bindRect(tileRect, waypointsByRectQuery);
+    waypointsByRectQuery->exec();
+    while(waypointsByRectQuery->next())
     {
-      query::bindRect(r, waypointsByRectQuery);
-      waypointsByRectQuery->exec();
-      while(waypointsByRectQuery->next())
-      {
-        map::MapWaypoint wp;
-        mapTypesFactory->fillWaypoint(waypointsByRectQuery->record(), wp, trackDatabase);
-
-        // Avoid artificial waypoints created only for procedure or airway resolution
-        if(wp.artificial == map::WAYPOINT_ARTIFICIAL_NONE)
-          waypointCache.list.append(wp);
-      }
+      map::MapWaypoint wp;
+      mapTypesFactory->fillWaypoint(waypointsByRectQuery->record(), wp, trackDatabase);
+
+      // Avoid artificial waypoints created only for procedure or airway resolution
+      if(wp.artificial == map::WAYPOINT_ARTIFICIAL_NONE)
+        waypoints.append(wp);
     }
-  }
+  }, queryMaxRowsWaypoints);
+
   overflow = waypointCache.validate(queryMaxRowsWaypoints);
   return &waypointCache.list;
 }
@@ -190,24 +187,21 @@ const QList<MapWaypoint> *WaypointQuery::getWaypointsAirway(const Marble::GeoDat
                                   [](const MapLayer *curLayer, const MapLayer *newLayer) -> bool
   {
     return curLayer->hasSameQueryParametersWaypoint(newLayer) && curLayer->hasSameQueryParametersAirwayTrack(newLayer);
-  });
-
-  if(waypointAirwayCache.list.isEmpty() && !lazy)
+  },
+                                  [this](const GeoDataLatLonBox& tileRect, QList<map::MapWaypoint>& waypoints) -> void
   {
-    for(const GeoDataLatLonBox& r : query::splitAtAntiMeridian(rect, queryRectInflationFactor, queryRectInflationIncrement))
+    query::bindRect(tileRect, waypointsAirwayByRectQuery);
+    waypointsAirwayByRectQuery->exec();
+    while(waypointsAirwayByRectQuery->next())
     {
-      query::bindRect(r, waypointsAirwayByRectQuery);
-      waypointsAirwayByRectQuery->exec();
-      while(waypointsAirwayByRectQuery->next())
-      {
-        map::MapWaypoint wp;
-        mapTypesFactory->fillWaypoint(waypointsAirwayByRectQuery->record(), wp, trackDatabase);
-
-        // Also insert artificial waypoints
-        waypointAirwayCache.list.append(wp);
-      }
+      map::MapWaypoint wp;
+      mapTypesFactory->fillWaypoint(waypointsAirwayByRectQuery->record(), wp, trackDatabase);
+
+      // Also insert artificial waypoints
+      waypoints.append(wp);
     }
-  }
+  }, queryMaxRowsWaypoints);
+
   overflow = waypointAirwayCache.validate(queryMaxRowsWaypoints);
   return &waypointAirwayCache.list;
 }
@@ -328,6 +322,9 @@ ATOOLS_DELETE(waypointInfoQuery);
 
 void WaypointQuery::clearCache()
 {
+  waypointCache.logStatistics(trackDatabase ? "track waypoints" : "waypoints");
+  waypointAirwayCache.logStatistics(trackDatabase ? "track airway waypoints" : "airway waypoints");
+
   waypointCache.clear();
   waypointAirwayCache.clear();
   waypointInfoCache.clear();
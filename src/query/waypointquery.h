@@ -98,7 +98,7 @@ private:
   atools::sql::SqlDatabase *dbNav;
 
   /* Simple bounding rectangle caches */
-  query::SimpleRectCache<map::MapWaypoint> waypointCache, waypointAirwayCache;
+  query::TileRectCache<map::MapWaypoint> waypointCache, waypointAirwayCache;
   QCache<int, atools::sql::SqlRecord> waypointInfoCache;
 
   static int queryMaxRowsWaypoints;
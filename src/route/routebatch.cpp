@@ -0,0 +1,422 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "route/routebatch.h"
+
+#include "app/navapp.h"
+#include "atools.h"
+#include "fs/pln/flightplanio.h"
+#include "query/airportquery.h"
+#include "query/airwaytrackquery.h"
+#include "route/flightplanentrybuilder.h"
+#include "route/route.h"
+#include "route/routeflags.h"
+#include "routestring/routestringwriter.h"
+#include "routing/routenetwork.h"
+#include "sql/sqldatabase.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QSet>
+#include <QTextStream>
+#include <QThread>
+#include <QWaitCondition>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <atomic>
+
+using atools::fs::pln::Flightplan;
+using atools::fs::pln::FlightplanEntry;
+
+namespace routebatch {
+
+QVector<Entry> readEntries(const QString& filename)
+{
+  QVector<Entry> entries;
+  QFile file(filename);
+  if(file.open(QIODevice::ReadOnly | QIODevice::Text))
+  {
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    int lineNum = 0;
+    while(!stream.atEnd())
+    {
+      QString line = stream.readLine().trimmed();
+      lineNum++;
+
+      if(line.isEmpty() || line.startsWith('#'))
+        continue;
+
+      QStringList cols = line.split(',');
+      if(cols.size() < 4)
+      {
+        qWarning() << Q_FUNC_INFO << "Invalid line" << lineNum << line;
+        continue;
+      }
+
+      Entry entry;
+      entry.departureIdent = cols.at(0).trimmed().toUpper();
+      entry.destinationIdent = cols.at(1).trimmed().toUpper();
+      entry.altitudeFt = cols.at(2).trimmed().toFloat();
+      entry.mode = cols.at(3).trimmed();
+      entries.append(entry);
+    }
+    file.close();
+  }
+  else
+    qWarning() << Q_FUNC_INFO << "Cannot open" << filename << file.errorString();
+
+  return entries;
+}
+
+bool modeFromString(const QString& modeStr, atools::routing::Modes& mode, bool& airwayNetwork)
+{
+  QString str = modeStr.toLower();
+  airwayNetwork = true;
+
+  if(str == "airway")
+    mode = atools::routing::MODE_AIRWAY_WAYPOINT;
+  else if(str == "airwaytrack")
+    mode = atools::routing::MODE_AIRWAY_WAYPOINT | atools::routing::MODE_TRACK;
+  else if(str == "jet")
+    mode = atools::routing::MODE_JET_WAYPOINT;
+  else if(str == "victor")
+    mode = atools::routing::MODE_VICTOR_WAYPOINT;
+  else
+  {
+    airwayNetwork = false;
+    if(str == "radionav")
+      mode = atools::routing::MODE_RADIONAV_VOR;
+    else if(str == "radionavndb")
+      mode = atools::routing::MODE_RADIONAV_VOR | atools::routing::MODE_RADIONAV_NDB;
+    else
+      return false;
+  }
+  return true;
+}
+
+} // namespace routebatch
+
+/* Makes database connection names unique for concurrent batches */
+static std::atomic_int batchCounter(0);
+
+/* Batches in calculateRoutes() and database generation increased by cancelAll(). Guarded by batchMutex. */
+static QMutex batchMutex;
+static QWaitCondition batchFinishedCondition;
+static QSet<RouteBatch *> runningBatches;
+static int batchDatabaseGeneration = 0;
+
+RouteBatch::RouteBatch()
+{
+  numWorkers = QThread::idealThreadCount();
+  batchId = batchCounter.fetch_add(1);
+  canceled.store(false);
+}
+
+void RouteBatch::cancelAll()
+{
+  QMutexLocker locker(&batchMutex);
+
+  // Prepared batches which did not start yet are canceled when calling calculateRoutes()
+  batchDatabaseGeneration++;
+
+  if(!runningBatches.isEmpty())
+  {
+    qDebug() << Q_FUNC_INFO << "Canceling" << runningBatches.size() << "batches";
+    for(RouteBatch *batch : qAsConst(runningBatches))
+      batch->canceled.store(true);
+
+    while(!runningBatches.isEmpty())
+      batchFinishedCondition.wait(&batchMutex);
+  }
+}
+
+void RouteBatch::prepare(const QVector<routebatch::Entry>& entries)
+{
+  qDebug() << Q_FUNC_INFO << "entries" << entries.size() << "workers" << numWorkers;
+
+  timer.start();
+  canceled.store(false);
+  statistics = routebatch::Statistics();
+  statistics.numRoutes = entries.size();
+
+  batchResults = QVector<routebatch::Result>(entries.size());
+  departures = QVector<map::MapAirport>(entries.size());
+  destinations = QVector<map::MapAirport>(entries.size());
+  requests.clear();
+  workerResults.clear();
+
+  // Resolve airports and modes in GUI thread =====================================
+  AirportQuery *airportQuery = NavApp::getAirportQuerySim();
+  for(int i = 0; i < entries.size(); i++)
+  {
+    const routebatch::Entry& entry = entries.at(i);
+    routebatch::Result& result = batchResults[i];
+    result.entry = entry;
+
+    routecalc::Request request;
+    if(!routebatch::modeFromString(entry.mode, request.mode, request.airwayNetwork))
+    {
+      result.error = tr("Invalid mode \"%1\"").arg(entry.mode);
+      continue;
+    }
+
+    airportQuery->getAirportByIdent(departures[i], entry.departureIdent);
+    airportQuery->getAirportByIdent(destinations[i], entry.destinationIdent);
+
+    if(!departures.at(i).isValid())
+      result.error = tr("Departure airport \"%1\" not found").arg(entry.departureIdent);
+    else if(!destinations.at(i).isValid())
+      result.error = tr("Destination airport \"%1\" not found").arg(entry.destinationIdent);
+    else
+    {
+      request.id = i;
+      request.departurePos = departures.at(i).position;
+      request.destinationPos = destinations.at(i).position;
+      request.altitudeFt = entry.altitudeFt;
+      request.fetchAirways = request.airwayNetwork;
+      requests.append(request);
+    }
+  }
+
+  // Database files are fetched here in the GUI thread since the connections must not be used in the workers
+  navDbFile = NavApp::getDatabaseNav()->databaseName();
+  trackDbFile = NavApp::getDatabaseTrack() != nullptr ? NavApp::getDatabaseTrack()->databaseName() : QString();
+
+  QMutexLocker locker(&batchMutex);
+  databaseGeneration = batchDatabaseGeneration;
+}
+
+void RouteBatch::calculateRoutes()
+{
+  workerResults.clear();
+
+  {
+    QMutexLocker locker(&batchMutex);
+    if(databaseGeneration != batchDatabaseGeneration)
+    {
+      // Database was switched after prepare()
+      qDebug() << Q_FUNC_INFO << "Database changed - not starting";
+      canceled.store(true);
+      return;
+    }
+    runningBatches.insert(this);
+  }
+
+  // Distribute requests round robin to workers ===============================
+  int workers = std::max(1, std::min(numWorkers, requests.size()));
+  statistics.numWorkers = workers;
+
+  QVector<QVector<routecalc::Request> > workerRequests(workers);
+  for(int i = 0; i < requests.size(); i++)
+    workerRequests[i % workers].append(requests.at(i));
+
+  QVector<QFuture<QVector<routecalc::Result> > > futures;
+  for(int i = 0; i < workers; i++)
+  {
+    if(!workerRequests.at(i).isEmpty())
+      futures.append(QtConcurrent::run(&RouteBatch::calculateWorker, workerRequests.at(i),
+                                       QString("_BATCH%1_%2").arg(batchId).arg(i), navDbFile, trackDbFile, &canceled));
+  }
+
+  // Wait for all workers ===============================
+  for(QFuture<QVector<routecalc::Result> >& future : futures)
+  {
+    future.waitForFinished();
+    workerResults.append(future.result());
+  }
+
+  // Wake up cancelAll() if waiting
+  QMutexLocker locker(&batchMutex);
+  runningBatches.remove(this);
+  batchFinishedCondition.wakeAll();
+}
+
+QVector<routebatch::Result> RouteBatch::finish()
+{
+  if(canceled.load())
+  {
+    // Database was switched - results are not valid for the new database
+    for(const routecalc::Request& request : qAsConst(requests))
+      batchResults[request.id].error = tr("Calculation canceled");
+    workerResults.clear();
+    statistics.totalTimeMs = timer.elapsed();
+    return batchResults;
+  }
+
+  // Build flight plans in GUI thread ===============================
+  for(int workerIndex = 0; workerIndex < workerResults.size(); workerIndex++)
+  {
+    for(const routecalc::Result& calcResult : workerResults.at(workerIndex))
+    {
+      int id = calcResult.request.id;
+      routebatch::Result& result = batchResults[id];
+      result.workerIndex = workerIndex;
+      result.loadTimeMs = calcResult.loadTimeMs;
+      result.calcTimeMs = calcResult.calcTimeMs;
+
+      statistics.sumCalcTimeMs += calcResult.calcTimeMs;
+      statistics.maxCalcTimeMs = std::max(statistics.maxCalcTimeMs, calcResult.calcTimeMs);
+
+      if(calcResult.found)
+      {
+        buildFlightplan(result, calcResult, departures.at(id), destinations.at(id));
+        statistics.numFound++;
+      }
+      else
+        result.error = tr("No route found");
+    }
+  }
+
+  statistics.totalTimeMs = timer.elapsed();
+
+  qDebug() << Q_FUNC_INFO << "routes" << statistics.numRoutes << "found" << statistics.numFound
+           << "workers" << statistics.numWorkers << "total" << statistics.totalTimeMs << "ms"
+           << "sum calculation" << statistics.sumCalcTimeMs << "ms" << "max calculation" << statistics.maxCalcTimeMs << "ms";
+
+  workerResults.clear();
+  return batchResults;
+}
+
+QVector<routecalc::Result> RouteBatch::calculateWorker(QVector<routecalc::Request> requests, QString suffix,
+                                                       QString navDbFile, QString trackDbFile,
+                                                       const std::atomic_bool *cancelFlag)
+{
+  // Finder adds departure and destination nodes to the network - use own copies in this thread
+  atools::routing::RouteNetwork networkAirway(atools::routing::SOURCE_AIRWAY), networkRadio(atools::routing::SOURCE_RADIO);
+
+  QVector<routecalc::Result> results;
+  for(const routecalc::Request& request : requests)
+  {
+    if(cancelFlag->load())
+      break;
+
+    results.append(RouteCalcWorker::calculate(request.airwayNetwork ? &networkAirway : &networkRadio, request,
+                                              navDbFile, trackDbFile, suffix, cancelFlag,
+                                              nullptr /* progressCallback */));
+  }
+  return results;
+}
+
+void RouteBatch::buildFlightplan(routebatch::Result& result, const routecalc::Result& calcResult,
+                                 const map::MapAirport& departure, const map::MapAirport& destination) const
+{
+  FlightplanEntryBuilder entryBuilder;
+  Route route;
+  Flightplan& flightplan = route.getFlightplan();
+
+  FlightplanEntry departureEntry, destinationEntry;
+  entryBuilder.buildFlightplanEntry(departure, departureEntry, false /* alternate */);
+  entryBuilder.buildFlightplanEntry(destination, destinationEntry, false /* alternate */);
+
+  // Create flight plan entries from calculated waypoints ====================
+  flightplan.append(departureEntry);
+  for(const RouteEntry& routeEntry : calcResult.entries)
+  {
+    FlightplanEntry flightplanEntry;
+    entryBuilder.buildFlightplanEntry(routeEntry.ref.id, atools::geo::EMPTY_POS, routeEntry.ref.objType,
+                                      flightplanEntry, calcResult.request.fetchAirways);
+
+    if(calcResult.request.fetchAirways && routeEntry.airwayId != -1)
+    {
+      // Get airway by id - needed to fetch the name first
+      map::MapAirway airway;
+      NavApp::getAirwayTrackQueryGui()->getAirwayById(airway, routeEntry.airwayId);
+      flightplanEntry.setAirway(airway.name);
+      flightplanEntry.setFlag(atools::fs::pln::entry::TRACK, airway.isTrack());
+    }
+    flightplan.append(flightplanEntry);
+  }
+  flightplan.append(destinationEntry);
+  flightplan.setCruiseAltitudeFt(calcResult.request.altitudeFt);
+  flightplan.setFlightplanType(atools::fs::pln::IFR);
+
+  // Copy flight plan to route object and update all structures
+  route.createRouteLegsFromFlightplan();
+  route.updateAll();
+  route.updateAirwaysAndAltitude(false /* adjustRouteAltitude */);
+
+  result.found = true;
+  result.distanceNm = route.getTotalDistance();
+  result.routeString = RouteStringWriter().createStringForRoute(route, 0.f, rs::DEFAULT_OPTIONS);
+  Flightplan saveFlightplan = route.updatedAltitudes().adjustedToOptions(rf::DEFAULT_OPTS_LNMPLN).getFlightplanConst();
+  result.lnmpln = atools::fs::pln::FlightplanIO().saveLnmStr(saveFlightplan);
+}
+
+bool RouteBatch::writeResults(const QString& directory, const QVector<routebatch::Result>& results) const
+{
+  QDir dir(directory);
+  if(!dir.exists() && !dir.mkpath(directory))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot create" << directory;
+    return false;
+  }
+
+  QFile csvFile(dir.absoluteFilePath("routes.csv"));
+  if(!csvFile.open(QIODevice::WriteOnly | QIODevice::Text))
+  {
+    qWarning() << Q_FUNC_INFO << "Cannot open" << csvFile.fileName() << csvFile.errorString();
+    return false;
+  }
+
+  QTextStream csv(&csvFile);
+  csv.setCodec("UTF-8");
+  csv << "departure,destination,altitude,mode,found,distance_nm,load_ms,calc_ms,worker,file,route,error" << endl;
+
+  bool ok = true;
+  for(int index = 0; index < results.size(); index++)
+  {
+    const routebatch::Result& result = results.at(index);
+    QString filename;
+    if(result.found)
+    {
+      // One LNMPLN file per city pair - number avoids overwriting if a pair is given more than once
+      filename = QString("%1_%2_%3_%4.lnmpln").arg(index + 1, 4, 10, QChar('0')).arg(result.entry.departureIdent).
+                 arg(result.entry.destinationIdent).arg(result.entry.mode.toLower());
+      QFile file(dir.absoluteFilePath(filename));
+      if(file.open(QIODevice::WriteOnly))
+      {
+        file.write(result.lnmpln.toUtf8());
+        file.close();
+      }
+      else
+      {
+        qWarning() << Q_FUNC_INFO << "Cannot open" << file.fileName() << file.errorString();
+        ok = false;
+      }
+    }
+
+    csv << result.entry.departureIdent << ","
+        << result.entry.destinationIdent << ","
+        << result.entry.altitudeFt << ","
+        << result.entry.mode << ","
+        << (result.found ? "1" : "0") << ","
+        << QString::number(result.distanceNm, 'f', 1) << ","
+        << result.loadTimeMs << ","
+        << result.calcTimeMs << ","
+        << result.workerIndex << ","
+        << filename << ","
+        << "\"" << result.routeString << "\","
+        << "\"" << result.error << "\"" << endl;
+  }
+
+  csvFile.close();
+  return ok;
+}
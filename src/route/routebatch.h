@@ -0,0 +1,161 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_ROUTEBATCH_H
+#define LNM_ROUTEBATCH_H
+
+#include "route/routecalcworker.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+#include <atomic>
+
+namespace routebatch {
+
+/* One city pair to calculate */
+struct Entry
+{
+  QString departureIdent, destinationIdent;
+  float altitudeFt = 0.f;
+
+  /* One of "airway", "jet", "victor", "airwaytrack", "radionav" or "radionavndb". Case insensitive. */
+  QString mode;
+};
+
+/* Result for one city pair */
+struct Result
+{
+  Entry entry;
+  bool found = false;
+
+  /* Error message if airports were not found or mode is invalid */
+  QString error;
+
+  /* ATS route description and flight plan as LNMPLN XML. Empty if nothing found. */
+  QString routeString, lnmpln;
+  float distanceNm = 0.f;
+
+  /* Time needed to load network in worker if not already loaded and calculation time in milliseconds */
+  qint64 loadTimeMs = 0L, calcTimeMs = 0L;
+
+  /* Index of worker thread which calculated this route */
+  int workerIndex = -1;
+};
+
+/* Summary for all city pairs */
+struct Statistics
+{
+  int numRoutes = 0, numFound = 0, numWorkers = 0;
+  qint64 totalTimeMs = 0L, sumCalcTimeMs = 0L, maxCalcTimeMs = 0L;
+};
+
+/* Read entries from CSV file. Each line contains departure, destination, altitude in feet and mode.
+ * Empty lines and lines starting with "#" are ignored. Example: "EDDF,LIRF,35000,airway" */
+QVector<Entry> readEntries(const QString& filename);
+
+/* Convert mode string to route finder modes. Returns false if mode is invalid. */
+bool modeFromString(const QString& modeStr, atools::routing::Modes& mode, bool& airwayNetwork);
+
+}
+
+/*
+ * Calculates flight plans for a list of departure/destination pairs in parallel using all cores.
+ *
+ * Each worker thread owns its own copy of the route networks since the route finder modifies
+ * the network by adding departure and destination nodes. Networks are loaded once per worker
+ * and reused for all city pairs assigned to it.
+ *
+ * Airport resolution and flight plan creation are done in the calling thread which has to be the GUI thread
+ * since the GUI queries are used.
+ *
+ * cancelAll() stops all running calculations before the database is switched. finish() then reports all
+ * routes as canceled.
+ */
+class RouteBatch
+{
+  Q_DECLARE_TR_FUNCTIONS(RouteBatch)
+
+public:
+  RouteBatch();
+
+  /* Number of worker threads. Default is QThread::idealThreadCount(). */
+  void setNumWorkers(int value)
+  {
+    numWorkers = value;
+  }
+
+  /* Resolve airports and modes. GUI thread only. */
+  void prepare(const QVector<routebatch::Entry>& entries);
+
+  /* Calculate routes for prepared entries using all workers. Blocks until all workers are finished.
+   * Can be called from any thread since it uses own database connections. */
+  void calculateRoutes();
+
+  /* Build flight plans from calculated routes and return results. GUI thread only. */
+  QVector<routebatch::Result> finish();
+
+  /* true if calculation was stopped by cancelAll() */
+  bool isCanceled() const
+  {
+    return canceled.load();
+  }
+
+  /* Cancel all batches which are calculating or prepared and wait until the workers are finished.
+   * Call before closing or switching databases. GUI thread only. */
+  static void cancelAll();
+
+  /* Statistics for last call of finish() */
+  const routebatch::Statistics& getStatistics() const
+  {
+    return statistics;
+  }
+
+  /* Write one LNMPLN file per found route and a CSV summary file "routes.csv" into the given directory.
+   * Returns false if writing failed. */
+  bool writeResults(const QString& directory, const QVector<routebatch::Result>& results) const;
+
+private:
+  /* Runs in worker thread and calculates all requests using own networks and database connections.
+   * suffix makes connection names unique. */
+  static QVector<routecalc::Result> calculateWorker(QVector<routecalc::Request> requests, QString suffix,
+                                                   QString navDbFile, QString trackDbFile,
+                                                   const std::atomic_bool *cancelFlag);
+
+  /* Build flight plan from calculated result and fill route string and LNMPLN. GUI thread only. */
+  void buildFlightplan(routebatch::Result& result, const routecalc::Result& calcResult,
+                       const map::MapAirport& departure, const map::MapAirport& destination) const;
+
+  int numWorkers, batchId;
+  routebatch::Statistics statistics;
+
+  /* Set by cancelAll() */
+  std::atomic_bool canceled;
+
+  /* Database generation at prepare() time. Calculation is canceled if cancelAll() was called in the meantime. */
+  int databaseGeneration = 0;
+
+  /* State passed between prepare(), calculateRoutes() and finish() */
+  QVector<routebatch::Result> batchResults;
+  QVector<map::MapAirport> departures, destinations;
+  QVector<routecalc::Request> requests;
+  QVector<QVector<routecalc::Result> > workerResults;
+  QString navDbFile, trackDbFile;
+  QElapsedTimer timer;
+};
+
+#endif // LNM_ROUTEBATCH_H
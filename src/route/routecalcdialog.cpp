@@ -105,12 +105,8 @@ void RouteCalcDialog::buttonBoxClicked(QAbstractButton *button)
 {
   if(button == ui->buttonBox->button(QDialogButtonBox::Apply))
   {
-    calculating = true;
-    updateWidgets();
-    QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+    // Calculation runs in background - controller calls setCalculating()
     emit calculateClicked();
-    calculating = false;
-    updateWidgets();
   }
   else if(button == ui->buttonBox->button(QDialogButtonBox::Help))
     atools::gui::HelpHandler::openHelpUrlWeb(NavApp::getQMainWidget(), lnm::helpOnlineUrl + "ROUTECALC.html", lnm::helpLanguageOnline());
@@ -161,6 +157,12 @@ void RouteCalcDialog::setCruisingAltitudeFt(float altitude)
   ui->spinBoxRouteCalcCruiseAltitude->setValue(atools::roundToInt(Unit::altFeetF(altitude)));
 }
 
+void RouteCalcDialog::setCalculating(bool value)
+{
+  calculating = value;
+  updateWidgets();
+}
+
 void RouteCalcDialog::updateWidgets()
 {
   bool airway = ui->radioButtonRouteCalcAirway->isChecked();
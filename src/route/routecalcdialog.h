@@ -81,6 +81,9 @@ public:
   /* Update messages if route has changed. */
   void updateWidgets();
 
+  /* Disables buttons while a calculation is running in background */
+  void setCalculating(bool value);
+
   /* Load and save widget status */
   void restoreState();
   void saveState();
@@ -166,7 +169,7 @@ private:
   /* Remember dialog position when reopening */
   QPoint position;
 
-  /* Set to true before emitting calculateClicked() to avoid user clicking button twice. */
+  /* Set to true by controller while calculation is running to avoid user clicking button twice. */
   bool calculating = false;
 };
 
@@ -0,0 +1,384 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "route/routecalcworker.h"
+
+#include "app/navapp.h"
+#include "atools.h"
+#include "db/dbtools.h"
+#include "exception.h"
+#include "fs/db/databasemeta.h"
+#include "routing/routefinder.h"
+#include "routing/routenetwork.h"
+#include "routing/routenetworkloader.h"
+#include "sql/sqldatabase.h"
+#include "track/trackmanager.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentRun>
+
+using atools::routing::RouteNetwork;
+using atools::sql::SqlDatabase;
+
+RouteCalcWorker::RouteCalcWorker(QObject *parent)
+  : QObject(parent)
+{
+  cancelFlag.store(false);
+
+  networkRadio = new RouteNetwork(atools::routing::SOURCE_RADIO);
+  networkAirway = new RouteNetwork(atools::routing::SOURCE_AIRWAY);
+
+  // Notification from thread that it has finished and we can get the result from the future
+  connect(&watcher, &QFutureWatcher<routecalc::Result>::finished, this, &RouteCalcWorker::threadFinished);
+}
+
+RouteCalcWorker::~RouteCalcWorker()
+{
+  cancelAndWait();
+  ATOOLS_DELETE_LOG(networkRadio);
+  ATOOLS_DELETE_LOG(networkAirway);
+}
+
+bool RouteCalcWorker::start(const routecalc::Request& request)
+{
+  if(isCalculating())
+  {
+    qWarning() << Q_FUNC_INFO << "Calculation already running";
+    return false;
+  }
+
+  cancelFlag.store(false);
+  suppressFinished = false;
+  result = routecalc::Result();
+
+  if(isRunning())
+  {
+    // Networks are loading - start calculation once done
+    qDebug() << Q_FUNC_INFO << "Waiting for network preload";
+    pendingRequest = request;
+    hasPendingRequest = true;
+  }
+  else
+    startThread(request);
+  return true;
+}
+
+void RouteCalcWorker::preload()
+{
+  if(isRunning())
+    return;
+
+  // Drop outdated networks and skip thread if both are still valid
+  updateNetworkKeys();
+  if(networkAirway->isLoaded() && networkRadio->isLoaded())
+  {
+    qDebug() << Q_FUNC_INFO << "Networks up to date";
+    return;
+  }
+
+  qDebug() << Q_FUNC_INFO << "Preloading networks";
+  routecalc::Request request;
+  request.loadOnly = true;
+  cancelFlag.store(false);
+  suppressFinished = false;
+  startThread(request);
+}
+
+void RouteCalcWorker::startThread(const routecalc::Request& request)
+{
+  // Drop outdated networks
+  updateNetworkKeys();
+
+  // Database files are fetched here in the GUI thread since the connections must not be used in the worker
+  QString navDbFile = NavApp::getDatabaseNav()->databaseName();
+  QString trackDbFile = NavApp::getDatabaseTrack() != nullptr ? NavApp::getDatabaseTrack()->databaseName() : QString();
+
+  // Start thread
+  runningLoadOnly = request.loadOnly;
+  future = QtConcurrent::run(this, &RouteCalcWorker::calculateThread, request, navDbFile, trackDbFile);
+
+  // Watcher will call RouteCalcWorker::threadFinished() when finished
+  watcher.setFuture(future);
+}
+
+void RouteCalcWorker::updateNetworkKeys()
+{
+  // Database file, cycle and load time identify the navdata for the radio network
+  const atools::fs::db::DatabaseMeta *meta = NavApp::getDatabaseMetaNav();
+  QString navKey = NavApp::getDatabaseNav()->databaseName();
+  if(meta != nullptr)
+    navKey += "|" + meta->getAiracCycle() + "|" + meta->getLastLoadTime().toString(Qt::ISODate);
+
+  // Airway network additionally contains tracks
+  QString airwayKey = navKey;
+  if(NavApp::getTrackManager() != nullptr)
+    airwayKey += "|" + QString::number(NavApp::getTrackManager()->getTrackSetKey());
+
+  if(keyRadio != navKey)
+  {
+    qDebug() << Q_FUNC_INFO << "Radio network key changed" << keyRadio << navKey;
+    networkRadio->clear();
+    keyRadio = navKey;
+  }
+
+  if(keyAirway != airwayKey)
+  {
+    qDebug() << Q_FUNC_INFO << "Airway network key changed" << keyAirway << airwayKey;
+    networkAirway->clear();
+    keyAirway = airwayKey;
+  }
+}
+
+void RouteCalcWorker::cancel()
+{
+  cancelFlag.store(true);
+}
+
+void RouteCalcWorker::cancelAndWait()
+{
+  hasPendingRequest = false;
+  if(isRunning())
+  {
+    qDebug() << Q_FUNC_INFO;
+    suppressFinished = true;
+    cancelFlag.store(true);
+    future.waitForFinished();
+  }
+}
+
+bool RouteCalcWorker::isRunning() const
+{
+  // isStarted() is true for a default constructed future and stays true when done - do not use it here
+  return future.isRunning();
+}
+
+bool RouteCalcWorker::isCalculating() const
+{
+  return hasPendingRequest || (isRunning() && !runningLoadOnly);
+}
+
+void RouteCalcWorker::clearNetworks()
+{
+  cancelAndWait();
+  networkRadio->clear();
+  networkAirway->clear();
+  keyRadio.clear();
+  keyAirway.clear();
+}
+
+atools::routing::RouteNetwork *RouteCalcWorker::getNetworkAirway(atools::sql::SqlDatabase *dbNav, atools::sql::SqlDatabase *dbTrack)
+{
+  cancelAndWait();
+  updateNetworkKeys();
+  if(!networkAirway->isLoaded())
+    atools::routing::RouteNetworkLoader(dbNav, dbTrack).load(networkAirway);
+  return networkAirway;
+}
+
+atools::routing::RouteNetwork *RouteCalcWorker::getNetworkRadio(atools::sql::SqlDatabase *dbNav, atools::sql::SqlDatabase *dbTrack)
+{
+  cancelAndWait();
+  updateNetworkKeys();
+  if(!networkRadio->isLoaded())
+    atools::routing::RouteNetworkLoader(dbNav, dbTrack).load(networkRadio);
+  return networkRadio;
+}
+
+routecalc::Result RouteCalcWorker::calculateThread(routecalc::Request request, QString navDbFile, QString trackDbFile)
+{
+  if(request.loadOnly)
+  {
+    // Warm up cache ==================================
+    QThread::currentThread()->setPriority(QThread::LowestPriority);
+
+    routecalc::Result res;
+    res.request = request;
+    QElapsedTimer timer;
+    timer.start();
+
+    try
+    {
+      if(!networkAirway->isLoaded())
+        loadNetwork(networkAirway, navDbFile, trackDbFile, QString());
+      if(!networkRadio->isLoaded())
+        loadNetwork(networkRadio, navDbFile, trackDbFile, QString());
+    }
+    catch(atools::Exception& e)
+    {
+      qWarning() << Q_FUNC_INFO << "Caught exception" << e.what();
+    }
+    catch(...)
+    {
+      qWarning() << Q_FUNC_INFO << "Caught unknown exception";
+    }
+
+    res.loadTimeMs = timer.elapsed();
+    qDebug() << Q_FUNC_INFO << "Preloading networks took" << res.loadTimeMs << "ms";
+    return res;
+  }
+
+  QThread::currentThread()->setPriority(QThread::LowPriority);
+
+  QElapsedTimer progressTimer;
+  progressTimer.start();
+
+  // Called from finder in this thread - throttle signals which are queued to the GUI thread
+  auto progressCallback = [this, &progressTimer](int distToDest, int currentDistToDest) -> void
+                          {
+                            if(progressTimer.elapsed() > PROGRESS_INTERVAL_MS)
+                            {
+                              progressTimer.restart();
+                              emit progress(distToDest, distToDest - currentDistToDest);
+                            }
+                          };
+
+  return calculate(request.airwayNetwork ? networkAirway : networkRadio, request, navDbFile, trackDbFile,
+                   QString() /* connectionSuffix */, &cancelFlag, progressCallback);
+}
+
+routecalc::Result RouteCalcWorker::calculate(atools::routing::RouteNetwork *network, const routecalc::Request& request,
+                                             const QString& navDbFile, const QString& trackDbFile,
+                                             const QString& connectionSuffix, const std::atomic_bool *cancelFlag,
+                                             const std::function<void(int, int)>& progressCallback)
+{
+  routecalc::Result res;
+  res.request = request;
+
+  QElapsedTimer timer;
+  timer.start();
+
+  try
+  {
+    // Load network from database if not already done
+    if(!network->isLoaded())
+      loadNetwork(network, navDbFile, trackDbFile, connectionSuffix);
+    res.loadTimeMs = timer.restart();
+
+    atools::routing::RouteFinder routeFinder(network);
+    routeFinder.setCostFactorForceAirways(request.costFactorForceAirways);
+    routeFinder.setProgressCallback([cancelFlag, &progressCallback](int distToDest, int currentDistToDest) -> bool
+    {
+      if(progressCallback)
+        progressCallback(distToDest, currentDistToDest);
+
+      // Continue if not canceled
+      return cancelFlag == nullptr || !cancelFlag->load();
+    });
+
+    // Calculate the route - calls above lambda ================================================
+    res.found = routeFinder.calculateRoute(request.departurePos, request.destinationPos,
+                                           atools::roundToInt(request.altitudeFt), request.mode);
+    res.canceled = cancelFlag != nullptr && cancelFlag->load();
+
+    if(res.found && !res.canceled)
+    {
+      // A route was found - fetch waypoints
+      RouteExtractor extractor(&routeFinder);
+      extractor.extractRoute(res.entries, res.distanceMeter);
+      res.found = !res.entries.isEmpty();
+    }
+  }
+  catch(atools::Exception& e)
+  {
+    qWarning() << Q_FUNC_INFO << "Caught exception" << e.what();
+    res.found = false;
+  }
+  catch(...)
+  {
+    qWarning() << Q_FUNC_INFO << "Caught unknown exception";
+    res.found = false;
+  }
+
+  res.calcTimeMs = timer.elapsed();
+
+  qDebug() << Q_FUNC_INFO << "found" << res.found << "canceled" << res.canceled
+           << "entries" << res.entries.size() << "load" << res.loadTimeMs << "ms calculation" << res.calcTimeMs << "ms";
+  return res;
+}
+
+void RouteCalcWorker::loadNetwork(atools::routing::RouteNetwork *network, const QString& navDbFile, const QString& trackDbFile,
+                                  const QString& connectionSuffix)
+{
+  // Connections can only be used in the thread which created them - use separate ones here
+  QString navName = dbtools::DATABASE_NAME_ROUTE_CALC_NAV + connectionSuffix;
+  QString trackName = dbtools::DATABASE_NAME_ROUTE_CALC_TRACK + connectionSuffix;
+  SqlDatabase::addDatabase(dbtools::DATABASE_TYPE, navName);
+  SqlDatabase::addDatabase(dbtools::DATABASE_TYPE, trackName);
+
+  try
+  {
+    SqlDatabase dbNav(navName), dbTrack(trackName);
+    bool hasTrack = !trackDbFile.isEmpty();
+
+    dbtools::openDatabaseFileExt(&dbNav, navDbFile, true /* readonly */, false /* createSchema */,
+                                 false /* exclusive */, false /* auto transactions */);
+    if(hasTrack)
+      dbtools::openDatabaseFileExt(&dbTrack, trackDbFile, true /* readonly */, false /* createSchema */,
+                                   false /* exclusive */, false /* auto transactions */);
+
+    atools::routing::RouteNetworkLoader loader(&dbNav, hasTrack ? &dbTrack : nullptr);
+    loader.load(network);
+
+    dbtools::closeDatabaseFile(&dbNav);
+    dbtools::closeDatabaseFile(&dbTrack);
+  }
+  catch(...)
+  {
+    // Remove connections and pass exception to caller
+    SqlDatabase::removeDatabase(navName);
+    SqlDatabase::removeDatabase(trackName);
+    throw;
+  }
+
+  SqlDatabase::removeDatabase(navName);
+  SqlDatabase::removeDatabase(trackName);
+}
+
+void RouteCalcWorker::threadFinished()
+{
+  routecalc::Result res = future.result();
+
+  if(res.request.loadOnly)
+  {
+    // Preloading done - start queued calculation if any
+    if(hasPendingRequest)
+    {
+      hasPendingRequest = false;
+
+      if(cancelFlag.load())
+      {
+        // Canceled while waiting for preload
+        result = routecalc::Result();
+        result.request = pendingRequest;
+        result.canceled = true;
+        if(!suppressFinished)
+          emit finished();
+      }
+      else
+        startThread(pendingRequest);
+    }
+    return;
+  }
+
+  if(suppressFinished)
+    return;
+
+  result = res;
+  emit finished();
+}
@@ -0,0 +1,189 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_ROUTECALCWORKER_H
+#define LNM_ROUTECALCWORKER_H
+
+#include "route/routeextractor.h"
+#include "routing/routenetworktypes.h"
+
+#include <QFutureWatcher>
+#include <QObject>
+
+#include <atomic>
+#include <functional>
+
+namespace atools {
+namespace routing {
+class RouteNetwork;
+}
+namespace sql {
+class SqlDatabase;
+}
+}
+
+namespace routecalc {
+
+/* Parameters for a single flight plan calculation. Filled on the GUI thread and passed by value to the worker. */
+struct Request
+{
+  atools::geo::Pos departurePos, destinationPos;
+  atools::routing::Modes mode = atools::routing::MODE_NONE;
+  float altitudeFt = 0.f, costFactorForceAirways = 1.f;
+
+  /* true if airway network is used. Otherwise radio navaid network. */
+  bool airwayNetwork = true;
+
+  /* Only load networks if needed without calculation. Used to warm up the cache in background. */
+  bool loadOnly = false;
+
+  /* Context for caller. Not used by the worker. */
+  QString commandName;
+  bool fetchAirways = false;
+  int fromIndex = -1, toIndex = -1, id = -1;
+};
+
+/* Result of a calculation. Only valid once the worker signalled finished(). */
+struct Result
+{
+  Request request;
+
+  /* Extracted route without departure and destination */
+  QVector<RouteEntry> entries;
+  float distanceMeter = 0.f;
+
+  bool found = false, canceled = false;
+
+  /* Time for network loading if needed and calculation in milliseconds */
+  qint64 loadTimeMs = 0L, calcTimeMs = 0L;
+};
+
+}
+
+/*
+ * Runs flight plan calculations in a background thread using QtConcurrent.
+ *
+ * Owns the airway and radio navaid networks which are loaded on demand in the worker thread
+ * using separate read-only database connections. The networks must not be accessed while a calculation is running.
+ *
+ * Networks are kept as long as the key consisting of database file, AIRAC cycle, load time and
+ * loaded track set does not change. This avoids reloading after switching simulators using the same navdata
+ * or after downloading identical tracks. preload() fills the cache in background ahead of the first calculation.
+ * Networks are kept in memory only. There is no file snapshot, so the first load after program start
+ * still reads the database, though in background.
+ *
+ * Only one calculation can be active at any time. Progress and completion are reported by signals
+ * which are delivered as queued connections in the GUI thread.
+ */
+class RouteCalcWorker :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit RouteCalcWorker(QObject *parent);
+  virtual ~RouteCalcWorker() override;
+
+  RouteCalcWorker(const RouteCalcWorker& other) = delete;
+  RouteCalcWorker& operator=(const RouteCalcWorker& other) = delete;
+
+  /* Start calculation in background and return immediately. Does nothing and returns false if already calculating.
+   * Calculation is queued and started once done if networks are loading in background. */
+  bool start(const routecalc::Request& request);
+
+  /* Load all networks in background if the key changed or not loaded yet. Does nothing if already running. */
+  void preload();
+
+  /* Signal cancel to the route finder. Returns immediately. finished() is sent later. */
+  void cancel();
+
+  /* Signal cancel and block until the thread has finished. finished() is not sent. */
+  void cancelAndWait();
+
+  /* true if a calculation or network preloading is running */
+  bool isRunning() const;
+
+  /* true if a calculation is running or queued. Not true for network preloading. */
+  bool isCalculating() const;
+
+  /* Result of last calculation. Valid after finished() was sent. */
+  const routecalc::Result& getResult() const
+  {
+    return result;
+  }
+
+  /* Clear networks to force reloading with the next calculation. Cancels and waits for calculation. */
+  void clearNetworks();
+
+  /* Loads networks if needed using the given database connections. Call only if not running. */
+  atools::routing::RouteNetwork *getNetworkAirway(atools::sql::SqlDatabase *dbNav, atools::sql::SqlDatabase *dbTrack);
+  atools::routing::RouteNetwork *getNetworkRadio(atools::sql::SqlDatabase *dbNav, atools::sql::SqlDatabase *dbTrack);
+
+  /* Thread safe. Calculate route using the given network which will be loaded if needed.
+   * Opens separate database connections named by connectionSuffix in the calling thread for loading.
+   * cancelFlag can be null. progressCallback can be empty. */
+  static routecalc::Result calculate(atools::routing::RouteNetwork *network, const routecalc::Request& request,
+                                     const QString& navDbFile, const QString& trackDbFile, const QString& connectionSuffix,
+                                     const std::atomic_bool *cancelFlag,
+                                     const std::function<void(int distToDest, int currentDistToDest)>& progressCallback);
+
+  /* Load network in the calling thread using new read only database connections */
+  static void loadNetwork(atools::routing::RouteNetwork *network, const QString& navDbFile, const QString& trackDbFile,
+                          const QString& connectionSuffix);
+
+signals:
+  /* Progress from finder. Sent at most every PROGRESS_INTERVAL_MS. */
+  void progress(int maximum, int value);
+
+  /* Calculation finished or was canceled. Get result with getResult(). */
+  void finished();
+
+private:
+  /* Start thread for calculation or preloading */
+  void startThread(const routecalc::Request& request);
+  routecalc::Result calculateThread(routecalc::Request request, QString navDbFile, QString trackDbFile);
+  void threadFinished();
+
+  /* Clear networks in GUI thread if database or tracks changed. Call only if not running. */
+  void updateNetworkKeys();
+
+  /* Limit progress signals to avoid flooding the event queue */
+  static Q_DECL_CONSTEXPR qint64 PROGRESS_INTERVAL_MS = 100L;
+
+  atools::routing::RouteNetwork *networkRadio = nullptr, *networkAirway = nullptr;
+
+  /* Database and track keys the networks were loaded for */
+  QString keyRadio, keyAirway;
+
+  /* Calculation requested while preloading. Started once loading is done. */
+  routecalc::Request pendingRequest;
+  bool hasPendingRequest = false, runningLoadOnly = false;
+
+  /* Used to fetch result from thread */
+  QFuture<routecalc::Result> future;
+
+  /* Sends signal once thread is finished */
+  QFutureWatcher<routecalc::Result> watcher;
+
+  routecalc::Result result;
+  std::atomic_bool cancelFlag;
+
+  /* Suppresses finished() signal if canceled by cancelAndWait() */
+  bool suppressFinished = false;
+};
+
+#endif // LNM_ROUTECALCWORKER_H
@@ -55,6 +55,7 @@
 #include "route/flightplanentrybuilder.h"
 #include "route/routealtitude.h"
 #include "route/routecalcdialog.h"
+#include "route/routecalcworker.h"
 #include "route/routecommand.h"
 #include "route/routelabel.h"
 #include "route/runwayselectiondialog.h"
@@ -63,9 +64,7 @@
 #include "routestring/routestringdialog.h"
 #include "routestring/routestringreader.h"
 #include "routestring/routestringwriter.h"
-#include "routing/routefinder.h"
 #include "routing/routenetwork.h"
-#include "routing/routenetworkloader.h"
 #include "settings/settings.h"
 #include "track/trackcontroller.h"
 #include "ui_mainwindow.h"
@@ -282,13 +281,19 @@ RouteController::RouteController(QMainWindow *parentWindow, QTableView *tableVie
 
   tableViewRoute->setContextMenuPolicy(Qt::CustomContextMenu);
 
-  // Create flight plan calculation caches ===================================
-  routeNetworkRadio = new atools::routing::RouteNetwork(atools::routing::SOURCE_RADIO);
-  routeNetworkAirway = new atools::routing::RouteNetwork(atools::routing::SOURCE_AIRWAY);
+  // Create flight plan calculation worker and caches ===================================
+  routeCalcWorker = new RouteCalcWorker(this);
 
   // Do not use a parent to allow the window moving to back
   routeCalcDialog = new RouteCalcDialog(nullptr);
 
+  routeCalcProgress = new QProgressDialog(tr("Calculating Flight Plan ..."), tr("Cancel"), 0, 0, routeCalcDialog);
+  routeCalcProgress->setWindowTitle(tr("Little Navmap - Calculating Flight Plan"));
+  routeCalcProgress->setWindowFlags(routeCalcProgress->windowFlags() & ~Qt::WindowContextHelpButtonHint);
+  routeCalcProgress->setWindowModality(Qt::NonModal);
+  routeCalcProgress->setAutoReset(false);
+  routeCalcProgress->reset();
+
   // Set up undo/redo framework ========================================
   undoStack = new QUndoStack(mainWindow);
   undoStack->setUndoLimit(ROUTE_UNDO_LIMIT);
@@ -423,6 +428,9 @@ RouteController::RouteController(QMainWindow *parentWindow, QTableView *tableVie
 
   connect(this, &RouteController::routeChanged, routeCalcDialog, &RouteCalcDialog::routeChanged);
   connect(routeCalcDialog, &RouteCalcDialog::calculateClicked, this, &RouteController::calculateRoute);
+  connect(routeCalcWorker, &RouteCalcWorker::finished, this, &RouteController::routeCalcFinished);
+  connect(routeCalcWorker, &RouteCalcWorker::progress, this, &RouteController::routeCalcProgressChanged);
+  connect(routeCalcProgress, &QProgressDialog::canceled, routeCalcWorker, &RouteCalcWorker::cancel);
   connect(routeCalcDialog, &RouteCalcDialog::calculateDirectClicked, this, &RouteController::calculateDirect);
   connect(routeCalcDialog, &RouteCalcDialog::calculateReverseClicked, this, &RouteController::reverseRoute);
   connect(routeCalcDialog, &RouteCalcDialog::downloadTrackClicked, NavApp::getTrackController(), &TrackController::startDownload);
@@ -445,14 +453,15 @@ RouteController::~RouteController()
   NavApp::removeDialogFromDockHandler(routeCalcDialog);
   routeAltDelayTimer.stop();
 
+  // Stop calculation thread before deleting anything
+  ATOOLS_DELETE_LOG(routeCalcWorker);
+  ATOOLS_DELETE_LOG(routeCalcProgress);
   ATOOLS_DELETE_LOG(routeCalcDialog);
   ATOOLS_DELETE_LOG(tabHandlerRoute);
   ATOOLS_DELETE_LOG(units);
   ATOOLS_DELETE_LOG(entryBuilder);
   ATOOLS_DELETE_LOG(model);
   ATOOLS_DELETE_LOG(undoStack);
-  ATOOLS_DELETE_LOG(routeNetworkRadio);
-  ATOOLS_DELETE_LOG(routeNetworkAirway);
   ATOOLS_DELETE_LOG(zoomHandler);
   ATOOLS_DELETE_LOG(symbolPainter);
   ATOOLS_DELETE_LOG(routeLabel);
@@ -1853,201 +1862,205 @@ void RouteController::calculateRoute()
 {
   qDebug() << Q_FUNC_INFO;
 
-  atools::routing::RouteNetwork *net = nullptr;
-  QString command;
-  atools::routing::Modes mode = atools::routing::MODE_NONE;
-  bool fetchAirways = false;
+  if(routeCalcWorker->isCalculating())
+  {
+    qWarning() << Q_FUNC_INFO << "Calculation already running";
+    return;
+  }
 
-  // Ignore events triggering follow due to selection changes
-  atools::util::ContextSaverBool saver(ignoreFollowSelection);
+  routecalc::Request request;
 
   // Build configuration for route finder =======================================
   if(routeCalcDialog->getRoutingType() == rd::AIRWAY)
   {
-    net = routeNetworkAirway;
-    fetchAirways = true;
+    request.airwayNetwork = true;
+    request.fetchAirways = true;
 
     // Airway preference =======================================
     switch(routeCalcDialog->getAirwayRoutingType())
     {
       case rd::BOTH:
-        command = tr("Airway Flight Plan Calculation");
-        mode = atools::routing::MODE_AIRWAY_WAYPOINT;
+        request.commandName = tr("Airway Flight Plan Calculation");
+        request.mode = atools::routing::MODE_AIRWAY_WAYPOINT;
         break;
 
       case rd::VICTOR:
-        command = tr("Low altitude airway Flight Plan Calculation");
-        mode = atools::routing::MODE_VICTOR_WAYPOINT;
+        request.commandName = tr("Low altitude airway Flight Plan Calculation");
+        request.mode = atools::routing::MODE_VICTOR_WAYPOINT;
         break;
 
       case rd::JET:
-        command = tr("High altitude airway Flight Plan Calculation");
-        mode = atools::routing::MODE_JET_WAYPOINT;
+        request.commandName = tr("High altitude airway Flight Plan Calculation");
+        request.mode = atools::routing::MODE_JET_WAYPOINT;
         break;
     }
 
     // Airway/waypoint preference =======================================
     int pref = routeCalcDialog->getAirwayWaypointPreference();
     if(pref == RouteCalcDialog::AIRWAY_WAYPOINT_PREF_MIN)
-      mode &= ~atools::routing::MODE_WAYPOINT;
+      request.mode &= ~atools::routing::MODE_WAYPOINT;
     else if(pref == RouteCalcDialog::AIRWAY_WAYPOINT_PREF_MAX)
-      mode &= ~atools::routing::MODE_AIRWAY;
+      request.mode &= ~atools::routing::MODE_AIRWAY;
 
     // RNAV setting
     if(routeCalcDialog->isAirwayNoRnav())
-      mode |= atools::routing::MODE_NO_RNAV;
+      request.mode |= atools::routing::MODE_NO_RNAV;
 
     // Use tracks like NAT or PACOTS
     if(routeCalcDialog->isUseTracks())
-      mode |= atools::routing::MODE_TRACK;
+      request.mode |= atools::routing::MODE_TRACK;
   }
   else if(routeCalcDialog->getRoutingType() == rd::RADIONNAV)
   {
     // Radionav settings ========================================
-    command = tr("Radionnav Flight Plan Calculation");
-    fetchAirways = false;
-    net = routeNetworkRadio;
-    mode = atools::routing::MODE_RADIONAV_VOR;
+    request.commandName = tr("Radionnav Flight Plan Calculation");
+    request.fetchAirways = false;
+    request.airwayNetwork = false;
+    request.mode = atools::routing::MODE_RADIONAV_VOR;
     if(routeCalcDialog->isRadionavNdb())
-      mode |= atools::routing::MODE_RADIONAV_NDB;
-  }
-
-  if(!net->isLoaded())
-  {
-    atools::routing::RouteNetworkLoader loader(NavApp::getDatabaseNav(), NavApp::getDatabaseTrack());
-    loader.load(net);
+      request.mode |= atools::routing::MODE_RADIONAV_NDB;
   }
 
-  atools::routing::RouteFinder routeFinder(net);
-  routeFinder.setCostFactorForceAirways(routeCalcDialog->getAirwayPreferenceCostFactor());
+  request.costFactorForceAirways = routeCalcDialog->getAirwayPreferenceCostFactor();
+  request.altitudeFt = routeCalcDialog->getCruisingAltitudeFt();
 
-  int fromIdx = -1, toIdx = -1;
   if(routeCalcDialog->isCalculateSelection())
   {
-    fromIdx = routeCalcDialog->getRouteRangeFromIndex();
-    toIdx = routeCalcDialog->getRouteRangeToIndex();
+    request.fromIndex = std::max(route.getLastIndexOfDepartureProcedure(), routeCalcDialog->getRouteRangeFromIndex());
+    request.toIndex = std::min(route.getDestinationIndexBeforeProcedure(), routeCalcDialog->getRouteRangeToIndex());
+
+    request.departurePos = route.value(request.fromIndex).getPosition();
+    request.destinationPos = route.value(request.toIndex).getPosition();
 
     // Disable certain optimizations in route finder - use nearest underlying point as start for departure position
-    mode |= atools::routing::MODE_POINT_TO_POINT;
+    request.mode |= atools::routing::MODE_POINT_TO_POINT;
+  }
+  else
+  {
+    request.departurePos = route.getLastLegOfDepartureProcedure().getPosition();
+    request.destinationPos = route.getDestinationBeforeProcedure().getPosition();
   }
 
   if(route.hasAnySidProcedure())
     // Disable certain optimizations in route finder - use nearest underlying point as start for departure position
-    mode |= atools::routing::MODE_POINT_TO_POINT;
+    request.mode |= atools::routing::MODE_POINT_TO_POINT;
 
-  if(calculateRouteInternal(&routeFinder, command, fetchAirways, routeCalcDialog->getCruisingAltitudeFt(), fromIdx, toIdx, mode))
-    NavApp::setStatusMessage(tr("Calculated flight plan."));
-  else
-    NavApp::setStatusMessage(tr("No route found."));
+  // Stop any background tasks
+  beforeRouteCalc();
 
-  routeCalcDialog->updateWidgets();
+  // Remember route size to detect changes while the calculation is running in background
+  routeCalcRouteSize = route.size();
+
+  // Start thread - calls routeCalcFinished() when done ===============================
+  if(routeCalcWorker->start(request))
+  {
+    routeCalcDialog->setCalculating(true);
+    NavApp::setStatusMessage(tr("Calculating flight plan ..."));
+
+    // Set up a progress dialog which shows for all calculations taking more than half a second
+    // Dialog is not modal to keep map, simulator updates and web server responsive
+    routeCalcProgress->setMaximum(0);
+    routeCalcProgress->setValue(0);
+    routeCalcProgress->setMinimumDuration(500);
+  }
 }
 
-void RouteController::clearAirwayNetworkCache()
+void RouteController::routeCalcProgressChanged(int maximum, int value)
 {
-  routeNetworkAirway->clear();
+  if(routeCalcWorker->isCalculating())
+  {
+    routeCalcProgress->setMaximum(maximum);
+    routeCalcProgress->setValue(value);
+  }
 }
 
-/* Calculate a flight plan to all types */
-bool RouteController::calculateRouteInternal(atools::routing::RouteFinder *routeFinder, const QString& commandName,
-                                             bool fetchAirways, float altitudeFt, int fromIndex, int toIndex,
-                                             atools::routing::Modes mode)
+void RouteController::cancelRouteCalculation()
 {
-  qDebug() << Q_FUNC_INFO;
-  bool calcRange = fromIndex != -1 && toIndex != -1;
-  int oldRouteSize = route.size();
-
-  // Stop any background tasks
-  beforeRouteCalc();
+  bool calculating = routeCalcWorker->isCalculating();
 
-  Flightplan& flightplan = route.getFlightplan();
+  // Also waits for network preloading
+  routeCalcWorker->cancelAndWait();
 
-  // Load network from database if not already done
-  QGuiApplication::setOverrideCursor(Qt::WaitCursor);
+  if(calculating)
+  {
+    qDebug() << Q_FUNC_INFO;
+    routeCalcProgress->reset();
+    routeCalcDialog->setCalculating(false);
+  }
+}
 
-  Pos departurePos, destinationPos;
+void RouteController::preloadRouteNetworks()
+{
+  // Worker checks if database or tracks changed and reloads networks only if needed
+  routeCalcWorker->preload();
+}
 
-  if(calcRange)
-  {
-    fromIndex = std::max(route.getLastIndexOfDepartureProcedure(), fromIndex);
-    toIndex = std::min(route.getDestinationIndexBeforeProcedure(), toIndex);
+void RouteController::routeCalcFinished()
+{
+  const routecalc::Result& result = routeCalcWorker->getResult();
+  qDebug() << Q_FUNC_INFO << "found" << result.found << "canceled" << result.canceled;
 
-    departurePos = route.value(fromIndex).getPosition();
-    destinationPos = route.value(toIndex).getPosition();
-  }
+  // Hide dialog
+  routeCalcProgress->reset();
+  routeCalcDialog->setCalculating(false);
+
+  if(result.canceled)
+    NavApp::setStatusMessage(tr("Flight plan calculation canceled."));
+  else if(loadingDatabaseState || !routeCalcResultMatches(result.request))
+    // Flight plan was changed by user while calculating - discard result
+    NavApp::setStatusMessage(tr("Flight plan changed while calculating. Result discarded."));
+  else if(calculateRouteInternal(result))
+    NavApp::setStatusMessage(tr("Calculated flight plan."));
   else
-  {
-    departurePos = route.getLastLegOfDepartureProcedure().getPosition();
-    destinationPos = route.getDestinationBeforeProcedure().getPosition();
-  }
-
-  // ===================================================================
-  // Set up a progress dialog which shows for all calculations taking more than half a second
-  QProgressDialog progress(tr("Calculating Flight Plan ..."), tr("Cancel"), 0, 0, routeCalcDialog);
-  progress.setWindowTitle(tr("Little Navmap - Calculating Flight Plan"));
-  progress.setWindowFlags(progress.windowFlags() & ~Qt::WindowContextHelpButtonHint);
-  progress.setWindowModality(Qt::ApplicationModal);
-  progress.setMinimumDuration(500);
+    NavApp::setStatusMessage(tr("No route found."));
 
-  bool dialogShown = false, canceled = false;
-  routeFinder->setProgressCallback([&progress, &canceled, &dialogShown](int distToDest, int currentDistToDest) -> bool
-  {
-    QApplication::processEvents();
-    progress.setMaximum(distToDest);
-    progress.setValue(distToDest - currentDistToDest);
-    canceled = progress.wasCanceled();
+  routeCalcDialog->updateWidgets();
+}
 
-    if(!dialogShown && progress.isVisible())
-    {
-      // Dialog is shown - remove wait cursor
-      dialogShown = true;
-      QGuiApplication::restoreOverrideCursor();
-    }
+bool RouteController::routeCalcResultMatches(const routecalc::Request& request) const
+{
+  if(route.size() != routeCalcRouteSize)
+    return false;
 
-    return !canceled;
-  });
+  if(request.fromIndex != -1 && request.toIndex != -1)
+    return route.value(request.fromIndex).getPosition().almostEqual(request.departurePos) &&
+           route.value(request.toIndex).getPosition().almostEqual(request.destinationPos);
+  else
+    return route.getLastLegOfDepartureProcedure().getPosition().almostEqual(request.departurePos) &&
+           route.getDestinationBeforeProcedure().getPosition().almostEqual(request.destinationPos);
+}
 
-  // Calculate the route - calls above lambda ================================================
-  bool found = routeFinder->calculateRoute(departurePos, destinationPos, atools::roundToInt(altitudeFt), mode);
+/* Apply calculated flight plan from background thread */
+bool RouteController::calculateRouteInternal(const routecalc::Result& result)
+{
+  qDebug() << Q_FUNC_INFO;
 
-  if(!dialogShown)
-    QGuiApplication::restoreOverrideCursor();
+  // Ignore events triggering follow due to selection changes
+  atools::util::ContextSaverBool saver(ignoreFollowSelection);
 
-  qDebug() << Q_FUNC_INFO << "found" << found << "canceled" << canceled;
+  const routecalc::Request& request = result.request;
+  int fromIndex = request.fromIndex, toIndex = request.toIndex;
+  bool calcRange = fromIndex != -1 && toIndex != -1, fetchAirways = request.fetchAirways;
+  int oldRouteSize = route.size();
+  bool found = result.found;
 
-  // Hide dialog
-  progress.reset();
+  Flightplan& flightplan = route.getFlightplan();
 
   // Create wait cursor if calculation takes too long
   QGuiApplication::setOverrideCursor(Qt::WaitCursor);
 
-  float distance = 0.f;
-  QVector<RouteEntry> calculatedRoute;
-
-  if(found && !canceled)
-  {
-    // A route was found
-
-    // Fetch waypoints
-    RouteExtractor extractor(routeFinder);
-    extractor.extractRoute(calculatedRoute, distance);
-    qDebug() << Q_FUNC_INFO << "Extracted size" << calculatedRoute.size();
-
-    found = calculatedRoute.size() > 0;
-  }
-
-  if(found && !canceled)
+  if(found)
   {
     // Compare to direct connection and check if route is too long
-    float directDistance = departurePos.distanceMeterTo(destinationPos);
-    float ratio = distance / directDistance;
-    qDebug() << "route distance" << QString::number(distance, 'f', 0)
+    float directDistance = request.departurePos.distanceMeterTo(request.destinationPos);
+    float ratio = result.distanceMeter / directDistance;
+    qDebug() << "route distance" << QString::number(result.distanceMeter, 'f', 0)
              << "direct distance" << QString::number(directDistance, 'f', 0) << "ratio" << ratio;
 
     if(ratio < MAX_DISTANCE_DIRECT_RATIO)
     {
       // Start undo
-      RouteCommand *undoCommand = preChange(commandName);
+      RouteCommand *undoCommand = preChange(request.commandName);
       int numAlternateLegs = route.getNumAlternateLegs();
 
       if(calcRange)
@@ -2062,7 +2075,7 @@ bool RouteController::calculateRouteInternal(atools::routing::RouteFinder *route
 
       int idx = 1;
       // Create flight plan entries - will be copied later to the route map objects
-      for(const RouteEntry& routeEntry : qAsConst(calculatedRoute))
+      for(const RouteEntry& routeEntry : result.entries)
       {
         FlightplanEntry flightplanEntry;
         entryBuilder->buildFlightplanEntry(routeEntry.ref.id, atools::geo::EMPTY_POS, routeEntry.ref.objType,
@@ -2092,7 +2105,7 @@ bool RouteController::calculateRouteInternal(atools::routing::RouteFinder *route
       route.updateAll();
 
       // Set altitude in local units
-      flightplan.setCruiseAltitudeFt(altitudeFt);
+      flightplan.setCruiseAltitudeFt(request.altitudeFt);
 
       route.updateAirwaysAndAltitude(false /* adjustRouteAltitude */);
 
@@ -2132,7 +2145,7 @@ bool RouteController::calculateRouteInternal(atools::routing::RouteFinder *route
   }
 
   QGuiApplication::restoreOverrideCursor();
-  if(!found && !canceled)
+  if(!found)
     // Use routeCalcDialog as parent to avoid main raising in front
     atools::gui::Dialog(routeCalcDialog).showInfoMsgBox(lnm::ACTIONS_SHOW_ROUTE_ERROR,
                                                         tr("Cannot calculate flight plan.\n\n"
@@ -2247,6 +2260,9 @@ void RouteController::reverseRoute()
 
 void RouteController::preDatabaseLoad()
 {
+  // Stop calculation before databases are closed
+  cancelRouteCalculation();
+
   loadingDatabaseState = true;
   routeAltDelayTimer.stop();
 
@@ -2267,9 +2283,8 @@ void RouteController::preDatabaseLoad()
 
 void RouteController::postDatabaseLoad()
 {
-  // Clear routing caches
-  routeNetworkRadio->clear();
-  routeNetworkAirway->clear();
+  // Reload routing caches in background if navdata changed
+  preloadRouteNetworks();
   clearAllErrors();
 
   Flightplan flightplan;
@@ -5201,8 +5216,10 @@ void RouteController::disconnectedFromSimulator()
   emit routeChanged(false /* geometryChanged */);
 }
 
-void RouteController::simDataChanged(const atools::fs::sc::SimConnectData& simulatorData)
+void RouteController::simDataChanged(const simdata::PacketPtr& packet)
 {
+  const atools::fs::sc::SimConnectData& simulatorData = *packet;
+
   if(!loadingDatabaseState && atools::almostNotEqual(QDateTime::currentDateTime().toMSecsSinceEpoch(),
                                                      lastSimUpdate, static_cast<qint64>(MIN_SIM_UPDATE_TIME_MS)))
   {
@@ -5813,11 +5830,10 @@ void RouteController::debugNetworkClick(const atools::geo::Pos& pos)
   {
     qDebug() << Q_FUNC_INFO << pos;
 
-    atools::routing::RouteNetworkLoader loader(NavApp::getDatabaseNav(), NavApp::getDatabaseTrack());
-    if(!routeNetworkAirway->isLoaded())
-      loader.load(routeNetworkAirway);
-    if(!routeNetworkRadio->isLoaded())
-      loader.load(routeNetworkRadio);
+    atools::routing::RouteNetwork *routeNetworkAirway =
+      routeCalcWorker->getNetworkAirway(NavApp::getDatabaseNav(), NavApp::getDatabaseTrack());
+    atools::routing::RouteNetwork *routeNetworkRadio =
+      routeCalcWorker->getNetworkRadio(NavApp::getDatabaseNav(), NavApp::getDatabaseTrack());
 
     atools::routing::Node node = routeNetworkAirway->getNearestNode(pos);
     if(node.isValid())
@@ -18,6 +18,7 @@
 #ifndef LITTLENAVMAP_ROUTECONTROLLER_H
 #define LITTLENAVMAP_ROUTECONTROLLER_H
 
+#include "connect/simdatapacket.h"
 #include "routing/routenetworktypes.h"
 #include "route/route.h"
 #include "route/routecommandflags.h"
@@ -61,7 +62,14 @@ class QStandardItemModel;
 class QTableView;
 class QTextCursor;
 class RouteCalcDialog;
+class RouteCalcWorker;
 class RouteCommand;
+class QProgressDialog;
+
+namespace routecalc {
+struct Request;
+struct Result;
+}
 class RouteLabel;
 class SymbolPainter;
 class UnitStringTool;
@@ -255,7 +263,7 @@ public:
 
   void disconnectedFromSimulator();
 
-  void simDataChanged(const atools::fs::sc::SimConnectData& simulatorData);
+  void simDataChanged(const simdata::PacketPtr& packet);
 
   void editUserWaypointName(int index);
 
@@ -299,8 +307,12 @@ public:
     return tabHandlerRoute;
   }
 
-  /* Clear network, so it will be reloaded before next flight plan calculation. */
-  void clearAirwayNetworkCache();
+  /* Load route networks in background if not done yet or if navdata or tracks changed.
+   * Avoids loading delay for the first flight plan calculation. */
+  void preloadRouteNetworks();
+
+  /* Cancel flight plan calculation running in background and wait until finished. Result is discarded. */
+  void cancelRouteCalculation();
 
 #ifdef DEBUG_NETWORK_INFORMATION
   void debugNetworkClick(const atools::geo::Pos& pos);
@@ -437,12 +449,18 @@ private:
   void clearRouteAndUndo();
   void clearRoute();
 
-  /* Calculate flight plan pressed in dock window */
+  /* Calculate flight plan pressed in dock window. Starts calculation in background and returns immediately. */
   void calculateRoute();
-  bool calculateRouteInternal(atools::routing::RouteFinder *routeFinder,
-                              const QString& commandName,
-                              bool fetchAirways, float altitudeFt, int fromIndex, int toIndex,
-                              atools::routing::Modes mode);
+
+  /* Called by worker in GUI thread when calculation is done */
+  void routeCalcFinished();
+  void routeCalcProgressChanged(int maximum, int value);
+
+  /* true if departure, destination and size of the plan did not change since calculation start */
+  bool routeCalcResultMatches(const routecalc::Request& request) const;
+
+  /* Apply result to flight plan with undo */
+  bool calculateRouteInternal(const routecalc::Result& result);
 
   /* Assign type and altitude from GUI */
   void updateFlightplanFromWidgets(atools::fs::pln::Flightplan& flightplan);
@@ -561,8 +579,14 @@ private:
   /* Clean index of the undo stack or -1 if no clean state exists */
   int undoIndexClean = 0;
 
-  /* Network cache for flight plan calculation */
-  atools::routing::RouteNetwork *routeNetworkRadio = nullptr, *routeNetworkAirway = nullptr;
+  /* Runs flight plan calculation in background and keeps network cache */
+  RouteCalcWorker *routeCalcWorker = nullptr;
+
+  /* Non-modal progress dialog for calculation */
+  QProgressDialog *routeCalcProgress = nullptr;
+
+  /* Flight plan size at calculation start */
+  int routeCalcRouteSize = -1;
 
   /* Flightplan and route objects */
   Route route; /* real route containing all segments */
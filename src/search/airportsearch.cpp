@@ -35,7 +35,7 @@
 #include "search/column.h"
 #include "search/columnlist.h"
 #include "search/sqlmodel.h"
-#include "search/randomdepartureairportpickingbycriteria.h"
+#include "search/randomflightpicker.h"
 #include "search/sqlcontroller.h"
 #include "settings/settings.h"
 #include "sql/sqlrecord.h"
@@ -62,6 +62,9 @@ AirportSearch::AirportSearch(QMainWindow *parent, QTableView *tableView, si::Tab
   unitStringTool = new UnitStringTool;
   unitStringTool->init({ui->spinBoxAirportFlightplanMinSearch, ui->spinBoxAirportFlightplanMaxSearch});
 
+  randomFlightPicker = new RandomFlightPicker(this);
+  connect(randomFlightPicker, &RandomFlightPicker::finished, this, &AirportSearch::randomFlightplanFinished);
+
   /* *INDENT-OFF* */
   ui->pushButtonAirportHelpSearch->setToolTip(
     "<p>All set search conditions have to match.</p>"
@@ -292,6 +295,7 @@ AirportSearch::AirportSearch(QMainWindow *parent, QTableView *tableView, si::Tab
 
 AirportSearch::~AirportSearch()
 {
+  randomFlightPicker->cancelAndWait();
   delete iconDelegate;
   delete unitStringTool;
 }
@@ -699,7 +703,7 @@ void AirportSearch::updateRandomFlightplanDistance()
 
 void AirportSearch::randomFlightplanClicked()
 {
-  if(progress != nullptr) // previous run did not complete yet
+  if(randomFlightPicker->isRunning()) // previous run did not complete yet
     return;
 
   // Convert user selected display units to meter
@@ -710,56 +714,33 @@ void AirportSearch::randomFlightplanClicked()
   qDebug() << Q_FUNC_INFO << "random flight, distance min: " << distanceMinMeter
            << ", random flight, distance max: " << distanceMaxMeter;
 
-  // Fetch data from SQL model
-  // create new for threads, delete in method receiving result
-  QVector<std::pair<int, atools::geo::Pos> > *result = new QVector<std::pair<int, atools::geo::Pos> >();
-  controller->getSqlModel()->getFullResultSet(*result);
-
-  const int countResult = result->size();
-
-  qDebug() << Q_FUNC_INFO << "random flight, count source airports: " << countResult;
+  // Fetch airport ids and positions from SQL model
+  QVector<std::pair<int, atools::geo::Pos> > airports;
+  controller->getSqlModel()->getFullResultSet(airports);
 
-  // above this limit do not try to find a random value beacuse this will only have few "space" to "pick" from many already picked
-  const int randomLimit = countResult / 10 * 7;
+  qDebug() << Q_FUNC_INFO << "random flight, count source airports: " << airports.size();
 
-  // maximum equals seconds to 100% (per attempted departure)
-  progress = new QProgressDialog(tr("random picking and criteria comparison running..."),
-                                 tr("Abort running"), 0, 30, NavApp::getQMainWidget());
+  // Busy indicator - allows to cancel the search if the result set is huge
+  progress = new QProgressDialog(tr("Searching for random flight ..."), tr("&Cancel"), 0, 0, NavApp::getQMainWidget());
   progress->setWindowModality(Qt::ApplicationModal);
   progress->setAutoClose(false);
-  progress->setValue(progress->minimum());
 
-  // Let progress dialog pop up early to block application
-  // Allows to avoid waiting cursor
-  progress->setMinimumDuration(200); // see https://doc.qt.io/qt-5/qprogressdialog.html#value-prop . Issues with Modal include non-showing of the progress bar.
+  // Show only if search takes longer
+  progress->setMinimumDuration(500);
+  connect(progress, &QProgressDialog::canceled, randomFlightPicker, &RandomFlightPicker::cancel);
 
   // Disable button to avoid multiple clicks
   ui->pushButtonAirportFlightplanSearch->setDisabled(true);
 
-  RandomDepartureAirportPickingByCriteria::initStatics(countResult, randomLimit, result,
-                                                       atools::roundToInt(distanceMinMeter),
-                                                       atools::roundToInt(distanceMaxMeter));
-  RandomDepartureAirportPickingByCriteria *departurePicker = new RandomDepartureAirportPickingByCriteria(this);
-  connect(progress, &QProgressDialog::canceled, departurePicker,
-          &RandomDepartureAirportPickingByCriteria::cancellationReceived);
-  connect(departurePicker, &RandomDepartureAirportPickingByCriteria::progressing, this, &AirportSearch::progressing);
-  connect(departurePicker, &RandomDepartureAirportPickingByCriteria::resultReady, this,
-          &AirportSearch::dataRandomAirportsReceived);
-  connect(departurePicker, &RandomDepartureAirportPickingByCriteria::finished, departurePicker, &QObject::deleteLater);
-  departurePicker->start();
+  randomFlightPicker->start(airports, distanceMinMeter, distanceMaxMeter);
 }
 
-void AirportSearch::progressing()
+void AirportSearch::randomFlightplanFinished()
 {
-  if(progress != nullptr)
-    progress->setValue((progress->value() + 1) % progress->maximum() + 1);
-}
+  const randomflight::Result& pickResult = randomFlightPicker->getResult();
 
-void AirportSearch::dataRandomAirportsReceived(bool isSuccess, int indexDeparture, int indexDestination,
-                                               QVector<std::pair<int, atools::geo::Pos> > *data)
-{
   // Check if user pressed cancel in the progress dialog
-  bool canceled = progress->wasCanceled();
+  bool canceled = progress->wasCanceled() || pickResult.canceled;
   progress->hide();
   delete progress;
   progress = nullptr;
@@ -770,14 +751,14 @@ void AirportSearch::dataRandomAirportsReceived(bool isSuccess, int indexDepartur
   // Do not show any dialogs at all if user canceled
   if(!canceled)
   {
-    if(isSuccess)
+    if(pickResult.found)
     {
-      qDebug() << Q_FUNC_INFO << "random flight, index departure: " << indexDeparture
-               << ", random flight, index destination: " << indexDestination;
+      qDebug() << Q_FUNC_INFO << "random flight, departure id: " << pickResult.departureId
+               << ", random flight, destination id: " << pickResult.destinationId;
 
       AirportQuery *airportQuery = NavApp::getAirportQuerySim();
-      map::MapAirport airportDeparture = airportQuery->getAirportById(data->at(indexDeparture).first);
-      map::MapAirport airportDestination = airportQuery->getAirportById(data->at(indexDestination).first);
+      map::MapAirport airportDeparture = airportQuery->getAirportById(pickResult.departureId);
+      map::MapAirport airportDestination = airportQuery->getAirportById(pickResult.destinationId);
 
       // Show a question dialog before taking over plan - avoids "flight plan has changed" nagging dialog
       QString text(tr("<p><b>%1</b> to <b>%2</b></p><p>Direct distance: %3</p>").
@@ -810,6 +791,4 @@ void AirportSearch::dataRandomAirportsReceived(bool isSuccess, int indexDepartur
       msgBox.exec();
     }
   }
-
-  delete data; // delete data created for threads
 }
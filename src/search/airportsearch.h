@@ -33,6 +33,7 @@ class SqlDatabase;
 }
 
 class QProgressDialog;
+class RandomFlightPicker;
 
 /*
  * Airport search tab including all search widgets and the result table view.
@@ -58,11 +59,6 @@ public:
   virtual void postDatabaseLoad() override;
   virtual void resetSearch() override;
 
-public slots:
-  void progressing();
-  void dataRandomAirportsReceived(bool isSuccess, int indexDeparture, int indexDestination,
-                                  QVector<std::pair<int, atools::geo::Pos> > *data);
-
 private:
   virtual void updateButtonMenu() override;
   virtual void saveViewState(bool distanceSearchState) override;
@@ -82,6 +78,9 @@ private:
   /* UI push button clicked */
   void randomFlightplanClicked();
 
+  /* Result from random flight picker thread */
+  void randomFlightplanFinished();
+
   /* Update min/max values in random flight plan spin boxes */
   void updateRandomFlightplanDistance();
 
@@ -96,6 +95,7 @@ private:
   UnitStringTool *unitStringTool;
 
   QProgressDialog *progress = nullptr;
+  RandomFlightPicker *randomFlightPicker;
 };
 
 #endif // LITTLENAVMAP_AIRPORTSEARCH_H
@@ -0,0 +1,266 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#include "search/randomflightpicker.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QtConcurrent/QtConcurrentRun>
+
+using atools::geo::Pos;
+
+namespace {
+
+/* Grid cell size in degree */
+const int CELL_SIZE_DEG = 2;
+const int GRID_COLUMNS = 360 / CELL_SIZE_DEG;
+const int GRID_ROWS = 180 / CELL_SIZE_DEG;
+
+/* Random draws per departure before all airports in the candidate cells are checked */
+const int MAX_RANDOM_DRAWS = 64;
+
+/* Airport indexes sorted into a lat/lon grid. Cells are stored in compressed row format. */
+struct AirportGrid
+{
+  explicit AirportGrid(const QVector<std::pair<int, Pos> >& airports);
+
+  /* Start index of each cell in items plus one entry for the end */
+  QVector<int> cellStart;
+
+  /* Indexes into airport list */
+  QVector<int> items;
+
+  /* Non empty cells with center and maximum distance from center to any point in the cell */
+  QVector<int> cells;
+  QVector<Pos> cellCenters;
+  QVector<float> cellRadiusMeter;
+
+  static int cellIndex(const Pos& pos)
+  {
+    int col = std::min(std::max(static_cast<int>((pos.getLonX() + 180.f) / CELL_SIZE_DEG), 0), GRID_COLUMNS - 1);
+    int row = std::min(std::max(static_cast<int>((pos.getLatY() + 90.f) / CELL_SIZE_DEG), 0), GRID_ROWS - 1);
+    return row * GRID_COLUMNS + col;
+  }
+
+};
+
+AirportGrid::AirportGrid(const QVector<std::pair<int, Pos> >& airports)
+{
+  // Count airports per cell
+  cellStart.fill(0, GRID_COLUMNS * GRID_ROWS + 1);
+  for(const std::pair<int, Pos>& airport : airports)
+  {
+    if(airport.second.isValid())
+      cellStart[cellIndex(airport.second) + 1]++;
+  }
+
+  for(int i = 1; i < cellStart.size(); i++)
+    cellStart[i] += cellStart.at(i - 1);
+
+  // Fill cells
+  QVector<int> fill(cellStart);
+  items.resize(cellStart.constLast());
+  for(int i = 0; i < airports.size(); i++)
+  {
+    if(airports.at(i).second.isValid())
+      items[fill[cellIndex(airports.at(i).second)]++] = i;
+  }
+
+  // Remember non empty cells and their extent
+  for(int cell = 0; cell < GRID_COLUMNS * GRID_ROWS; cell++)
+  {
+    if(cellStart.at(cell + 1) > cellStart.at(cell))
+    {
+      float west = (cell % GRID_COLUMNS) * CELL_SIZE_DEG - 180.f, south = (cell / GRID_COLUMNS) * CELL_SIZE_DEG - 90.f;
+      Pos center(west + CELL_SIZE_DEG / 2.f, south + CELL_SIZE_DEG / 2.f);
+
+      // Corner nearest to equator is farthest away
+      float radius = std::max(center.distanceMeterTo(Pos(west, south)), center.distanceMeterTo(Pos(west, south + CELL_SIZE_DEG)));
+
+      cells.append(cell);
+      cellCenters.append(center);
+      cellRadiusMeter.append(radius);
+    }
+  }
+}
+
+}
+
+RandomFlightPicker::RandomFlightPicker(QObject *parent)
+  : QObject(parent)
+{
+  cancelFlag.store(false);
+
+  // Notification from thread that it has finished and we can get the result from the future
+  connect(&watcher, &QFutureWatcher<randomflight::Result>::finished, this, &RandomFlightPicker::threadFinished);
+}
+
+RandomFlightPicker::~RandomFlightPicker()
+{
+  cancelAndWait();
+}
+
+bool RandomFlightPicker::start(const QVector<std::pair<int, atools::geo::Pos> >& airports, float distanceMinMeter,
+                               float distanceMaxMeter)
+{
+  if(isRunning())
+  {
+    qWarning() << Q_FUNC_INFO << "Search already running";
+    return false;
+  }
+
+  cancelFlag.store(false);
+  suppressFinished = false;
+  result = randomflight::Result();
+
+  future = QtConcurrent::run(&RandomFlightPicker::pick, airports, distanceMinMeter, distanceMaxMeter,
+                             static_cast<const std::atomic_bool *>(&cancelFlag));
+
+  // Watcher will call RandomFlightPicker::threadFinished() when finished
+  watcher.setFuture(future);
+  return true;
+}
+
+void RandomFlightPicker::cancel()
+{
+  cancelFlag.store(true);
+}
+
+void RandomFlightPicker::cancelAndWait()
+{
+  if(isRunning())
+  {
+    suppressFinished = true;
+    cancelFlag.store(true);
+    future.waitForFinished();
+  }
+}
+
+bool RandomFlightPicker::isRunning() const
+{
+  // isStarted() is true for a default constructed future and stays true when done - do not use it here
+  return future.isRunning();
+}
+
+void RandomFlightPicker::threadFinished()
+{
+  if(suppressFinished)
+    return;
+
+  result = future.result();
+  emit finished();
+}
+
+randomflight::Result RandomFlightPicker::pick(const QVector<std::pair<int, atools::geo::Pos> >& airports, float distanceMinMeter,
+                                              float distanceMaxMeter, const std::atomic_bool *cancelFlag)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  randomflight::Result res;
+  AirportGrid grid(airports);
+
+  // Try departures in random order
+  QVector<int> departures(grid.items);
+  QRandomGenerator random(QRandomGenerator::global()->generate());
+  for(int i = departures.size() - 1; i > 0; i--)
+    std::swap(departures[i], departures[static_cast<int>(random.bounded(i + 1))]);
+
+  QVector<int> candidateCells, candidateSums, matches;
+  for(int departureIndex : qAsConst(departures))
+  {
+    if(cancelFlag != nullptr && cancelFlag->load())
+    {
+      res.canceled = true;
+      break;
+    }
+    res.departuresTried++;
+
+    // Collect all cells which can contain airports in the distance range from departure ===================
+    const Pos& departurePos = airports.at(departureIndex).second;
+    candidateCells.clear();
+    candidateSums.clear();
+    int total = 0;
+    for(int i = 0; i < grid.cells.size(); i++)
+    {
+      float distance = departurePos.distanceMeterTo(grid.cellCenters.at(i)), radius = grid.cellRadiusMeter.at(i);
+      if(distance + radius >= distanceMinMeter && distance - radius <= distanceMaxMeter)
+      {
+        int cell = grid.cells.at(i);
+        total += grid.cellStart.at(cell + 1) - grid.cellStart.at(cell);
+        candidateCells.append(cell);
+        candidateSums.append(total);
+      }
+    }
+
+    if(total == 0)
+      continue;
+
+    // Draw random airports from candidate cells with equal probability ===================
+    auto inRange = [&](int destinationIndex) -> bool {
+                     if(destinationIndex == departureIndex)
+                       return false;
+
+                     float distance = departurePos.distanceMeterTo(airports.at(destinationIndex).second);
+                     return distance >= distanceMinMeter && distance <= distanceMaxMeter;
+                   };
+
+    int destinationIndex = -1;
+    for(int draw = 0; draw < MAX_RANDOM_DRAWS && destinationIndex == -1; draw++)
+    {
+      int value = static_cast<int>(random.bounded(total));
+      int candidate = static_cast<int>(std::upper_bound(candidateSums.constBegin(), candidateSums.constEnd(), value) -
+                                       candidateSums.constBegin());
+      int offset = value - (candidate > 0 ? candidateSums.at(candidate - 1) : 0);
+      int index = grid.items.at(grid.cellStart.at(candidateCells.at(candidate)) + offset);
+      if(inRange(index))
+        destinationIndex = index;
+    }
+
+    if(destinationIndex == -1)
+    {
+      // Range covers only a small part of the cells - check all airports in the cells
+      matches.clear();
+      for(int cell : qAsConst(candidateCells))
+      {
+        for(int i = grid.cellStart.at(cell); i < grid.cellStart.at(cell + 1); i++)
+        {
+          if(inRange(grid.items.at(i)))
+            matches.append(grid.items.at(i));
+        }
+      }
+
+      if(!matches.isEmpty())
+        destinationIndex = matches.at(static_cast<int>(random.bounded(matches.size())));
+    }
+
+    if(destinationIndex != -1)
+    {
+      res.found = true;
+      res.departureId = airports.at(departureIndex).first;
+      res.destinationId = airports.at(destinationIndex).first;
+      break;
+    }
+  }
+
+  res.timeMs = timer.elapsed();
+  qDebug() << Q_FUNC_INFO << "found" << res.found << "canceled" << res.canceled << "airports" << airports.size()
+           << "departures tried" << res.departuresTried << "time" << res.timeMs << "ms";
+  return res;
+}
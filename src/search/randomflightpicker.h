@@ -0,0 +1,108 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+
+#ifndef LNM_RANDOMFLIGHTPICKER_H
+#define LNM_RANDOMFLIGHTPICKER_H
+
+#include "geo/pos.h"
+
+#include <QFutureWatcher>
+#include <QObject>
+
+#include <atomic>
+
+namespace randomflight {
+
+/* Result of a search. Only valid once the picker signalled finished(). */
+struct Result
+{
+  bool found = false, canceled = false;
+
+  /* Airport ids as given in the input list */
+  int departureId = -1, destinationId = -1;
+
+  /* Number of departures tried and time needed in milliseconds */
+  int departuresTried = 0;
+  qint64 timeMs = 0L;
+};
+
+}
+
+/*
+ * Picks a random departure and destination airport pair within a distance range from a list of airports.
+ *
+ * Airports are sorted into a latitude/longitude grid. For each randomly chosen departure only grid cells
+ * which can contain airports within the distance annulus are considered and destinations are drawn directly from these.
+ *
+ * The search runs in the global thread pool. Completion is signalled by finished() in the GUI thread.
+ */
+class RandomFlightPicker :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit RandomFlightPicker(QObject *parent);
+  virtual ~RandomFlightPicker() override;
+
+  RandomFlightPicker(const RandomFlightPicker& other) = delete;
+  RandomFlightPicker& operator=(const RandomFlightPicker& other) = delete;
+
+  /* Start search in background and return immediately. airports contains airport id and position.
+   * Does nothing and returns false if already running. */
+  bool start(const QVector<std::pair<int, atools::geo::Pos> >& airports, float distanceMinMeter, float distanceMaxMeter);
+
+  /* Signal cancel to the search. Returns immediately. finished() is sent later. */
+  void cancel();
+
+  /* Signal cancel and block until the thread has finished. finished() is not sent. */
+  void cancelAndWait();
+
+  bool isRunning() const;
+
+  /* Result of last search. Valid after finished() was sent. */
+  const randomflight::Result& getResult() const
+  {
+    return result;
+  }
+
+  /* Thread safe. Search for a random pair. cancelFlag can be null. */
+  static randomflight::Result pick(const QVector<std::pair<int, atools::geo::Pos> >& airports, float distanceMinMeter,
+                                   float distanceMaxMeter, const std::atomic_bool *cancelFlag);
+
+signals:
+  /* Search finished, nothing was found or search was canceled. Get result with getResult(). */
+  void finished();
+
+private:
+  void threadFinished();
+
+  /* Used to fetch result from thread */
+  QFuture<randomflight::Result> future;
+
+  /* Sends signal once thread is finished */
+  QFutureWatcher<randomflight::Result> watcher;
+
+  randomflight::Result result;
+  std::atomic_bool cancelFlag;
+
+  /* Suppresses finished() signal if canceled by cancelAndWait() */
+  bool suppressFinished = false;
+};
+
+#endif // LNM_RANDOMFLIGHTPICKER_H
@@ -753,6 +753,8 @@ void SearchBaseTable::connectSearchSlots()
 
   connect(controller->getSqlModel(), &SqlModel::modelReset, this, &SearchBaseTable::reconnectSelectionModel);
   connect(controller->getSqlModel(), &SqlModel::fetchedMore, this, &SearchBaseTable::fetchedMore);
+  connect(controller->getSqlModel(), &SqlModel::fetchedAll, this, &SearchBaseTable::fetchedAll);
+  connect(controller->getSqlModel(), &SqlModel::totalRowCountChanged, this, &SearchBaseTable::fetchedMore);
 
   connect(ui->dockWidgetSearch, &QDockWidget::visibilityChanged, this, &SearchBaseTable::dockVisibilityChanged);
 }
@@ -802,6 +804,12 @@ void SearchBaseTable::fetchedMore()
   tableSelectionChangedInternal(true /* noFollow */);
 }
 
+void SearchBaseTable::fetchedAll()
+{
+  updatePushButtons();
+  NavApp::setStatusMessage(tr("All entries read."));
+}
+
 void SearchBaseTable::tableSelectionChangedInternal(bool noFollow)
 {
   QItemSelectionModel *sm = view->selectionModel();
@@ -953,13 +961,11 @@ void SearchBaseTable::loadAllRowsIntoView()
     // Clear selection since it can get invalid
     view->clearSelection();
 
+    // Calls fetchedAll() when done
     controller->loadAllRows();
-    updatePushButtons();
 
     // if(allSelected)
     // view->selectAll();
-
-    NavApp::setStatusMessage(tr("All entries read."));
   }
 }
 
@@ -262,6 +262,7 @@ private:
   void fontChanged();
   void showApproaches(bool customApproach, bool customDeparture);
   void fetchedMore();
+  void fetchedAll();
 
   /* Called by actions on airport search tab */
   void routeSetDepartureAction();
@@ -17,6 +17,7 @@
 
 #include "search/sqlcontroller.h"
 
+#include "common/constants.h"
 #include "geo/calculations.h"
 #include "search/column.h"
 #include "search/columnlist.h"
@@ -25,11 +26,13 @@
 #include "sql/sqlrecord.h"
 #include "sql/sqldatabase.h"
 #include "gui/tools.h"
+#include "settings/settings.h"
 
 #include <QTableView>
 #include <QHeaderView>
 #include <QSpinBox>
 #include <QApplication>
+#include <QElapsedTimer>
 
 using atools::sql::SqlQuery;
 using atools::sql::SqlDatabase;
@@ -37,12 +40,16 @@ using atools::sql::SqlDatabase;
 SqlController::SqlController(atools::sql::SqlDatabase *sqlDb, ColumnList *cols, QTableView *tableView)
   : db(sqlDb), view(tableView), columns(cols)
 {
+  benchmark = atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_SEARCH_BENCHMARK_DEBUG, false).toBool();
 }
 
 SqlController::~SqlController()
 {
   viewSetModel(nullptr);
 
+  if(model != nullptr)
+    model->stopBackgroundQueries();
+
   if(proxyModel != nullptr)
     proxyModel->invalidate();
   delete proxyModel;
@@ -59,7 +66,11 @@ void SqlController::preDatabaseLoad()
   viewSetModel(nullptr);
 
   if(model != nullptr)
+  {
+    // Database file must not be used by background count query
+    model->stopBackgroundQueries();
     model->clear();
+  }
 }
 
 void SqlController::postDatabaseLoad()
@@ -623,6 +634,9 @@ void SqlController::loadAllRowsForDistanceSearch()
 {
   if(searchParamsChanged && proxyModel != nullptr)
   {
+    QElapsedTimer timer;
+    timer.start();
+
     QGuiApplication::setOverrideCursor(Qt::WaitCursor);
 
     // Run query again
@@ -637,6 +651,10 @@ void SqlController::loadAllRowsForDistanceSearch()
 
     QGuiApplication::restoreOverrideCursor();
     searchParamsChanged = false;
+
+    if(benchmark)
+      qDebug() << Q_FUNC_INFO << "source rows" << model->rowCount() << "rows" << proxyModel->rowCount()
+               << "took" << timer.elapsed() << "ms";
   }
 }
 
@@ -647,21 +665,24 @@ void SqlController::setDataCallback(const sqlmodeltypes::DataFunctionType& value
 
 void SqlController::loadAllRows()
 {
-  QGuiApplication::setOverrideCursor(Qt::WaitCursor);
-
   if(proxyModel != nullptr)
   {
+    QGuiApplication::setOverrideCursor(Qt::WaitCursor);
+
     // Run query again
     model->resetSqlQuery(false /* force */);
 
     // Let proxy know that filter parameters have changed
     proxyModel->invalidate();
-  }
 
-  while(model->canFetchMore())
-    model->fetchMore(QModelIndex());
+    // Proxy needs all rows at once for sorting and filtering
+    model->fetchAll(false /* incremental */);
 
-  QGuiApplication::restoreOverrideCursor();
+    QGuiApplication::restoreOverrideCursor();
+  }
+  else
+    // Fetch in slices from the event loop to keep the GUI responsive
+    model->fetchAll(true /* incremental */);
 }
 
 QVector<const Column *> SqlController::getCurrentColumns() const
@@ -62,7 +62,8 @@ public:
   /* Create a new SqlModel, build and execute a query */
   void prepareModel();
 
-  /* Load all rows into the view */
+  /* Load all rows into the view. Rows are loaded incrementally in background if distance search is not active.
+   * SqlModel::fetchedAll() is sent when done. */
   void loadAllRows();
 
   /* Restore columns ordering, sorting and column widths to default */
@@ -251,6 +252,9 @@ private:
    * are indicated by this bool */
   bool searchParamsChanged = false;
   atools::geo::Pos currentDistanceCenter;
+
+  /* Log distance search time */
+  bool benchmark = false;
 };
 
 #endif // LITTLENAVMAP_CONTROLLER_H
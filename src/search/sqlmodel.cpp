@@ -17,6 +17,8 @@
 
 #include "search/sqlmodel.h"
 
+#include "common/constants.h"
+#include "db/dbtools.h"
 #include "gui/application.h"
 #include "gui/errorhandler.h"
 #include "sql/sqldatabase.h"
@@ -25,22 +27,45 @@
 #include "search/column.h"
 #include "search/columnlist.h"
 #include "sql/sqlrecord.h"
+#include "settings/settings.h"
 
+#include <QElapsedTimer>
 #include <QLineEdit>
 #include <QCheckBox>
 #include <QSqlError>
 #include <QRegularExpression>
 #include <QComboBox>
 #include <QStringBuilder>
+#include <QtConcurrent/QtConcurrentRun>
 
 using atools::sql::SqlQuery;
 using atools::sql::SqlDatabase;
 using atools::gui::ErrorHandler;
 using atools::sql::SqlRecord;
 
+/* Time slice for incremental fetching of all rows. Gives control back to the event loop after this. */
+const static qint64 FETCH_ALL_SLICE_MS = 50L;
+
 SqlModel::SqlModel(QWidget *parent, SqlDatabase *sqlDb, const ColumnList *columnList)
   : QSqlQueryModel(parent), db(sqlDb), columns(columnList), parentWidget(parent)
 {
+  countCancel.store(false);
+
+  atools::settings::Settings& settings = atools::settings::Settings::instance();
+  buildQueryDelayMs = settings.getAndStoreValue(lnm::SETTINGS_SEARCH + "QueryDelayMs", 250).toInt();
+  countInBackground = settings.getAndStoreValue(lnm::SETTINGS_SEARCH + "CountInBackground", true).toBool();
+
+  buildQueryTimer.setSingleShot(true);
+  connect(&buildQueryTimer, &QTimer::timeout, this, [this]() {
+    buildQuery();
+  });
+
+  fetchAllTimer.setSingleShot(true);
+  connect(&fetchAllTimer, &QTimer::timeout, this, &SqlModel::fetchAllSlice);
+
+  // Notification from thread that counting has finished
+  connect(&countWatcher, &QFutureWatcher<sqlmodel::CountResult>::finished, this, &SqlModel::countThreadFinished);
+
   // Set default handler
   setDataCallback(nullptr, QSet<Qt::ItemDataRole>());
 
@@ -49,12 +74,14 @@ SqlModel::SqlModel(QWidget *parent, SqlDatabase *sqlDb, const ColumnList *column
 
 SqlModel::~SqlModel()
 {
+  stopBackgroundQueries();
 }
 
 void SqlModel::filterByBuilder(const QWidget *widget)
 {
+  Q_UNUSED(widget)
   qDebug() << Q_FUNC_INFO;
-  buildQuery(widget);
+  buildQueryDelayed();
 }
 
 void SqlModel::filterIncluding(QModelIndex index, bool forceQueryBuilder, bool exact)
@@ -308,7 +335,7 @@ void SqlModel::filter(const Column *col, const QVariant& variantDisp, const QVar
       // Insert new condition
       whereConditionMap.insert(colName, {oper, variantSql, variantDisp, col});
   }
-  buildQuery(col->getLineEditWidget());
+  buildQueryDelayed();
 }
 
 void SqlModel::buildSqlWhereValue(QVariant& whereValue, bool exact) const
@@ -484,6 +511,9 @@ void SqlModel::buildQuery(const QWidget *widgetFromBuilder)
   if(updatingWidgets)
     return;
 
+  // Conditions of a delayed query are included here
+  buildQueryTimer.stop();
+
   QString tablename = columns->getTablename();
 
   atools::sql::SqlRecord tableCols = db->record(tablename);
@@ -559,12 +589,12 @@ void SqlModel::buildQuery(const QWidget *widgetFromBuilder)
 
   try
   {
-    // Count total rows
-    updateTotalCount();
-
     if(!isDistanceSearchActive())
       // Delay query for bounding rectangle query with proxy model
       resetSqlQuery(false /* force */);
+
+    // Count total rows - needs the result of the query above
+    startTotalCount();
   }
   catch(atools::Exception& e)
   {
@@ -576,6 +606,158 @@ void SqlModel::buildQuery(const QWidget *widgetFromBuilder)
   }
 }
 
+void SqlModel::buildQueryDelayed()
+{
+  // Ignore signals/messages from values set in widgets
+  if(updatingWidgets)
+    return;
+
+  // Distance search is already delayed by the search tab
+  if(buildQueryDelayMs > 0 && !isDistanceSearchActive())
+    buildQueryTimer.start(buildQueryDelayMs);
+  else
+    buildQuery();
+}
+
+void SqlModel::applyPendingQuery()
+{
+  if(buildQueryTimer.isActive())
+    buildQuery();
+}
+
+void SqlModel::stopBackgroundQueries()
+{
+  buildQueryTimer.stop();
+  fetchAllTimer.stop();
+
+  pendingCountQuery.clear();
+  if(countWatcher.isRunning())
+  {
+    qDebug() << Q_FUNC_INFO << "Waiting for count query";
+    countCancel.store(true);
+    countWatcher.waitForFinished();
+  }
+}
+
+void SqlModel::startTotalCount()
+{
+  // Drop results of running and queued count queries
+  countCancel.store(true);
+  pendingCountQuery.clear();
+
+  QString dbFile = db->databaseName();
+  if(!isDistanceSearchActive() && !canFetchMore() && QSqlQueryModel::query().lastQuery() == currentSqlQuery)
+    // Model already contains all rows - no need to count
+    totalRowCount = rowCount();
+  else if(countInBackground && !dbFile.isEmpty() && dbFile != ":memory:")
+  {
+    // Use number of loaded rows until count is available
+    totalRowCount = isDistanceSearchActive() ? 0 : rowCount();
+
+    if(countWatcher.isRunning())
+      // Start once the running query is finished
+      pendingCountQuery = currentSqlCountQuery;
+    else
+      startCountThread(currentSqlCountQuery);
+  }
+  else
+    updateTotalCount();
+}
+
+void SqlModel::startCountThread(const QString& query)
+{
+  countCancel.store(false);
+
+  // Model address makes connection name unique
+  QString connectionName = dbtools::DATABASE_NAME_SEARCH_COUNT + QString::number(reinterpret_cast<quintptr>(this), 16);
+
+  // Watcher will call SqlModel::countThreadFinished() when finished
+  countWatcher.setFuture(QtConcurrent::run(&SqlModel::countThread, query, db->databaseName(), connectionName, &countCancel));
+}
+
+sqlmodel::CountResult SqlModel::countThread(QString query, QString dbFile, QString connectionName,
+                                            const std::atomic_bool *cancel)
+{
+  sqlmodel::CountResult result;
+  result.query = query;
+
+  if(cancel->load())
+    return result;
+
+  // Connections can only be used in the thread which created them - use a separate one here
+  SqlDatabase::addDatabase(dbtools::DATABASE_TYPE, connectionName);
+
+  try
+  {
+    SqlDatabase countDb(connectionName);
+    dbtools::openDatabaseFileExt(&countDb, dbFile, true /* readonly */, false /* createSchema */,
+                                 false /* exclusive */, false /* auto transactions */);
+
+    // Skip query if superseded while opening
+    if(!cancel->load())
+    {
+      SqlQuery countStmt(&countDb);
+      countStmt.exec(query);
+      result.count = countStmt.next() ? countStmt.value(0).toInt() : 0;
+      result.ok = !cancel->load();
+    }
+    countDb.close();
+  }
+  catch(atools::Exception& e)
+  {
+    // Database might be locked by a writer - caller falls back to counting in the GUI thread
+    qWarning() << Q_FUNC_INFO << "Caught exception" << e.what();
+    result.ok = false;
+  }
+  catch(...)
+  {
+    qWarning() << Q_FUNC_INFO << "Caught unknown exception";
+    result.ok = false;
+  }
+
+  SqlDatabase::removeDatabase(connectionName);
+  return result;
+}
+
+void SqlModel::countThreadFinished()
+{
+  sqlmodel::CountResult result = countWatcher.result();
+
+  if(!pendingCountQuery.isEmpty())
+  {
+    // Query changed while counting - start latest and drop this result
+    QString query = pendingCountQuery;
+    pendingCountQuery.clear();
+    startCountThread(query);
+    return;
+  }
+
+  if(countCancel.load() || result.query != currentSqlCountQuery)
+    // Superseded or stopped
+    return;
+
+  if(result.ok)
+    totalRowCount = result.count;
+  else
+  {
+    try
+    {
+      // Failed in background - try again in GUI thread
+      updateTotalCount();
+    }
+    catch(atools::Exception& e)
+    {
+      ATOOLS_HANDLE_EXCEPTION(e);
+    }
+    catch(...)
+    {
+      ATOOLS_HANDLE_UNKNOWN_EXCEPTION;
+    }
+  }
+
+  emit totalRowCountChanged();
+}
+
 void SqlModel::updateTotalCount()
 {
   if(!currentSqlCountQuery.isEmpty())
@@ -723,14 +905,26 @@ QString SqlModel::buildWhereValue(const WhereCondition& cond)
 void SqlModel::refreshData(bool force)
 {
   resetSqlQuery(force);
+
+  // Count is needed immediately by the caller to restore the selection - drop background count
+  countCancel.store(true);
+  pendingCountQuery.clear();
   updateTotalCount();
 }
 
 void SqlModel::resetSqlQuery(bool force)
 {
+  // Get conditions of a delayed query
+  applyPendingQuery();
+
   // Update can be forced when changing database rows, for distance search or if the query differs
   if(force || isDistanceSearchActive() || QSqlQueryModel::query().lastQuery() != currentSqlQuery)
   {
+    // Incremental fetching is not valid for the new query
+    fetchAllTimer.stop();
+
+    // Runs in the GUI thread - QSqlQueryModel needs a query from a connection owned by this thread
+    // Superseded queries are avoided by the typing delay in buildQueryDelayed()
     QSqlQueryModel::setQuery(currentSqlQuery, db->getQSqlDatabase());
 
     if(lastError().isValid())
@@ -795,6 +989,41 @@ void SqlModel::fetchMore(const QModelIndex& parent)
   emit fetchedMore();
 }
 
+void SqlModel::fetchAll(bool incremental)
+{
+  applyPendingQuery();
+
+  if(incremental)
+    // Fetch first slice right away
+    fetchAllSlice();
+  else
+  {
+    fetchAllTimer.stop();
+    while(canFetchMore())
+      QSqlQueryModel::fetchMore(QModelIndex());
+    emit fetchedMore();
+    emit fetchedAll();
+  }
+}
+
+void SqlModel::fetchAllSlice()
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  // Fetch batches until the time slice is used up
+  while(canFetchMore() && timer.elapsed() < FETCH_ALL_SLICE_MS)
+    QSqlQueryModel::fetchMore(QModelIndex());
+
+  emit fetchedMore();
+
+  if(canFetchMore())
+    // Continue from event loop
+    fetchAllTimer.start(0);
+  else
+    emit fetchedAll();
+}
+
 QVariant SqlModel::getRawData(int row, const QString& colname) const
 {
   return getRawData(row, getSqlRecord().indexOf(colname));
@@ -822,6 +1051,8 @@ QVariant SqlModel::getFormattedFieldData(const QModelIndex& index) const
 
 void SqlModel::getFullResultSet(QVector<std::pair<int, atools::geo::Pos> >& result)
 {
+  applyPendingQuery();
+
   if(!currentSqlFetchQuery.isEmpty())
   {
     try
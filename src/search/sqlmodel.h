@@ -22,7 +22,11 @@
 #include "search/querybuilder.h"
 #include "search/sqlmodeltypes.h"
 
+#include <QFutureWatcher>
 #include <QSqlQueryModel>
+#include <QTimer>
+
+#include <atomic>
 
 namespace atools {
 namespace sql {
@@ -35,8 +39,30 @@ class SqlRecord;
 class Column;
 class ColumnList;
 
+namespace sqlmodel {
+
+/* Result of a row count query executed in background */
+struct CountResult
+{
+  QString query;
+  int count = 0;
+
+  /* false if canceled or query failed */
+  bool ok = false;
+};
+
+}
+
 /*
  * Extends the QSqlQueryModel and adds query building based on filters and ordering.
+ *
+ * Queries triggered by editing search widgets are delayed until typing pauses.
+ * The total row count is queried in a background thread using a separate read only database connection.
+ * Only the latest count query is executed and results of superseded queries are dropped.
+ *
+ * The result rows are still queried and fetched by QSqlQueryModel in the GUI thread since the model
+ * is bound to the GUI thread database connection. Only the first batch is fetched on query changes
+ * and remaining rows are loaded on demand or incrementally by fetchAll().
  */
 class SqlModel :
   public QSqlQueryModel
@@ -102,6 +128,7 @@ public:
     return orderByColIndex;
   }
 
+  /* Total row count of the current query. Can be preliminary as long as the background count query is running. */
   int getTotalRowCount() const
   {
     return totalRowCount;
@@ -115,6 +142,18 @@ public:
   /* Fetch more data and emit signal fetchedMore */
   virtual void fetchMore(const QModelIndex& parent) override;
 
+  /* Fetch all rows and emit fetchedAll when done. If incremental is true rows are fetched in slices
+   * from the event loop which keeps the GUI responsive. Signal fetchedMore is emitted after each slice.
+   * Incremental fetching is canceled if the query changes. */
+  void fetchAll(bool incremental);
+
+  /* Execute a delayed query immediately if one is pending */
+  void applyPendingQuery();
+
+  /* Stop delayed queries and incremental fetching and wait for background count query.
+   * Call before closing or switching the database. */
+  void stopBackgroundQueries();
+
   /* Get unformatted data from the model */
   QVariant getRawData(int row, int col) const;
   QVariant getRawData(int row, const QString& colname) const;
@@ -122,7 +161,8 @@ public:
   /* Sets the SQL query into the model. This will start the query and fetch data from the database. */
   void updateSqlQuery();
 
-  /* Set query to model causing a refresh. Unless force is set the query is compared to the current query and skipped if equal */
+  /* Set query to model causing a refresh. Unless force is set the query is compared to the current query and skipped if equal.
+   * Executes the query and fetches the first batch of rows in the calling GUI thread. */
   void resetSqlQuery(bool force);
 
   /* Set a filter for objects within the given bounding rectangle */
@@ -191,6 +231,12 @@ signals:
   /* Emitted when more data was fetched */
   void fetchedMore();
 
+  /* Emitted when fetchAll() has loaded all rows */
+  void fetchedAll();
+
+  /* Background query for total row count finished */
+  void totalRowCountChanged();
+
   /* One or more columns overrides all other search options */
   void overrideMode(const QStringList& overrideColumnTitles);
 
@@ -213,6 +259,9 @@ private:
   QString buildWhere(const atools::sql::SqlRecord& tableCols, QVector<const Column *>& overridingColumns);
   QString buildWhereValue(const WhereCondition& cond);
   void buildQuery(const QWidget *widgetFromBuilder = nullptr);
+
+  /* Start timer for buildQuery() to avoid running queries for each keystroke */
+  void buildQueryDelayed();
   void clearWhereConditions();
 
   /* Filter by value at index (context menu in table view). forceQueryBuilder to always use it. */
@@ -221,6 +270,18 @@ private:
   QVariant defaultDataHandler(int, int, const Column *, const QVariant&,
                               const QVariant& displayRoleValue, Qt::ItemDataRole role) const;
   void updateTotalCount();
+
+  /* Start count query in background or get count from model if all rows are already loaded */
+  void startTotalCount();
+  void startCountThread(const QString& query);
+  void countThreadFinished();
+
+  /* Runs in background thread. Opens own database connection. */
+  static sqlmodel::CountResult countThread(QString query, QString dbFile, QString connectionName,
+                                           const std::atomic_bool *cancel);
+
+  /* Fetch one slice of rows for incremental fetchAll() */
+  void fetchAllSlice();
   void buildSqlWhereValue(QVariant& whereValue, bool exact) const;
   void buildSqlWhereValue(QString& whereValue, bool exact) const;
   bool isDistanceSearchActive() const;
@@ -259,6 +320,23 @@ private:
 
   bool restoreFinished = false;
   bool updatingWidgets = false;
+
+  /* Delays query building while typing. Delay is zero if disabled. */
+  QTimer buildQueryTimer;
+  int buildQueryDelayMs = 0;
+
+  /* Count total rows in background thread if enabled */
+  bool countInBackground = true;
+  QFutureWatcher<sqlmodel::CountResult> countWatcher;
+
+  /* Count query requested while another is running. Started once the running query is finished. */
+  QString pendingCountQuery;
+
+  /* Signals a superseded count. Result is dropped. */
+  std::atomic_bool countCancel;
+
+  /* Calls fetchAllSlice() from the event loop */
+  QTimer fetchAllTimer;
 };
 
 #endif // LITTLENAVMAP_SQLMODEL_H
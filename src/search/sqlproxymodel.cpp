@@ -19,16 +19,24 @@
 
 #include "geo/calculations.h"
 #include "search/sqlmodel.h"
+#include "common/constants.h"
 #include "common/unit.h"
 #include "common/mapflags.h"
+#include "settings/settings.h"
+#include "sql/sqlrecord.h"
 
 #include <QApplication>
+#include <QElapsedTimer>
 
 using namespace atools::geo;
 
 SqlProxyModel::SqlProxyModel(QObject *parent, SqlModel *sqlModel)
   : QSortFilterProxyModel(parent), sourceSqlModel(sqlModel)
 {
+  // Row numbers and columns change with a new query
+  connect(sourceSqlModel, &QAbstractItemModel::modelReset, this, &SqlProxyModel::clearRowCache);
+
+  benchmark = atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_SEARCH_BENCHMARK_DEBUG, false).toBool();
 }
 
 SqlProxyModel::~SqlProxyModel()
@@ -41,6 +49,11 @@ void SqlProxyModel::setDistanceFilter(const Pos& center, sqlmodeltypes::SearchDi
 {
   minDistMeter = nmToMeter(minDistance);
   maxDistMeter = nmToMeter(maxDistance);
+
+  // Distances and headings remain valid if only range or direction change
+  if(centerPos != center)
+    clearRowCache();
+
   centerPos = center;
   direction = dir;
 }
@@ -48,6 +61,44 @@ void SqlProxyModel::setDistanceFilter(const Pos& center, sqlmodeltypes::SearchDi
 void SqlProxyModel::clearDistanceFilter()
 {
   centerPos = Pos();
+  clearRowCache();
+}
+
+void SqlProxyModel::clearRowCache()
+{
+  rowGeoCache.clear();
+  columnIndexesValid = false;
+}
+
+void SqlProxyModel::updateColumnIndexes() const
+{
+  if(!columnIndexesValid)
+  {
+    atools::sql::SqlRecord rec = sourceSqlModel->getSqlRecord();
+    colLonX = rec.indexOf("lonx");
+    colLatY = rec.indexOf("laty");
+    colDistance = rec.indexOf("distance");
+    colHeading = rec.indexOf("heading");
+    columnIndexesValid = true;
+  }
+}
+
+SqlProxyModel::RowGeo SqlProxyModel::rowGeo(int sourceRow) const
+{
+  if(sourceRow >= rowGeoCache.size())
+  {
+    updateColumnIndexes();
+
+    // Calculate for all rows fetched so far to avoid reallocation for each new row
+    int numRows = std::max(sourceRow + 1, sourceSqlModel->rowCount());
+    rowGeoCache.reserve(numRows);
+    for(int row = rowGeoCache.size(); row < numRows; row++)
+    {
+      Pos pos = buildPos(row);
+      rowGeoCache.append({pos.distanceMeterTo(centerPos), normalizeCourse(centerPos.angleDegTo(pos))});
+    }
+  }
+  return rowGeoCache.at(sourceRow);
 }
 
 /* Does the filtering by minimum and maximum distance and direction */
@@ -56,53 +107,55 @@ bool SqlProxyModel::filterAcceptsRow(int sourceRow, const QModelIndex&) const
   if(sourceSqlModel->isOverrideModeActive())
     return true;
 
-  Pos pos = buildPos(sourceRow);
-  float heading = normalizeCourse(centerPos.angleDegTo(pos));
+  const RowGeo geo = rowGeo(sourceRow);
+  float heading = geo.headingDeg;
 
   switch(direction)
   {
     case sqlmodeltypes::ALL:
       // All directions
-      return matchDistance(pos);
+      return matchDistance(geo.distMeter);
 
     case sqlmodeltypes::NORTH:
       if(MIN_NORTH_DEG <= heading || heading <= MAX_NORTH_DEG)
-        return matchDistance(pos);
+        return matchDistance(geo.distMeter);
       else
         return false;
 
     case sqlmodeltypes::EAST:
       if(MIN_EAST_DEG <= heading && heading <= MAX_EAST_DEG)
-        return matchDistance(pos);
+        return matchDistance(geo.distMeter);
       else
         return false;
 
     case sqlmodeltypes::SOUTH:
       if(MIN_SOUTH_DEG <= heading && heading <= MAX_SOUTH_DEG)
-        return matchDistance(pos);
+        return matchDistance(geo.distMeter);
       else
         return false;
 
     case sqlmodeltypes::WEST:
       if(MIN_WEST_DEG <= heading && heading <= MAX_WEST_DEG)
-        return matchDistance(pos);
+        return matchDistance(geo.distMeter);
       else
         return false;
   }
   return true;
 }
 
-bool SqlProxyModel::matchDistance(const Pos& pos) const
+bool SqlProxyModel::matchDistance(float distMeter) const
 {
   if(sourceSqlModel->isOverrideModeActive())
     return true;
 
-  float distMeter = pos.distanceMeterTo(centerPos);
   return distMeter >= minDistMeter && distMeter <= maxDistMeter;
 }
 
 void SqlProxyModel::sort(int column, Qt::SortOrder order)
 {
+  QElapsedTimer timer;
+  timer.start();
+
   QSortFilterProxyModel::sort(column, order);
 
   // Update query in underlying SQL model
@@ -113,6 +166,10 @@ void SqlProxyModel::sort(int column, Qt::SortOrder order)
   while(canFetchMore(QModelIndex()))
     fetchMore(QModelIndex());
   QGuiApplication::restoreOverrideCursor();
+
+  if(benchmark)
+    qDebug() << Q_FUNC_INFO << "column" << column << "source rows" << sourceSqlModel->rowCount()
+             << "rows" << rowCount() << "took" << timer.elapsed() << "ms";
 }
 
 QVariant SqlProxyModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -127,23 +184,14 @@ bool SqlProxyModel::lessThan(const QModelIndex& sourceLeft, const QModelIndex& s
   const static QSet<QVariant::Type> NUMERIC_TYPES({QVariant::Bool, QVariant::Int, QVariant::UInt, QVariant::LongLong, QVariant::ULongLong,
                                                    QVariant::Date, QVariant::Time, QVariant::DateTime});
 
-  QString leftCol = sourceSqlModel->getColumnName(sourceLeft.column());
-  QString rightCol = sourceSqlModel->getColumnName(sourceRight.column());
+  updateColumnIndexes();
 
-  if(leftCol == "distance" && rightCol == "distance")
-  {
+  if(sourceLeft.column() == colDistance && sourceRight.column() == colDistance)
     // Sort by distance
-    float distLeft = buildPos(sourceLeft.row()).distanceMeterTo(centerPos);
-    float distRight = buildPos(sourceRight.row()).distanceMeterTo(centerPos);
-    return distLeft < distRight;
-  }
-  else if(leftCol == "heading" && rightCol == "heading")
-  {
+    return rowGeo(sourceLeft.row()).distMeter < rowGeo(sourceRight.row()).distMeter;
+  else if(sourceLeft.column() == colHeading && sourceRight.column() == colHeading)
     // Sort by heading
-    float headingLeft = normalizeCourse(centerPos.angleDegTo(buildPos(sourceLeft.row())));
-    float headingRight = normalizeCourse(centerPos.angleDegTo(buildPos(sourceRight.row())));
-    return headingLeft < headingRight;
-  }
+    return rowGeo(sourceLeft.row()).headingDeg < rowGeo(sourceRight.row()).headingDeg;
   else
   {
     // Get unmodified (converted to strings) raw data
@@ -165,18 +213,20 @@ bool SqlProxyModel::lessThan(const QModelIndex& sourceLeft, const QModelIndex& s
 /* Returns the formatted data for the "distance" and "heading" column */
 QVariant SqlProxyModel::data(const QModelIndex& index, int role) const
 {
-  if(sourceSqlModel->getColumnName(index.column()) == "distance")
+  updateColumnIndexes();
+
+  if(index.isValid() && index.column() == colDistance)
   {
     if(role == Qt::DisplayRole)
-      return Unit::distMeter(buildPos(mapToSource(index).row()).distanceMeterTo(centerPos), false);
+      return Unit::distMeter(rowGeo(mapToSource(index).row()).distMeter, false);
     else if(role == Qt::TextAlignmentRole)
       return Qt::AlignRight;
   }
-  else if(sourceSqlModel->getColumnName(index.column()) == "heading")
+  else if(index.isValid() && index.column() == colHeading)
   {
     if(role == Qt::DisplayRole)
     {
-      float heading = normalizeCourse(centerPos.angleDegTo(buildPos(mapToSource(index).row())));
+      float heading = rowGeo(mapToSource(index).row()).headingDeg;
       if(heading < map::INVALID_COURSE_VALUE)
         return QLocale().toString(heading, 'f', 0);
       else
@@ -191,5 +241,5 @@ QVariant SqlProxyModel::data(const QModelIndex& index, int role) const
 
 Pos SqlProxyModel::buildPos(int row) const
 {
-  return Pos(sourceSqlModel->getRawData(row, "lonx").toFloat(), sourceSqlModel->getRawData(row, "laty").toFloat());
+  return Pos(sourceSqlModel->getRawData(row, colLonX).toFloat(), sourceSqlModel->getRawData(row, colLatY).toFloat());
 }
@@ -31,6 +31,9 @@ class SqlModel;
  * and direction.
  * Dynamic loading on demand (like the SQL model does) does not work with this model. Therefore all results
  * have to be fetched.
+ *
+ * Distance and heading to the center are calculated once per source row and kept in a flat array which is
+ * used for filtering, sorting and display. The array is cleared if the center or the source query changes.
  */
 class SqlProxyModel :
   public QSortFilterProxyModel
@@ -62,9 +65,24 @@ private:
   virtual bool filterAcceptsRow(int sourceRow, const QModelIndex&) const override;
   virtual bool lessThan(const QModelIndex& sourceLeft, const QModelIndex& sourceRight) const override;
 
-  bool matchDistance(const atools::geo::Pos& pos) const;
+  /* Distance and heading from center for one source row */
+  struct RowGeo
+  {
+    float distMeter, headingDeg;
+  };
+
+  bool matchDistance(float distMeter) const;
   atools::geo::Pos buildPos(int row) const;
 
+  /* Get distance and heading for source row. Calculates values for all rows up to this one if not done yet. */
+  RowGeo rowGeo(int sourceRow) const;
+
+  /* Get source column indexes for current query if not done yet */
+  void updateColumnIndexes() const;
+
+  /* Clear distances, headings and column indexes. Called on center change and source model reset. */
+  void clearRowCache();
+
   /* Direction filter ranges are decreased by this value on each side */
   static float Q_DECL_CONSTEXPR DIR_RANGE_DEG = 22.5f;
 
@@ -79,6 +97,15 @@ private:
   sqlmodeltypes::SearchDirection direction;
   float minDistMeter = 0.f, maxDistMeter = 0.f;
 
+  /* Indexed by source row */
+  mutable QVector<RowGeo> rowGeoCache;
+
+  /* Source model column indexes. Valid if columnIndexesValid is true. */
+  mutable int colLonX = -1, colLatY = -1, colDistance = -1, colHeading = -1;
+  mutable bool columnIndexesValid = false;
+
+  /* Log sort time */
+  bool benchmark = false;
 };
 
 #endif // LITTLENAVMAP_SQLPROXYMODEL_H
@@ -32,6 +32,7 @@
 
 #include <QDataStream>
 #include <QElapsedTimer>
+#include <QStringBuilder>
 
 using atools::sql::SqlDatabase;
 using atools::sql::SqlTransaction;
@@ -132,6 +133,11 @@ void TrackManager::loadTracks(const TrackVectorType& tracks, bool onlyValid)
     if(onlyValid && (now < track.validFrom || now > track.validTo))
       continue;
 
+    // Build key from all values relevant for the route network
+    trackSetKey = qHash(atools::charToStr(track.type) % track.name % track.route.join(" "), trackSetKey);
+    trackSetKey = qHash(track.eastLevels, trackSetKey);
+    trackSetKey = qHash(track.westLevels, trackSetKey);
+
     // Add or increment fragment number for a new name
     if(nameFragmentHash.contains(track.name))
       nameFragmentHash[track.name]++;
@@ -425,6 +431,7 @@ bool TrackManager::addTrackmeta(QHash<std::pair<TrackType, QString>, SqlRecord>&
 
 void TrackManager::clearTracks()
 {
+  trackSetKey = 0;
   deleteAllRows();
   deleteAllRows("trackpoint");
   deleteAllRows("trackmeta");
@@ -59,6 +59,13 @@ public:
   /* Clears track tables in database. */
   void clearTracks();
 
+  /* Hash over all tracks loaded into the database. 0 if no tracks are loaded.
+   * Used to detect changes of the track set for route network caching. */
+  uint getTrackSetKey() const
+  {
+    return trackSetKey;
+  }
+
   /* Get number of tracks for each type */
   QMap<atools::track::TrackType, int> getNumTracks();
 
@@ -85,6 +92,7 @@ private:
                         *ndbQuery = nullptr, *vorQuery = nullptr, *airwayQuery = nullptr;
 
   bool verbose = false;
+  uint trackSetKey = 0;
 
   /* Database for querying navaids. */
   atools::sql::SqlDatabase *dbNav = nullptr;
@@ -26,6 +26,9 @@
 #include "info/infocontroller.h"
 #include "route/routecontroller.h"
 #include "web/webmapcontroller.h"
+#include "web/webmapimagecache.h"
+#include "web/webmaprequestqueue.h"
+#include "web/webaircraftfeed.h"
 #include "webapi/webapicontroller.h"
 #include "web/webtools.h"
 #include "web/webapp.h"
@@ -38,17 +41,24 @@
 
 #include <QBuffer>
 #include <QCoreApplication>
+#include <QCryptographicHash>
 #include <QDir>
 #include <QUrl>
 #include <QPainter>
+#include <QStringBuilder>
+#include <QThread>
 #include <QtWidgets/QApplication>
 
 using namespace stefanfrings;
 
-RequestHandler::RequestHandler(QObject *parent, WebMapController *webMapController,WebApiController *webApiController,
-                               HtmlInfoBuilder *htmlInfoBuilderParam, bool verboseParam)
-  : HttpRequestHandler(parent), webApiController(webApiController), htmlInfoBuilder(htmlInfoBuilderParam), verbose(verboseParam)
+RequestHandler::RequestHandler(QObject *parent, WebMapController *webMapControllerParam,WebApiController *webApiController,
+                               WebAircraftFeed *aircraftFeedParam, HtmlInfoBuilder *htmlInfoBuilderParam, bool verboseParam)
+  : HttpRequestHandler(parent), webApiController(webApiController), webMapController(webMapControllerParam),
+  aircraftFeed(aircraftFeedParam), htmlInfoBuilder(htmlInfoBuilderParam), verbose(verboseParam)
 {
+  mapRequestQueue = webMapControllerParam->getRequestQueue();
+  mapImageCache = webMapControllerParam->getImageCache();
+
   if(verbose)
     qDebug() << Q_FUNC_INFO;
 
@@ -99,6 +109,16 @@ void RequestHandler::service(HttpRequest& request, HttpResponse& response)
     // ===========================================================================
     // Requests for map images only - either with or without session
     handleMapImage(request, response);
+  else if(path == QLatin1String("/aircraftfeed"))
+    // ===========================================================================
+    // Push user and AI aircraft updates without going through the main thread
+    handleAircraftFeed(request, response);
+  else if(path == QLatin1String("/mapimage/statistics"))
+  {
+    // Queue depth, coalesced requests and latency for map images
+    response.setHeader("Content-Type", "text/plain");
+    response.write((mapRequestQueue->getStatisticsText() % mapImageCache->getStatisticsText()).toUtf8(), true);
+  }
   else if(path.startsWith(webApiController->webApiPathPrefix))
     // ===========================================================================
     // Requests for web api - either with or without session
@@ -195,8 +215,12 @@ inline void RequestHandler::handleMapImage(HttpRequest& request, HttpResponse& r
   // Extract values from parameter list ===========================================
   int width = params.asInt(QStringLiteral(u"width"), 0);
   int height = params.asInt(QStringLiteral(u"height"), 0);
+  int quality = params.asInt(QStringLiteral(u"quality"), -1);
+
+  // Image format, jpg is default and only jpg and png allowed ===========================================
+  QString format = params.asEnum(QStringLiteral(u"format"), QStringLiteral(u"jpg"), {QStringLiteral(u"jpg"), QStringLiteral(u"png")});
 
-  MapPixmap mapPixmap;
+  WebMapImage image;
 
   if(params.has("session"))
   {
@@ -222,35 +246,45 @@ inline void RequestHandler::handleMapImage(HttpRequest& request, HttpResponse& r
 
     if(mapcmd == QLatin1String("user"))
       // Show user aircraft
-      mapPixmap = emit getPixmapObject(width, height, web::USER_AIRCRAFT, QLatin1String(""), requestedDistanceKm);
+      image = mapImage(QString("user|%1").arg(requestedDistanceKm), true /* cache */, width, height, format, quality, [&]() -> MapPixmap {
+        return emit getPixmapObject(width, height, web::USER_AIRCRAFT, QLatin1String(""), requestedDistanceKm);
+      });
     else if(mapcmd == QLatin1String("route"))
       // Center flight plan
-      mapPixmap = emit getPixmapObject(width, height, web::ROUTE, QLatin1String(""), requestedDistanceKm);
+      image = mapImage(QString("route|%1").arg(requestedDistanceKm), true /* cache */, width, height, format, quality, [&]() -> MapPixmap {
+        return emit getPixmapObject(width, height, web::ROUTE, QLatin1String(""), requestedDistanceKm);
+      });
     else if(mapcmd == QLatin1String("airport"))
+    {
       // Show an airport by ident
-      mapPixmap = emit getPixmapObject(width, height, web::AIRPORT, params.asStr(
-                                         QStringLiteral(u"airport")).toUpper(), requestedDistanceKm);
+      QString ident = params.asStr(QStringLiteral(u"airport")).toUpper();
+      image = mapImage(QString("airport|%1|%2").arg(ident).arg(requestedDistanceKm), true /* cache */, width, height, format, quality, [&]() -> MapPixmap {
+        return emit getPixmapObject(width, height, web::AIRPORT, ident, requestedDistanceKm);
+      });
+    }
     else
     {
         // When zooming in or out use the last corrected distance (i.e. actual distance) as a base
         // Zoom or move map
-        mapPixmap = emit getPixmapPosDistance(width, height,
-                                              atools::geo::Pos(session.get("lon").toFloat(),
-                                                               session.get("lat").toFloat()),
-                                              (mapcmd == QLatin1String("in") || mapcmd == QLatin1String("out")) ?
-                                                                       session.get("corrected_distance").toFloat() : requestedDistanceKm, mapcmd);
+        atools::geo::Pos pos(session.get("lon").toFloat(), session.get("lat").toFloat());
+        float distanceKm = (mapcmd == QLatin1String("in") || mapcmd == QLatin1String("out")) ?
+                           session.get("corrected_distance").toFloat() : requestedDistanceKm;
+        QString key = QString("pos|%1|%2|%3|%4").arg(pos.getLonX()).arg(pos.getLatY()).arg(distanceKm).arg(mapcmd);
+        image = mapImage(key, true /* cache */, width, height, format, quality, [&]() -> MapPixmap {
+          return emit getPixmapPosDistance(width, height, pos, distanceKm, mapcmd);
+        });
     }
 
-    if(mapPixmap.hasNoError())
+    if(image.error.isEmpty())
     {
       // Push results from last map call into session
-      session.set("requested_distance", QVariant(mapPixmap.requestedDistanceKm));
-      session.set("corrected_distance", QVariant(mapPixmap.correctedDistanceKm));
-      session.set("lon", mapPixmap.pos.getLonX());
-      session.set("lat", mapPixmap.pos.getLatY());
+      session.set("requested_distance", QVariant(image.requestedDistanceKm));
+      session.set("corrected_distance", QVariant(image.correctedDistanceKm));
+      session.set("lon", image.pos.getLonX());
+      session.set("lat", image.pos.getLatY());
     }
     else
-      return showErrorPixmap(response, width, height, 404, mapPixmap.error);
+      return showErrorPixmap(response, width, height, 404, image.error);
   }
   else
   {
@@ -261,19 +295,31 @@ inline void RequestHandler::handleMapImage(HttpRequest& request, HttpResponse& r
     // Session-less / state-less calls ============================================
     if(params.has(QStringLiteral(u"user")))
       // User aircraft =======================
-      mapPixmap = emit getPixmapObject(width, height, web::USER_AIRCRAFT, QLatin1String(""), requestedDistanceKm);
+      image = mapImage(QString("user|%1").arg(requestedDistanceKm), true /* cache */, width, height, format, quality, [&]() -> MapPixmap {
+        return emit getPixmapObject(width, height, web::USER_AIRCRAFT, QLatin1String(""), requestedDistanceKm);
+      });
     else if(params.has(QStringLiteral(u"route")))
       // Center flight plan =======================
-      mapPixmap = emit getPixmapObject(width, height, web::ROUTE, QLatin1String(""), requestedDistanceKm);
+      image = mapImage(QString("route|%1").arg(requestedDistanceKm), true /* cache */, width, height, format, quality, [&]() -> MapPixmap {
+        return emit getPixmapObject(width, height, web::ROUTE, QLatin1String(""), requestedDistanceKm);
+      });
     else if(params.has(QStringLiteral(u"airport")))
+    {
       // Show airport =======================
-      mapPixmap = emit getPixmapObject(width, height, web::AIRPORT, params.asStr("airport"), requestedDistanceKm);
+      QString ident = params.asStr("airport");
+      image = mapImage(QString("airport|%1|%2").arg(ident).arg(requestedDistanceKm), true /* cache */, width, height, format, quality, [&]() -> MapPixmap {
+        return emit getPixmapObject(width, height, web::AIRPORT, ident, requestedDistanceKm);
+      });
+    }
     else if(params.has(QStringLiteral(u"leftlon")) && params.has(QStringLiteral(u"toplat")) && params.has(QStringLiteral(u"rightlon")) && params.has(QStringLiteral(u"bottomlat")))
     {
       // Show rectangle =======================
       atools::geo::Rect rect(params.asFloat(QStringLiteral(u"leftlon")), params.asFloat(QStringLiteral(u"toplat")),
                              params.asFloat(QStringLiteral(u"rightlon")), params.asFloat(QStringLiteral(u"bottomlat")));
-      mapPixmap = emit getPixmapRect(width, height, rect);
+      QString key = QString("rect|%1|%2|%3|%4").arg(rect.getWest()).arg(rect.getNorth()).arg(rect.getEast()).arg(rect.getSouth());
+      image = mapImage(key, true /* cache */, width, height, format, quality, [&]() -> MapPixmap {
+        return emit getPixmapRect(width, height, rect);
+      });
     }
     else if(params.has(QStringLiteral(u"distance")) || (params.has(QStringLiteral(u"lon")) && params.has(QStringLiteral(u"lat"))))
     {
@@ -285,51 +331,180 @@ inline void RequestHandler::handleMapImage(HttpRequest& request, HttpResponse& r
         pos.setLatY(params.asFloat(QStringLiteral(u"lat")));
       }
 
-      mapPixmap = emit getPixmapPosDistance(width, height, pos, requestedDistanceKm, QLatin1String(""));
+      // Not cached if position is missing since the view falls back to the current GUI map center
+      QString key = QString("pos|%1|%2|%3|").arg(pos.getLonX()).arg(pos.getLatY()).arg(requestedDistanceKm);
+      image = mapImage(key, pos.isValid(), width, height, format, quality, [&]() -> MapPixmap {
+        return emit getPixmapPosDistance(width, height, pos, requestedDistanceKm, QLatin1String(""));
+      });
     }
     else
-      // Show current map view =======================
-      mapPixmap = emit getPixmap(width, height);
+      // Show current map view - not cached since panning the GUI map does not change the generation ============
+      image = mapImage(QStringLiteral(u"current"), false /* cache */, width, height, format, quality, [&]() -> MapPixmap {
+        return emit getPixmap(width, height);
+      });
 
-    if(mapPixmap.hasError())
+    if(!image.error.isEmpty())
       // Show error message as image
-      return showErrorPixmap(response, width, height, 404, mapPixmap.error);
+      return showErrorPixmap(response, width, height, 404, image.error);
   }
 
-  if(mapPixmap.isValid())
+  if(!image.bytes.isEmpty())
+  {
+    if(!image.etag.isEmpty())
+    {
+      // Let clients revalidate using If-None-Match
+      response.setHeader("ETag", image.etag);
+      response.setHeader("Cache-Control", "no-cache");
+    }
+
+    if(!image.etag.isEmpty() && request.getHeader("If-None-Match") == image.etag)
+    {
+      // Client has this image already
+      mapImageCache->notModified();
+      response.setStatus(304, "Not Modified");
+      response.write(QByteArray(), true);
+    }
+    else
+    {
+      response.setHeader("Content-Type", image.contentType);
+      response.write(image.bytes);
+    }
+  }
+  else
+    // Show error message as image
+    showErrorPixmap(response, width, height, 404, QStringLiteral(u"invalid pixmap"));
+}
+
+WebMapImage RequestHandler::mapImage(const QString& key, bool cache, int width, int height, const QString& format, int quality,
+                                     const std::function<MapPixmap()>& function)
+{
+  WebMapImage image;
+  QString fullKey;
+  quint64 generation = 0L;
+
+  if(cache)
+  {
+    // Look for an encoded image of the current map state ===================
+    fullKey = key % QString("|%1x%2|%3|%4").arg(width).arg(height).arg(format).arg(quality);
+    generation = webMapController->getMapStateGeneration();
+    if(mapImageCache->get(fullKey, generation, image))
+      return image;
+  }
+
+  // Render using queue which passes request to main thread ===================
+  MapPixmap mapPixmap = mapRequestQueue->request(key % QString("|%1x%2").arg(width).arg(height), function);
+
+  if(mapPixmap.hasError())
+    image.error = mapPixmap.error;
+  else if(mapPixmap.isValid())
   {
     // ===========================================================================
     // Write pixmap as image
-    QByteArray bytes;
-    QBuffer buffer(&bytes);
+    QBuffer buffer(&image.bytes);
     buffer.open(QIODevice::WriteOnly);
 
-    int quality = params.asInt(QStringLiteral(u"quality"), -1);
-
-    // Image format, jpg is default and only jpg and png allowed ===========================================
-    QString format = params.asEnum(QStringLiteral(u"format"), QStringLiteral(u"jpg"), {QStringLiteral(u"jpg"), QStringLiteral(u"png")});
-
     if(format == QLatin1String("jpg"))
     {
-      response.setHeader("Content-Type", "image/jpeg");
+      image.contentType = "image/jpeg";
       mapPixmap.pixmap.save(&buffer, "JPG", quality);
     }
     else if(format == QLatin1String("png"))
     {
-      response.setHeader("Content-Type", "image/png");
+      image.contentType = "image/png";
       mapPixmap.pixmap.save(&buffer, "PNG", quality);
     }
     else
       // Should never happen
       qWarning() << Q_FUNC_INFO << "invalid format";
 
-    response.write(bytes);
+    // Tag depends on content only - a re-rendered identical image can be answered with "304 Not Modified"
+    if(!image.bytes.isEmpty())
+      image.etag = '"' + QCryptographicHash::hash(image.bytes, QCryptographicHash::Md5).toHex() + '"';
+
+    image.pos = mapPixmap.pos;
+    image.requestedDistanceKm = mapPixmap.requestedDistanceKm;
+    image.correctedDistanceKm = mapPixmap.correctedDistanceKm;
+
+    if(!fullKey.isEmpty() && !image.bytes.isEmpty())
+      // Use generation from before rendering to avoid caching an outdated image for a newer state
+      mapImageCache->insert(fullKey, generation, image);
   }
-  else
-    // Show error message as image
-    showErrorPixmap(response, width, height, 404, QStringLiteral(u"invalid pixmap"));
+  return image;
 }
 
+void RequestHandler::handleAircraftFeed(HttpRequest& request, HttpResponse& response)
+{
+  Parameter params(request, verbose);
+
+  // Include AI and online shadow aircraft
+  bool ai = params.has(QStringLiteral(u"ai"));
+
+  // Minimum time between two updates for this client
+  unsigned long intervalMs = static_cast<unsigned long>(std::max(params.asInt(QStringLiteral(u"interval"), 500), 100));
+
+  response.setHeader("Cache-Control", "no-cache");
+  WebAircraftFrame frame;
+
+  if(params.has(QStringLiteral(u"poll")))
+  {
+    // ===========================================================================
+    // Long-poll - wait for a packet newer than "since" and return it as JSON
+    quint64 since = params.asStr(QStringLiteral(u"since"), QStringLiteral(u"0")).toULongLong();
+    response.setHeader("Content-Type", "application/json");
+
+    if(aircraftFeed->waitForFrame(since, 10000, frame))
+    {
+      response.setHeader("Sequence", QByteArray::number(frame.sequence));
+      response.write(ai ? frame.userAi : frame.user, true);
+    }
+    else
+    {
+      response.setStatus(204, "No Content");
+      response.write(QByteArray(), true);
+    }
+  }
+  else if(!aircraftFeed->addStreamClient())
+  {
+    // ===========================================================================
+    // Too many streaming clients - each one blocks a server thread. Tell client to retry or use long-poll.
+    qWarning() << Q_FUNC_INFO << "Too many aircraft feed streaming clients" << WebAircraftFeed::MAX_STREAM_CLIENTS;
+    response.setStatus(503, "Service Unavailable");
+    response.setHeader("Content-Type", "text/plain");
+    response.setHeader("Retry-After", "10");
+    response.write("Too many streaming clients. Use \"poll\" parameter for long-poll requests.", true);
+  }
+  else
+  {
+    // ===========================================================================
+    // Server-sent events - keep connection open and send latest packet at most every intervalMs
+    response.setHeader("Content-Type", "text/event-stream");
+
+    quint64 sequence = 0L;
+    while(response.isConnected() && !aircraftFeed->isStopped())
+    {
+      if(aircraftFeed->waitForFrame(sequence, 5000, frame))
+      {
+        sequence = frame.sequence;
+        response.write("id: " % QByteArray::number(frame.sequence) % "\ndata: " % (ai ? frame.userAi : frame.user) % "\n\n");
+        response.flush();
+
+        // Rate limit - packets arriving in the meantime are skipped and only the latest is sent
+        QThread::msleep(intervalMs);
+      }
+      else if(!aircraftFeed->isStopped())
+      {
+        // Comment line to detect closed connections if no simulator is connected
+        response.write(": keepalive\n\n");
+        response.flush();
+      }
+    }
+
+    aircraftFeed->removeStreamClient();
+
+    if(response.isConnected())
+      response.write(QByteArray(), true);
+  }
+}
 
 inline void RequestHandler::handleWebApiRequest(HttpRequest& request, HttpResponse& response)
 {
@@ -347,6 +522,14 @@ inline void RequestHandler::handleWebApiRequest(HttpRequest& request, HttpRespon
   // Call API in-sync
   WebApiResponse result = emit serviceWebApi(apiRequest);
 
+  if(result.continuation)
+  {
+    // Finish long running action in this thread
+    std::function<void(WebApiResponse& response)> continuation = result.continuation;
+    result.continuation = nullptr;
+    continuation(result);
+  }
+
   // Map API response
   response.setStatus(result.status);
   QMultiMap<QByteArray, QByteArray>::iterator i;
@@ -22,12 +22,15 @@
 
 #include "web/webflags.h"
 #include "web/webmapcontroller.h"
+#include "web/webmapimagecache.h"
 #include "webapi/webapicontroller.h"
 #include "webapi/webapirequest.h"
 #include "webapi/webapiresponse.h"
 
 #include <QPixmap>
 
+#include <functional>
+
 #include "geo/pos.h"
 #include "geo/rect.h"
 #include "route/route.h"
@@ -39,6 +42,9 @@ class HttpSession;
 }
 
 class HtmlInfoBuilder;
+class WebMapRequestQueue;
+class WebMapImageCache;
+class WebAircraftFeed;
 
 /*
  * Handles all HTTP server requests including stateless and stateful. Maintains a session for the stateful page.
@@ -55,7 +61,7 @@ class RequestHandler :
 public:
   /* Prepare connections to other objects. Handler is ready to accept connections when instantiated. */
   RequestHandler(QObject *parent, WebMapController *webMapController, WebApiController *webApiController,
-                 HtmlInfoBuilder *htmlInfoBuilderParam, bool verboseParam);
+                 WebAircraftFeed *aircraftFeedParam, HtmlInfoBuilder *htmlInfoBuilderParam, bool verboseParam);
   virtual ~RequestHandler() override;
 
   /* Doing all the work right here. */
@@ -93,6 +99,16 @@ private:
   /* Handle stateful and stateless map image requests. */
   void handleMapImage(stefanfrings::HttpRequest& request, stefanfrings::HttpResponse& response);
 
+  /* Get encoded image from cache or pass request to the queue which coalesces identical requests and encode the result.
+   * key has to contain all parameters except width, height, format and quality.
+   * Caching is disabled if cache is false. Identical requests are coalesced nevertheless. */
+  WebMapImage mapImage(const QString& key, bool cache, int width, int height, const QString& format, int quality,
+                       const std::function<MapPixmap()>& function);
+
+  /* Stream user and AI aircraft updates as server-sent events or answer a long-poll request.
+   * Streaming is limited to WebAircraftFeed::MAX_STREAM_CLIENTS clients. Further ones get status 503. */
+  void handleAircraftFeed(stefanfrings::HttpRequest& request, stefanfrings::HttpResponse& response);
+
   /* Handle stateful and stateless api requests. */
   void handleWebApiRequest(stefanfrings::HttpRequest& request, stefanfrings::HttpResponse& response);
 
@@ -106,6 +122,10 @@ private:
   stefanfrings::HttpSession getSession(stefanfrings::HttpRequest& request, stefanfrings::HttpResponse& response);
 
   WebApiController *webApiController;
+  WebMapController *webMapController;
+  WebMapRequestQueue *mapRequestQueue;
+  WebMapImageCache *mapImageCache;
+  WebAircraftFeed *aircraftFeed;
   HtmlInfoBuilder *htmlInfoBuilder;
 
   bool verbose = false;
@@ -0,0 +1,151 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "web/webaircraftfeed.h"
+
+#include "fs/sc/simconnectdata.h"
+
+#include <QDateTime>
+#include <QDeadlineTimer>
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+using atools::fs::sc::SimConnectAircraft;
+using atools::fs::sc::SimConnectData;
+
+WebAircraftFeed::WebAircraftFeed(QObject *parent)
+  : QObject(parent)
+{
+  stopped.store(false);
+  streamClients.store(0);
+  lastClientRequest.store(0L);
+}
+
+WebAircraftFeed::~WebAircraftFeed()
+{
+  stop();
+}
+
+QJsonObject WebAircraftFeed::aircraftToJson(const SimConnectAircraft& aircraft)
+{
+  // Keep names short since this is sent for every packet
+  const atools::geo::Pos& pos = aircraft.getPosition();
+  QJsonObject obj;
+  obj.insert("id", static_cast<qint64>(aircraft.getObjectId()));
+  obj.insert("lat", static_cast<double>(pos.getLatY()));
+  obj.insert("lon", static_cast<double>(pos.getLonX()));
+  obj.insert("alt", static_cast<double>(aircraft.getActualAltitudeFt()));
+  obj.insert("gs", static_cast<double>(aircraft.getGroundSpeedKts()));
+  obj.insert("hdg", static_cast<double>(aircraft.getHeadingDegTrue()));
+  obj.insert("vs", static_cast<double>(aircraft.getVerticalSpeedFeetPerMin()));
+  obj.insert("gnd", aircraft.isOnGround());
+  return obj;
+}
+
+void WebAircraftFeed::simDataChanged(const simdata::PacketPtr& packet)
+{
+  const SimConnectData& simulatorData = *packet;
+
+  // Avoid serialization if nobody is listening
+  if(stopped.load() || QDateTime::currentMSecsSinceEpoch() - lastClientRequest.load() > CLIENT_TIMEOUT_MS)
+    return;
+
+  const atools::fs::sc::SimConnectUserAircraft& userAircraft = simulatorData.getUserAircraftConst();
+  if(!userAircraft.isValid())
+    return;
+
+  // Serialize once in main thread for all clients =============================
+  QJsonObject user = aircraftToJson(userAircraft);
+  user.insert("ias", static_cast<double>(userAircraft.getIndicatedSpeedKts()));
+  user.insert("ialt", static_cast<double>(userAircraft.getIndicatedAltitudeFt()));
+
+  QJsonObject root;
+  root.insert("user", user);
+  QByteArray userBytes = QJsonDocument(root).toJson(QJsonDocument::Compact);
+
+  QJsonArray ai;
+  for(const SimConnectAircraft& aircraft : simulatorData.getAiAircraftConst())
+  {
+    QJsonObject obj = aircraftToJson(aircraft);
+    obj.insert("reg", aircraft.getAirplaneRegistration());
+    obj.insert("type", aircraft.getAirplaneModel());
+    if(aircraft.isOnlineShadow())
+      obj.insert("online", true);
+    ai.append(obj);
+  }
+  root.insert("ai", ai);
+  QByteArray userAiBytes = QJsonDocument(root).toJson(QJsonDocument::Compact);
+
+  QMutexLocker locker(&mutex);
+  frame.sequence++;
+  frame.user = userBytes;
+  frame.userAi = userAiBytes;
+  frameCondition.wakeAll();
+}
+
+bool WebAircraftFeed::waitForFrame(quint64 sequence, unsigned long timeoutMs, WebAircraftFrame& frameParam)
+{
+  lastClientRequest.store(QDateTime::currentMSecsSinceEpoch());
+
+  // Deadline keeps the total timeout when waking up without a new frame
+  QDeadlineTimer deadline(static_cast<qint64>(timeoutMs));
+
+  QMutexLocker locker(&mutex);
+  while(frame.sequence <= sequence && !stopped.load())
+  {
+    // Returns false on timeout - loop again on spurious wakeups
+    if(!frameCondition.wait(&mutex, deadline))
+      break;
+  }
+
+  if(frame.sequence > sequence && !stopped.load())
+  {
+    frameParam = frame;
+    return true;
+  }
+  return false;
+}
+
+void WebAircraftFeed::stop()
+{
+  QMutexLocker locker(&mutex);
+  stopped.store(true);
+  frameCondition.wakeAll();
+}
+
+void WebAircraftFeed::start()
+{
+  QMutexLocker locker(&mutex);
+  stopped.store(false);
+}
+
+bool WebAircraftFeed::addStreamClient()
+{
+  if(streamClients.fetch_add(1) >= MAX_STREAM_CLIENTS)
+  {
+    streamClients.fetch_sub(1);
+    return false;
+  }
+  return true;
+}
+
+void WebAircraftFeed::removeStreamClient()
+{
+  streamClients.fetch_sub(1);
+}
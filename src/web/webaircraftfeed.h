@@ -0,0 +1,119 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_WEBAIRCRAFTFEED_H
+#define LNM_WEBAIRCRAFTFEED_H
+
+#include "connect/simdatapacket.h"
+
+#include <QMutex>
+#include <QObject>
+#include <QWaitCondition>
+
+#include <atomic>
+
+namespace atools {
+namespace fs {
+namespace sc {
+class SimConnectData;
+class SimConnectAircraft;
+}
+}
+}
+
+class QJsonObject;
+
+/*
+ * One serialized simulator packet as compact JSON. Shared by all streaming clients.
+ */
+struct WebAircraftFrame
+{
+  /* Increased for each packet. Starts with 1. */
+  quint64 sequence = 0L;
+
+  /* User aircraft only and user aircraft with AI and online shadow aircraft */
+  QByteArray user, userAi;
+};
+
+/*
+ * Serializes user and AI aircraft once per simulator packet and hands the result to any number
+ * of web server threads waiting for updates.
+ *
+ * simDataChanged() is called in the main thread. All other methods are thread safe.
+ * Packets are only serialized if a client asked for updates recently.
+ *
+ * Each streaming client occupies one web server thread for the whole connection. The number of streaming clients
+ * is therefore limited to MAX_STREAM_CLIENTS to keep threads free for pages, map images and long-poll requests.
+ */
+class WebAircraftFeed :
+  public QObject
+{
+  Q_OBJECT
+
+public:
+  explicit WebAircraftFeed(QObject *parent);
+  virtual ~WebAircraftFeed() override;
+
+  WebAircraftFeed(const WebAircraftFeed& other) = delete;
+  WebAircraftFeed& operator=(const WebAircraftFeed& other) = delete;
+
+  /* Serialize packet and wake up all waiting clients */
+  void simDataChanged(const simdata::PacketPtr& packet);
+
+  /* Wait until a frame newer than sequence is available and copy it into frame.
+   * Returns false on timeout or if the feed was stopped. */
+  bool waitForFrame(quint64 sequence, unsigned long timeoutMs, WebAircraftFrame& frame);
+
+  /* Stop all waiting clients. Used when shutting down the server. */
+  void stop();
+
+  /* Accept clients again after stop() */
+  void start();
+
+  bool isStopped() const
+  {
+    return stopped.load();
+  }
+
+  /* Register a streaming client. Returns false if MAX_STREAM_CLIENTS are already connected.
+   * Call removeStreamClient() when done if true was returned. */
+  bool addStreamClient();
+  void removeStreamClient();
+
+  /* Maximum number of concurrent server-sent event clients. Web server has 32 threads by default. */
+  static Q_DECL_CONSTEXPR int MAX_STREAM_CLIENTS = 8;
+
+private:
+  static QJsonObject aircraftToJson(const atools::fs::sc::SimConnectAircraft& aircraft);
+
+  /* Stop serializing if no client asked for this period */
+  static Q_DECL_CONSTEXPR qint64 CLIENT_TIMEOUT_MS = 30000L;
+
+  WebAircraftFrame frame;
+  std::atomic_bool stopped;
+
+  /* Number of connected streaming clients */
+  std::atomic_int streamClients;
+
+  /* Milliseconds since epoch of last client request */
+  std::atomic<qint64> lastClientRequest;
+
+  QMutex mutex;
+  QWaitCondition frameCondition;
+};
+
+#endif // LNM_WEBAIRCRAFTFEED_H
@@ -20,6 +20,7 @@
 #include "settings/settings.h"
 #include "web/requesthandler.h"
 #include "web/webmapcontroller.h"
+#include "web/webaircraftfeed.h"
 #include "webapi/webapicontroller.h"
 #include "web/webapp.h"
 #include "gui/helphandler.h"
@@ -63,6 +64,7 @@ WebController::WebController(QWidget *parent) :
 
   mapController = new WebMapController(parentWidget, verbose);
   apiController = new WebApiController(parentWidget, verbose);
+  aircraftFeed = new WebAircraftFeed(this);
 
   htmlInfoBuilder = new HtmlInfoBuilder(parent, mapController->getMapPaintWidget(), true /*info*/, true /*print*/);
   updateSettings();
@@ -105,7 +107,8 @@ void WebController::startServer()
   // Start map
   mapController->init();
 
-  requestHandler = new RequestHandler(this, mapController, apiController, htmlInfoBuilder, verbose);
+  aircraftFeed->start();
+  requestHandler = new RequestHandler(this, mapController, apiController, aircraftFeed, htmlInfoBuilder, verbose);
 
   // Set port - always override configuration file
   listenerSettings.insert("port", port);
@@ -217,6 +220,9 @@ void WebController::stopServer()
 
   mapController->deInit();
 
+  // Let streaming connections return from the request handler
+  aircraftFeed->stop();
+
   if(listener != nullptr)
     listener->close();
 
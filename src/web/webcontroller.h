@@ -31,6 +31,7 @@ class HttpListener;
 class RequestHandler;
 class WebMapController;
 class WebApiController;
+class WebAircraftFeed;
 class HtmlInfoBuilder;
 class QSettings;
 
@@ -114,6 +115,12 @@ public:
 
   WebMapController *getWebMapController() const;
 
+  /* Streams aircraft updates to web clients. Connect to simulator packets. */
+  WebAircraftFeed *getAircraftFeed() const
+  {
+    return aircraftFeed;
+  }
+
   /* Need to clear caches and tear down queries in map widget before switching database */
   void preDatabaseLoad();
 
@@ -133,6 +140,9 @@ private:
   /* Web API controller */
   WebApiController *apiController = nullptr;
 
+  /* Serialized simulator packets for streaming clients */
+  WebAircraftFeed *aircraftFeed = nullptr;
+
   /* Handles all HTTP requests using templates or static */
   RequestHandler *requestHandler = nullptr;
 
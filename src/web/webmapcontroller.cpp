@@ -19,7 +19,15 @@
 
 #include "mapgui/mappaintwidget.h"
 #include "mapgui/mapwidget.h"
+#include "mapgui/mapscreenindex.h"
 #include "app/navapp.h"
+#include "common/constants.h"
+#include "settings/settings.h"
+#include "web/webmapimagecache.h"
+#include "web/webmaprequestqueue.h"
+#include "fs/sc/simconnectdata.h"
+
+#include <marble/GeoDataLatLonBox.h>
 
 #include <QDebug>
 #include <QPixmap>
@@ -28,33 +36,165 @@ WebMapController::WebMapController(QWidget *parent, bool verboseParam)
   : QObject(parent), parentWidget(parent), verbose(verboseParam)
 {
   qDebug() << Q_FUNC_INFO;
+
+  // Number of offscreen map widgets - each one needs memory for its own tile and query caches
+  poolSize = atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_WEBSERVER_MAP_POOL_SIZE, 2).toInt();
+  poolSize = std::max(1, std::min(poolSize, 8));
+
+  requestQueue = new WebMapRequestQueue;
+
+  // Memory budget for encoded images
+  int cacheMb = atools::settings::Settings::instance().getAndStoreValue(lnm::OPTIONS_WEBSERVER_IMAGE_CACHE_MB, 32).toInt();
+  imageCache = new WebMapImageCache(std::max(cacheMb, 0) * 1024 * 1024);
+
+  mapStateGeneration.store(0L);
 }
 
 WebMapController::~WebMapController()
 {
   qDebug() << Q_FUNC_INFO;
   deInit();
+  delete requestQueue;
+  delete imageCache;
 }
 
 void WebMapController::init()
 {
-  qDebug() << Q_FUNC_INFO;
+  qDebug() << Q_FUNC_INFO << "pool size" << poolSize;
 
   deInit();
 
-  // Create a map widget clone with the desired resolution
-  mapPaintWidget = new MapPaintWidget(parentWidget, false /* no real widget - hidden */);
+  for(int i = 0; i < poolSize; i++)
+  {
+    // Create a map widget clone with the desired resolution
+    MapPaintWidget *widget = new MapPaintWidget(parentWidget, false /* no real widget - hidden */);
+
+    // Activate painting
+    widget->setActive();
 
-  // Activate painting
-  mapPaintWidget->setActive();
+    mapPaintWidgets.append({widget, QString(), 0L});
+  }
 }
 
 void WebMapController::deInit()
 {
   qDebug() << Q_FUNC_INFO;
 
-  delete mapPaintWidget;
-  mapPaintWidget = nullptr;
+  for(PoolEntry& entry : mapPaintWidgets)
+    delete entry.widget;
+  mapPaintWidgets.clear();
+
+  requestQueue->clearStatistics();
+  imageCache->clear();
+}
+
+quint64 WebMapController::getMapStateGeneration() const
+{
+  // Sum of two increasing counters changes whenever one of them changes
+  MapWidget *mapWidget = NavApp::getMapWidgetGui();
+  return mapStateGeneration.load() + (mapWidget != nullptr ? mapWidget->getScreenIndex()->getContentGeneration() : 0L);
+}
+
+void WebMapController::mapStateChanged()
+{
+  mapStateGeneration++;
+}
+
+void WebMapController::simDataChanged(const simdata::PacketPtr& packet)
+{
+  const atools::fs::sc::SimConnectData& simulatorData = *packet;
+
+  if(mapPaintWidgets.isEmpty())
+    return;
+
+  const atools::fs::sc::SimConnectUserAircraft& aircraft = simulatorData.getUserAircraftConst();
+  if(isAiAircraftShown(simulatorData))
+    // AI moves all the time
+    mapStateChanged();
+  else if(aircraft.isValid())
+  {
+    // Ignore small changes which are not visible on the map
+    if(!lastAircraftPos.isValid() || !lastAircraftPos.almostEqual(aircraft.getPosition(), 0.0001f) ||
+       std::abs(lastAircraftHeading - aircraft.getHeadingDegTrue()) > 1.f)
+    {
+      lastAircraftPos = aircraft.getPosition();
+      lastAircraftHeading = aircraft.getHeadingDegTrue();
+      mapStateChanged();
+    }
+  }
+}
+
+bool WebMapController::isAiAircraftShown(const atools::fs::sc::SimConnectData& simulatorData)
+{
+  const QVector<atools::fs::sc::SimConnectAircraft>& aiAircraft = simulatorData.getAiAircraftConst();
+  if(aiAircraft.isEmpty())
+    return false;
+
+  QMutexLocker locker(&mapPaintWidgetMutex);
+  for(const PoolEntry& entry : qAsConst(mapPaintWidgets))
+  {
+    // Skip widgets which did not render a view yet or do not show AI
+    if(entry.viewKey.isEmpty() || !(entry.widget->getShownMapTypes() & (map::AIRCRAFT_AI | map::AIRCRAFT_AI_SHIP)))
+      continue;
+
+    const Marble::GeoDataLatLonBox& box = entry.widget->getCurrentViewBoundingBox();
+    for(const atools::fs::sc::SimConnectAircraft& ai : aiAircraft)
+    {
+      const atools::geo::Pos& pos = ai.getPosition();
+      if(pos.isValid() && box.contains(Marble::GeoDataCoordinates(pos.getLonX(), pos.getLatY(), 0.,
+                                                                  Marble::GeoDataCoordinates::Degree)))
+        return true;
+    }
+  }
+  return false;
+}
+
+QString WebMapController::viewKey(const atools::geo::Pos& pos, float distanceKm, int width, int height)
+{
+  return QString("%1|%2|%3|%4x%5").
+         arg(pos.getLonX(), 0, 'f', 4).arg(pos.getLatY(), 0, 'f', 4).arg(distanceKm, 0, 'f', 1).arg(width).arg(height);
+}
+
+MapPaintWidget *WebMapController::widgetForView(const QString& viewKey)
+{
+  if(mapPaintWidgets.isEmpty())
+    return nullptr;
+
+  // Look for a widget showing this view already and remember least recently used one
+  PoolEntry *found = nullptr, *leastRecent = &mapPaintWidgets.first();
+  for(PoolEntry& entry : mapPaintWidgets)
+  {
+    if(entry.viewKey == viewKey)
+    {
+      found = &entry;
+      break;
+    }
+
+    if(entry.lastUsed < leastRecent->lastUsed)
+      leastRecent = &entry;
+  }
+
+  if(found == nullptr)
+    found = leastRecent;
+
+  found->lastUsed = ++useCounter;
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << "widget" << (found - mapPaintWidgets.data()) << "key" << viewKey << "last" << found->viewKey;
+
+  return found->widget;
+}
+
+void WebMapController::updateWidgetView(MapPaintWidget *widget, const QString& viewKey)
+{
+  for(PoolEntry& entry : mapPaintWidgets)
+  {
+    if(entry.widget == widget)
+    {
+      entry.viewKey = viewKey;
+      break;
+    }
+  }
 }
 
 MapPixmap WebMapController::getPixmap(int width, int height)
@@ -117,10 +257,11 @@ MapPixmap WebMapController::getPixmapPosDistance(int width, int height, atools::
     }
   }
 
+  QMutexLocker locker(&mapPaintWidgetMutex);
+  MapPaintWidget *mapPaintWidget = widgetForView(viewKey(pos, distanceKm, width, height));
+
   if(mapPaintWidget != nullptr)
   {
-    QMutexLocker locker(&mapPaintWidgetMutex);
-
     // Copy all map settings
     mapPaintWidget->copySettings(*NavApp::getMapWidgetGui());
 
@@ -171,6 +312,7 @@ MapPixmap WebMapController::getPixmapPosDistance(int width, int height, atools::
     // Fill result object
     mappixmap.pixmap = mapPaintWidget->getPixmap(width, height);
     mappixmap.pos = mapPaintWidget->getCurrentViewCenterPos();
+    updateWidgetView(mapPaintWidget, viewKey(mappixmap.pos, mappixmap.requestedDistanceKm, width, height));
 
     return mappixmap;
   }
@@ -188,10 +330,14 @@ MapPixmap WebMapController::getPixmapRect(int width, int height, atools::geo::Re
 
   if(rect.isValid())
   {
+    QMutexLocker locker(&mapPaintWidgetMutex);
+    QString rectKey = QString("%1|%2|%3|%4|%5x%6").
+                      arg(rect.getWest(), 0, 'f', 4).arg(rect.getNorth(), 0, 'f', 4).
+                      arg(rect.getEast(), 0, 'f', 4).arg(rect.getSouth(), 0, 'f', 4).arg(width).arg(height);
+    MapPaintWidget *mapPaintWidget = widgetForView(rectKey);
+
     if(mapPaintWidget != nullptr)
     {
-      QMutexLocker locker(&mapPaintWidgetMutex);
-
       // Copy all map settings
       mapPaintWidget->copySettings(*NavApp::getMapWidgetGui());
 
@@ -207,6 +353,9 @@ MapPixmap WebMapController::getPixmapRect(int width, int height, atools::geo::Re
       mapPixmap.pixmap = mapPaintWidget->getPixmap(width, height);
       mapPixmap.pos = mapPaintWidget->getCurrentViewCenterPos();
 
+      // Remember rectangle since position and distance will not match a later rectangle request
+      updateWidgetView(mapPaintWidget, rectKey);
+
       return mapPixmap;
     }
     else
@@ -226,17 +375,35 @@ MapPixmap WebMapController::getPixmapRect(int width, int height, atools::geo::Re
 
 MapPaintWidget *WebMapController::getMapPaintWidget() const
 {
-  return mapPaintWidget;
+  return mapPaintWidgets.isEmpty() ? nullptr : mapPaintWidgets.first().widget;
+}
+
+void WebMapController::setTheme(const QString& themePath, const QString& themeId)
+{
+  for(PoolEntry& entry : mapPaintWidgets)
+    entry.widget->setTheme(themePath, themeId);
+  mapStateChanged();
+}
+
+void WebMapController::setKeys(const QHash<QString, QString>& keys)
+{
+  for(PoolEntry& entry : mapPaintWidgets)
+    entry.widget->setKeys(keys);
+  mapStateChanged();
 }
 
 void WebMapController::preDatabaseLoad()
 {
-  if(mapPaintWidget != nullptr)
-    mapPaintWidget->preDatabaseLoad();
+  for(PoolEntry& entry : mapPaintWidgets)
+  {
+    entry.widget->preDatabaseLoad();
+    entry.viewKey.clear();
+  }
 }
 
 void WebMapController::postDatabaseLoad()
 {
-  if(mapPaintWidget != nullptr)
-    mapPaintWidget->postDatabaseLoad();
+  for(PoolEntry& entry : mapPaintWidgets)
+    entry.widget->postDatabaseLoad();
+  mapStateChanged();
 }
@@ -18,15 +18,29 @@
 #ifndef LNM_WEBMAPCONTROLLER_H
 #define LNM_WEBMAPCONTROLLER_H
 
+#include "connect/simdatapacket.h"
 #include "web/webflags.h"
 
 #include "geo/rect.h"
 
 #include <QMutex>
 #include <QPixmap>
+#include <QVector>
+
+#include <atomic>
 
 class QPixmap;
 class MapPaintWidget;
+class WebMapRequestQueue;
+class WebMapImageCache;
+
+namespace atools {
+namespace fs {
+namespace sc {
+class SimConnectData;
+}
+}
+}
 
 /*
  * Result of a map image creating also covering error messages, center position, zoom distance and shown rectangle.
@@ -64,9 +78,12 @@ struct MapPixmap
 };
 
 /*
- * Wraps the MapPaintWidget and provides methods to retreive map images.
+ * Wraps a pool of MapPaintWidgets and provides methods to retreive map images.
  *
- * The map widget has a state, i.e. it remains in the last shown position and zoom value.
+ * Each map widget has a state, i.e. it remains in the last shown position and zoom value and has its own
+ * query objects and caches. A request is sent to the widget which already shows the requested view or
+ * to the least recently used one otherwise. This keeps several clients polling different views from
+ * invalidating each others caches.
  * Settings are copied from normal visible map window before rendering.
  *
  * This has to run in the main thread and event queue. Therefore, it is necessary to use queued signals to separate
@@ -104,19 +121,75 @@ public:
   /* Zoom to rectangel on map. */
   MapPixmap getPixmapRect(int width, int height, atools::geo::Rect rect, const QString& errorCase = tr("Invalid rectangle"));
 
-  /* Get the map paint widget */
+  /* Get the first map paint widget of the pool which is used for queries */
   MapPaintWidget* getMapPaintWidget() const;
 
+  /* Set theme or API keys for all widgets in the pool */
+  void setTheme(const QString& themePath, const QString& themeId);
+  void setKeys(const QHash<QString, QString>& keys);
+
+  /* Thread safe. Increased whenever something changes which is drawn on the map.
+   * Includes changes of marks and highlights in the GUI map which are copied to the web map. */
+  quint64 getMapStateGeneration() const;
+
+  /* Thread safe cache for encoded images used by the HTTP threads */
+  WebMapImageCache *getImageCache() const
+  {
+    return imageCache;
+  }
+
+  /* Thread safe queue used by the HTTP threads to coalesce identical requests */
+  WebMapRequestQueue *getRequestQueue() const
+  {
+    return requestQueue;
+  }
+
   /* Need to clear caches and tear down queries before switching database */
   void preDatabaseLoad();
 
   /* Initialize queries again after a database change */
   void postDatabaseLoad();
 
+  /* Increase map state generation to invalidate cached images. Connected to route, weather, online, userdata,
+   * logbook, track, options and map changes. Marks and highlights are covered by getMapStateGeneration(). */
+  void mapStateChanged();
+
+  /* Increase map state generation if user aircraft moved or AI is visible in one of the rendered views */
+  void simDataChanged(const simdata::PacketPtr& packet);
+
 private:
-  MapPaintWidget *mapPaintWidget = nullptr;
+  /* true if AI aircraft or ships are enabled and inside the view of a pool widget */
+  bool isAiAircraftShown(const atools::fs::sc::SimConnectData& simulatorData);
+
+  /* Get widget already showing the view identified by viewKey or the least recently used one */
+  MapPaintWidget *widgetForView(const QString& viewKey);
+
+  /* Remember view shown by widget after rendering so the next request from the same client is sent to it again */
+  void updateWidgetView(MapPaintWidget *widget, const QString& viewKey);
+
+  static QString viewKey(const atools::geo::Pos& pos, float distanceKm, int width, int height);
+
+  struct PoolEntry
+  {
+    MapPaintWidget *widget;
+    QString viewKey;
+    quint64 lastUsed;
+  };
+
+  QVector<PoolEntry> mapPaintWidgets;
+  int poolSize = 1;
+  quint64 useCounter = 0L;
   QMutex mapPaintWidgetMutex;
 
+  WebMapRequestQueue *requestQueue;
+  WebMapImageCache *imageCache;
+
+  std::atomic<quint64> mapStateGeneration;
+
+  /* Last user aircraft state which increased the generation */
+  atools::geo::Pos lastAircraftPos;
+  float lastAircraftHeading = 0.f;
+
   QWidget *parentWidget;
   bool verbose = false;
 };
@@ -0,0 +1,94 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "web/webmapimagecache.h"
+
+#include <QDebug>
+
+WebMapImageCache::WebMapImageCache(int maxBytes)
+{
+  cache.setMaxCost(maxBytes);
+}
+
+WebMapImageCache::~WebMapImageCache()
+{
+  qDebug() << Q_FUNC_INFO << getStatisticsText();
+}
+
+QString WebMapImageCache::fullKey(const QString& key, quint64 generation)
+{
+  return key + QString("|%1").arg(generation);
+}
+
+bool WebMapImageCache::get(const QString& key, quint64 generation, WebMapImage& image)
+{
+  QMutexLocker locker(&mutex);
+  numLookups++;
+
+  QString k = fullKey(key, generation);
+  Entry *entry = cache.object(k);
+  if(entry != nullptr)
+  {
+    if(entry->timestamp.msecsTo(QDateTime::currentDateTimeUtc()) < MAX_AGE_MS)
+    {
+      numHits++;
+      image = entry->image;
+      return true;
+    }
+    else
+      // Expired
+      cache.remove(k);
+  }
+  return false;
+}
+
+void WebMapImageCache::insert(const QString& key, quint64 generation, const WebMapImage& image)
+{
+  QString k = fullKey(key, generation);
+
+  QMutexLocker locker(&mutex);
+  int cost = image.bytes.size();
+  if(cost <= cache.maxCost())
+    cache.insert(k, new Entry{image, QDateTime::currentDateTimeUtc()}, cost);
+}
+
+void WebMapImageCache::notModified()
+{
+  QMutexLocker locker(&mutex);
+  numNotModified++;
+}
+
+void WebMapImageCache::clear()
+{
+  QMutexLocker locker(&mutex);
+  cache.clear();
+}
+
+QString WebMapImageCache::getStatisticsText() const
+{
+  QMutexLocker locker(&mutex);
+  return QString("image_cache_lookups=%1\n"
+                 "image_cache_hits=%2\n"
+                 "image_cache_hit_rate_percent=%3\n"
+                 "image_cache_not_modified=%4\n"
+                 "image_cache_entries=%5\n"
+                 "image_cache_bytes=%6\n"
+                 "image_cache_max_bytes=%7\n").
+         arg(numLookups).arg(numHits).
+         arg(numLookups > 0 ? static_cast<double>(numHits) * 100. / static_cast<double>(numLookups) : 0., 0, 'f', 1).
+         arg(numNotModified).arg(cache.count()).arg(cache.totalCost()).arg(cache.maxCost());
+}
@@ -0,0 +1,94 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_WEBMAPIMAGECACHE_H
+#define LNM_WEBMAPIMAGECACHE_H
+
+#include "geo/pos.h"
+
+#include <QCache>
+#include <QDateTime>
+#include <QMutex>
+
+/*
+ * Encoded map image including the view information needed to update a web session.
+ */
+struct WebMapImage
+{
+  QByteArray bytes, contentType;
+
+  /* Quoted entity tag for the HTTP header. Hash of the encoded image bytes. */
+  QByteArray etag;
+
+  atools::geo::Pos pos; /* Map center */
+  float requestedDistanceKm = 0.f, correctedDistanceKm = 0.f;
+
+  /* Error message from rendering. Not cached. */
+  QString error;
+};
+
+/*
+ * Thread safe cache for encoded map images used by the HTTP server threads.
+ *
+ * Images are keyed by the normalized request and a map state generation which is increased by the map controller
+ * whenever something changes what is drawn. Entries of older generations are never returned and drop out
+ * once the memory budget is exceeded. Entries also expire after a maximum age to cover changes which do not
+ * increase the generation.
+ */
+class WebMapImageCache
+{
+public:
+  /* Memory budget in bytes for encoded images */
+  explicit WebMapImageCache(int maxBytes);
+  ~WebMapImageCache();
+
+  WebMapImageCache(const WebMapImageCache& other) = delete;
+  WebMapImageCache& operator=(const WebMapImageCache& other) = delete;
+
+  /* Copies image and returns true if found for key and generation */
+  bool get(const QString& key, quint64 generation, WebMapImage& image);
+
+  /* Insert image. Images larger than the budget are not cached. */
+  void insert(const QString& key, quint64 generation, const WebMapImage& image);
+
+  /* Count a request answered with "304 Not Modified" */
+  void notModified();
+
+  void clear();
+
+  /* Counters as text in lines of "key=value" */
+  QString getStatisticsText() const;
+
+private:
+  struct Entry
+  {
+    WebMapImage image;
+    QDateTime timestamp;
+  };
+
+  static QString fullKey(const QString& key, quint64 generation);
+
+  /* Entries older than this are ignored */
+  static Q_DECL_CONSTEXPR qint64 MAX_AGE_MS = 60000L;
+
+  QCache<QString, Entry> cache;
+
+  quint64 numLookups = 0L, numHits = 0L, numNotModified = 0L;
+  mutable QMutex mutex;
+};
+
+#endif // LNM_WEBMAPIMAGECACHE_H
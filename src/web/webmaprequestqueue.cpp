@@ -0,0 +1,106 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "web/webmaprequestqueue.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+
+WebMapRequestQueue::WebMapRequestQueue()
+{
+
+}
+
+WebMapRequestQueue::~WebMapRequestQueue()
+{
+  qDebug() << Q_FUNC_INFO << getStatisticsText();
+}
+
+MapPixmap WebMapRequestQueue::request(const QString& key, const std::function<MapPixmap()>& function)
+{
+  QElapsedTimer timer;
+  timer.start();
+
+  QMutexLocker locker(&mutex);
+  statistics.numRequests++;
+  statistics.queueDepth++;
+  statistics.maxQueueDepth = std::max(statistics.maxQueueDepth, statistics.queueDepth);
+
+  MapPixmap result;
+  QSharedPointer<Pending> running = pending.value(key);
+  if(running.isNull())
+  {
+    // No identical request running - call map controller with unlocked mutex ===========
+    running = QSharedPointer<Pending>::create();
+    pending.insert(key, running);
+    statistics.numRendered++;
+
+    locker.unlock();
+    result = function();
+    locker.relock();
+
+    // Pass result to all waiting threads
+    running->result = result;
+    running->done = true;
+    pending.remove(key);
+    doneCondition.wakeAll();
+  }
+  else
+  {
+    // Wait for the identical request to finish and take its result ===========
+    statistics.numCoalesced++;
+    while(!running->done)
+      doneCondition.wait(&mutex);
+    result = running->result;
+  }
+
+  statistics.queueDepth--;
+  qint64 latency = timer.elapsed();
+  statistics.sumLatencyMs += latency;
+  statistics.maxLatencyMs = std::max(statistics.maxLatencyMs, latency);
+
+  return result;
+}
+
+WebMapRequestStatistics WebMapRequestQueue::getStatistics() const
+{
+  QMutexLocker locker(&mutex);
+  return statistics;
+}
+
+QString WebMapRequestQueue::getStatisticsText() const
+{
+  WebMapRequestStatistics stats = getStatistics();
+  return QString("requests=%1\n"
+                 "rendered=%2\n"
+                 "coalesced=%3\n"
+                 "queue_depth=%4\n"
+                 "max_queue_depth=%5\n"
+                 "average_latency_ms=%6\n"
+                 "max_latency_ms=%7\n").
+         arg(stats.numRequests).arg(stats.numRendered).arg(stats.numCoalesced).
+         arg(stats.queueDepth).arg(stats.maxQueueDepth).
+         arg(stats.averageLatencyMs()).arg(stats.maxLatencyMs);
+}
+
+void WebMapRequestQueue::clearStatistics()
+{
+  QMutexLocker locker(&mutex);
+  int queueDepth = statistics.queueDepth;
+  statistics = WebMapRequestStatistics();
+  statistics.queueDepth = queueDepth;
+}
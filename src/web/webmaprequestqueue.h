@@ -0,0 +1,94 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef LNM_WEBMAPREQUESTQUEUE_H
+#define LNM_WEBMAPREQUESTQUEUE_H
+
+#include "web/webmapcontroller.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QWaitCondition>
+
+#include <functional>
+
+/*
+ * Counters for map image requests. All times in milliseconds.
+ */
+struct WebMapRequestStatistics
+{
+  /* Number of all requests, requests which were passed to the map controller and
+   * requests which shared the result of an identical running request */
+  quint64 numRequests = 0L, numRendered = 0L, numCoalesced = 0L;
+
+  /* Current and maximum number of requests waiting or rendering */
+  int queueDepth = 0, maxQueueDepth = 0;
+
+  /* Time from receiving request until result is available */
+  qint64 sumLatencyMs = 0L, maxLatencyMs = 0L;
+
+  qint64 averageLatencyMs() const
+  {
+    return numRequests > 0 ? sumLatencyMs / static_cast<qint64>(numRequests) : 0L;
+  }
+
+};
+
+/*
+ * Thread safe queue used by the HTTP server threads for map image requests.
+ *
+ * Identical requests which arrive while one is still waiting for the main thread are not queued again.
+ * Instead the later threads wait for the first one and share its result.
+ */
+class WebMapRequestQueue
+{
+public:
+  WebMapRequestQueue();
+  ~WebMapRequestQueue();
+
+  WebMapRequestQueue(const WebMapRequestQueue& other) = delete;
+  WebMapRequestQueue& operator=(const WebMapRequestQueue& other) = delete;
+
+  /* Call function for request identified by key or wait for an already running identical request.
+   * key has to contain all parameters which influence the resulting image. */
+  MapPixmap request(const QString& key, const std::function<MapPixmap()>& function);
+
+  /* Get a copy of the current counters */
+  WebMapRequestStatistics getStatistics() const;
+
+  /* Counters as text in lines of "key=value" */
+  QString getStatisticsText() const;
+
+  void clearStatistics();
+
+private:
+  /* A running request and its result which is set once done */
+  struct Pending
+  {
+    MapPixmap result;
+    bool done = false;
+  };
+
+  QHash<QString, QSharedPointer<Pending> > pending;
+  WebMapRequestStatistics statistics;
+
+  mutable QMutex mutex;
+  QWaitCondition doneCondition;
+};
+
+#endif // LNM_WEBMAPREQUESTQUEUE_H
@@ -29,6 +29,7 @@
 #include "app/navapp.h"
 #include "common/mapresult.h"
 #include "web/webmapcontroller.h"
+#include "geo/calculations.h"
 
 #include <QDebug>
 #include <QBuffer>
@@ -110,31 +111,28 @@ WebApiResponse MapActionsController::featuresAction(WebApiRequest request){
         request.parameters.value("bottomlat").toFloat()
     );
 
-    bool overflow = false;
+    int detailFactor = request.parameters.contains("detailfactor") ?
+                request.parameters.value("detailfactor").toInt() : MapLayerSettings::MAP_DEFAULT_DETAIL_LEVEL;
+
+    // Size of the client view - default is the size formerly used by the dummy image request
+    int width = request.parameters.contains("width") ? request.parameters.value("width").toInt() : 300;
+    int height = request.parameters.contains("height") ? request.parameters.value("height").toInt() : 300;
+
+    // Select layer directly instead of rendering a map to have it updated
+    const MapLayer *mapLayer = getMapLayerForRect(rect, width, height, detailFactor);
+    if(mapLayer == nullptr){
+        response.body = "Invalid rectangle";
+        response.status = 400;
+        return response;
+    }
 
-    // Init dummy image request
-    WebApiRequest *imageRequest = new WebApiRequest();
-    imageRequest->parameters = QMap<QByteArray,QByteArray>();
-    imageRequest->parameters.insert("leftlon",request.parameters.value("leftlon")),
-    imageRequest->parameters.insert("toplat",request.parameters.value("toplat")),
-    imageRequest->parameters.insert("rightlon",request.parameters.value("rightlon")),
-    imageRequest->parameters.insert("bottomlat",request.parameters.value("bottomlat")),
-    imageRequest->parameters.insert("detailfactor",request.parameters.value("detailfactor"));
-    imageRequest->parameters.insert("width","300");
-    imageRequest->parameters.insert("height","300");
-    imageRequest->parameters.insert("format","jpg");
-    imageRequest->parameters.insert("quality","1");
-
-    // Perform dummy image request
-    imageAction(*imageRequest);
-
-    // Extract results created during dummy image request
-    const QList<map::MapAirport> airports = *mapPaintWidget->getMapQuery()->getAirportsByRect(rect,mapPaintWidget->getMapPaintLayer()->getMapLayer(), false,map::NONE,overflow);
-
-    const QList<map::MapNdb> ndbs = *mapPaintWidget->getMapQuery()->getNdbsByRect(rect,mapPaintWidget->getMapPaintLayer()->getMapLayer(), false,overflow);
-    const QList<map::MapVor> vors = *mapPaintWidget->getMapQuery()->getVorsByRect(rect,mapPaintWidget->getMapPaintLayer()->getMapLayer(), false,overflow);
-    const QList<map::MapMarker> markers = *mapPaintWidget->getMapQuery()->getMarkersByRect(rect,mapPaintWidget->getMapPaintLayer()->getMapLayer(), false,overflow);
-    const QList<map::MapWaypoint> waypoints = mapPaintWidget->getWaypointTrackQuery()->getWaypointsByRect(rect,mapPaintWidget->getMapPaintLayer()->getMapLayer(), false,overflow);
+    bool overflow = false;
+    MapQuery *mapQuery = mapPaintWidget->getMapQuery();
+    const QList<map::MapAirport> airports = *mapQuery->getAirportsByRect(rect, mapLayer, false, map::NONE, overflow);
+    const QList<map::MapNdb> ndbs = *mapQuery->getNdbsByRect(rect, mapLayer, false, overflow);
+    const QList<map::MapVor> vors = *mapQuery->getVorsByRect(rect, mapLayer, false, overflow);
+    const QList<map::MapMarker> markers = *mapQuery->getMarkersByRect(rect, mapLayer, false, overflow);
+    const QList<map::MapWaypoint> waypoints = mapPaintWidget->getWaypointTrackQuery()->getWaypointsByRect(rect, mapLayer, false, overflow);
 
     MapFeaturesData data = {
         airports,
@@ -145,6 +143,7 @@ WebApiResponse MapActionsController::featuresAction(WebApiRequest request){
     };
 
     response.body = infoBuilder->features(data);
+    response.status = 200;
 
     return response;
 
@@ -182,6 +181,31 @@ WebApiResponse MapActionsController::featureAction(WebApiRequest request){
 
 }
 
+const MapLayer *MapActionsController::getMapLayerForRect(const atools::geo::Rect& rect, int width, int height, int detailFactor)
+{
+  if(!rect.isValid() || width <= 0 || height <= 0 || mapPaintWidget == nullptr)
+    return nullptr;
+
+  float distanceKm = distanceForRect(rect, width, height);
+
+  if(verbose)
+    qDebug() << Q_FUNC_INFO << rect << width << "x" << height << "detailFactor" << detailFactor << "distanceKm" << distanceKm;
+
+  return mapPaintWidget->getMapPaintLayer()->getMapLayerForDistance(distanceKm, detailFactor);
+}
+
+float MapActionsController::distanceForRect(const atools::geo::Rect& rect, int width, int height)
+{
+  // Radius in pixel like Marble calculates it when centering on a bounding box
+  double widthRad = std::max(atools::geo::toRadians(static_cast<double>(std::abs(rect.getWidthDegree()))), 1.e-6);
+  double heightRad = std::max(atools::geo::toRadians(static_cast<double>(std::abs(rect.getHeightDegree()))), 1.e-6);
+  double radius = std::max(std::min(0.25 * M_PI * height / heightRad, 0.25 * M_PI * width / widthRad), 1.);
+
+  // Marble distance definition using planet radius in meter and a viewing angle of 110 degree
+  // which results in a distance in km
+  return static_cast<float>(6378137. * 0.4 / radius / std::tan(0.5 * atools::geo::toRadians(110.)));
+}
+
 MapActionsController::~MapActionsController()
 {
   qDebug() << Q_FUNC_INFO;
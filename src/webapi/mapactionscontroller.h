@@ -24,6 +24,7 @@
 #include "mapgui/maplayersettings.h"
 
 class QPixmap;
+class MapLayer;
 class MapPaintWidget;
 class WebApiRequest;
 class WebApiResponse;
@@ -80,6 +81,12 @@ protected:
     /* Zoom to rectangel on map. */
     MapPixmap getPixmapRect(int width, int height, atools::geo::Rect rect, int detailFactor = MapLayerSettings::MAP_DEFAULT_DETAIL_LEVEL, const QString& errorCase = tr("Invalid rectangle"));
 
+    /* Get map layer for rectangle shown in a view of the given size without changing or painting the map */
+    const MapLayer *getMapLayerForRect(const atools::geo::Rect& rect, int width, int height, int detailFactor);
+
+    /* Zoom distance in km as used by Marble when fitting rect into a view of the given size */
+    static float distanceForRect(const atools::geo::Rect& rect, int width, int height);
+
     MapPaintWidget *mapPaintWidget = nullptr;
     QMutex mapPaintWidgetMutex;
 
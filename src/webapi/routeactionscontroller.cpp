@@ -0,0 +1,107 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#include "routeactionscontroller.h"
+#include "common/infobuildertypes.h"
+#include "common/abstractinfobuilder.h"
+#include "route/routebatch.h"
+#include "webapi/webapirequest.h"
+#include "json/nlohmann/json.hpp"
+
+using InfoBuilderTypes::RouteBatchData;
+using JSON = nlohmann::json;
+
+#include <QDebug>
+#include <QSharedPointer>
+#include <QThread>
+
+RouteActionsController::RouteActionsController(QObject *parent, bool verboseParam, AbstractInfoBuilder* infoBuilder) :
+    AbstractLnmActionsController(parent, verboseParam, infoBuilder)
+{
+    if(verbose)
+        qDebug() << Q_FUNC_INFO;
+}
+
+WebApiResponse RouteActionsController::batchAction(WebApiRequest request){
+    if(verbose)
+        qDebug() << Q_FUNC_INFO << request.method << request.body.size();
+
+    // Get a new response object
+    WebApiResponse response = getResponse();
+
+    if(request.method != "POST"){
+        response.body = "POST required";
+        response.status = 405;
+        return response;
+    }
+
+    // Parse city pairs from body
+    QVector<routebatch::Entry> entries;
+    int threads = 0;
+    try{
+        JSON json = JSON::parse(request.body.constData());
+
+        threads = json.value("threads", 0);
+
+        for(const JSON& route : json.at("routes")){
+            routebatch::Entry entry;
+            entry.departureIdent = QString::fromStdString(route.at("departure").get<std::string>()).toUpper();
+            entry.destinationIdent = QString::fromStdString(route.at("destination").get<std::string>()).toUpper();
+            entry.altitudeFt = route.value("altitude", 0.f);
+            entry.mode = QString::fromStdString(route.value("mode", std::string("airway")));
+            entries.append(entry);
+        }
+    }catch(const JSON::exception& e){
+        qWarning() << Q_FUNC_INFO << e.what();
+        response.body = QByteArray("Invalid request: ") + e.what();
+        response.status = 400;
+        return response;
+    }
+
+    if(entries.isEmpty()){
+        response.body = "No routes given";
+        response.status = 400;
+        return response;
+    }
+
+    // Resolve airports here in the GUI thread
+    QSharedPointer<RouteBatch> batch(new RouteBatch);
+    if(threads > 0)
+        batch->setNumWorkers(std::min(threads, QThread::idealThreadCount()));
+    batch->prepare(entries);
+
+    // Calculation is done in the HTTP thread to keep the GUI responsive - flight plans are built in the GUI thread again
+    response.continuation = [this, batch](WebApiResponse& finalResponse) -> void {
+        batch->calculateRoutes();
+
+        QMetaObject::invokeMethod(this, [this, batch, &finalResponse]() -> void {
+            QVector<routebatch::Result> results = batch->finish();
+
+            RouteBatchData data = {
+                &results,
+                &batch->getStatistics()
+            };
+
+            finalResponse.body = infoBuilder->routebatch(data);
+            finalResponse.status = 200;
+        }, Qt::BlockingQueuedConnection);
+    };
+
+    response.status = 200;
+    return response;
+
+}
@@ -0,0 +1,41 @@
+/*****************************************************************************
+* Copyright 2015-2023 Alexander Barthel alex@littlenavmap.org
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*****************************************************************************/
+
+#ifndef ROUTEACTIONSCONTROLLER_H
+#define ROUTEACTIONSCONTROLLER_H
+
+#include "webapi/abstractlnmactionscontroller.h"
+
+/**
+ * @brief Flight plan calculation actions controller implementation.
+ */
+class RouteActionsController :
+        public AbstractLnmActionsController
+{
+    Q_OBJECT
+public:
+    Q_INVOKABLE RouteActionsController(QObject *parent, bool verboseParam, AbstractInfoBuilder* infoBuilder);
+    /**
+     * @brief calculate flight plans for a list of city pairs in parallel
+     * POST body: {"threads":4,"routes":[{"departure":"EDDF","destination":"LIRF","altitude":35000,"mode":"airway"}]}
+     * "threads" is optional and defaults to the number of cores. It is limited to the number of cores.
+     * Routes are calculated in the HTTP worker thread. Airports and flight plans are resolved in the GUI thread.
+     */
+    Q_INVOKABLE WebApiResponse batchAction(WebApiRequest request);
+};
+
+#endif // ROUTEACTIONSCONTROLLER_H
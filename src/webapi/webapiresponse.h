@@ -21,6 +21,8 @@
 #include <QByteArray>
 #include <QMultiMap>
 
+#include <functional>
+
 /**
  * @brief Generic WebApiResponse POD object
  */
@@ -29,5 +31,9 @@ public:
     int status;
     QMultiMap<QByteArray, QByteArray> headers;
     QByteArray body;
+
+    /* Optional. Called in the HTTP worker thread after the action returned in the GUI thread.
+     * Allows long running actions to complete the response without blocking the GUI. */
+    std::function<void(WebApiResponse& response)> continuation;
 };
 #endif // WEBAPIRESPONSE_H